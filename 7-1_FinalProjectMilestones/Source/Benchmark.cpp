@@ -0,0 +1,284 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// draw a fixed number of frames into an offscreen target and write the frame
+// time percentiles, call counts and GPU times of the run to a CSV file
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_framebuffer = 0;
+	m_colorTexture = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_frameCount = 0;
+	m_warmupFrameCount = 0;
+	m_frameIndex = 0;
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the offscreen color and
+ *  depth targets at the passed in resolution and one query
+ *  for every measured frame.
+ ***********************************************************/
+bool Benchmark::Create(int width, int height, int frameCount, int warmupFrameCount)
+{
+	Destroy();
+
+	if ((width <= 0) || (height <= 0) || (frameCount <= 0))
+	{
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	m_frameCount = frameCount;
+	m_warmupFrameCount = (warmupFrameCount > 0) ? warmupFrameCount : 0;
+	m_frameIndex = 0;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_colorTexture);
+	glTextureStorage2D(m_colorTexture, 1, GL_RGBA8, m_width, m_height);
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+
+	glCreateFramebuffers(1, &m_framebuffer);
+	glNamedFramebufferTexture(m_framebuffer, GL_COLOR_ATTACHMENT0, m_colorTexture, 0);
+	glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+	glNamedFramebufferDrawBuffer(m_framebuffer, GL_COLOR_ATTACHMENT0);
+	if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "The benchmark framebuffer is not complete" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_queries.resize(m_frameCount);
+	glGenQueries(m_frameCount, m_queries.data());
+	m_samples.reserve(m_frameCount);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the offscreen targets and
+ *  the queries of the run.
+ ***********************************************************/
+void Benchmark::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+		m_colorTexture = 0;
+	}
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+	if (m_queries.empty() == false)
+	{
+		glDeleteQueries((GLsizei)m_queries.size(), m_queries.data());
+		m_queries.clear();
+	}
+	m_samples.clear();
+}
+
+/***********************************************************
+ *  GetProgress()
+ *
+ *  This method is used for getting the fraction of the
+ *  measured frames that has been drawn, such as for sampling
+ *  the camera path of the run.
+ ***********************************************************/
+float Benchmark::GetProgress() const
+{
+	if ((m_frameIndex < m_warmupFrameCount) || (m_frameCount <= 1))
+	{
+		return(0.0f);
+	}
+
+	return((float)(m_frameIndex - m_warmupFrameCount) / (float)(m_frameCount - 1));
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the offscreen target at
+ *  its full size and starting the timing of a frame.
+ ***********************************************************/
+void Benchmark::BeginFrame()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	m_frameStart = std::chrono::steady_clock::now();
+	if (m_frameIndex >= m_warmupFrameCount)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_frameIndex - m_warmupFrameCount]);
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stopping the timing of a frame.
+ *  The warm up frames are drawn but not kept.
+ ***********************************************************/
+void Benchmark::EndFrame()
+{
+	if (m_frameIndex >= m_warmupFrameCount)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_frameStart;
+		FRAME_SAMPLE sample;
+		sample.cpuTime = elapsed.count();
+		sample.gpuTime = 0.0;
+		sample.drawCount = (NULL != m_pStateCache) ? m_pStateCache->GetFrameDrawCount() : 0;
+		sample.uniformCount = (NULL != m_pStateCache) ? m_pStateCache->GetFrameUniformCount() : 0;
+		sample.stateChangeCount = (NULL != m_pStateCache) ? m_pStateCache->GetFrameStateChangeCount() : 0;
+		m_samples.push_back(sample);
+	}
+
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  GetPercentile()
+ *
+ *  This method is used for getting the nearest rank
+ *  percentile of a list of sorted values.
+ ***********************************************************/
+double Benchmark::GetPercentile(const std::vector<double>& sortedValues, double percentile)
+{
+	if (sortedValues.empty() == true)
+	{
+		return(0.0);
+	}
+
+	size_t rank = (size_t)std::ceil(percentile * sortedValues.size());
+	rank = (rank > 0) ? rank - 1 : 0;
+	rank = std::min(rank, sortedValues.size() - 1);
+
+	return(sortedValues[rank]);
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for reading back the GPU times of the
+ *  run and adding one row with the mean, median and 99th
+ *  percentile frame times and the average call counts of a
+ *  frame to a CSV file.
+ ***********************************************************/
+bool Benchmark::WriteResults(const char* filePath, const std::string& label, int objectCount)
+{
+	glFinish();
+
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	double cpuTotal = 0.0;
+	double gpuTotal = 0.0;
+	unsigned long long drawTotal = 0;
+	unsigned long long uniformTotal = 0;
+	unsigned long long stateChangeTotal = 0;
+
+	for (size_t i = 0; i < m_samples.size(); i++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+		// the elapsed time is in nanoseconds
+		m_samples[i].gpuTime = (double)elapsed / 1000000.0;
+
+		cpuTimes.push_back(m_samples[i].cpuTime);
+		gpuTimes.push_back(m_samples[i].gpuTime);
+		cpuTotal += m_samples[i].cpuTime;
+		gpuTotal += m_samples[i].gpuTime;
+		drawTotal += m_samples[i].drawCount;
+		uniformTotal += m_samples[i].uniformCount;
+		stateChangeTotal += m_samples[i].stateChangeCount;
+	}
+
+	if (m_samples.empty() == true)
+	{
+		std::cout << "The benchmark did not measure any frames" << std::endl;
+		return(false);
+	}
+
+	std::sort(cpuTimes.begin(), cpuTimes.end());
+	std::sort(gpuTimes.begin(), gpuTimes.end());
+	size_t sampleCount = m_samples.size();
+
+	// a new file starts with the column names
+	bool bNewFile = true;
+	{
+		std::ifstream existing(filePath);
+		bNewFile = !existing;
+	}
+
+	std::ofstream file(filePath, std::ios::app);
+	if (!file)
+	{
+		std::cout << "Could not write benchmark results:" << filePath << std::endl;
+		return(false);
+	}
+
+	if (bNewFile == true)
+	{
+		file << "mode,width,height,objects,frames,"
+			<< "cpu_mean_ms,cpu_p50_ms,cpu_p99_ms,"
+			<< "gpu_mean_ms,gpu_p50_ms,gpu_p99_ms,"
+			<< "draws,uniforms,state_changes\n";
+	}
+
+	file << label << "," << m_width << "," << m_height << "," << objectCount << "," << sampleCount << ","
+		<< (cpuTotal / sampleCount) << "," << GetPercentile(cpuTimes, 0.5) << "," << GetPercentile(cpuTimes, 0.99) << ","
+		<< (gpuTotal / sampleCount) << "," << GetPercentile(gpuTimes, 0.5) << "," << GetPercentile(gpuTimes, 0.99) << ","
+		<< (drawTotal / sampleCount) << "," << (uniformTotal / sampleCount) << "," << (stateChangeTotal / sampleCount) << "\n";
+
+	if (!file)
+	{
+		std::cout << "Could not write benchmark results:" << filePath << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: Benchmark " << label << " - " << sampleCount << " frames, CPU p50 "
+		<< GetPercentile(cpuTimes, 0.5) << " ms p99 " << GetPercentile(cpuTimes, 0.99)
+		<< " ms, GPU p50 " << GetPercentile(gpuTimes, 0.5) << " ms p99 " << GetPercentile(gpuTimes, 0.99)
+		<< " ms, written to " << filePath << std::endl;
+	return(true);
+}
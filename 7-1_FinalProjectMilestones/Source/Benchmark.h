@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// draw a fixed number of frames into an offscreen target and write the frame
+// time percentiles, call counts and GPU times of the run to a CSV file
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StateCache.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class owns the offscreen color and depth targets
+ *  that a benchmark run draws into and times every frame of
+ *  the run.  The first frames warm up the caches and the
+ *  driver and are not measured.  The CPU time of a frame
+ *  comes from a steady clock and its GPU time from one
+ *  elapsed time query per measured frame, which are only
+ *  read back after the run, so the timing never waits on the
+ *  GPU.  The results of a run are added as one row of a CSV
+ *  file, so runs of different modes and scales can be
+ *  compared side by side.
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// constructor
+	Benchmark(StateCache* pStateCache);
+	// destructor
+	~Benchmark();
+
+	// create the offscreen targets and the queries of a run
+	bool Create(int width, int height, int frameCount, int warmupFrameCount);
+	// free the targets and the queries
+	void Destroy();
+
+	// bind the offscreen target and start timing a frame
+	void BeginFrame();
+	// stop timing the frame and take its call counts from the
+	// state cache
+	void EndFrame();
+
+	// true when every frame of the run has been drawn
+	bool IsFinished() const { return(m_frameIndex >= m_warmupFrameCount + m_frameCount); }
+	// fraction of the measured frames that has been drawn,
+	// which is 0 during the warm up
+	float GetProgress() const;
+
+	// wait for the GPU and add the results of the run as one
+	// row of a CSV file, writing the header for a new file
+	bool WriteResults(const char* filePath, const std::string& label, int objectCount);
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+
+private:
+	// measurements of one frame
+	struct FRAME_SAMPLE
+	{
+		double cpuTime;
+		double gpuTime;
+		unsigned int drawCount;
+		unsigned int uniformCount;
+		unsigned int stateChangeCount;
+	};
+
+	// pointer to the state cache that counts the calls
+	StateCache* m_pStateCache;
+	// offscreen framebuffer and its targets
+	GLuint m_framebuffer;
+	GLuint m_colorTexture;
+	GLuint m_depthTexture;
+	int m_width;
+	int m_height;
+	// frames of the run
+	int m_frameCount;
+	int m_warmupFrameCount;
+	int m_frameIndex;
+	// elapsed time query of every measured frame
+	std::vector<GLuint> m_queries;
+	std::vector<FRAME_SAMPLE> m_samples;
+	std::chrono::steady_clock::time_point m_frameStart;
+
+	// get a percentile from 0 to 1 of sorted values
+	static double GetPercentile(const std::vector<double>& sortedValues, double percentile);
+};
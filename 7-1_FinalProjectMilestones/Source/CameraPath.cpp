@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// record, save and replay the camera of the view manager along a path
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+}
+
+/***********************************************************
+ *  ~CameraPath()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CameraPath::~CameraPath()
+{
+	m_keys.clear();
+}
+
+/***********************************************************
+ *  AddKey()
+ *
+ *  This method is used for adding a camera key to the end of
+ *  the path.
+ ***********************************************************/
+void CameraPath::AddKey(const CAMERA_KEY& key)
+{
+	m_keys.push_back(key);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all keys from the path.
+ ***********************************************************/
+void CameraPath::Clear()
+{
+	m_keys.clear();
+}
+
+/***********************************************************
+ *  MakeOrbit()
+ *
+ *  This method is used for building a path that circles the
+ *  passed in center once at the passed in height, looking at
+ *  the center the whole way around.
+ ***********************************************************/
+void CameraPath::MakeOrbit(
+	glm::vec3 center,
+	float radius,
+	float height,
+	float zoom,
+	int keyCount)
+{
+	m_keys.clear();
+
+	for (int i = 0; i <= keyCount; i++)
+	{
+		float angle = (6.2831853f * i) / keyCount;
+
+		CAMERA_KEY key;
+		key.position = center + glm::vec3(std::sin(angle) * radius, height, std::cos(angle) * radius);
+		key.front = glm::normalize(center - key.position);
+		key.up = glm::vec3(0.0f, 1.0f, 0.0f);
+		key.zoom = zoom;
+		m_keys.push_back(key);
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading a path file.  Each line
+ *  holds the position, the front direction, the up direction
+ *  and the zoom of one key, and lines starting with # are
+ *  skipped.
+ ***********************************************************/
+bool CameraPath::Load(const char* filePath)
+{
+	std::ifstream file(filePath);
+	std::string line;
+
+	if (!file)
+	{
+		std::cout << "Could not open camera path:" << filePath << std::endl;
+		return(false);
+	}
+
+	m_keys.clear();
+	while (std::getline(file, line))
+	{
+		if ((line.empty() == true) || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		CAMERA_KEY key;
+		std::istringstream values(line);
+		values >> key.position.x >> key.position.y >> key.position.z
+			>> key.front.x >> key.front.y >> key.front.z
+			>> key.up.x >> key.up.y >> key.up.z
+			>> key.zoom;
+		if (!values)
+		{
+			std::cout << "Skipped a damaged camera path key:" << filePath << std::endl;
+			continue;
+		}
+
+		m_keys.push_back(key);
+	}
+
+	std::cout << "Loaded camera path:" << filePath << ", keys:" << m_keys.size() << std::endl;
+	return(m_keys.empty() == false);
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the keys to a path file
+ *  that Load() can read back.
+ ***********************************************************/
+bool CameraPath::Save(const char* filePath) const
+{
+	std::ofstream file(filePath, std::ios::trunc);
+
+	if (!file)
+	{
+		std::cout << "Could not write camera path:" << filePath << std::endl;
+		return(false);
+	}
+
+	file << "# position xyz, front xyz, up xyz, zoom\n";
+	for (size_t i = 0; i < m_keys.size(); i++)
+	{
+		const CAMERA_KEY& key = m_keys[i];
+		file << key.position.x << " " << key.position.y << " " << key.position.z << " "
+			<< key.front.x << " " << key.front.y << " " << key.front.z << " "
+			<< key.up.x << " " << key.up.y << " " << key.up.z << " "
+			<< key.zoom << "\n";
+	}
+
+	if (!file)
+	{
+		std::cout << "Could not write camera path:" << filePath << std::endl;
+		return(false);
+	}
+
+	std::cout << "Wrote camera path:" << filePath << ", keys:" << m_keys.size() << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Sample()
+ *
+ *  This method is used for getting the camera at a fraction
+ *  of the path.  The position and the zoom are blended
+ *  linearly between the two nearest keys and the directions
+ *  are blended and made unit length again.
+ ***********************************************************/
+CameraPath::CAMERA_KEY CameraPath::Sample(float fraction) const
+{
+	CAMERA_KEY key;
+
+	if (m_keys.empty() == true)
+	{
+		key.position = glm::vec3(0.0f);
+		key.front = glm::vec3(0.0f, 0.0f, -1.0f);
+		key.up = glm::vec3(0.0f, 1.0f, 0.0f);
+		key.zoom = 45.0f;
+		return(key);
+	}
+
+	float position = glm::clamp(fraction, 0.0f, 1.0f) * (float)(m_keys.size() - 1);
+	size_t first = (size_t)position;
+	size_t second = (first + 1 < m_keys.size()) ? first + 1 : first;
+	float blend = position - (float)first;
+
+	const CAMERA_KEY& a = m_keys[first];
+	const CAMERA_KEY& b = m_keys[second];
+	key.position = glm::mix(a.position, b.position, blend);
+	key.front = glm::normalize(glm::mix(a.front, b.front, blend));
+	key.up = glm::normalize(glm::mix(a.up, b.up, blend));
+	key.zoom = a.zoom + ((b.zoom - a.zoom) * blend);
+
+	return(key);
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// record, save and replay the camera of the view manager along a path
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class holds a list of camera keys - the position,
+ *  the view direction, the up direction and the zoom of the
+ *  camera.  A path is recorded one key per frame, saved as a
+ *  text file with one key per line, and replayed by sampling
+ *  it at a fraction of its length, so a path can be replayed
+ *  over any number of frames.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// constructor
+	CameraPath();
+	// destructor
+	~CameraPath();
+
+	// one recorded camera state
+	struct CAMERA_KEY
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float zoom;
+	};
+
+	// add a key to the end of the path
+	void AddKey(const CAMERA_KEY& key);
+	// remove all keys
+	void Clear();
+	// build a path that circles the passed in center once
+	void MakeOrbit(
+		glm::vec3 center,
+		float radius,
+		float height,
+		float zoom,
+		int keyCount);
+
+	// read and write the keys of a path file
+	bool Load(const char* filePath);
+	bool Save(const char* filePath) const;
+
+	// get the camera at a fraction from 0 to 1 of the path,
+	// blended between the two nearest keys
+	CAMERA_KEY Sample(float fraction) const;
+
+	int GetKeyCount() const { return((int)m_keys.size()); }
+
+private:
+	// keys of the path in replay order
+	std::vector<CAMERA_KEY> m_keys;
+};
@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.cpp
+// ============
+// bin point lights into a view space cluster grid for forward shading
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// the point lights are uploaded as they are, so their size
+// must match the std430 layout of the light buffer
+static_assert(sizeof(ClusteredLights::POINT_LIGHT) == 32, "POINT_LIGHT does not match the std430 layout");
+
+/***********************************************************
+ *  ClusteredLights()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLights::ClusteredLights()
+{
+	m_boundsProjection = glm::mat4(1.0f);
+	m_nearDepth = 0.1f;
+	m_farDepth = 100.0f;
+	m_buffers[POINT_LIGHT_BINDING] = 0;
+	m_buffers[CLUSTER_RANGE_BINDING] = 0;
+	m_buffers[CLUSTER_INDEX_BINDING] = 0;
+	m_buffers[CLUSTER_BLOCK_BINDING] = 0;
+	m_pStreamBuffer = NULL;
+	m_clusterRanges.resize(CLUSTER_COUNT * 2, 0);
+	m_clusterCounts.resize(CLUSTER_COUNT, 0);
+}
+
+/***********************************************************
+ *  ~ClusteredLights()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLights::~ClusteredLights()
+{
+	if (m_buffers[POINT_LIGHT_BINDING] != 0)
+	{
+		glDeleteBuffers(4, m_buffers);
+	}
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the buffers behind the
+ *  light storage blocks and the cluster uniform block, and
+ *  attaching each one to its binding point.
+ ***********************************************************/
+void ClusteredLights::CreateBuffers()
+{
+	if (m_buffers[POINT_LIGHT_BINDING] != 0)
+	{
+		return;
+	}
+
+	glGenBuffers(4, m_buffers);
+	for (GLuint binding = POINT_LIGHT_BINDING; binding <= CLUSTER_INDEX_BINDING; binding++)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffers[binding]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t) * 4, NULL, GL_STREAM_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_buffers[binding]);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffers[CLUSTER_BLOCK_BINDING]);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CLUSTER_BLOCK), NULL, GL_STREAM_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CLUSTER_BLOCK_BINDING, m_buffers[CLUSTER_BLOCK_BINDING]);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light - returns
+ *  the index of the new light.
+ ***********************************************************/
+int ClusteredLights::AddPointLight(const POINT_LIGHT& light)
+{
+	m_pointLights.push_back(light);
+	return((int)m_pointLights.size() - 1);
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for changing the values of a point
+ *  light, such as when it moves.
+ ***********************************************************/
+void ClusteredLights::SetPointLight(int lightIndex, const POINT_LIGHT& light)
+{
+	if ((lightIndex >= 0) && (lightIndex < (int)m_pointLights.size()))
+	{
+		m_pointLights[lightIndex] = light;
+	}
+}
+
+/***********************************************************
+ *  ClearPointLights()
+ *
+ *  This method is used for removing all of the point lights.
+ ***********************************************************/
+void ClusteredLights::ClearPointLights()
+{
+	m_pointLights.clear();
+}
+
+/***********************************************************
+ *  GetDepthRange()
+ *
+ *  This method is used for getting the near and far depths
+ *  back out of a perspective or orthographic projection.
+ ***********************************************************/
+void ClusteredLights::GetDepthRange(const glm::mat4& projection, float& nearDepth, float& farDepth)
+{
+	// perspective projections copy the negated depth into w
+	if (projection[2][3] != 0.0f)
+	{
+		nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+		farDepth = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		nearDepth = (projection[3][2] + 1.0f) / projection[2][2];
+		farDepth = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+
+	// keep the exponential slices well defined
+	if (nearDepth < 0.001f)
+		nearDepth = 0.001f;
+	if (farDepth <= nearDepth)
+		farDepth = nearDepth + 1.0f;
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used for getting the depth slice holding a
+ *  view depth.  The slices are spaced exponentially, so near
+ *  slices are thin and far slices are deep.
+ ***********************************************************/
+int ClusteredLights::GetDepthSlice(float viewDepth) const
+{
+	if (viewDepth <= m_nearDepth)
+	{
+		return(0);
+	}
+
+	int slice = (int)(logf(viewDepth / m_nearDepth) / logf(m_farDepth / m_nearDepth) * GRID_SIZE_Z);
+	if (slice >= GRID_SIZE_Z)
+		slice = GRID_SIZE_Z - 1;
+
+	return(slice);
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used for computing the view space bounding
+ *  box of every cluster.  The corners of each screen tile are
+ *  unprojected into view space rays, which are cut at the
+ *  depths of the slice boundaries.
+ ***********************************************************/
+void ClusteredLights::BuildClusterBounds(const glm::mat4& projection)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	GetDepthRange(projection, m_nearDepth, m_farDepth);
+	m_boundsProjection = projection;
+	m_clusterBounds.resize(CLUSTER_COUNT);
+
+	for (int y = 0; y < GRID_SIZE_Y; y++)
+	{
+		for (int x = 0; x < GRID_SIZE_X; x++)
+		{
+			glm::vec3 rayNear[4];
+			glm::vec3 rayFar[4];
+
+			// unproject the four tile corners onto the near and far planes
+			for (int corner = 0; corner < 4; corner++)
+			{
+				float ndcX = -1.0f + (2.0f * (float)(x + (corner & 1)) / GRID_SIZE_X);
+				float ndcY = -1.0f + (2.0f * (float)(y + (corner >> 1)) / GRID_SIZE_Y);
+				glm::vec4 nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				glm::vec4 farPoint = inverseProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+				rayNear[corner] = glm::vec3(nearPoint) / nearPoint.w;
+				rayFar[corner] = glm::vec3(farPoint) / farPoint.w;
+			}
+
+			for (int z = 0; z < GRID_SIZE_Z; z++)
+			{
+				float sliceDepths[2];
+				sliceDepths[0] = m_nearDepth * powf(m_farDepth / m_nearDepth, (float)z / GRID_SIZE_Z);
+				sliceDepths[1] = m_nearDepth * powf(m_farDepth / m_nearDepth, (float)(z + 1) / GRID_SIZE_Z);
+
+				CLUSTER_BOUNDS& bounds = m_clusterBounds[x + GRID_SIZE_X * (y + GRID_SIZE_Y * z)];
+				bounds.minimum = glm::vec3(1.0e30f);
+				bounds.maximum = glm::vec3(-1.0e30f);
+
+				// the cluster corners are where the rays cross the slice depths
+				for (int corner = 0; corner < 4; corner++)
+				{
+					float depthNear = -rayNear[corner].z;
+					float depthFar = -rayFar[corner].z;
+
+					for (int side = 0; side < 2; side++)
+					{
+						float t = (sliceDepths[side] - depthNear) / (depthFar - depthNear);
+						glm::vec3 point = glm::mix(rayNear[corner], rayFar[corner], t);
+
+						bounds.minimum = glm::min(bounds.minimum, point);
+						bounds.maximum = glm::max(bounds.maximum, point);
+					}
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for binning the point lights into the
+ *  clusters of the passed in view.  Each light is tested
+ *  against the clusters of the depth slices its sphere of
+ *  influence reaches, then the light indices are packed per
+ *  cluster and uploaded.
+ ***********************************************************/
+void ClusteredLights::Update(const glm::mat4& view, const glm::mat4& projection)
+{
+	BinLights(view, projection);
+	UploadBuffers();
+}
+
+/***********************************************************
+ *  BinLights()
+ *
+ *  This method is used for binning the point lights into the
+ *  clusters of the passed in view and packing the light
+ *  indices of each cluster, without uploading them.
+ ***********************************************************/
+void ClusteredLights::BinLights(const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((m_clusterBounds.size() == 0) || (projection != m_boundsProjection))
+	{
+		BuildClusterBounds(projection);
+	}
+
+	std::fill(m_clusterCounts.begin(), m_clusterCounts.end(), 0);
+	m_binnedPairs.clear();
+
+	for (int i = 0; i < (int)m_pointLights.size(); i++)
+	{
+		const POINT_LIGHT& light = m_pointLights[i];
+		glm::vec3 viewPosition = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		float viewDepth = -viewPosition.z;
+		float radiusSquared = light.radius * light.radius;
+
+		// skip the lights that cannot reach the view depth range
+		if ((viewDepth + light.radius < m_nearDepth) || (viewDepth - light.radius > m_farDepth))
+		{
+			continue;
+		}
+
+		int firstSlice = GetDepthSlice(viewDepth - light.radius);
+		int lastSlice = GetDepthSlice(viewDepth + light.radius);
+		for (int z = firstSlice; z <= lastSlice; z++)
+		{
+			for (int cluster = GRID_SIZE_X * GRID_SIZE_Y * z; cluster < GRID_SIZE_X * GRID_SIZE_Y * (z + 1); cluster++)
+			{
+				const CLUSTER_BOUNDS& bounds = m_clusterBounds[cluster];
+				glm::vec3 closest = glm::clamp(viewPosition, bounds.minimum, bounds.maximum);
+				glm::vec3 offset = closest - viewPosition;
+
+				if (glm::dot(offset, offset) <= radiusSquared)
+				{
+					m_binnedPairs.push_back((uint32_t)cluster);
+					m_binnedPairs.push_back((uint32_t)i);
+					m_clusterCounts[cluster]++;
+				}
+			}
+		}
+	}
+
+	// give each cluster its range of the packed light indices
+	uint32_t offset = 0;
+	for (int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		m_clusterRanges[(cluster * 2) + 0] = offset;
+		m_clusterRanges[(cluster * 2) + 1] = m_clusterCounts[cluster];
+		offset += m_clusterCounts[cluster];
+		m_clusterCounts[cluster] = 0;
+	}
+
+	// pack the light indices, using the counts as write cursors
+	m_lightIndices.resize(offset);
+	for (size_t pair = 0; pair < m_binnedPairs.size(); pair += 2)
+	{
+		uint32_t cluster = m_binnedPairs[pair];
+		m_lightIndices[m_clusterRanges[cluster * 2] + m_clusterCounts[cluster]] = m_binnedPairs[pair + 1];
+		m_clusterCounts[cluster]++;
+	}
+}
+
+/***********************************************************
+ *  UploadBuffers()
+ *
+ *  This method is used for uploading the point lights, the
+ *  cluster ranges, the light indices and the cluster grid
+ *  values.  The storage is orphaned each frame so the upload
+ *  never waits on draws that still read the previous frame,
+ *  unless the stream buffer takes the data.
+ ***********************************************************/
+void ClusteredLights::UploadBuffers()
+{
+	GLint viewport[4] = { 0, 0, 1, 1 };
+	CLUSTER_BLOCK clusterBlock;
+
+	if (m_buffers[POINT_LIGHT_BINDING] == 0)
+	{
+		return;
+	}
+
+	// the storage buffers are never left empty
+	UploadBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		POINT_LIGHT_BINDING,
+		m_pointLights.data(),
+		sizeof(POINT_LIGHT) * m_pointLights.size(),
+		sizeof(POINT_LIGHT) * (m_pointLights.size() + 1));
+	UploadBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		CLUSTER_RANGE_BINDING,
+		m_clusterRanges.data(),
+		sizeof(uint32_t) * m_clusterRanges.size(),
+		sizeof(uint32_t) * m_clusterRanges.size());
+	UploadBuffer(
+		GL_SHADER_STORAGE_BUFFER,
+		CLUSTER_INDEX_BINDING,
+		m_lightIndices.data(),
+		sizeof(uint32_t) * m_lightIndices.size(),
+		sizeof(uint32_t) * (m_lightIndices.size() + 1));
+
+	// the fragment shader finds its cluster from the window
+	// position and the view depth
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float depthScale = GRID_SIZE_Z / logf(m_farDepth / m_nearDepth);
+
+	clusterBlock.gridSize[0] = GRID_SIZE_X;
+	clusterBlock.gridSize[1] = GRID_SIZE_Y;
+	clusterBlock.gridSize[2] = GRID_SIZE_Z;
+	clusterBlock.gridSize[3] = (uint32_t)m_pointLights.size();
+	clusterBlock.depthParams[0] = m_nearDepth;
+	clusterBlock.depthParams[1] = m_farDepth;
+	clusterBlock.depthParams[2] = depthScale;
+	clusterBlock.depthParams[3] = depthScale * logf(m_nearDepth);
+	clusterBlock.screenSize[0] = (float)viewport[0];
+	clusterBlock.screenSize[1] = (float)viewport[1];
+	clusterBlock.screenSize[2] = (float)viewport[2];
+	clusterBlock.screenSize[3] = (float)viewport[3];
+
+	UploadBuffer(GL_UNIFORM_BUFFER, CLUSTER_BLOCK_BINDING, &clusterBlock, sizeof(clusterBlock), sizeof(clusterBlock));
+}
+
+/***********************************************************
+ *  UploadBuffer()
+ *
+ *  This method is used for uploading one buffer of the
+ *  binning results.  The data is copied into the stream
+ *  buffer when it has room, and otherwise into the buffer of
+ *  the binding point, which is bound again in case an earlier
+ *  frame bound the stream buffer there.
+ ***********************************************************/
+void ClusteredLights::UploadBuffer(GLenum target, GLuint binding, const void* pData, size_t dataSize, size_t boundSize)
+{
+	if (NULL != m_pStreamBuffer)
+	{
+		StreamBuffer::STREAM_ALLOCATION allocation =
+			m_pStreamBuffer->Allocate(boundSize, m_pStreamBuffer->GetOffsetAlignment(target));
+		if (NULL != allocation.pData)
+		{
+			if (dataSize > 0)
+			{
+				memcpy(allocation.pData, pData, dataSize);
+			}
+			glBindBufferRange(target, binding, m_pStreamBuffer->GetBuffer(), allocation.offset, allocation.size);
+			return;
+		}
+	}
+
+	glBindBuffer(target, m_buffers[binding]);
+	if (target == GL_UNIFORM_BUFFER)
+	{
+		// the cluster block keeps its fixed size storage
+		glBufferSubData(target, 0, (GLsizeiptr)dataSize, pData);
+	}
+	else
+	{
+		glBufferData(target, (GLsizeiptr)boundSize, NULL, GL_STREAM_DRAW);
+		if (dataSize > 0)
+		{
+			glBufferSubData(target, 0, (GLsizeiptr)dataSize, pData);
+		}
+	}
+	glBindBuffer(target, 0);
+	glBindBufferBase(target, binding, m_buffers[binding]);
+}
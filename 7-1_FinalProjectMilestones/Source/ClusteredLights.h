@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.h
+// ============
+// bin point lights into a view space cluster grid for forward shading
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StreamBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  ClusteredLights
+ *
+ *  This class keeps a list of point lights and bins them
+ *  into a grid of view space clusters every frame - screen
+ *  tiles split into exponentially spaced depth slices.  The
+ *  light list, the light range of each cluster and the light
+ *  indices are uploaded into shader storage buffers, so each
+ *  fragment only evaluates the lights that reach its cluster.
+ ***********************************************************/
+class ClusteredLights
+{
+public:
+	// constructor
+	ClusteredLights();
+	// destructor
+	~ClusteredLights();
+
+	// cluster grid dimensions - screen tiles and depth slices
+	static const int GRID_SIZE_X = 16;
+	static const int GRID_SIZE_Y = 9;
+	static const int GRID_SIZE_Z = 24;
+	static const int CLUSTER_COUNT = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+
+	// binding points - must match the binding layout
+	// qualifiers in the fragment shader
+	enum BUFFER_BINDING
+	{
+		POINT_LIGHT_BINDING = 0,
+		CLUSTER_RANGE_BINDING = 1,
+		CLUSTER_INDEX_BINDING = 2,
+		CLUSTER_BLOCK_BINDING = 3
+	};
+
+	// a point light - its light falls off to nothing at the radius
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		float radius;
+		glm::vec3 color;
+		float intensity;
+	};
+
+	// create the storage buffers and attach them to their
+	// binding points - needs a current OpenGL context
+	void CreateBuffers();
+
+	// manage the point lights
+	int AddPointLight(const POINT_LIGHT& light);
+	void SetPointLight(int lightIndex, const POINT_LIGHT& light);
+	void ClearPointLights();
+	int GetPointLightCount() const { return((int)m_pointLights.size()); }
+
+	// bin the point lights into the clusters of the passed in
+	// view and upload the results - called once per frame
+	void Update(const glm::mat4& view, const glm::mat4& projection);
+	// the two halves of Update() - the binning touches no
+	// OpenGL state, so it can run on a worker thread, and the
+	// upload runs on the render thread afterwards
+	void BinLights(const glm::mat4& view, const glm::mat4& projection);
+	void UploadBuffers();
+
+	// number of light indices in the clusters of the last update
+	int GetBinnedIndexCount() const { return((int)m_lightIndices.size()); }
+
+	// copy the binning results into the passed in stream buffer
+	// instead of orphaning the storage buffers each frame
+	void SetStreamBuffer(StreamBuffer* pStreamBuffer) { m_pStreamBuffer = pStreamBuffer; }
+
+private:
+	// view space bounds of a cluster
+	struct CLUSTER_BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// values of the cluster block in the fragment shader
+	struct CLUSTER_BLOCK
+	{
+		uint32_t gridSize[4];
+		float depthParams[4];
+		float screenSize[4];
+	};
+
+	// the point lights and their world space values
+	std::vector<POINT_LIGHT> m_pointLights;
+	// cluster bounds of the current projection
+	std::vector<CLUSTER_BOUNDS> m_clusterBounds;
+	glm::mat4 m_boundsProjection;
+	float m_nearDepth;
+	float m_farDepth;
+	// binning results - offset and count per cluster, and the
+	// light indices of all clusters packed one after another
+	std::vector<uint32_t> m_clusterRanges;
+	std::vector<uint32_t> m_lightIndices;
+	std::vector<uint32_t> m_clusterCounts;
+	std::vector<uint32_t> m_binnedPairs;
+	// storage buffers indexed by binding point
+	GLuint m_buffers[4];
+	// pointer to the per-frame stream buffer, or NULL
+	StreamBuffer* m_pStreamBuffer;
+
+	// rebuild the cluster bounds for a new projection
+	void BuildClusterBounds(const glm::mat4& projection);
+	// get the depth slice that holds a view depth
+	int GetDepthSlice(float viewDepth) const;
+	// upload one buffer of the binning results, keeping at least
+	// the passed in number of bytes bound
+	void UploadBuffer(GLenum target, GLuint binding, const void* pData, size_t dataSize, size_t boundSize);
+	// get the near and far depths of a projection matrix
+	static void GetDepthRange(const glm::mat4& projection, float& nearDepth, float& farDepth);
+};
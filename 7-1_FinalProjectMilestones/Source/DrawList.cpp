@@ -0,0 +1,472 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawlist.cpp
+// ============
+// retained list of draw records that make up a 3D scene - the records are
+// built once and walked every frame without rebuilding any state
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DrawList.h"
+#include "ShapeGeometry.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+// declaration of the global variables and defines
+namespace
+{
+	// fewest records in one range of a parallel loop - smaller
+	// lists are handled on the calling thread
+	const int g_RecordGrainSize = 256;
+}
+
+/***********************************************************
+ *  DrawList()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DrawList::DrawList()
+{
+	m_bAnyDirty = false;
+}
+
+/***********************************************************
+ *  ~DrawList()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DrawList::~DrawList()
+{
+	m_records.clear();
+}
+
+/***********************************************************
+ *  MakeRecord()
+ *
+ *  This method is used for creating a draw record with the
+ *  passed in mesh and transformation values.  The record
+ *  defaults to a white color with no texture or material.
+ ***********************************************************/
+DrawList::DRAW_RECORD DrawList::MakeRecord(
+	MESH_TYPE mesh,
+	unsigned int meshParts,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	DRAW_RECORD record;
+
+	record.meshID = (uint16_t)mesh;
+	record.meshParts = (uint16_t)meshParts;
+	record.scaleXYZ = scaleXYZ;
+	record.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	record.positionXYZ = positionXYZ;
+	record.model = BuildModelMatrix(record.scaleXYZ, record.rotationDegrees, record.positionXYZ);
+	record.normalMatrix = BuildNormalMatrix(record.model);
+	record.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	record.uvScale = glm::vec2(1.0f, 1.0f);
+	record.textureSlot = -1;
+	record.materialIndex = -1;
+	record.batchIndex = -1;
+	record.staticBatchIndex = -1;
+	record.shaderPermutation = 0;
+	record.bDirty = false;
+	record.bStatic = false;
+
+	return(record);
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for building the model matrix from
+ *  the passed in scale, rotation and position values.
+ ***********************************************************/
+glm::mat4 DrawList::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 scale;
+	glm::mat4 rotationX;
+	glm::mat4 rotationY;
+	glm::mat4 rotationZ;
+	glm::mat4 translation;
+
+	scale = glm::scale(scaleXYZ);
+	rotationX = glm::rotate(glm::radians(rotationDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	rotationY = glm::rotate(glm::radians(rotationDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	rotationZ = glm::rotate(glm::radians(rotationDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	translation = glm::translate(positionXYZ);
+
+	return(translation * rotationZ * rotationY * rotationX * scale);
+}
+
+/***********************************************************
+ *  BuildNormalMatrix()
+ *
+ *  This method is used for building the normal matrix of a
+ *  model matrix - the inverse transpose of its upper 3x3, so
+ *  the normals stay perpendicular to non-uniformly scaled
+ *  surfaces.  It is built once per transform change instead
+ *  of once per vertex.
+ ***********************************************************/
+glm::mat3 DrawList::BuildNormalMatrix(
+	const glm::mat4& model)
+{
+	return(glm::transpose(glm::inverse(glm::mat3(model))));
+}
+
+/***********************************************************
+ *  AddRecord()
+ *
+ *  This method is used for appending a draw record to the
+ *  list.  The index of the new record is returned.
+ ***********************************************************/
+int DrawList::AddRecord(const DRAW_RECORD& record)
+{
+	m_records.push_back(record);
+	m_sphereX.push_back(0.0f);
+	m_sphereY.push_back(0.0f);
+	m_sphereZ.push_back(0.0f);
+	m_sphereRadius.push_back(0.0f);
+	m_visible.push_back(1);
+	if (record.bDirty == true)
+	{
+		m_bAnyDirty = true;
+	}
+	else
+	{
+		UpdateBounds((int)m_records.size() - 1);
+	}
+
+	return((int)m_records.size() - 1);
+}
+
+/***********************************************************
+ *  SetTransform()
+ *
+ *  This method is used for changing the transformation
+ *  values of a record.  The model matrix is rebuilt on the
+ *  next call to UpdateTransforms().
+ ***********************************************************/
+void DrawList::SetTransform(
+	int index,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((index < 0) || (index >= (int)m_records.size()))
+	{
+		return;
+	}
+
+	DRAW_RECORD& record = m_records[index];
+	record.scaleXYZ = scaleXYZ;
+	record.rotationDegrees = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	record.positionXYZ = positionXYZ;
+	record.bDirty = true;
+	m_bAnyDirty = true;
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for flagging a record so that its
+ *  model matrix gets rebuilt on the next update.
+ ***********************************************************/
+void DrawList::MarkDirty(int index)
+{
+	if ((index < 0) || (index >= (int)m_records.size()))
+	{
+		return;
+	}
+
+	m_records[index].bDirty = true;
+	m_bAnyDirty = true;
+}
+
+/***********************************************************
+ *  UpdateTransforms()
+ *
+ *  This method is used for rebuilding the cached model
+ *  matrix of every record that has been marked dirty.  The
+ *  records are rebuilt in parallel ranges, and the dirty
+ *  flags are only cleared afterwards, so the changed records
+ *  are listed in order on the calling thread.
+ ***********************************************************/
+void DrawList::UpdateTransforms(JobSystem* pJobSystem)
+{
+	m_changedRecords.clear();
+
+	// nothing to do when no record has changed
+	if (m_bAnyDirty == false)
+	{
+		return;
+	}
+
+	JobSystem::RANGE_FUNCTION rebuildRange = [this](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			DRAW_RECORD& record = m_records[i];
+			if (record.bDirty == true)
+			{
+				record.model = BuildModelMatrix(record.scaleXYZ, record.rotationDegrees, record.positionXYZ);
+				record.normalMatrix = BuildNormalMatrix(record.model);
+				UpdateBounds(i);
+			}
+		}
+	};
+
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor((int)m_records.size(), g_RecordGrainSize, rebuildRange);
+	}
+	else
+	{
+		rebuildRange(0, (int)m_records.size());
+	}
+
+	for (size_t i = 0; i < m_records.size(); i++)
+	{
+		if (m_records[i].bDirty == true)
+		{
+			m_records[i].bDirty = false;
+			m_changedRecords.push_back((int)i);
+		}
+	}
+
+	m_bAnyDirty = false;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the records.
+ ***********************************************************/
+void DrawList::Clear()
+{
+	m_records.clear();
+	m_sphereX.clear();
+	m_sphereY.clear();
+	m_sphereZ.clear();
+	m_sphereRadius.clear();
+	m_visible.clear();
+	m_changedRecords.clear();
+	m_bAnyDirty = false;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for making room for a known number of
+ *  records in the record and bounds arrays.
+ ***********************************************************/
+void DrawList::Reserve(int recordCount)
+{
+	m_records.reserve(recordCount);
+	m_sphereX.reserve(recordCount);
+	m_sphereY.reserve(recordCount);
+	m_sphereZ.reserve(recordCount);
+	m_sphereRadius.reserve(recordCount);
+	m_visible.reserve(recordCount);
+}
+
+/***********************************************************
+ *  UpdateBounds()
+ *
+ *  This method is used for transforming the local bounds of
+ *  a record's mesh into world space.  The world box encloses
+ *  the transformed local box, and the bounding sphere grows
+ *  with the largest axis scale of the model matrix.
+ ***********************************************************/
+void DrawList::UpdateBounds(int index)
+{
+	DRAW_RECORD& record = m_records[index];
+	ShapeGeometry::BOUNDS localBounds;
+
+	switch (record.meshID)
+	{
+	case MESH_PLANE:
+		localBounds = ShapeGeometry::GetPlaneBounds();
+		break;
+	case MESH_BOX:
+		localBounds = ShapeGeometry::GetBoxBounds();
+		break;
+	case MESH_CONE:
+		localBounds = ShapeGeometry::GetConeBounds();
+		break;
+	case MESH_CYLINDER:
+		localBounds = ShapeGeometry::GetCylinderBounds();
+		break;
+	default:
+		localBounds = ShapeGeometry::GetSphereBounds();
+		break;
+	}
+
+	glm::vec3 localCenter = (localBounds.minimum + localBounds.maximum) * 0.5f;
+	glm::vec3 localExtent = (localBounds.maximum - localBounds.minimum) * 0.5f;
+	glm::vec3 worldCenter = glm::vec3(record.model * glm::vec4(localCenter, 1.0f));
+	glm::vec3 worldExtent = glm::vec3(0.0f);
+	float largestScale = 0.0f;
+
+	// each world axis extent sums the absolute contributions
+	// of the three rotated and scaled local axes
+	for (int column = 0; column < 3; column++)
+	{
+		glm::vec3 axis = glm::vec3(record.model[column]);
+		worldExtent += glm::abs(axis) * localExtent[column];
+		largestScale = glm::max(largestScale, glm::length(axis));
+	}
+
+	record.boundsMinimum = worldCenter - worldExtent;
+	record.boundsMaximum = worldCenter + worldExtent;
+
+	m_sphereX[index] = worldCenter.x;
+	m_sphereY[index] = worldCenter.y;
+	m_sphereZ[index] = worldCenter.z;
+	m_sphereRadius[index] = glm::length(localExtent) * largestScale;
+}
+
+/***********************************************************
+ *  ExtractFrustumPlanes()
+ *
+ *  This method is used for getting the frustum planes from
+ *  the rows of a view projection matrix.  Each plane is
+ *  normalized, so its distance to a point is in world units.
+ ***********************************************************/
+void DrawList::ExtractFrustumPlanes(
+	const glm::mat4& viewProjection,
+	glm::vec4 planes[6])
+{
+	glm::vec4 rows[4];
+
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	planes[0] = rows[3] + rows[0];   // left
+	planes[1] = rows[3] - rows[0];   // right
+	planes[2] = rows[3] + rows[1];   // bottom
+	planes[3] = rows[3] - rows[1];   // top
+	planes[4] = rows[3] + rows[2];   // near
+	planes[5] = rows[3] - rows[2];   // far
+
+	for (int i = 0; i < 6; i++)
+	{
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+/***********************************************************
+ *  CullRecords()
+ *
+ *  This method is used for testing the bounding sphere of
+ *  every record against the frustum planes.  The planes are
+ *  walked in the outer loop so the inner loop runs over the
+ *  sphere arrays without branches, which lets the compiler
+ *  vectorize it.  Large lists are tested in parallel ranges.
+ ***********************************************************/
+int DrawList::CullRecords(const glm::mat4& viewProjection, JobSystem* pJobSystem)
+{
+	glm::vec4 planes[6];
+	const int recordCount = (int)m_records.size();
+
+	ExtractFrustumPlanes(viewProjection, planes);
+
+	if (NULL == pJobSystem)
+	{
+		return(CullRange(planes, 0, recordCount));
+	}
+
+	std::atomic<int> visibleCount(0);
+	pJobSystem->ParallelFor(recordCount, g_RecordGrainSize, [this, &planes, &visibleCount](int first, int last)
+	{
+		visibleCount.fetch_add(CullRange(planes, first, last));
+	});
+
+	return(visibleCount.load());
+}
+
+/***********************************************************
+ *  CullRange()
+ *
+ *  This method is used for testing the bounding spheres of
+ *  a range of records against the frustum planes.
+ ***********************************************************/
+int DrawList::CullRange(const glm::vec4 planes[6], int first, int last)
+{
+	const int recordCount = last - first;
+	int visibleCount = 0;
+
+	const float* pX = m_sphereX.data() + first;
+	const float* pY = m_sphereY.data() + first;
+	const float* pZ = m_sphereZ.data() + first;
+	const float* pRadius = m_sphereRadius.data() + first;
+	uint8_t* pVisible = m_visible.data() + first;
+
+	for (int i = 0; i < recordCount; i++)
+	{
+		pVisible[i] = 1;
+	}
+
+	for (int plane = 0; plane < 6; plane++)
+	{
+		const float planeX = planes[plane].x;
+		const float planeY = planes[plane].y;
+		const float planeZ = planes[plane].z;
+		const float planeW = planes[plane].w;
+
+		for (int i = 0; i < recordCount; i++)
+		{
+			float distance = (planeX * pX[i]) + (planeY * pY[i]) + (planeZ * pZ[i]) + planeW;
+			pVisible[i] &= (uint8_t)(distance >= -pRadius[i]);
+		}
+	}
+
+	for (int i = 0; i < recordCount; i++)
+	{
+		visibleCount += pVisible[i];
+	}
+
+	return(visibleCount);
+}
+
+
+/***********************************************************
+ *  SetVisibleRecords()
+ *
+ *  This method is used for replacing the results of the last
+ *  frustum test with a list of visible record indices.
+ ***********************************************************/
+void DrawList::SetVisibleRecords(const std::vector<int>& visibleRecords)
+{
+	std::fill(m_visible.begin(), m_visible.end(), (uint8_t)0);
+
+	for (size_t i = 0; i < visibleRecords.size(); i++)
+	{
+		m_visible[visibleRecords[i]] = 1;
+	}
+}
+
+/***********************************************************
+ *  SetAllVisible()
+ *
+ *  This method is used for marking every record as visible
+ *  without testing it.
+ ***********************************************************/
+void DrawList::SetAllVisible()
+{
+	std::fill(m_visible.begin(), m_visible.end(), (uint8_t)1);
+}
\ No newline at end of file
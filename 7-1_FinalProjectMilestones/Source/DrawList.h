@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// drawlist.h
+// ============
+// retained list of draw records that make up a 3D scene - the records are
+// built once and walked every frame without rebuilding any state
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  DrawList
+ *
+ *  This class holds a flat, contiguous array of draw records.
+ *  Each record caches its model matrix, which is only rebuilt
+ *  when the record has been marked dirty.  The world space
+ *  bounding spheres of the records are also kept in separate
+ *  arrays (structure of arrays), so the frustum test runs as
+ *  straight loops over plain floats.
+ ***********************************************************/
+class DrawList
+{
+public:
+	// constructor
+	DrawList();
+	// destructor
+	~DrawList();
+
+	// basic mesh shapes that a draw record can reference
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_SPHERE,
+		MESH_TYPE_COUNT
+	};
+
+	// mesh parts that are drawn for cones and cylinders
+	enum MESH_PART
+	{
+		PART_TOP = 0x01,
+		PART_BOTTOM = 0x02,
+		PART_SIDES = 0x04,
+		PART_ALL = PART_TOP | PART_BOTTOM | PART_SIDES
+	};
+
+	struct DRAW_RECORD
+	{
+		// cached model matrix and the inverse transpose of its
+		// upper 3x3 for the normals - valid when bDirty is false
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		glm::vec4 color;
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec2 uvScale;
+		// texture slot, or -1 to draw with the solid color
+		int textureSlot;
+		// index into the defined materials, or -1 for none
+		int materialIndex;
+		// instance batch that draws the record, or -1 when
+		// the record is drawn on its own
+		int batchIndex;
+		// static batch that the record is baked into, or -1
+		int staticBatchIndex;
+		// world space bounds - kept up to date with the model matrix
+		glm::vec3 boundsMinimum;
+		glm::vec3 boundsMaximum;
+		uint16_t meshID;
+		uint16_t meshParts;
+		// shader permutation that draws the record - set by the
+		// scene from its texture and lighting
+		uint16_t shaderPermutation;
+		bool bDirty;
+		// true when the record never moves once the scene is
+		// prepared, so its mesh can be baked into world space
+		bool bStatic;
+	};
+
+	// create a record with default color, texture and material values
+	static DRAW_RECORD MakeRecord(
+		MESH_TYPE mesh,
+		unsigned int meshParts,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// build a model matrix from the passed in transformation values
+	static glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// build the matrix that moves the normals of a model
+	// matrix into world space
+	static glm::mat3 BuildNormalMatrix(
+		const glm::mat4& model);
+
+	// get the six frustum planes of a view projection matrix,
+	// with the normals facing into the frustum
+	static void ExtractFrustumPlanes(
+		const glm::mat4& viewProjection,
+		glm::vec4 planes[6]);
+
+	// add a record to the end of the list and return its index
+	int AddRecord(const DRAW_RECORD& record);
+	// change the transformation values of a record and mark it dirty
+	void SetTransform(
+		int index,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// mark a record so its model matrix is rebuilt on the next update
+	void MarkDirty(int index);
+	// rebuild the cached model matrix of every dirty record,
+	// spread over the job system unless it is NULL
+	void UpdateTransforms(JobSystem* pJobSystem = NULL);
+	// records whose transforms were rebuilt by the last update
+	const std::vector<int>& GetChangedRecords() const { return(m_changedRecords); }
+	// test the record bounds against the frustum of the passed
+	// in view projection matrix, spread over the job system
+	// unless it is NULL - returns the visible count
+	int CullRecords(const glm::mat4& viewProjection, JobSystem* pJobSystem = NULL);
+	// mark only the passed in records as visible, such as the
+	// results of a spatial index query
+	void SetVisibleRecords(const std::vector<int>& visibleRecords);
+	// mark every record as visible, such as when culling is off
+	void SetAllVisible();
+	// true when the record passed the last frustum test
+	bool IsVisible(int index) const { return(m_visible[index] != 0); }
+	// remove all records from the list
+	void Clear();
+	// make room for the passed in number of records, so adding
+	// them does not grow the arrays one record at a time
+	void Reserve(int recordCount);
+
+	int GetRecordCount() const { return((int)m_records.size()); }
+	DRAW_RECORD& GetRecord(int index) { return(m_records[index]); }
+	const DRAW_RECORD& GetRecord(int index) const { return(m_records[index]); }
+	const DRAW_RECORD* GetRecords() const { return(m_records.data()); }
+
+private:
+	// contiguous array of draw records
+	std::vector<DRAW_RECORD> m_records;
+	// world space bounding spheres indexed like the records
+	std::vector<float> m_sphereX;
+	std::vector<float> m_sphereY;
+	std::vector<float> m_sphereZ;
+	std::vector<float> m_sphereRadius;
+	// results of the last frustum test
+	std::vector<uint8_t> m_visible;
+	// records rebuilt by the last transform update
+	std::vector<int> m_changedRecords;
+	// true when at least one record is dirty
+	bool m_bAnyDirty;
+
+	// rebuild the world space bounds of a record from its model matrix
+	void UpdateBounds(int index);
+	// test the bounds of a range of records against the planes -
+	// returns the visible count of the range
+	int CullRange(const glm::vec4 planes[6], int first, int last);
+};
@@ -0,0 +1,315 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// pace the frame loop - swap interval, frame rate limit, frames in flight and
+// the fixed timestep of the view updates
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// declaration of the global variables and defines
+namespace
+{
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000;
+	// the most time one frame adds to the due updates, so a
+	// long stall does not leave more updates than can be caught up
+	const double g_MaxFrameDelta = 0.25;
+	// first guess of how long a one millisecond sleep takes
+	const double g_InitialSleepEstimate = 0.002;
+	// how quickly the sleep estimate falls back after a late wake
+	const double g_SleepEstimateDecay = 0.99;
+	// view updates per second until another rate is set
+	const int g_DefaultUpdateRate = 120;
+	// frames in flight until another count is set
+	const int g_DefaultFramesInFlight = 2;
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_frameTime = 0.0;
+	m_frameStart = 0.0;
+	m_sleepEstimate = g_InitialSleepEstimate;
+	m_timeStep = 1.0 / g_DefaultUpdateRate;
+	m_lastTime = -1.0;
+	m_accumulator = 0.0;
+	m_fences.resize(g_DefaultFramesInFlight, NULL);
+	m_fenceIndex = 0;
+	m_stallCount = 0;
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+	ClearFences();
+}
+
+/***********************************************************
+ *  SetSwapMode()
+ *
+ *  This method is used for setting how the swaps of the
+ *  current context wait for the display.  The adaptive mode
+ *  falls back to vsync when the swap control tear extension
+ *  is not available.
+ ***********************************************************/
+void FramePacer::SetSwapMode(SWAP_MODE swapMode)
+{
+	switch (swapMode)
+	{
+	case SWAP_ADAPTIVE:
+		if ((glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_TRUE) ||
+			(glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_TRUE))
+		{
+			glfwSwapInterval(-1);
+		}
+		else
+		{
+			std::cout << "Adaptive vsync is not supported - using vsync" << std::endl;
+			glfwSwapInterval(1);
+		}
+		break;
+	case SWAP_UNCAPPED:
+		glfwSwapInterval(0);
+		break;
+	default:
+		glfwSwapInterval(1);
+		break;
+	}
+}
+
+/***********************************************************
+ *  SetFrameLimit()
+ *
+ *  This method is used for setting the most frames per
+ *  second that the loop runs at.
+ ***********************************************************/
+void FramePacer::SetFrameLimit(int framesPerSecond)
+{
+	m_frameTime = (framesPerSecond > 0) ? (1.0 / framesPerSecond) : 0.0;
+}
+
+/***********************************************************
+ *  SetFramesInFlight()
+ *
+ *  This method is used for setting how many frames the CPU
+ *  may have queued before it waits for the GPU.  One frame
+ *  gives the least latency, while more frames keep the GPU
+ *  busy when the frame times vary.
+ ***********************************************************/
+void FramePacer::SetFramesInFlight(int frameCount)
+{
+	if (frameCount > MAX_FRAMES_IN_FLIGHT)
+	{
+		frameCount = MAX_FRAMES_IN_FLIGHT;
+	}
+	if (frameCount < 0)
+	{
+		frameCount = 0;
+	}
+
+	ClearFences();
+	m_fences.resize(frameCount, NULL);
+	m_fenceIndex = 0;
+}
+
+/***********************************************************
+ *  SetUpdateRate()
+ *
+ *  This method is used for setting how many view updates
+ *  run per second of time.
+ ***********************************************************/
+void FramePacer::SetUpdateRate(int updatesPerSecond)
+{
+	if (updatesPerSecond > 0)
+	{
+		m_timeStep = 1.0 / updatesPerSecond;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for waiting until the next frame may
+ *  start, first for the GPU and then for the frame rate
+ *  limit, and adding the time since the last frame to the
+ *  time that is due to be updated.
+ ***********************************************************/
+void FramePacer::BeginFrame()
+{
+	WaitForFrameFence();
+	WaitForFrameTime();
+
+	double currentTime = glfwGetTime();
+	m_frameStart = currentTime;
+	if (m_lastTime < 0.0)
+	{
+		m_lastTime = currentTime;
+	}
+
+	double frameDelta = currentTime - m_lastTime;
+	if (frameDelta > g_MaxFrameDelta)
+	{
+		frameDelta = g_MaxFrameDelta;
+	}
+	m_accumulator += frameDelta;
+	m_lastTime = currentTime;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence of the frame
+ *  after its last command, such as the swap.
+ ***********************************************************/
+void FramePacer::EndFrame()
+{
+	if (m_fences.size() == 0)
+	{
+		return;
+	}
+
+	if (NULL != m_fences[m_fenceIndex])
+	{
+		glDeleteSync(m_fences[m_fenceIndex]);
+	}
+	m_fences[m_fenceIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_fenceIndex = (m_fenceIndex + 1) % (int)m_fences.size();
+}
+
+/***********************************************************
+ *  TakeUpdateStep()
+ *
+ *  This method is used for taking one fixed step of the due
+ *  time.  The time that is left over is the interpolation of
+ *  the frame.
+ ***********************************************************/
+bool FramePacer::TakeUpdateStep()
+{
+	if (m_accumulator < m_timeStep)
+	{
+		return(false);
+	}
+
+	m_accumulator -= m_timeStep;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ResetUpdates()
+ *
+ *  This method is used for dropping the due time, so the
+ *  next frame starts the updates over.
+ ***********************************************************/
+void FramePacer::ResetUpdates()
+{
+	m_lastTime = -1.0;
+	m_accumulator = 0.0;
+}
+
+/***********************************************************
+ *  WaitForFrameFence()
+ *
+ *  This method is used for waiting until the GPU has passed
+ *  the fence of the frame that is the most frames in flight
+ *  back.  The fence in the next slot is always the oldest.
+ ***********************************************************/
+void FramePacer::WaitForFrameFence()
+{
+	if (m_fences.size() == 0)
+	{
+		return;
+	}
+
+	GLsync fence = m_fences[m_fenceIndex];
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	GLenum waitResult = glClientWaitSync(fence, 0, 0);
+	if (waitResult == GL_TIMEOUT_EXPIRED)
+	{
+		m_stallCount++;
+		do
+		{
+			waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+		} while (waitResult == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	m_fences[m_fenceIndex] = NULL;
+}
+
+/***********************************************************
+ *  WaitForFrameTime()
+ *
+ *  This method is used for holding the loop until a frame
+ *  time has passed since the last frame started.  It sleeps
+ *  in short slices for as long as a sleep is sure to wake up
+ *  in time, and spins for the rest.  The length of the
+ *  slices is measured as it goes, so the spin stays short on
+ *  systems with a fine timer.
+ ***********************************************************/
+void FramePacer::WaitForFrameTime()
+{
+	if (m_frameTime <= 0.0)
+	{
+		return;
+	}
+
+	double deadline = m_frameStart + m_frameTime;
+	double currentTime = glfwGetTime();
+
+	while (deadline - currentTime > m_sleepEstimate)
+	{
+		double sleepStart = currentTime;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		currentTime = glfwGetTime();
+
+		// the estimate follows the longest recent sleep
+		double slept = currentTime - sleepStart;
+		m_sleepEstimate *= g_SleepEstimateDecay;
+		if (slept > m_sleepEstimate)
+		{
+			m_sleepEstimate = slept;
+		}
+	}
+
+	while (currentTime < deadline)
+	{
+		std::this_thread::yield();
+		currentTime = glfwGetTime();
+	}
+}
+
+/***********************************************************
+ *  ClearFences()
+ *
+ *  This method is used for deleting every fence of the
+ *  frames in flight.
+ ***********************************************************/
+void FramePacer::ClearFences()
+{
+	for (size_t i = 0; i < m_fences.size(); i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// pace the frame loop - swap interval, frame rate limit, frames in flight and
+// the fixed timestep of the view updates
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include "GLFW/glfw3.h"
+
+#include <vector>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class decides when a frame starts and how far the
+ *  view updates advance.  The updates run at a fixed rate no
+ *  matter how fast frames are drawn, and each frame draws
+ *  the view part of the way from the last update to the next
+ *  one.  Before a frame starts, the pacer waits until the
+ *  GPU has finished the frame that is the most frames in
+ *  flight back, so the CPU never runs so far ahead that the
+ *  input it samples is shown late, and then until the frame
+ *  rate limit allows the next frame - sleeping for most of
+ *  the wait and spinning for the rest, since sleeps wake up
+ *  late.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// how the swap waits for the display
+	enum SWAP_MODE
+	{
+		// every swap waits for the vertical blank
+		SWAP_VSYNC = 0,
+		// late swaps tear instead of waiting for the next blank,
+		// where the driver supports it
+		SWAP_ADAPTIVE,
+		// the swaps never wait
+		SWAP_UNCAPPED
+	};
+
+	// the most frames in flight that can be set
+	static const int MAX_FRAMES_IN_FLIGHT = 4;
+
+	// set the swap interval of the current context
+	void SetSwapMode(SWAP_MODE swapMode);
+	// frames per second the loop is held to, or 0 for no limit
+	void SetFrameLimit(int framesPerSecond);
+	// frames the CPU may queue ahead of the GPU, or 0 for no limit
+	void SetFramesInFlight(int frameCount);
+	// view updates per second
+	void SetUpdateRate(int updatesPerSecond);
+
+	// wait until the next frame may start and add the time
+	// that has passed to the updates that are due
+	void BeginFrame();
+	// place the fence of the frame after its last command
+	void EndFrame();
+	// take one due view update - call until it returns false
+	bool TakeUpdateStep();
+	// forget the due updates, such as after a long load
+	void ResetUpdates();
+
+	// seconds that one view update advances
+	float GetTimeStep() const { return((float)m_timeStep); }
+	// how far the frame is between the last two updates
+	float GetInterpolation() const { return((float)(m_accumulator / m_timeStep)); }
+	// waits on the fences that took longer than no time
+	int GetStallCount() const { return(m_stallCount); }
+
+private:
+	// seconds of the frame rate limit, or 0 for no limit
+	double m_frameTime;
+	// start time of the last frame
+	double m_frameStart;
+	// longest recent sleep of one millisecond, which is how
+	// early the limiter stops sleeping and starts spinning
+	double m_sleepEstimate;
+	// seconds of one view update
+	double m_timeStep;
+	// time of the last BeginFrame() call
+	double m_lastTime;
+	// time that has passed but has not been updated yet
+	double m_accumulator;
+	// fences of the frames in flight, oldest at the index
+	std::vector<GLsync> m_fences;
+	int m_fenceIndex;
+	int m_stallCount;
+
+	// wait for the fence of the oldest frame in flight
+	void WaitForFrameFence();
+	// hold the loop to the frame rate limit
+	void WaitForFrameTime();
+	// delete every fence
+	void ClearFences();
+};
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+// gbuffer.cpp
+// ============
+// surface attributes of the opaque objects for the deferred lighting pass
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GBuffer.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  GBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GBuffer::GBuffer(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_geometryFramebuffer = 0;
+	m_lightingFramebuffer = 0;
+	m_forwardFramebuffer = 0;
+	for (int i = 0; i < TARGET_COUNT; i++)
+	{
+		m_textures[i] = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+	m_viewport[0] = 0;
+	m_viewport[1] = 0;
+	m_viewport[2] = 0;
+	m_viewport[3] = 0;
+	m_targetFramebuffer = 0;
+}
+
+/***********************************************************
+ *  ~GBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GBuffer::~GBuffer()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffers and the
+ *  target textures.
+ ***********************************************************/
+void GBuffer::Destroy()
+{
+	if (m_geometryFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_geometryFramebuffer);
+		glDeleteFramebuffers(1, &m_lightingFramebuffer);
+		glDeleteFramebuffers(1, &m_forwardFramebuffer);
+	}
+
+	for (int i = 0; i < TARGET_COUNT; i++)
+	{
+		if (m_textures[i] != 0)
+		{
+			m_pStateCache->ForgetTexture(m_textures[i]);
+			glDeleteTextures(1, &m_textures[i]);
+		}
+		m_textures[i] = 0;
+	}
+
+	m_geometryFramebuffer = 0;
+	m_lightingFramebuffer = 0;
+	m_forwardFramebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bComplete = false;
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for creating one target texture at
+ *  the current size.  The targets are read with texel
+ *  fetches, so they have a single level and no filtering.
+ ***********************************************************/
+GLuint GBuffer::CreateTarget(GLenum format)
+{
+	GLuint textureID = 0;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+	glTextureStorage2D(textureID, 1, format, m_width, m_height);
+	glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for creating the targets at the size
+ *  of the viewport.  The material target holds the material
+ *  index plus one, with zero for pixels that are not lit.
+ ***********************************************************/
+void GBuffer::Resize(int width, int height)
+{
+	const GLenum geometryBuffers[3] =
+	{
+		GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2
+	};
+
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+	m_textures[TARGET_ALBEDO] = CreateTarget(GL_RGBA8);
+	m_textures[TARGET_NORMAL] = CreateTarget(GL_RGBA16F);
+	m_textures[TARGET_MATERIAL] = CreateTarget(GL_R16UI);
+	m_textures[TARGET_DEPTH] = CreateTarget(GL_DEPTH_COMPONENT32F);
+	m_textures[TARGET_LIGHTING] = CreateTarget(GL_RGBA8);
+
+	glCreateFramebuffers(1, &m_geometryFramebuffer);
+	glNamedFramebufferTexture(m_geometryFramebuffer, GL_COLOR_ATTACHMENT0, m_textures[TARGET_ALBEDO], 0);
+	glNamedFramebufferTexture(m_geometryFramebuffer, GL_COLOR_ATTACHMENT1, m_textures[TARGET_NORMAL], 0);
+	glNamedFramebufferTexture(m_geometryFramebuffer, GL_COLOR_ATTACHMENT2, m_textures[TARGET_MATERIAL], 0);
+	glNamedFramebufferTexture(m_geometryFramebuffer, GL_DEPTH_ATTACHMENT, m_textures[TARGET_DEPTH], 0);
+	glNamedFramebufferDrawBuffers(m_geometryFramebuffer, 3, geometryBuffers);
+
+	// the lighting pass samples the depth, so the depth must
+	// not be attached while it draws
+	glCreateFramebuffers(1, &m_lightingFramebuffer);
+	glNamedFramebufferTexture(m_lightingFramebuffer, GL_COLOR_ATTACHMENT0, m_textures[TARGET_LIGHTING], 0);
+	glNamedFramebufferDrawBuffer(m_lightingFramebuffer, GL_COLOR_ATTACHMENT0);
+	glNamedFramebufferReadBuffer(m_lightingFramebuffer, GL_COLOR_ATTACHMENT0);
+
+	// the transparent items are depth tested against the
+	// opaque surfaces of the geometry pass
+	glCreateFramebuffers(1, &m_forwardFramebuffer);
+	glNamedFramebufferTexture(m_forwardFramebuffer, GL_COLOR_ATTACHMENT0, m_textures[TARGET_LIGHTING], 0);
+	glNamedFramebufferTexture(m_forwardFramebuffer, GL_DEPTH_ATTACHMENT, m_textures[TARGET_DEPTH], 0);
+	glNamedFramebufferDrawBuffer(m_forwardFramebuffer, GL_COLOR_ATTACHMENT0);
+
+	m_bComplete =
+		(glCheckNamedFramebufferStatus(m_geometryFramebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) &&
+		(glCheckNamedFramebufferStatus(m_lightingFramebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) &&
+		(glCheckNamedFramebufferStatus(m_forwardFramebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	if (m_bComplete == false)
+	{
+		std::cout << "The deferred shading framebuffers are not complete" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for binding the geometry targets and
+ *  clearing them.  The cleared albedo matches the window
+ *  clear color, so the pixels that no surface covers keep
+ *  the background.
+ ***********************************************************/
+bool GBuffer::BeginGeometryPass()
+{
+	const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const GLfloat clearNormal[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLuint clearMaterial[4] = { 0, 0, 0, 0 };
+	const GLfloat clearDepth = 1.0f;
+
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+	if ((m_viewport[2] != m_width) || (m_viewport[3] != m_height))
+	{
+		Resize(m_viewport[2], m_viewport[3]);
+	}
+
+	if (m_bComplete == false)
+	{
+		return(false);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_geometryFramebuffer);
+	glViewport(0, 0, m_width, m_height);
+	glClearNamedFramebufferfv(m_geometryFramebuffer, GL_COLOR, 0, clearColor);
+	glClearNamedFramebufferfv(m_geometryFramebuffer, GL_COLOR, 1, clearNormal);
+	glClearNamedFramebufferuiv(m_geometryFramebuffer, GL_COLOR, 2, clearMaterial);
+	glClearNamedFramebufferfv(m_geometryFramebuffer, GL_DEPTH, 0, &clearDepth);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginLightingPass()
+ *
+ *  This method is used for binding the lighting target and
+ *  the geometry textures that the lighting pass reads.  The
+ *  lighting target has no depth attached, so the depth
+ *  texture can be read without a feedback loop.
+ ***********************************************************/
+void GBuffer::BeginLightingPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_lightingFramebuffer);
+
+	m_pStateCache->BindTexture(ALBEDO_TEXTURE_UNIT, GL_TEXTURE_2D, m_textures[TARGET_ALBEDO]);
+	m_pStateCache->BindTexture(NORMAL_TEXTURE_UNIT, GL_TEXTURE_2D, m_textures[TARGET_NORMAL]);
+	m_pStateCache->BindTexture(MATERIAL_TEXTURE_UNIT, GL_TEXTURE_2D, m_textures[TARGET_MATERIAL]);
+	m_pStateCache->BindTexture(DEPTH_TEXTURE_UNIT, GL_TEXTURE_2D, m_textures[TARGET_DEPTH]);
+}
+
+/***********************************************************
+ *  BeginForwardPass()
+ *
+ *  This method is used for binding the lighting target with
+ *  the geometry depth attached, so the transparent items are
+ *  blended over the lit color behind the opaque surfaces.
+ *  The depth texture is unbound first, since it can not be
+ *  read while it is attached.
+ ***********************************************************/
+void GBuffer::BeginForwardPass()
+{
+	m_pStateCache->BindTexture(DEPTH_TEXTURE_UNIT, GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_forwardFramebuffer);
+}
+
+/***********************************************************
+ *  EndLightingPass()
+ *
+ *  This method is used for copying the lit color into the
+ *  framebuffer that was bound before the geometry pass, such
+ *  as the window, and binding it again.
+ ***********************************************************/
+void GBuffer::EndLightingPass()
+{
+	glBlitNamedFramebuffer(
+		m_lightingFramebuffer, (GLuint)m_targetFramebuffer,
+		0, 0, m_width, m_height,
+		m_viewport[0], m_viewport[1], m_viewport[0] + m_width, m_viewport[1] + m_height,
+		GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_targetFramebuffer);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// gbuffer.h
+// ============
+// surface attributes of the opaque objects for the deferred lighting pass
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StateCache.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GBuffer
+ *
+ *  This class owns the render targets of the deferred mode.
+ *  The geometry pass writes the unlit color, the normal and
+ *  the material of the nearest opaque surface of each pixel,
+ *  so the lighting pass shades every pixel once no matter how
+ *  many surfaces were drawn over it.  The lighting pass reads
+ *  the geometry depth, so it draws into a framebuffer that
+ *  holds only the lit color.  The transparent items are then
+ *  drawn over the lit color through a second framebuffer that
+ *  adds the geometry depth, and the lit color is copied to
+ *  the window.  The targets follow the size of the viewport.
+ ***********************************************************/
+class GBuffer
+{
+public:
+	// constructor
+	GBuffer(StateCache* pStateCache);
+	// destructor
+	~GBuffer();
+
+	// texture units that the lighting pass reads the targets
+	// from - below the units used by the occlusion pyramid and
+	// the uploads
+	enum TEXTURE_UNIT
+	{
+		ALBEDO_TEXTURE_UNIT = 26,
+		NORMAL_TEXTURE_UNIT = 27,
+		MATERIAL_TEXTURE_UNIT = 28,
+		DEPTH_TEXTURE_UNIT = 29
+	};
+
+	// bind and clear the geometry targets - returns false when
+	// the targets cannot be drawn into
+	bool BeginGeometryPass();
+	// bind the lighting target and the geometry textures
+	void BeginLightingPass();
+	// bind the lighting target with the geometry depth for the
+	// transparent items
+	void BeginForwardPass();
+	// copy the lit color to the window framebuffer
+	void EndLightingPass();
+	// free the framebuffers and textures
+	void Destroy();
+
+	bool IsComplete() const { return(m_bComplete); }
+
+private:
+	// render target textures
+	enum TARGET
+	{
+		TARGET_ALBEDO = 0,
+		TARGET_NORMAL,
+		TARGET_MATERIAL,
+		TARGET_DEPTH,
+		TARGET_LIGHTING,
+		TARGET_COUNT
+	};
+
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// geometry pass and lighting pass framebuffers, and the
+	// framebuffer of the transparent items that adds the depth
+	GLuint m_geometryFramebuffer;
+	GLuint m_lightingFramebuffer;
+	GLuint m_forwardFramebuffer;
+	GLuint m_textures[TARGET_COUNT];
+	int m_width;
+	int m_height;
+	// true when every framebuffer can be drawn into
+	bool m_bComplete;
+	// window viewport that the targets are sized to, and the
+	// framebuffer that the lit color is copied into
+	GLint m_viewport[4];
+	GLint m_targetFramebuffer;
+
+	// create the targets at the passed in size
+	void Resize(int width, int height);
+	// create one target texture
+	GLuint CreateTarget(GLenum format);
+};
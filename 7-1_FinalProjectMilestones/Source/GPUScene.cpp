@@ -0,0 +1,435 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuscene.cpp
+// ============
+// keep the per-object data of the scene in shader storage buffers and let a
+// compute shader cull it into indirect draw commands
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GPUScene.h"
+#include "DrawList.h"
+#include "LODMeshes.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// vertex attribute location of the object index
+	const GLuint g_ObjectIndexLocation = 9;
+	// threads in one work group of the cull shader
+	const GLuint g_CullGroupSize = 64;
+
+	static_assert(sizeof(GPUScene::OBJECT_DATA) == 176, "OBJECT_DATA must match the std430 ObjectData layout");
+}
+
+/***********************************************************
+ *  GPUScene()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GPUScene::GPUScene(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_pStreamBuffer = NULL;
+	m_cullProgram = 0;
+	m_planesLocation = -1;
+	m_viewProjectionLocation = -1;
+	m_lodScaleLocation = -1;
+	m_drawItemCountLocation = -1;
+	m_levelCountLocation = -1;
+	m_fullDetailRadiusLocation = -1;
+	m_useOcclusionLocation = -1;
+	m_hiZLevelCountLocation = -1;
+	m_objectBuffer = 0;
+	m_drawItemBuffer = 0;
+	m_meshRangeBuffer = 0;
+	m_commandBuffer = 0;
+	m_drawCountBuffer = 0;
+	m_objectIndexBuffer = 0;
+	m_levelCount = 1;
+}
+
+/***********************************************************
+ *  ~GPUScene()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GPUScene::~GPUScene()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for building the cull program and
+ *  creating the buffers.  The object index attribute is added
+ *  to the shared vertex array, reading one value per instance,
+ *  so the base instance of each indirect command selects the
+ *  object that the command draws.  It returns false when the
+ *  context cannot run the GPU driven path.
+ ***********************************************************/
+bool GPUScene::Create(
+	ShaderLibrary* pShaderLibrary,
+	MeshBuffer* pMeshBuffer,
+	const char* cullShaderPath)
+{
+	GLuint firstObjectIndex = 0;
+	GLuint buffers[6];
+
+	if (m_cullProgram != 0)
+	{
+		return(true);
+	}
+
+	// the draw count of a multi-draw is read from a buffer,
+	// which needs OpenGL 4.6
+	if ((NULL == pShaderLibrary) || (NULL == pMeshBuffer) || (GLEW_VERSION_4_6 == false))
+	{
+		std::cout << "GPU driven rendering needs an OpenGL 4.6 context" << std::endl;
+		return(false);
+	}
+
+	m_cullProgram = pShaderLibrary->LoadComputeProgram(cullShaderPath);
+	if (m_cullProgram == 0)
+	{
+		return(false);
+	}
+
+	m_planesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+	m_viewProjectionLocation = glGetUniformLocation(m_cullProgram, "viewProjection");
+	m_lodScaleLocation = glGetUniformLocation(m_cullProgram, "lodScale");
+	m_drawItemCountLocation = glGetUniformLocation(m_cullProgram, "drawItemCount");
+	m_levelCountLocation = glGetUniformLocation(m_cullProgram, "levelCount");
+	m_fullDetailRadiusLocation = glGetUniformLocation(m_cullProgram, "fullDetailRadius");
+	m_useOcclusionLocation = glGetUniformLocation(m_cullProgram, "bUseOcclusion");
+	m_hiZLevelCountLocation = glGetUniformLocation(m_cullProgram, "hiZLevelCount");
+	glProgramUniform1i(
+		m_cullProgram,
+		glGetUniformLocation(m_cullProgram, "hiZBuffer"),
+		(GLint)HiZBuffer::PYRAMID_TEXTURE_UNIT);
+
+	glGenBuffers(6, buffers);
+	m_objectBuffer = buffers[0];
+	m_drawItemBuffer = buffers[1];
+	m_meshRangeBuffer = buffers[2];
+	m_commandBuffer = buffers[3];
+	m_drawCountBuffer = buffers[4];
+	m_objectIndexBuffer = buffers[5];
+
+	// the buffer holds one value until the scene is uploaded,
+	// so the enabled attribute always reads valid memory
+	glBindBuffer(GL_ARRAY_BUFFER, m_objectIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint), &firstObjectIndex, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	pMeshBuffer->Bind();
+	glBindVertexBuffer(MeshBuffer::OBJECT_INDEX_BINDING, m_objectIndexBuffer, 0, sizeof(GLuint));
+	glVertexBindingDivisor(MeshBuffer::OBJECT_INDEX_BINDING, 1);
+	glVertexAttribIFormat(g_ObjectIndexLocation, 1, GL_UNSIGNED_INT, 0);
+	glVertexAttribBinding(g_ObjectIndexLocation, MeshBuffer::OBJECT_INDEX_BINDING);
+	glEnableVertexAttribArray(g_ObjectIndexLocation);
+	glBindVertexArray(0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffers.  The cull
+ *  program belongs to the shader library.
+ ***********************************************************/
+void GPUScene::Destroy()
+{
+	if (m_objectBuffer != 0)
+	{
+		GLuint buffers[6] =
+		{
+			m_objectBuffer, m_drawItemBuffer, m_meshRangeBuffer,
+			m_commandBuffer, m_drawCountBuffer, m_objectIndexBuffer
+		};
+		glDeleteBuffers(6, buffers);
+	}
+
+	m_cullProgram = 0;
+	m_objectBuffer = 0;
+	m_drawItemBuffer = 0;
+	m_meshRangeBuffer = 0;
+	m_commandBuffer = 0;
+	m_drawCountBuffer = 0;
+	m_objectIndexBuffer = 0;
+	Clear();
+}
+
+/***********************************************************
+ *  SetMeshRanges()
+ *
+ *  This method is used for uploading the table of mesh
+ *  buffer ranges that the cull shader builds commands from.
+ ***********************************************************/
+void GPUScene::SetMeshRanges(
+	const std::vector<MeshBuffer::MESH_RANGE>& ranges,
+	int levelCount)
+{
+	m_levelCount = levelCount;
+	m_meshRanges.resize(ranges.size());
+
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		m_meshRanges[i].indexCount = ranges[i].indexCount;
+		m_meshRanges[i].firstIndex = ranges[i].firstIndex;
+		m_meshRanges[i].baseVertex = ranges[i].baseVertex;
+		m_meshRanges[i].padding = 0;
+	}
+
+	if (m_meshRangeBuffer != 0)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshRangeBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPU_MESH_RANGE) * m_meshRanges.size(), m_meshRanges.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the objects and
+ *  draws before the scene is built again.
+ ***********************************************************/
+void GPUScene::Clear()
+{
+	m_objects.clear();
+	m_drawItems.clear();
+	m_drawTextureArrays.clear();
+	m_buckets.clear();
+}
+
+/***********************************************************
+ *  AddObject()
+ *
+ *  This method is used for adding the data of an object and
+ *  returning its index.
+ ***********************************************************/
+int GPUScene::AddObject(const OBJECT_DATA& object)
+{
+	m_objects.push_back(object);
+	return((int)m_objects.size() - 1);
+}
+
+/***********************************************************
+ *  AddDraw()
+ *
+ *  This method is used for adding a draw of one mesh for an
+ *  object.  Objects made of several mesh parts add one draw
+ *  for each part.
+ ***********************************************************/
+void GPUScene::AddDraw(int objectIndex, int meshIndex, int textureArray)
+{
+	DRAW_ITEM item;
+
+	item.objectIndex = (uint32_t)objectIndex;
+	item.meshIndex = (uint32_t)meshIndex;
+	item.bucket = 0;
+	item.commandOffset = 0;
+
+	m_drawItems.push_back(item);
+	m_drawTextureArrays.push_back(textureArray);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for grouping the draws into buckets
+ *  by texture array and uploading every buffer.  Each bucket
+ *  owns a region of the command buffer that is large enough
+ *  for all of its draws, and the cull shader appends the
+ *  visible commands of a bucket into its region.
+ ***********************************************************/
+void GPUScene::Upload()
+{
+	if (m_objectBuffer == 0)
+	{
+		return;
+	}
+
+	m_buckets.clear();
+	for (size_t i = 0; i < m_drawItems.size(); i++)
+	{
+		size_t bucket = 0;
+		while ((bucket < m_buckets.size()) && (m_buckets[bucket].textureArray != m_drawTextureArrays[i]))
+		{
+			bucket++;
+		}
+		if (bucket == m_buckets.size())
+		{
+			DRAW_BUCKET newBucket;
+			newBucket.textureArray = m_drawTextureArrays[i];
+			newBucket.commandOffset = 0;
+			newBucket.commandCount = 0;
+			m_buckets.push_back(newBucket);
+		}
+
+		m_drawItems[i].bucket = (uint32_t)bucket;
+		m_buckets[bucket].commandCount++;
+	}
+
+	uint32_t commandOffset = 0;
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		m_buckets[i].commandOffset = commandOffset;
+		commandOffset += m_buckets[i].commandCount;
+	}
+	for (size_t i = 0; i < m_drawItems.size(); i++)
+	{
+		m_drawItems[i].commandOffset = m_buckets[m_drawItems[i].bucket].commandOffset;
+	}
+
+	// the object index of instance n is n
+	std::vector<GLuint> objectIndices(m_objects.empty() ? 1 : m_objects.size());
+	for (size_t i = 0; i < objectIndices.size(); i++)
+	{
+		objectIndices[i] = (GLuint)i;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(OBJECT_DATA) * m_objects.size(), m_objects.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawItemBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DRAW_ITEM) * m_drawItems.size(), m_drawItems.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DRAW_COMMAND) * m_drawItems.size(), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * m_buckets.size(), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_objectIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint) * objectIndices.size(), objectIndices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the vertex shader reads the objects from the same binding
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for replacing the data of one object
+ *  in the object buffer.  The object is staged in the stream
+ *  buffer and copied on the GPU when the stream has room, so
+ *  the update never waits on a cull that still reads the
+ *  object buffer.
+ ***********************************************************/
+void GPUScene::UpdateObject(int objectIndex, const OBJECT_DATA& object)
+{
+	if ((objectIndex < 0) || (objectIndex >= (int)m_objects.size()))
+	{
+		return;
+	}
+
+	m_objects[objectIndex] = object;
+	if (NULL != m_pStreamBuffer)
+	{
+		StreamBuffer::STREAM_ALLOCATION allocation = m_pStreamBuffer->Allocate(sizeof(OBJECT_DATA), 16);
+		if (NULL != allocation.pData)
+		{
+			memcpy(allocation.pData, &object, sizeof(OBJECT_DATA));
+			glCopyNamedBufferSubData(
+				m_pStreamBuffer->GetBuffer(), m_objectBuffer,
+				allocation.offset, sizeof(OBJECT_DATA) * objectIndex, sizeof(OBJECT_DATA));
+			return;
+		}
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(OBJECT_DATA) * objectIndex, sizeof(OBJECT_DATA), &object);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for running the cull shader over the
+ *  draws.  The draw counts are cleared first, then every
+ *  visible draw appends its command to its bucket.  The
+ *  barrier makes the commands visible to the indirect draws.
+ ***********************************************************/
+void GPUScene::Cull(
+	const glm::mat4& viewProjection,
+	const glm::mat4& projection,
+	HiZBuffer* pHiZBuffer)
+{
+	glm::vec4 planes[6];
+
+	if ((m_cullProgram == 0) || (m_drawItems.empty() == true))
+	{
+		return;
+	}
+
+	DrawList::ExtractFrustumPlanes(viewProjection, planes);
+	glProgramUniform4fv(m_cullProgram, m_planesLocation, 6, glm::value_ptr(planes[0]));
+	glProgramUniformMatrix4fv(m_cullProgram, m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glProgramUniform1f(m_cullProgram, m_lodScaleLocation, projection[1][1]);
+	glProgramUniform1ui(m_cullProgram, m_drawItemCountLocation, (GLuint)m_drawItems.size());
+	glProgramUniform1ui(m_cullProgram, m_levelCountLocation, (GLuint)m_levelCount);
+	glProgramUniform1f(m_cullProgram, m_fullDetailRadiusLocation, LODMeshes::FULL_DETAIL_RADIUS);
+
+	// the pyramid is only valid once an occluder pass has run
+	if ((NULL != pHiZBuffer) && (pHiZBuffer->GetLevelCount() > 0))
+	{
+		pHiZBuffer->BindPyramid();
+		glProgramUniform1i(m_cullProgram, m_useOcclusionLocation, GL_TRUE);
+		glProgramUniform1i(m_cullProgram, m_hiZLevelCountLocation, pHiZBuffer->GetLevelCount());
+	}
+	else
+	{
+		glProgramUniform1i(m_cullProgram, m_useOcclusionLocation, GL_FALSE);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountBuffer);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_ITEM_BINDING, m_drawItemBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESH_RANGE_BINDING, m_meshRangeBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT_BINDING, m_drawCountBuffer);
+
+	m_pStateCache->UseProgram(m_cullProgram);
+	glDispatchCompute(((GLuint)m_drawItems.size() + g_CullGroupSize - 1) / g_CullGroupSize, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/***********************************************************
+ *  DrawBucket()
+ *
+ *  This method is used for drawing the commands that the
+ *  cull shader wrote for one bucket.  The number of commands
+ *  is read from the draw count buffer, so the CPU never
+ *  learns how many draws were visible.
+ ***********************************************************/
+void GPUScene::DrawBucket(int bucket)
+{
+	if ((bucket < 0) || (bucket >= (int)m_buckets.size()))
+	{
+		return;
+	}
+
+	const DRAW_BUCKET& drawBucket = m_buckets[bucket];
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBindBuffer(GL_PARAMETER_BUFFER, m_drawCountBuffer);
+	glMultiDrawElementsIndirectCount(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		(const void*)(sizeof(DRAW_COMMAND) * drawBucket.commandOffset),
+		(GLintptr)(sizeof(GLuint) * bucket),
+		(GLsizei)drawBucket.commandCount,
+		sizeof(DRAW_COMMAND));
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuscene.h
+// ============
+// keep the per-object data of the scene in shader storage buffers and let a
+// compute shader cull it into indirect draw commands
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "HiZBuffer.h"
+#include "MeshBuffer.h"
+#include "ShaderLibrary.h"
+#include "StateCache.h"
+#include "StreamBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  GPUScene
+ *
+ *  This class holds the transforms, colors, materials,
+ *  texture layers and bounds of the scene objects in shader
+ *  storage buffers.  Each frame a compute shader tests every
+ *  draw of an object against the view frustum, picks its
+ *  level of detail and appends an indirect draw command for
+ *  it, so the objects are submitted without any per-object
+ *  work on the CPU.  The draws are grouped into buckets by
+ *  texture array, since the sampler cannot change within one
+ *  multi-draw, and each bucket is drawn with one call.
+ ***********************************************************/
+class GPUScene
+{
+public:
+	// constructor
+	GPUScene(StateCache* pStateCache);
+	// destructor
+	~GPUScene();
+
+	// shader storage bindings - 0 to 2 are used by the
+	// clustered lights
+	enum STORAGE_BINDING
+	{
+		OBJECT_BINDING = 3,
+		DRAW_ITEM_BINDING = 4,
+		MESH_RANGE_BINDING = 5,
+		COMMAND_BINDING = 6,
+		DRAW_COUNT_BINDING = 7
+	};
+
+	// per-object data - matches the ObjectData struct of the
+	// vertex and cull shaders
+	struct OBJECT_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		// world bounds - the w values hold the u and v texture scale
+		glm::vec4 boundsMinimum;
+		glm::vec4 boundsMaximum;
+		// material index and texture array layer
+		int32_t materialIndex;
+		int32_t textureLayer;
+		int32_t padding[2];
+		// columns of the normal matrix - a std430 mat3 keeps
+		// each column on a vec4 boundary
+		glm::vec4 normalColumns[3];
+	};
+
+	// build the cull program and the buffers that the shared
+	// mesh buffer reads the object index from
+	bool Create(
+		ShaderLibrary* pShaderLibrary,
+		MeshBuffer* pMeshBuffer,
+		const char* cullShaderPath);
+	// free the cull program handle and the buffers
+	void Destroy();
+	bool IsCreated() const { return(m_cullProgram != 0); }
+
+	// set the mesh buffer range of every mesh at every detail
+	// level, indexed by (mesh * levelCount) + level
+	void SetMeshRanges(
+		const std::vector<MeshBuffer::MESH_RANGE>& ranges,
+		int levelCount);
+
+	// remove all objects and draws before the scene is rebuilt
+	void Clear();
+	// add an object and return its index
+	int AddObject(const OBJECT_DATA& object);
+	// add a draw of one mesh for an object, in the bucket of the
+	// passed in texture array or -1 for untextured draws
+	void AddDraw(int objectIndex, int meshIndex, int textureArray);
+	// group the draws into buckets and upload the buffers
+	void Upload();
+	// replace the data of one object that has changed
+	void UpdateObject(int objectIndex, const OBJECT_DATA& object);
+
+	// cull the draws into the indirect command buffer, testing
+	// them against the passed in occluder pyramid unless it is
+	// NULL - the cull program is left bound
+	void Cull(
+		const glm::mat4& viewProjection,
+		const glm::mat4& projection,
+		HiZBuffer* pHiZBuffer);
+	// draw the visible commands of one bucket
+	void DrawBucket(int bucket);
+
+	int GetObjectCount() const { return((int)m_objects.size()); }
+	int GetBucketCount() const { return((int)m_buckets.size()); }
+	int GetBucketTextureArray(int bucket) const { return(m_buckets[bucket].textureArray); }
+
+	// stage the changed objects in the passed in stream buffer
+	// instead of writing the object buffer directly
+	void SetStreamBuffer(StreamBuffer* pStreamBuffer) { m_pStreamBuffer = pStreamBuffer; }
+
+private:
+	// one draw of one mesh for an object - matches the DrawItem
+	// struct of the cull shader
+	struct DRAW_ITEM
+	{
+		uint32_t objectIndex;
+		uint32_t meshIndex;
+		uint32_t bucket;
+		uint32_t commandOffset;
+	};
+
+	// mesh buffer range - matches the MeshRange struct of the
+	// cull shader
+	struct GPU_MESH_RANGE
+	{
+		uint32_t indexCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t padding;
+	};
+
+	// layout of a glMultiDrawElementsIndirect command
+	struct DRAW_COMMAND
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+
+	// draws that share a texture array
+	struct DRAW_BUCKET
+	{
+		int textureArray;
+		uint32_t commandOffset;
+		uint32_t commandCount;
+	};
+
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// pointer to the per-frame stream buffer, or NULL
+	StreamBuffer* m_pStreamBuffer;
+	// compute program that culls the draws
+	GLuint m_cullProgram;
+	// cull program uniform locations
+	GLint m_planesLocation;
+	GLint m_viewProjectionLocation;
+	GLint m_lodScaleLocation;
+	GLint m_drawItemCountLocation;
+	GLint m_levelCountLocation;
+	GLint m_fullDetailRadiusLocation;
+	GLint m_useOcclusionLocation;
+	GLint m_hiZLevelCountLocation;
+	// shader storage buffers
+	GLuint m_objectBuffer;
+	GLuint m_drawItemBuffer;
+	GLuint m_meshRangeBuffer;
+	GLuint m_commandBuffer;
+	GLuint m_drawCountBuffer;
+	// object index attribute values - the base instance of a
+	// command picks its object from this buffer
+	GLuint m_objectIndexBuffer;
+	// CPU copies of the scene data
+	std::vector<OBJECT_DATA> m_objects;
+	std::vector<DRAW_ITEM> m_drawItems;
+	std::vector<int> m_drawTextureArrays;
+	std::vector<GPU_MESH_RANGE> m_meshRanges;
+	std::vector<DRAW_BUCKET> m_buckets;
+	int m_levelCount;
+};
\ No newline at end of file
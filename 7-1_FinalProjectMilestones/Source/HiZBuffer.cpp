@@ -0,0 +1,287 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.cpp
+// ============
+// depth of the large occluders and the hierarchical-Z pyramid built from it,
+// which the cull shader tests the object bounds against
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HiZBuffer.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// threads along each side of a downsample work group
+	const GLuint g_DownsampleGroupSize = 8;
+	// image unit that a pyramid level is written through
+	const GLuint g_PyramidImageUnit = 0;
+}
+
+/***********************************************************
+ *  HiZBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HiZBuffer::HiZBuffer(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_downsampleProgram = 0;
+	m_sourceLevelLocation = -1;
+	m_sourceSizeLocation = -1;
+	m_destinationSizeLocation = -1;
+	m_framebuffer = 0;
+	m_depthTexture = 0;
+	m_pyramidTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+	m_viewport[0] = 0;
+	m_viewport[1] = 0;
+	m_viewport[2] = 0;
+	m_viewport[3] = 0;
+	m_targetFramebuffer = 0;
+}
+
+/***********************************************************
+ *  ~HiZBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HiZBuffer::~HiZBuffer()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for building the downsample program.
+ *  It returns false when the program does not compile, and
+ *  the cull shader then skips the occlusion test.
+ ***********************************************************/
+bool HiZBuffer::Create(ShaderLibrary* pShaderLibrary, const char* downsampleShaderPath)
+{
+	if (m_downsampleProgram != 0)
+	{
+		return(true);
+	}
+
+	if (NULL == pShaderLibrary)
+	{
+		return(false);
+	}
+
+	m_downsampleProgram = pShaderLibrary->LoadComputeProgram(downsampleShaderPath);
+	if (m_downsampleProgram == 0)
+	{
+		return(false);
+	}
+
+	m_sourceLevelLocation = glGetUniformLocation(m_downsampleProgram, "sourceLevel");
+	m_sourceSizeLocation = glGetUniformLocation(m_downsampleProgram, "sourceSize");
+	m_destinationSizeLocation = glGetUniformLocation(m_downsampleProgram, "destinationSize");
+	glProgramUniform1i(
+		m_downsampleProgram,
+		glGetUniformLocation(m_downsampleProgram, "sourceDepth"),
+		(GLint)PYRAMID_TEXTURE_UNIT);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffer and the
+ *  textures.  The downsample program belongs to the shader
+ *  library.
+ ***********************************************************/
+void HiZBuffer::Destroy()
+{
+	DestroyTextures();
+	m_downsampleProgram = 0;
+}
+
+/***********************************************************
+ *  DestroyTextures()
+ *
+ *  This method is used for freeing the textures and the
+ *  framebuffer that are sized to the viewport.
+ ***********************************************************/
+void HiZBuffer::DestroyTextures()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+	}
+	if (m_depthTexture != 0)
+	{
+		m_pStateCache->ForgetTexture(m_depthTexture);
+		glDeleteTextures(1, &m_depthTexture);
+	}
+	if (m_pyramidTexture != 0)
+	{
+		m_pStateCache->ForgetTexture(m_pyramidTexture);
+		glDeleteTextures(1, &m_pyramidTexture);
+	}
+
+	m_framebuffer = 0;
+	m_depthTexture = 0;
+	m_pyramidTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_levelCount = 0;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for creating the occluder depth
+ *  buffer and the pyramid at the size of the viewport.  The
+ *  pyramid goes all the way down to a single texel.
+ ***********************************************************/
+void HiZBuffer::Resize(int width, int height)
+{
+	DestroyTextures();
+
+	m_width = width;
+	m_height = height;
+	m_levelCount = 1;
+	for (int size = (width > height) ? width : height; size > 1; size /= 2)
+	{
+		m_levelCount++;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_depthTexture);
+	glTextureStorage2D(m_depthTexture, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(m_depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_pyramidTexture);
+	glTextureStorage2D(m_pyramidTexture, m_levelCount, GL_R32F, width, height);
+	glTextureParameteri(m_pyramidTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTextureParameteri(m_pyramidTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(m_pyramidTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(m_pyramidTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glCreateFramebuffers(1, &m_framebuffer);
+	glNamedFramebufferTexture(m_framebuffer, GL_DEPTH_ATTACHMENT, m_depthTexture, 0);
+	glNamedFramebufferDrawBuffer(m_framebuffer, GL_NONE);
+	glNamedFramebufferReadBuffer(m_framebuffer, GL_NONE);
+
+	if (glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "The occluder depth framebuffer is not complete" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  BeginOccluderPass()
+ *
+ *  This method is used for binding the occluder depth buffer
+ *  and clearing it to the far plane.  The buffer follows the
+ *  size of the window viewport.
+ ***********************************************************/
+void HiZBuffer::BeginOccluderPass()
+{
+	if (m_downsampleProgram == 0)
+	{
+		return;
+	}
+
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+	if ((m_viewport[2] != m_width) || (m_viewport[3] != m_height))
+	{
+		Resize(m_viewport[2], m_viewport[3]);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  EndOccluderPass()
+ *
+ *  This method is used for going back to the framebuffer
+ *  and the viewport that were bound before the pass.
+ ***********************************************************/
+void HiZBuffer::EndOccluderPass()
+{
+	if (m_downsampleProgram == 0)
+	{
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_targetFramebuffer);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for copying the occluder depth into
+ *  the first pyramid level and reducing each level into the
+ *  next.  A level texel takes the farthest depth of every
+ *  texel it covers, including the extra row and column of an
+ *  odd sized level, so the test never hides a visible box.
+ ***********************************************************/
+void HiZBuffer::BuildPyramid()
+{
+	if ((m_downsampleProgram == 0) || (m_pyramidTexture == 0))
+	{
+		return;
+	}
+
+	int sourceWidth = m_width;
+	int sourceHeight = m_height;
+
+	m_pStateCache->UseProgram(m_downsampleProgram);
+
+	for (int level = 0; level < m_levelCount; level++)
+	{
+		int width = (m_width >> level) > 1 ? (m_width >> level) : 1;
+		int height = (m_height >> level) > 1 ? (m_height >> level) : 1;
+
+		// the first level reads the occluder depth, the others
+		// read the level above them
+		if (level == 0)
+		{
+			m_pStateCache->BindTexture(PYRAMID_TEXTURE_UNIT, GL_TEXTURE_2D, m_depthTexture);
+		}
+		else
+		{
+			m_pStateCache->BindTexture(PYRAMID_TEXTURE_UNIT, GL_TEXTURE_2D, m_pyramidTexture);
+		}
+
+		glUniform1i(m_sourceLevelLocation, (level == 0) ? 0 : (level - 1));
+		glUniform2i(m_sourceSizeLocation, sourceWidth, sourceHeight);
+		glUniform2i(m_destinationSizeLocation, width, height);
+		glBindImageTexture(g_PyramidImageUnit, m_pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute(
+			((GLuint)width + g_DownsampleGroupSize - 1) / g_DownsampleGroupSize,
+			((GLuint)height + g_DownsampleGroupSize - 1) / g_DownsampleGroupSize,
+			1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		sourceWidth = width;
+		sourceHeight = height;
+	}
+}
+
+/***********************************************************
+ *  BindPyramid()
+ *
+ *  This method is used for binding the pyramid to the texture
+ *  unit that the cull shader reads it from.
+ ***********************************************************/
+void HiZBuffer::BindPyramid()
+{
+	if (m_pyramidTexture != 0)
+	{
+		m_pStateCache->BindTexture(PYRAMID_TEXTURE_UNIT, GL_TEXTURE_2D, m_pyramidTexture);
+	}
+}
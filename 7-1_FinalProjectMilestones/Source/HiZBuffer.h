@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// hizbuffer.h
+// ============
+// depth of the large occluders and the hierarchical-Z pyramid built from it,
+// which the cull shader tests the object bounds against
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderLibrary.h"
+#include "StateCache.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  HiZBuffer
+ *
+ *  This class owns a depth only framebuffer that a chosen set
+ *  of large occluders is drawn into before the main pass, and
+ *  a mip chain of that depth.  Every texel of a level holds
+ *  the farthest depth of the texels it covers in the level
+ *  below, so the screen rectangle of a box is tested with a
+ *  few texel reads at the level where the rectangle spans
+ *  about two texels.  A box whose nearest depth is behind the
+ *  farthest occluder depth of its rectangle is hidden.
+ ***********************************************************/
+class HiZBuffer
+{
+public:
+	// constructor
+	HiZBuffer(StateCache* pStateCache);
+	// destructor
+	~HiZBuffer();
+
+	// texture unit that the pyramid is read from - the texture
+	// arrays use the low units and the uploads use unit 31
+	static const GLuint PYRAMID_TEXTURE_UNIT = 30;
+
+	// build the downsample program - the textures are created
+	// at the size of the viewport by the first occluder pass
+	bool Create(ShaderLibrary* pShaderLibrary, const char* downsampleShaderPath);
+	// free the framebuffer and textures
+	void Destroy();
+	bool IsCreated() const { return(m_downsampleProgram != 0); }
+
+	// bind and clear the occluder depth buffer
+	void BeginOccluderPass();
+	// go back to the window framebuffer
+	void EndOccluderPass();
+	// reduce the occluder depth into the pyramid levels - the
+	// downsample program is left bound
+	void BuildPyramid();
+	// bind the pyramid to its texture unit
+	void BindPyramid();
+
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	int GetLevelCount() const { return(m_levelCount); }
+
+private:
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// compute program that builds one pyramid level
+	GLuint m_downsampleProgram;
+	// downsample program uniform locations
+	GLint m_sourceLevelLocation;
+	GLint m_sourceSizeLocation;
+	GLint m_destinationSizeLocation;
+	// depth only framebuffer of the occluder pass
+	GLuint m_framebuffer;
+	GLuint m_depthTexture;
+	// farthest depth mip chain
+	GLuint m_pyramidTexture;
+	int m_width;
+	int m_height;
+	int m_levelCount;
+	// window viewport and framebuffer that are put back after
+	// the occluder pass
+	GLint m_viewport[4];
+	GLint m_targetFramebuffer;
+
+	// create the textures at the passed in size
+	void Resize(int width, int height);
+	// free the textures and framebuffer
+	void DestroyTextures();
+};
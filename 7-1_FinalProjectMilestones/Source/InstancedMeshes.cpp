@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.cpp
+// ============
+// draw many copies of a basic 3D shape with a single instanced draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstancedMeshes.h"
+
+#include <cstddef>
+#include <cstring>
+
+// declaration of the global variables and defines
+namespace
+{
+	// instance attribute locations used by the vertex shader -
+	// the model matrix takes four consecutive locations
+	const GLuint g_InstanceModelLocation = 3;
+	const GLuint g_InstanceColorLocation = 7;
+	const GLuint g_InstanceTextureLayerLocation = 8;
+	const GLuint g_InstanceNormalMatrixLocation = 10;
+}
+
+/***********************************************************
+ *  InstancedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstancedMeshes::InstancedMeshes()
+{
+	m_boxRange.firstIndex = 0;
+	m_boxRange.indexCount = 0;
+	m_boxRange.baseVertex = 0;
+	m_instanceVBO = 0;
+	m_instanceCapacity = 0;
+	m_vertexArray = 0;
+	m_pStreamBuffer = NULL;
+	m_bInstancesStreamed = false;
+}
+
+/***********************************************************
+ *  ~InstancedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstancedMeshes::~InstancedMeshes()
+{
+	DestroyInstanceBuffer();
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for keeping the range of the box in
+ *  the shared mesh buffer and adding the per-instance
+ *  attributes to the shared vertex array.  The attributes
+ *  read from the instance binding, which advances once per
+ *  instance.  The buffer starts out holding one instance, so
+ *  the enabled attributes always read valid memory, even for
+ *  draws that are not instanced.
+ ***********************************************************/
+void InstancedMeshes::LoadBoxMesh(
+	MeshBuffer* pMeshBuffer,
+	const MeshBuffer::MESH_RANGE& boxRange)
+{
+	const GLsizei instanceStride = sizeof(INSTANCE_DATA);
+	INSTANCE_DATA emptyInstance;
+
+	// only load the mesh once
+	if ((NULL == pMeshBuffer) || (m_instanceVBO != 0))
+	{
+		return;
+	}
+
+	m_boxRange = boxRange;
+	m_vertexArray = pMeshBuffer->GetVertexArray();
+
+	emptyInstance.model = glm::mat4(1.0f);
+	emptyInstance.color = glm::vec4(1.0f);
+	emptyInstance.textureLayer = 0.0f;
+	emptyInstance.normalMatrix = glm::mat3(1.0f);
+	m_instanceCapacity = 1;
+	glGenBuffers(1, &m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instanceStride, &emptyInstance, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// per-instance attributes - the model matrix is passed
+	// in as four column vectors followed by the color, the
+	// texture array layer and the three normal matrix columns
+	pMeshBuffer->Bind();
+	glBindVertexBuffer(MeshBuffer::INSTANCE_BINDING, m_instanceVBO, 0, instanceStride);
+	glVertexBindingDivisor(MeshBuffer::INSTANCE_BINDING, 1);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribFormat(
+			g_InstanceModelLocation + column, 4, GL_FLOAT, GL_FALSE,
+			(GLuint)(offsetof(INSTANCE_DATA, model) + (sizeof(glm::vec4) * column)));
+		glVertexAttribBinding(g_InstanceModelLocation + column, MeshBuffer::INSTANCE_BINDING);
+		glEnableVertexAttribArray(g_InstanceModelLocation + column);
+	}
+	glVertexAttribFormat(
+		g_InstanceColorLocation, 4, GL_FLOAT, GL_FALSE,
+		(GLuint)offsetof(INSTANCE_DATA, color));
+	glVertexAttribBinding(g_InstanceColorLocation, MeshBuffer::INSTANCE_BINDING);
+	glEnableVertexAttribArray(g_InstanceColorLocation);
+	glVertexAttribFormat(
+		g_InstanceTextureLayerLocation, 1, GL_FLOAT, GL_FALSE,
+		(GLuint)offsetof(INSTANCE_DATA, textureLayer));
+	glVertexAttribBinding(g_InstanceTextureLayerLocation, MeshBuffer::INSTANCE_BINDING);
+	glEnableVertexAttribArray(g_InstanceTextureLayerLocation);
+	for (GLuint column = 0; column < 3; column++)
+	{
+		glVertexAttribFormat(
+			g_InstanceNormalMatrixLocation + column, 3, GL_FLOAT, GL_FALSE,
+			(GLuint)(offsetof(INSTANCE_DATA, normalMatrix) + (sizeof(glm::vec3) * column)));
+		glVertexAttribBinding(g_InstanceNormalMatrixLocation + column, MeshBuffer::INSTANCE_BINDING);
+		glEnableVertexAttribArray(g_InstanceNormalMatrixLocation + column);
+	}
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  UploadInstances()
+ *
+ *  This method is used for copying the instance data into
+ *  the instance attribute buffer.  The buffer storage is
+ *  orphaned so the upload never waits on a draw that is
+ *  still using the previous contents.  Orphaning keeps the
+ *  buffer name, so the shared vertex array needs no rebinding.
+ *  When the stream buffer has room the instances are copied
+ *  there instead and the instance binding points at the copy.
+ ***********************************************************/
+void InstancedMeshes::UploadInstances(
+	const INSTANCE_DATA* pInstances,
+	int instanceCount)
+{
+	GLsizeiptr uploadSize = (GLsizeiptr)sizeof(INSTANCE_DATA) * instanceCount;
+
+	if (NULL != m_pStreamBuffer)
+	{
+		StreamBuffer::STREAM_ALLOCATION allocation = m_pStreamBuffer->Allocate((size_t)uploadSize, 16);
+		if (NULL != allocation.pData)
+		{
+			memcpy(allocation.pData, pInstances, (size_t)uploadSize);
+			glVertexArrayVertexBuffer(
+				m_vertexArray, MeshBuffer::INSTANCE_BINDING,
+				m_pStreamBuffer->GetBuffer(), allocation.offset, sizeof(INSTANCE_DATA));
+			m_bInstancesStreamed = true;
+			return;
+		}
+	}
+
+	// go back to the instance buffer when the stream is full
+	if (m_bInstancesStreamed == true)
+	{
+		glVertexArrayVertexBuffer(m_vertexArray, MeshBuffer::INSTANCE_BINDING, m_instanceVBO, 0, sizeof(INSTANCE_DATA));
+		m_bInstancesStreamed = false;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	if (instanceCount > m_instanceCapacity)
+	{
+		m_instanceCapacity = instanceCount;
+	}
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)sizeof(INSTANCE_DATA) * m_instanceCapacity, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, uploadSize, pInstances);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawBoxMeshInstanced()
+ *
+ *  This method is used for drawing every passed in instance
+ *  of the box mesh with one draw call.
+ ***********************************************************/
+void InstancedMeshes::DrawBoxMeshInstanced(
+	const INSTANCE_DATA* pInstances,
+	int instanceCount)
+{
+	if ((m_instanceVBO == 0) || (NULL == pInstances) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	UploadInstances(pInstances, instanceCount);
+	MeshBuffer::DrawRangeInstanced(m_boxRange, instanceCount);
+}
+
+/***********************************************************
+ *  DestroyInstanceBuffer()
+ *
+ *  This method is used for freeing the instance attribute
+ *  buffer.
+ ***********************************************************/
+void InstancedMeshes::DestroyInstanceBuffer()
+{
+	if (m_instanceVBO != 0)
+	{
+		glDeleteBuffers(1, &m_instanceVBO);
+	}
+	m_instanceVBO = 0;
+	m_instanceCapacity = 0;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// instancedmeshes.h
+// ============
+// draw many copies of a basic 3D shape with a single instanced draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshBuffer.h"
+#include "StreamBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  InstancedMeshes
+ *
+ *  This class draws the basic shapes of the shared mesh
+ *  buffer with hardware instancing.  A per-instance attribute
+ *  buffer, bound to the instance binding of the shared vertex
+ *  array, holds the model matrix, color and texture array
+ *  layer of every instance.
+ ***********************************************************/
+class InstancedMeshes
+{
+public:
+	// constructor
+	InstancedMeshes();
+	// destructor
+	~InstancedMeshes();
+
+	// per-instance attribute data - matches the instance
+	// attributes declared in the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		float textureLayer;
+		glm::mat3 normalMatrix;
+	};
+
+	// keep the box range of the shared mesh buffer and create
+	// the instance attribute buffer
+	void LoadBoxMesh(
+		MeshBuffer* pMeshBuffer,
+		const MeshBuffer::MESH_RANGE& boxRange);
+	// draw the passed in instances of the box mesh - the shared
+	// vertex array must be bound
+	void DrawBoxMeshInstanced(
+		const INSTANCE_DATA* pInstances,
+		int instanceCount);
+
+	// copy the instances into the passed in stream buffer
+	// instead of orphaning the instance attribute buffer
+	void SetStreamBuffer(StreamBuffer* pStreamBuffer) { m_pStreamBuffer = pStreamBuffer; }
+
+private:
+	// range of the box mesh in the shared mesh buffer
+	MeshBuffer::MESH_RANGE m_boxRange;
+	// handle for the instance attribute buffer
+	GLuint m_instanceVBO;
+	// number of instances the buffer can hold
+	int m_instanceCapacity;
+	// shared vertex array that reads the instance binding
+	GLuint m_vertexArray;
+	// pointer to the per-frame stream buffer, or NULL
+	StreamBuffer* m_pStreamBuffer;
+	// true when the instance binding is in the stream buffer
+	bool m_bInstancesStreamed;
+
+	// upload the instance data into the instance attribute buffer
+	void UploadInstances(
+		const INSTANCE_DATA* pInstances,
+		int instanceCount);
+	// free the instance attribute buffer
+	void DestroyInstanceBuffer();
+};
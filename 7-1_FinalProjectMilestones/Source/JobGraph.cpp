@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobgraph.cpp
+// ============
+// set of jobs with dependencies between them that runs on the job system
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobGraph.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  JobGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobGraph::JobGraph()
+{
+	m_pJobSystem = NULL;
+	m_pCounter = NULL;
+}
+
+/***********************************************************
+ *  ~JobGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobGraph::~JobGraph()
+{
+	m_nodes.clear();
+}
+
+/***********************************************************
+ *  AddJob()
+ *
+ *  This method is used for adding a job to the graph.  The
+ *  index of the new job is returned.
+ ***********************************************************/
+int JobGraph::AddJob(const JobSystem::JOB_FUNCTION& function)
+{
+	GRAPH_NODE node;
+	node.function = function;
+	node.dependencyCount = 0;
+	m_nodes.push_back(node);
+
+	return((int)m_nodes.size() - 1);
+}
+
+/***********************************************************
+ *  AddDependency()
+ *
+ *  This method is used for making a job wait until an earlier
+ *  job has finished.  Dependencies on later jobs are refused,
+ *  which keeps cycles out of the graph.
+ ***********************************************************/
+void JobGraph::AddDependency(int jobIndex, int dependencyIndex)
+{
+	if ((jobIndex < 0) || (jobIndex >= (int)m_nodes.size()) ||
+		(dependencyIndex < 0) || (dependencyIndex >= jobIndex))
+	{
+		std::cout << "A job can only depend on a job added before it" << std::endl;
+		return;
+	}
+
+	m_nodes[dependencyIndex].dependents.push_back(jobIndex);
+	m_nodes[jobIndex].dependencyCount++;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running the jobs of the graph and
+ *  waiting for them.  The calling thread runs jobs as well
+ *  while it waits.
+ ***********************************************************/
+void JobGraph::Run(JobSystem* pJobSystem)
+{
+	const int nodeCount = (int)m_nodes.size();
+
+	if ((NULL == pJobSystem) || (pJobSystem->GetWorkerCount() == 0))
+	{
+		for (int i = 0; i < nodeCount; i++)
+		{
+			m_nodes[i].function();
+		}
+		return;
+	}
+
+	JobSystem::JOB_COUNTER counter;
+	m_pJobSystem = pJobSystem;
+	m_pCounter = &counter;
+	m_remaining.reset(new std::atomic<int>[nodeCount]);
+	for (int i = 0; i < nodeCount; i++)
+	{
+		m_remaining[i] = m_nodes[i].dependencyCount;
+	}
+
+	for (int i = 0; i < nodeCount; i++)
+	{
+		if (m_nodes[i].dependencyCount == 0)
+		{
+			m_pJobSystem->Submit([this, i]() { RunNode(i); }, m_pCounter);
+		}
+	}
+
+	m_pJobSystem->Wait(m_pCounter);
+	m_pJobSystem = NULL;
+	m_pCounter = NULL;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the jobs, such as
+ *  before the jobs of the next frame are added.
+ ***********************************************************/
+void JobGraph::Clear()
+{
+	m_nodes.clear();
+	m_remaining.reset();
+}
+
+/***********************************************************
+ *  RunNode()
+ *
+ *  This method is used for running one job of the graph.
+ *  The dependents are submitted against the same counter
+ *  before this job finishes, so the count cannot reach zero
+ *  while jobs are still to come.
+ ***********************************************************/
+void JobGraph::RunNode(int jobIndex)
+{
+	m_nodes[jobIndex].function();
+
+	const std::vector<int>& dependents = m_nodes[jobIndex].dependents;
+	for (size_t i = 0; i < dependents.size(); i++)
+	{
+		int dependent = dependents[i];
+		if (m_remaining[dependent].fetch_sub(1) == 1)
+		{
+			m_pJobSystem->Submit([this, dependent]() { RunNode(dependent); }, m_pCounter);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobgraph.h
+// ============
+// set of jobs with dependencies between them that runs on the job system
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/***********************************************************
+ *  JobGraph
+ *
+ *  This class holds jobs together with the jobs they depend
+ *  on.  When the graph is run, the jobs without dependencies
+ *  are submitted first, and each finished job submits the
+ *  jobs that were only waiting on it, so independent work
+ *  overlaps while dependent work keeps its order.  A job can
+ *  only depend on jobs added before it, so the graph never
+ *  has a cycle and the order the jobs were added in is always
+ *  a valid order to run them in without a job system.
+ ***********************************************************/
+class JobGraph
+{
+public:
+	// constructor
+	JobGraph();
+	// destructor
+	~JobGraph();
+
+	// add a job and return its index
+	int AddJob(const JobSystem::JOB_FUNCTION& function);
+	// make a job wait for an earlier job to finish
+	void AddDependency(int jobIndex, int dependencyIndex);
+	// run every job and wait for all of them - the jobs run in
+	// the order they were added when the job system is NULL
+	void Run(JobSystem* pJobSystem);
+	// remove all of the jobs
+	void Clear();
+
+	int GetJobCount() const { return((int)m_nodes.size()); }
+
+private:
+	struct GRAPH_NODE
+	{
+		JobSystem::JOB_FUNCTION function;
+		// jobs that depend on this one
+		std::vector<int> dependents;
+		int dependencyCount;
+	};
+
+	// jobs of the graph in the order they were added
+	std::vector<GRAPH_NODE> m_nodes;
+	// dependencies of each job that have not finished yet
+	std::unique_ptr<std::atomic<int>[]> m_remaining;
+	// job system of the current run
+	JobSystem* m_pJobSystem;
+	JobSystem::JOB_COUNTER* m_pCounter;
+
+	// run a job and submit the dependents it was the last
+	// dependency of
+	void RunNode(int jobIndex);
+};
@@ -0,0 +1,301 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// fixed pool of worker threads that run short jobs from work-stealing queues
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// queue of the calling thread, or -1 outside of the pool
+	thread_local int g_WorkerQueueIndex = -1;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem()
+{
+	m_queuedCount = 0;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the worker threads and
+ *  their queues.  A negative count starts one worker for
+ *  each core but the one the render thread runs on.
+ ***********************************************************/
+void JobSystem::Start(int workerCount)
+{
+	if (m_workers.size() > 0)
+	{
+		return;
+	}
+
+	if (workerCount < 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+	}
+	if (workerCount < 0)
+	{
+		workerCount = 0;
+	}
+
+	m_bStopping = false;
+	m_queues.clear();
+	for (int i = 0; i <= workerCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<WORK_QUEUE>(new WORK_QUEUE()));
+	}
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+
+	std::cout << "INFO: Job system started " << workerCount << " worker threads" << std::endl;
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for telling the workers to exit and
+ *  waiting for them.  Callers wait on their counters before
+ *  this, so no queued job is left behind.
+ ***********************************************************/
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+	m_queuedCount = 0;
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for queueing a job on the queue of
+ *  the calling thread and waking an idle worker to run or
+ *  steal it.  Without workers the job runs right away.
+ ***********************************************************/
+void JobSystem::Submit(const JOB_FUNCTION& function, JOB_COUNTER* pCounter)
+{
+	if (m_workers.size() == 0)
+	{
+		function();
+		return;
+	}
+
+	if (NULL != pCounter)
+	{
+		pCounter->count.fetch_add(1);
+	}
+
+	JOB job;
+	job.function = function;
+	job.pCounter = pCounter;
+
+	WORK_QUEUE& queue = *m_queues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	m_queuedCount.fetch_add(1);
+
+	// the count is raised before the lock is taken, so a worker
+	// that is about to sleep sees the new job
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for waiting until every job submitted
+ *  against the counter has finished.  The waiting thread runs
+ *  queued jobs in the meantime instead of sleeping.
+ ***********************************************************/
+void JobSystem::Wait(JOB_COUNTER* pCounter)
+{
+	if (NULL == pCounter)
+	{
+		return;
+	}
+
+	int queueIndex = GetQueueIndex();
+	while (pCounter->count.load() > 0)
+	{
+		if ((m_queues.size() == 0) || (RunQueuedJob(queueIndex) == false))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running a loop over several
+ *  threads.  The items are split into ranges of the grain
+ *  size and the calling thread runs the last range itself.
+ *  Loops that fit in one range never leave the thread.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int grainSize, const RANGE_FUNCTION& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+
+	// a few ranges per thread leave room for stealing when
+	// some ranges take longer than others
+	int threadCount = (int)m_workers.size() + 1;
+	int rangeSize = (count + (threadCount * 4) - 1) / (threadCount * 4);
+	if (rangeSize < grainSize)
+	{
+		rangeSize = grainSize;
+	}
+
+	if ((m_workers.size() == 0) || (count <= rangeSize))
+	{
+		function(0, count);
+		return;
+	}
+
+	JOB_COUNTER counter;
+	int first = 0;
+	while (first + rangeSize < count)
+	{
+		int last = first + rangeSize;
+		Submit([&function, first, last]() { function(first, last); }, &counter);
+		first = last;
+	}
+
+	function(first, count);
+	Wait(&counter);
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by each worker thread.  It runs jobs
+ *  while any queue has one and sleeps when they are empty.
+ ***********************************************************/
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	g_WorkerQueueIndex = queueIndex;
+
+	while (m_bStopping == false)
+	{
+		if (RunQueuedJob(queueIndex) == true)
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]() { return((m_bStopping == true) || (m_queuedCount.load() > 0)); });
+	}
+}
+
+/***********************************************************
+ *  RunQueuedJob()
+ *
+ *  This method is used for running one job.  The newest job
+ *  of the own queue is taken first, since its data is most
+ *  likely still in the cache, and otherwise the oldest job
+ *  of the next queue that has one is stolen.
+ ***********************************************************/
+bool JobSystem::RunQueuedJob(int queueIndex)
+{
+	const int queueCount = (int)m_queues.size();
+	JOB job;
+	bool bFound = false;
+
+	for (int i = 0; (i < queueCount) && (bFound == false); i++)
+	{
+		int index = (queueIndex + i) % queueCount;
+		WORK_QUEUE& queue = *m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty() == true)
+		{
+			continue;
+		}
+
+		if (i == 0)
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		bFound = true;
+	}
+
+	if (bFound == false)
+	{
+		return(false);
+	}
+
+	m_queuedCount.fetch_sub(1);
+	job.function();
+	if (NULL != job.pCounter)
+	{
+		job.pCounter->count.fetch_sub(1);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetQueueIndex()
+ *
+ *  This method is used for getting the queue that the calling
+ *  thread submits to - its own for a worker, and the last
+ *  queue for any thread outside of the pool.
+ ***********************************************************/
+int JobSystem::GetQueueIndex() const
+{
+	if ((g_WorkerQueueIndex >= 0) && (g_WorkerQueueIndex < (int)m_workers.size()))
+	{
+		return(g_WorkerQueueIndex);
+	}
+
+	return((int)m_queues.size() - 1);
+}
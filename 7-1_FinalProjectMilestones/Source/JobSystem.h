@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// fixed pool of worker threads that run short jobs from work-stealing queues
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class runs short jobs on a fixed pool of worker
+ *  threads.  Every worker has its own queue - a worker takes
+ *  the newest job from the back of its own queue, and when
+ *  that is empty it steals the oldest job from the front of
+ *  another queue, so the work spreads over the pool without
+ *  one shared queue that every thread fights over.  A thread
+ *  waiting on a counter runs queued jobs while it waits, so
+ *  jobs may wait on jobs of their own.  Without any workers
+ *  every job runs right away on the thread that submits it.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor
+	JobSystem();
+	// destructor
+	~JobSystem();
+
+	// work of one job
+	typedef std::function<void()> JOB_FUNCTION;
+	// work of one range of a parallel loop, from the first
+	// index up to, but not including, the last index
+	typedef std::function<void(int first, int last)> RANGE_FUNCTION;
+
+	// number of jobs that have been submitted against it and
+	// have not finished yet
+	struct JOB_COUNTER
+	{
+		std::atomic<int> count;
+
+		JOB_COUNTER() : count(0) {}
+	};
+
+	// start the passed in number of worker threads - a
+	// negative count leaves one core for the render thread
+	void Start(int workerCount);
+	// finish the running jobs and join the worker threads
+	void Stop();
+	int GetWorkerCount() const { return((int)m_workers.size()); }
+
+	// queue a job that decrements the counter when it is done
+	void Submit(const JOB_FUNCTION& function, JOB_COUNTER* pCounter);
+	// run queued jobs until the counter reaches zero
+	void Wait(JOB_COUNTER* pCounter);
+	// split a loop over the passed in number of items into
+	// ranges of at least the grain size, run them in parallel
+	// and wait for all of them
+	void ParallelFor(int count, int grainSize, const RANGE_FUNCTION& function);
+
+private:
+	struct JOB
+	{
+		JOB_FUNCTION function;
+		JOB_COUNTER* pCounter;
+	};
+
+	// jobs of one thread - the owner uses the back and the
+	// other threads steal from the front
+	struct WORK_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB> jobs;
+	};
+
+	// worker threads of the pool
+	std::vector<std::thread> m_workers;
+	// one queue for each worker, and a last one for the
+	// threads outside of the pool
+	std::vector<std::unique_ptr<WORK_QUEUE>> m_queues;
+	// idle workers sleep until a job is queued
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	// jobs in all of the queues
+	std::atomic<int> m_queuedCount;
+	// true when the workers have been told to exit
+	std::atomic<bool> m_bStopping;
+
+	// run queued jobs until told to stop
+	void WorkerLoop(int queueIndex);
+	// take a job from the own queue or steal one, and run it -
+	// returns false when every queue was empty
+	bool RunQueuedJob(int queueIndex);
+	// get the queue of the calling thread
+	int GetQueueIndex() const;
+};
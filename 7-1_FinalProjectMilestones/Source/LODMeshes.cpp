@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodmeshes.cpp
+// ============
+// several levels of detail for the curved basic shapes, picked by the size
+// of an object on the screen
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LODMeshes.h"
+#include "ShapeGeometry.h"
+
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// slices around the Y axis at each level - the sphere has
+	// half as many stacks as slices
+	const int g_LevelSlices[LODMeshes::LOD_COUNT] = { 48, 24, 12, 6 };
+	// part of each level, at its far end, that fades into the next
+	const float g_BlendBand = 0.25f;
+}
+
+/***********************************************************
+ *  LODMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LODMeshes::LODMeshes()
+{
+	m_bLoaded = false;
+
+	for (int shape = 0; shape < SHAPE_COUNT; shape++)
+	{
+		for (int level = 0; level < LOD_COUNT; level++)
+		{
+			for (int part = 0; part < PART_COUNT; part++)
+			{
+				m_ranges[shape][level][part].firstIndex = 0;
+				m_ranges[shape][level][part].indexCount = 0;
+				m_ranges[shape][level][part].baseVertex = 0;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ~LODMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LODMeshes::~LODMeshes()
+{
+}
+
+/***********************************************************
+ *  SelectLevel()
+ *
+ *  This method is used for picking the detail level from the
+ *  size of an object on the screen.  One level is dropped
+ *  each time the screen radius halves, so the sphere, whose
+ *  vertex count falls by four per level, costs about as much
+ *  as the area it covers.  Near the far end of each level the
+ *  next level is faded in, so the switch does not pop.
+ ***********************************************************/
+LODMeshes::LOD_SELECTION LODMeshes::SelectLevel(float screenRadius)
+{
+	LOD_SELECTION selection;
+	float lod = 0.0f;
+
+	if (screenRadius < FULL_DETAIL_RADIUS)
+	{
+		lod = std::log2(FULL_DETAIL_RADIUS / std::fmax(screenRadius, 1e-6f));
+	}
+	if (lod > (float)(LOD_COUNT - 1))
+	{
+		lod = (float)(LOD_COUNT - 1);
+	}
+
+	selection.level = (int)lod;
+	selection.blend = 0.0f;
+
+	// fade toward the next level over the end of this one
+	float fraction = lod - (float)selection.level;
+	if ((selection.level < LOD_COUNT - 1) && (fraction > 1.0f - g_BlendBand))
+	{
+		selection.blend = (fraction - (1.0f - g_BlendBand)) / g_BlendBand;
+	}
+
+	return(selection);
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *
+ *  This method is used for generating every level of the
+ *  curved shapes into one set of vertex and index data, and
+ *  keeping the index range of each part.  The data is added
+ *  to the mesh buffer as one mesh, so the ranges of the parts
+ *  are moved by where that mesh starts.
+ ***********************************************************/
+void LODMeshes::LoadMeshes(MeshBuffer* pMeshBuffer)
+{
+	ShapeGeometry::MESH_DATA meshData;
+
+	// only load the meshes once
+	if ((NULL == pMeshBuffer) || (m_bLoaded == true))
+	{
+		return;
+	}
+
+	for (int level = 0; level < LOD_COUNT; level++)
+	{
+		const LOD_SHAPE shapes[5] = { SHAPE_SPHERE, SHAPE_CYLINDER, SHAPE_CYLINDER, SHAPE_CYLINDER, SHAPE_CONE };
+		const LOD_PART parts[5] = { PART_SIDES, PART_SIDES, PART_TOP, PART_BOTTOM, PART_SIDES };
+
+		for (int i = 0; i < 5; i++)
+		{
+			MeshBuffer::MESH_RANGE* pRange = &m_ranges[shapes[i]][level][parts[i]];
+			pRange->firstIndex = (GLuint)meshData.indices.size();
+			AppendPart(meshData, shapes[i], level, parts[i]);
+			pRange->indexCount = (GLuint)meshData.indices.size() - pRange->firstIndex;
+		}
+
+		// the cone shares the bottom disc of the cylinder
+		m_ranges[SHAPE_CONE][level][PART_BOTTOM] = m_ranges[SHAPE_CYLINDER][level][PART_BOTTOM];
+	}
+
+	MeshBuffer::MESH_RANGE meshRange = pMeshBuffer->AddMesh(meshData);
+	for (int shape = 0; shape < SHAPE_COUNT; shape++)
+	{
+		for (int level = 0; level < LOD_COUNT; level++)
+		{
+			for (int part = 0; part < PART_COUNT; part++)
+			{
+				m_ranges[shape][level][part].firstIndex += meshRange.firstIndex;
+				m_ranges[shape][level][part].baseVertex = meshRange.baseVertex;
+			}
+		}
+	}
+
+	m_bLoaded = true;
+}
+
+/***********************************************************
+ *  AppendPart()
+ *
+ *  This method is used for appending one part of a shape at
+ *  the passed in level to mesh data.  The cone has the same
+ *  bottom disc as the cylinder.
+ ***********************************************************/
+void LODMeshes::AppendPart(
+	ShapeGeometry::MESH_DATA& mesh,
+	LOD_SHAPE shape,
+	int level,
+	LOD_PART part)
+{
+	if ((level < 0) || (level >= LOD_COUNT))
+	{
+		return;
+	}
+
+	const int slices = g_LevelSlices[level];
+
+	switch (shape)
+	{
+	case SHAPE_SPHERE:
+		ShapeGeometry::AppendSphere(mesh, slices, slices / 2);
+		break;
+	case SHAPE_CYLINDER:
+		if (part == PART_SIDES)
+		{
+			ShapeGeometry::AppendCylinderSides(mesh, slices);
+		}
+		else
+		{
+			ShapeGeometry::AppendDisc(mesh, slices, (part == PART_TOP) ? 1.0f : 0.0f, part == PART_TOP);
+		}
+		break;
+	case SHAPE_CONE:
+		if (part == PART_SIDES)
+		{
+			ShapeGeometry::AppendConeSides(mesh, slices);
+		}
+		else if (part == PART_BOTTOM)
+		{
+			ShapeGeometry::AppendDisc(mesh, slices, 0.0f, false);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawPart()
+ *
+ *  This method is used for drawing the index range of one
+ *  part of a shape at the passed in level.
+ ***********************************************************/
+void LODMeshes::DrawPart(LOD_SHAPE shape, int level, LOD_PART part)
+{
+	if ((m_bLoaded == false) || (level < 0) || (level >= LOD_COUNT))
+	{
+		return;
+	}
+
+	MeshBuffer::DrawRange(m_ranges[shape][level][part]);
+}
+
+/***********************************************************
+ *  DrawSphereMesh()
+ *
+ *  This method is used for drawing the sphere at the passed
+ *  in level.
+ ***********************************************************/
+void LODMeshes::DrawSphereMesh(int level)
+{
+	DrawPart(SHAPE_SPHERE, level, PART_SIDES);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing the requested parts of
+ *  the cylinder at the passed in level.
+ ***********************************************************/
+void LODMeshes::DrawCylinderMesh(
+	int level,
+	bool bDrawTop,
+	bool bDrawBottom,
+	bool bDrawSides)
+{
+	if (bDrawSides == true)
+	{
+		DrawPart(SHAPE_CYLINDER, level, PART_SIDES);
+	}
+	if (bDrawTop == true)
+	{
+		DrawPart(SHAPE_CYLINDER, level, PART_TOP);
+	}
+	if (bDrawBottom == true)
+	{
+		DrawPart(SHAPE_CYLINDER, level, PART_BOTTOM);
+	}
+}
+
+/***********************************************************
+ *  DrawConeMesh()
+ *
+ *  This method is used for drawing the cone at the passed in
+ *  level, with or without its bottom.
+ ***********************************************************/
+void LODMeshes::DrawConeMesh(
+	int level,
+	bool bDrawBottom)
+{
+	DrawPart(SHAPE_CONE, level, PART_SIDES);
+	if (bDrawBottom == true)
+	{
+		DrawPart(SHAPE_CONE, level, PART_BOTTOM);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// lodmeshes.h
+// ============
+// several levels of detail for the curved basic shapes, picked by the size
+// of an object on the screen
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshBuffer.h"
+
+/***********************************************************
+ *  LODMeshes
+ *
+ *  This class generates the sphere, cylinder and cone at
+ *  several tessellations when the meshes are loaded.  Every
+ *  level of every shape is stored in the shared mesh buffer,
+ *  and a draw just picks the index range of a level.  Each
+ *  level has about half the slices of the level before it.
+ ***********************************************************/
+class LODMeshes
+{
+public:
+	// constructor
+	LODMeshes();
+	// destructor
+	~LODMeshes();
+
+	// number of detail levels generated for each shape
+	static const int LOD_COUNT = 4;
+	// screen radius, in normalized device units, that is drawn
+	// at full detail - every halving steps one level down
+	static constexpr float FULL_DETAIL_RADIUS = 0.25f;
+
+	enum LOD_SHAPE
+	{
+		SHAPE_SPHERE = 0,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_COUNT
+	};
+
+	enum LOD_PART
+	{
+		PART_SIDES = 0,
+		PART_TOP,
+		PART_BOTTOM,
+		PART_COUNT
+	};
+
+	// detail level picked for an object, with the fraction of
+	// the next level to cross fade in - 0 when not fading
+	struct LOD_SELECTION
+	{
+		int level;
+		float blend;
+	};
+
+	// pick the detail level for an object whose bounding sphere
+	// has the passed in radius in normalized device units
+	static LOD_SELECTION SelectLevel(float screenRadius);
+
+	// generate every level of the shapes into the mesh buffer
+	void LoadMeshes(MeshBuffer* pMeshBuffer);
+	// append one part of a shape level to CPU side mesh data,
+	// such as for baking it into a static batch
+	static void AppendPart(
+		ShapeGeometry::MESH_DATA& mesh,
+		LOD_SHAPE shape,
+		int level,
+		LOD_PART part);
+
+	// draw a level of the shapes - the parts match ShapeMeshes,
+	// and the shared vertex array must be bound
+	void DrawSphereMesh(int level);
+	void DrawCylinderMesh(
+		int level,
+		bool bDrawTop = true,
+		bool bDrawBottom = true,
+		bool bDrawSides = true);
+	void DrawConeMesh(
+		int level,
+		bool bDrawBottom = true);
+
+	// get the mesh buffer range of one part of a shape level
+	const MeshBuffer::MESH_RANGE& GetRange(LOD_SHAPE shape, int level, LOD_PART part) const
+	{
+		return(m_ranges[shape][level][part]);
+	}
+
+private:
+	// mesh buffer ranges of every part at every level of every shape
+	MeshBuffer::MESH_RANGE m_ranges[SHAPE_COUNT][LOD_COUNT][PART_COUNT];
+	// true once the levels have been added to the mesh buffer
+	bool m_bLoaded;
+
+	// draw one part of a shape at the passed in level
+	void DrawPart(LOD_SHAPE shape, int level, LOD_PART part);
+};
\ No newline at end of file
@@ -1,186 +1,752 @@
-///////////////////////////////////////////////////////////////////////////////
-// maincode.cpp
-// ============
-// gets called when application is launched - initializes GLEW, GLFW
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-}
-
-// Function declarations - all functions that are called manually
-// need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
-	}
-
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
-	}
-	if (NULL != g_ViewManager)
-	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
-	}
-
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
-}
-
-/***********************************************************
- *	InitializeGLFW()
- * 
- *  This function is used to initialize the GLFW library.   
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
-	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
-	}
-	// GLEW: end -------------------------------
-
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-	return(true);
+///////////////////////////////////////////////////////////////////////////////
+// maincode.cpp
+// ============
+// gets called when application is launched - initializes GLEW, GLFW
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <string>           // command line options
+#include <cstdio>           // sscanf
+#include <algorithm>        // std::max
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "ShaderManager.h"
+#include "UniformCache.h"
+#include "StateCache.h"
+#include "UniformBlocks.h"
+#include "Profiler.h"
+#include "StreamBuffer.h"
+#include "Benchmark.h"
+#include "CameraPath.h"
+#include "JobSystem.h"
+#include "SceneFile.h"
+#include "FramePacer.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+
+	// scene manager object for managing the 3D scene prepare and render
+	SceneManager* g_SceneManager = nullptr;
+	// shader manager object for dynamic interaction with the shader code
+	ShaderManager* g_ShaderManager = nullptr;
+	// uniform cache object for the resolved shader uniform locations
+	UniformCache* g_UniformCache = nullptr;
+	// state cache object for filtering out redundant OpenGL calls
+	StateCache* g_StateCache = nullptr;
+	// uniform blocks object for the camera, light and material values
+	UniformBlocks* g_UniformBlocks = nullptr;
+	// view manager object for managing the 3D view setup and projection to 2D
+	ViewManager* g_ViewManager = nullptr;
+	// profiler object for timing the frame, only created when profiling
+	Profiler* g_Profiler = nullptr;
+	// stream buffer object for the per-frame dynamic data
+	StreamBuffer* g_StreamBuffer = nullptr;
+	// bytes of dynamic data each frame can write into the stream buffer
+	const size_t STREAM_REGION_SIZE = 4 * 1024 * 1024;
+	// job system object that the CPU side of the frame is spread over
+	JobSystem* g_JobSystem = nullptr;
+	// benchmark object for timing an offscreen run, only created
+	// in the benchmark mode
+	Benchmark* g_Benchmark = nullptr;
+
+	// command line options of the application
+	struct APP_OPTIONS
+	{
+		// how the opaque objects are culled, drawn and shaded
+		bool bGPUDriven;
+		bool bInstancing;
+		bool bCulling;
+		bool bStaticBaking;
+		SceneManager::RENDER_MODE renderMode;
+		// timing of the frame and the trace file it is written to
+		bool bProfile;
+		std::string tracePath;
+		// offscreen benchmark run
+		bool bBenchmark;
+		int benchmarkWidth;
+		int benchmarkHeight;
+		int benchmarkFrames;
+		int warmupFrames;
+		int sceneScale;
+		std::string resultsPath;
+		// camera path that is replayed by the benchmark or
+		// recorded from the interactive camera
+		std::string cameraPath;
+		std::string recordPath;
+		// worker threads of the job system - negative for one
+		// less than the number of cores
+		int workerThreads;
+		// megabytes of video memory the streamed texture levels
+		// may take - 0 for no limit
+		int textureBudgetMB;
+		// how the display swaps wait, the frame rate limit, the
+		// frames queued ahead of the GPU and the view update rate
+		FramePacer::SWAP_MODE swapMode;
+		int frameLimit;
+		int framesInFlight;
+		int updateRate;
+		// binary scene file to load instead of the built in scene
+		std::string scenePath;
+		// text scene to compile into a binary scene file, which
+		// is written without opening the window
+		std::string compileTextPath;
+		std::string compileBinaryPath;
+		// mesh file the scene is exported into for 3D printing,
+		// written in the background while the scene is drawn
+		std::string exportPath;
+		bool bExportWeld;
+	};
+}
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+bool InitializeGLFW();
+bool InitializeGLEW();
+void ParseOptions(int argc, char* argv[], APP_OPTIONS& options);
+std::string GetModeLabel(const APP_OPTIONS& options);
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	// if GLFW fails initialization, then terminate the application
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	APP_OPTIONS options;
+	ParseOptions(argc, argv, options);
+
+	if (options.compileTextPath.empty() == false)
+	{
+		bool bCompiled = SceneFile::Compile(options.compileTextPath.c_str(), options.compileBinaryPath.c_str());
+		glfwTerminate();
+		return((bCompiled == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// try to create a new shader manager object
+	g_ShaderManager = new ShaderManager();
+	// try to create a new uniform cache object
+	g_UniformCache = new UniformCache();
+	// try to create a new state cache object and filter the
+	// uniform uploads through it
+	g_StateCache = new StateCache();
+	g_UniformCache->SetStateCache(g_StateCache);
+
+	// try to create a new uniform blocks object
+	g_UniformBlocks = new UniformBlocks();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_ShaderManager,
+		g_UniformBlocks);
+
+	// try to create the main display window - the benchmark only
+	// needs the OpenGL context of a hidden window
+	if (options.bBenchmark == true)
+	{
+		g_Window = g_ViewManager->CreateHiddenWindow(WINDOW_TITLE);
+		g_ViewManager->SetViewportSize(options.benchmarkWidth, options.benchmarkHeight);
+	}
+	else
+	{
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
+
+	// if GLEW fails initialization, then terminate the application
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// create the buffers behind the shader uniform blocks
+	g_UniformBlocks->CreateBuffers();
+
+	// the per-frame dynamic data is written into a persistently
+	// mapped ring buffer, and the owners of the data keep using
+	// their own buffers when the context cannot map one
+	g_StreamBuffer = new StreamBuffer();
+	if (g_StreamBuffer->Create(STREAM_REGION_SIZE) == true)
+	{
+		g_UniformBlocks->SetStreamBuffer(g_StreamBuffer);
+	}
+
+	// the frame can be timed and shown over the scene, and the
+	// samples written to a Chrome trace file on exit
+	if (options.bProfile == true)
+	{
+		g_Profiler = new Profiler(g_StateCache);
+		g_Profiler->EnableTrace(options.tracePath.empty() == false);
+	}
+
+	// the benchmark draws into offscreen targets at the chosen
+	// resolution along a camera path - a circle around the scene
+	// unless a recorded path is passed in
+	CameraPath cameraPath;
+	if (options.bBenchmark == true)
+	{
+		g_Benchmark = new Benchmark(g_StateCache);
+		if (g_Benchmark->Create(options.benchmarkWidth, options.benchmarkHeight, options.benchmarkFrames, options.warmupFrames) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+
+		if ((options.cameraPath.empty() == true) || (cameraPath.Load(options.cameraPath.c_str()) == false))
+		{
+			cameraPath.MakeOrbit(glm::vec3(2.0f, 0.0f, 3.0f), 12.0f, 5.5f, 80.0f, 32);
+		}
+	}
+	// the interactive camera can be recorded for later runs
+	CameraPath cameraRecording;
+
+	// the record transforms, culling, light binning and render
+	// queue are built on worker threads, while the OpenGL calls
+	// and the input stay on this thread
+	g_JobSystem = new JobSystem();
+	g_JobSystem->Start(options.workerThreads);
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager, g_UniformCache, g_StateCache, g_UniformBlocks);
+	g_SceneManager->SetProfiler(g_Profiler);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	// the base scene program is compiled from the external GLSL
+	// files on the first launch and loaded as a program binary
+	// after that, and its uniform locations are resolved
+	if (g_SceneManager->LoadBaseProgram() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+	if (g_StreamBuffer->IsCreated() == true)
+	{
+		g_SceneManager->SetStreamBuffer(g_StreamBuffer);
+	}
+	g_SceneManager->SetSceneScale(options.sceneScale);
+	g_SceneManager->SetInstancing(options.bInstancing);
+	g_SceneManager->SetCulling(options.bCulling);
+	g_SceneManager->SetStaticBaking(options.bStaticBaking);
+	g_SceneManager->SetTextureBudget((size_t)options.textureBudgetMB * 1024 * 1024);
+	g_SceneManager->SetSceneFile(options.scenePath);
+	g_SceneManager->PrepareScene();
+
+	// the opaque objects can be culled and drawn by the GPU,
+	// which falls back to the render queue when it is not supported,
+	// and shaded forward, after a depth pre-pass or deferred
+	if (options.bGPUDriven == true)
+	{
+		options.bGPUDriven = g_SceneManager->SetGPUDriven(true);
+	}
+	g_SceneManager->SetRenderMode(options.renderMode);
+
+	// the export runs beside the frame loop - a binary STL file,
+	// or a 3MF package for a path ending in .3mf
+	if (options.exportPath.empty() == false)
+	{
+		g_SceneManager->ExportScene(options.exportPath, options.bExportWeld);
+	}
+
+	// the view updates run at a fixed rate apart from the frame
+	// rate, and the frames are paced for the display - the
+	// benchmark keeps the swaps of its hidden window uncapped
+	FramePacer framePacer;
+	framePacer.SetFrameLimit(options.frameLimit);
+	framePacer.SetFramesInFlight(options.framesInFlight);
+	framePacer.SetUpdateRate(options.updateRate);
+	if (NULL == g_Benchmark)
+	{
+		framePacer.SetSwapMode(options.swapMode);
+	}
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		// the benchmark ends after its last frame, and moves the
+		// camera along its path instead of taking input
+		if (NULL != g_Benchmark)
+		{
+			if (g_Benchmark->IsFinished() == true)
+			{
+				break;
+			}
+			g_ViewManager->SetCameraKey(cameraPath.Sample(g_Benchmark->GetProgress()));
+		}
+
+		// start timing the frame
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+
+		// wait for the GPU and the frame rate limit before the
+		// input is read, so the frame shows the newest input
+		{
+			Profiler::ScopedSection section(g_Profiler, "Pacing");
+			framePacer.BeginFrame();
+		}
+
+		// query the latest GLFW events and run the view updates
+		// that are due
+		glfwPollEvents();
+		while (framePacer.TakeUpdateStep() == true)
+		{
+			g_ViewManager->UpdateView(framePacer.GetTimeStep());
+		}
+
+		// start counting the filtered calls for this frame
+		g_StateCache->ResetFrameCounters();
+		// move to the stream buffer region of this frame
+		g_StreamBuffer->BeginFrame();
+
+		// draw the benchmark frames into the offscreen target
+		if (NULL != g_Benchmark)
+		{
+			g_Benchmark->BeginFrame();
+		}
+
+		// Enable z-depth
+		g_StateCache->Enable(GL_DEPTH_TEST);
+
+		// Clear the frame and z buffers
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// convert from 3D object space to 2D view
+		{
+			Profiler::ScopedSection section(g_Profiler, "View");
+			g_ViewManager->PrepareSceneView(framePacer.GetInterpolation());
+		}
+		if (options.recordPath.empty() == false)
+		{
+			cameraRecording.AddKey(g_ViewManager->GetCameraKey());
+		}
+
+		// pass the view of this frame on for ordering the draws
+		g_SceneManager->SetSceneView(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewPosition());
+
+		// find the object under the view when a pick is requested
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+		if (g_ViewManager->TakePickRay(pickOrigin, pickDirection) == true)
+		{
+			g_SceneManager->PickSceneObject(pickOrigin, pickDirection);
+		}
+
+		// refresh the 3D scene
+		{
+			Profiler::ScopedSection section(g_Profiler, "Render");
+			g_SceneManager->RenderScene();
+		}
+
+		// show the frame times over the scene and in the title
+		if ((NULL != g_Profiler) && (NULL == g_Benchmark))
+		{
+			int width = 0;
+			int height = 0;
+			glfwGetFramebufferSize(g_Window, &width, &height);
+			g_Profiler->DrawOverlay(width, height);
+
+			std::string report;
+			if (g_Profiler->TakeReport(report) == true)
+			{
+				glfwSetWindowTitle(g_Window, (std::string(WINDOW_TITLE) + " - " + report).c_str());
+			}
+		}
+
+		// fence the stream buffer region after the last draw
+		g_StreamBuffer->EndFrame();
+
+		// Flips the the back buffer with the front buffer every frame.
+		{
+			Profiler::ScopedSection section(g_Profiler, "Swap");
+			glfwSwapBuffers(g_Window);
+		}
+		framePacer.EndFrame();
+
+		if (NULL != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+		if (NULL != g_Benchmark)
+		{
+			g_Benchmark->EndFrame();
+		}
+	}
+
+	// report how many redundant OpenGL calls were filtered out
+	std::cout << "INFO: State cache filtered " << g_StateCache->GetFilteredCount()
+		<< " of " << (g_StateCache->GetFilteredCount() + g_StateCache->GetIssuedCount())
+		<< " state changes and uniform uploads" << std::endl;
+
+	// write the kept profiler samples, the benchmark results and
+	// the recorded camera path
+	if ((NULL != g_Profiler) && (options.tracePath.empty() == false))
+	{
+		g_Profiler->WriteTrace(options.tracePath.c_str());
+	}
+	if (NULL != g_Benchmark)
+	{
+		g_Benchmark->WriteResults(options.resultsPath.c_str(), GetModeLabel(options), g_SceneManager->GetObjectCount());
+	}
+	if (options.recordPath.empty() == false)
+	{
+		cameraRecording.Save(options.recordPath.c_str());
+	}
+
+	// clear the allocated manager objects from memory
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
+	if (NULL != g_Benchmark)
+	{
+		delete g_Benchmark;
+		g_Benchmark = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_UniformBlocks)
+	{
+		delete g_UniformBlocks;
+		g_UniformBlocks = NULL;
+	}
+	if (NULL != g_StreamBuffer)
+	{
+		delete g_StreamBuffer;
+		g_StreamBuffer = NULL;
+	}
+	if (NULL != g_UniformCache)
+	{
+		delete g_UniformCache;
+		g_UniformCache = NULL;
+	}
+	if (NULL != g_Profiler)
+	{
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
+	if (NULL != g_StateCache)
+	{
+		delete g_StateCache;
+		g_StateCache = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+
+	// Terminates the program successfully
+	exit(EXIT_SUCCESS); 
+}
+
+/***********************************************************
+ *  ParseOptions()
+ *
+ *  This function is used to read the command line options.
+ *  Unknown options are ignored, and the value of an option
+ *  that is missing or not a number keeps its default.
+ ***********************************************************/
+void ParseOptions(int argc, char* argv[], APP_OPTIONS& options)
+{
+	options.bGPUDriven = false;
+	options.bInstancing = true;
+	options.bCulling = true;
+	options.bStaticBaking = false;
+	options.renderMode = SceneManager::RENDER_FORWARD;
+	options.bProfile = false;
+	options.bBenchmark = false;
+	options.benchmarkWidth = 1920;
+	options.benchmarkHeight = 1080;
+	options.benchmarkFrames = 600;
+	options.warmupFrames = 60;
+	options.sceneScale = 1;
+	options.resultsPath = "benchmark.csv";
+	options.workerThreads = -1;
+	options.textureBudgetMB = 0;
+	options.swapMode = FramePacer::SWAP_VSYNC;
+	options.frameLimit = 0;
+	options.framesInFlight = 2;
+	options.updateRate = 120;
+	options.bExportWeld = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+		bool bHasValue = (i + 1 < argc);
+
+		if (option == "--gpu-driven")
+		{
+			options.bGPUDriven = true;
+		}
+		else if (option == "--no-instancing")
+		{
+			options.bInstancing = false;
+		}
+		else if (option == "--no-culling")
+		{
+			options.bCulling = false;
+		}
+		else if (option == "--static-baking")
+		{
+			options.bStaticBaking = true;
+		}
+		else if (option == "--depth-prepass")
+		{
+			options.renderMode = SceneManager::RENDER_DEPTH_PREPASS;
+		}
+		else if (option == "--deferred")
+		{
+			options.renderMode = SceneManager::RENDER_DEFERRED;
+		}
+		else if (option == "--profile")
+		{
+			options.bProfile = true;
+		}
+		else if ((option == "--trace") && (bHasValue == true))
+		{
+			options.bProfile = true;
+			options.tracePath = argv[++i];
+		}
+		else if (option == "--benchmark")
+		{
+			options.bBenchmark = true;
+		}
+		else if ((option == "--resolution") && (bHasValue == true))
+		{
+			int width = 0;
+			int height = 0;
+			if ((sscanf(argv[++i], "%dx%d", &width, &height) == 2) && (width > 0) && (height > 0))
+			{
+				options.benchmarkWidth = width;
+				options.benchmarkHeight = height;
+			}
+		}
+		else if ((option == "--frames") && (bHasValue == true))
+		{
+			options.benchmarkFrames = std::max(atoi(argv[++i]), 1);
+		}
+		else if ((option == "--warmup") && (bHasValue == true))
+		{
+			options.warmupFrames = std::max(atoi(argv[++i]), 0);
+		}
+		else if ((option == "--scale") && (bHasValue == true))
+		{
+			options.sceneScale = std::max(atoi(argv[++i]), 1);
+		}
+		else if ((option == "--results") && (bHasValue == true))
+		{
+			options.resultsPath = argv[++i];
+		}
+		else if ((option == "--camera-path") && (bHasValue == true))
+		{
+			options.cameraPath = argv[++i];
+		}
+		else if ((option == "--record-camera") && (bHasValue == true))
+		{
+			options.recordPath = argv[++i];
+		}
+		else if ((option == "--threads") && (bHasValue == true))
+		{
+			options.workerThreads = std::max(atoi(argv[++i]), 0);
+		}
+		else if ((option == "--texture-budget") && (bHasValue == true))
+		{
+			options.textureBudgetMB = std::max(atoi(argv[++i]), 0);
+		}
+		else if ((option == "--swap") && (bHasValue == true))
+		{
+			std::string swapMode = argv[++i];
+			if (swapMode == "adaptive")
+			{
+				options.swapMode = FramePacer::SWAP_ADAPTIVE;
+			}
+			else if (swapMode == "uncapped")
+			{
+				options.swapMode = FramePacer::SWAP_UNCAPPED;
+			}
+			else
+			{
+				options.swapMode = FramePacer::SWAP_VSYNC;
+			}
+		}
+		else if ((option == "--fps-limit") && (bHasValue == true))
+		{
+			options.frameLimit = std::max(atoi(argv[++i]), 0);
+		}
+		else if ((option == "--frames-in-flight") && (bHasValue == true))
+		{
+			options.framesInFlight = std::min(std::max(atoi(argv[++i]), 0), FramePacer::MAX_FRAMES_IN_FLIGHT);
+		}
+		else if ((option == "--update-rate") && (bHasValue == true))
+		{
+			options.updateRate = std::max(atoi(argv[++i]), 1);
+		}
+		else if ((option == "--scene") && (bHasValue == true))
+		{
+			options.scenePath = argv[++i];
+		}
+		else if ((option == "--export") && (bHasValue == true))
+		{
+			options.exportPath = argv[++i];
+		}
+		else if (option == "--weld")
+		{
+			options.bExportWeld = true;
+		}
+		else if ((option == "--compile-scene") && (i + 2 < argc))
+		{
+			options.compileTextPath = argv[++i];
+			options.compileBinaryPath = argv[++i];
+		}
+	}
+}
+
+/***********************************************************
+ *  GetModeLabel()
+ *
+ *  This function is used to name the drawing mode of a run
+ *  for the benchmark results, such as "deferred+gpu-driven".
+ ***********************************************************/
+std::string GetModeLabel(const APP_OPTIONS& options)
+{
+	std::string label;
+
+	switch (options.renderMode)
+	{
+	case SceneManager::RENDER_DEPTH_PREPASS:
+		label = "depth-prepass";
+		break;
+	case SceneManager::RENDER_DEFERRED:
+		label = "deferred";
+		break;
+	default:
+		label = "forward";
+		break;
+	}
+
+	if (options.bGPUDriven == true)
+	{
+		label += "+gpu-driven";
+	}
+	if (options.bInstancing == false)
+	{
+		label += "+no-instancing";
+	}
+	if (options.bCulling == false)
+	{
+		label += "+no-culling";
+	}
+	if (options.bStaticBaking == true)
+	{
+		label += "+static-baking";
+	}
+	if (options.workerThreads >= 0)
+	{
+		label += "+threads-" + std::to_string(options.workerThreads);
+	}
+	if (options.textureBudgetMB > 0)
+	{
+		label += "+texture-budget-" + std::to_string(options.textureBudgetMB);
+	}
+	if (options.frameLimit > 0)
+	{
+		label += "+fps-limit-" + std::to_string(options.frameLimit);
+	}
+	if (options.framesInFlight != 2)
+	{
+		label += "+frames-in-flight-" + std::to_string(options.framesInFlight);
+	}
+
+	return(label);
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ * 
+ *  This function is used to initialize the GLFW library.   
+ ***********************************************************/
+bool InitializeGLFW()
+{
+	// GLFW: initialize and configure library
+	// --------------------------------------
+	glfwInit();
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	GLEWInitResult = glewInit();
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
 }
\ No newline at end of file
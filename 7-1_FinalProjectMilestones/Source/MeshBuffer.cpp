@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.cpp
+// ============
+// one shared vertex and index buffer behind a single vertex array object
+// for every mesh drawn by the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshBuffer.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// vertex attribute locations used by the vertex shader
+	const GLuint g_PositionLocation = 0;
+	const GLuint g_NormalLocation = 1;
+	const GLuint g_TextureCoordLocation = 2;
+}
+
+/***********************************************************
+ *  MeshBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshBuffer::MeshBuffer()
+{
+	m_vao = 0;
+	m_vbos[0] = 0;
+	m_vbos[1] = 0;
+}
+
+/***********************************************************
+ *  ~MeshBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshBuffer::~MeshBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for appending the data of a mesh to
+ *  the data that will be uploaded.  The indices of the mesh
+ *  are kept relative to its own vertices, and the returned
+ *  base vertex moves them onto the shared vertices.
+ ***********************************************************/
+MeshBuffer::MESH_RANGE MeshBuffer::AddMesh(const ShapeGeometry::MESH_DATA& mesh)
+{
+	MESH_RANGE range;
+
+	range.firstIndex = (GLuint)m_indices.size();
+	range.indexCount = 0;
+	range.baseVertex = (GLint)(m_vertices.size() / ShapeGeometry::FLOATS_PER_VERTEX);
+
+	// the buffers are not resized once they have been created
+	if (m_vao != 0)
+	{
+		std::cout << "Meshes cannot be added after the mesh buffer is uploaded" << std::endl;
+		return(range);
+	}
+
+	range.indexCount = (GLuint)mesh.indices.size();
+	m_vertices.insert(m_vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+	m_indices.insert(m_indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+	return(range);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for creating the shared buffers from
+ *  the added meshes and describing the vertex layout.  The
+ *  added data is freed once it is in the buffers.
+ ***********************************************************/
+void MeshBuffer::Upload()
+{
+	const GLsizei vertexStride = sizeof(float) * ShapeGeometry::FLOATS_PER_VERTEX;
+
+	// only upload the buffers once
+	if (m_vao != 0)
+	{
+		return;
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(2, m_vbos);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbos[0]);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vbos[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(uint32_t), m_indices.data(), GL_STATIC_DRAW);
+
+	// the per-vertex attributes all read from the vertex binding
+	glBindVertexBuffer(VERTEX_BINDING, m_vbos[0], 0, vertexStride);
+	glVertexAttribFormat(g_PositionLocation, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexAttribBinding(g_PositionLocation, VERTEX_BINDING);
+	glEnableVertexAttribArray(g_PositionLocation);
+	glVertexAttribFormat(g_NormalLocation, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3);
+	glVertexAttribBinding(g_NormalLocation, VERTEX_BINDING);
+	glEnableVertexAttribArray(g_NormalLocation);
+	glVertexAttribFormat(g_TextureCoordLocation, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 6);
+	glVertexAttribBinding(g_TextureCoordLocation, VERTEX_BINDING);
+	glEnableVertexAttribArray(g_TextureCoordLocation);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	std::cout << "INFO: Mesh buffer holds " << (m_vertices.size() / ShapeGeometry::FLOATS_PER_VERTEX)
+		<< " vertices and " << m_indices.size() << " indices" << std::endl;
+
+	m_vertices.clear();
+	m_vertices.shrink_to_fit();
+	m_indices.clear();
+	m_indices.shrink_to_fit();
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the shared vertex array
+ *  object.  It stays bound for every mesh that is drawn.
+ ***********************************************************/
+void MeshBuffer::Bind()
+{
+	glBindVertexArray(m_vao);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shared buffers.
+ ***********************************************************/
+void MeshBuffer::Destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(2, m_vbos);
+	}
+	m_vao = 0;
+	m_vbos[0] = 0;
+	m_vbos[1] = 0;
+	m_vertices.clear();
+	m_indices.clear();
+}
+
+/***********************************************************
+ *  DrawRange()
+ *
+ *  This method is used for drawing a mesh range from the
+ *  bound shared buffers.
+ ***********************************************************/
+void MeshBuffer::DrawRange(const MESH_RANGE& range)
+{
+	if (range.indexCount == 0)
+	{
+		return;
+	}
+
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(uint32_t) * range.firstIndex),
+		range.baseVertex);
+}
+
+/***********************************************************
+ *  DrawRangeInstanced()
+ *
+ *  This method is used for drawing several instances of a
+ *  mesh range from the bound shared buffers.
+ ***********************************************************/
+void MeshBuffer::DrawRangeInstanced(const MESH_RANGE& range, int instanceCount)
+{
+	if ((range.indexCount == 0) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	glDrawElementsInstancedBaseVertex(
+		GL_TRIANGLES,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(uint32_t) * range.firstIndex),
+		instanceCount,
+		range.baseVertex);
+}
\ No newline at end of file
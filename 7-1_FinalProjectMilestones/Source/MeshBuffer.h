@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.h
+// ============
+// one shared vertex and index buffer behind a single vertex array object
+// for every mesh drawn by the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshBuffer
+ *
+ *  This class packs the vertex and index data of every mesh
+ *  into one interleaved vertex buffer and one index buffer.
+ *  A mesh is drawn from its range of the index buffer, with a
+ *  base vertex, so switching between meshes never rebinds a
+ *  vertex array object.  The vertex array uses separate
+ *  attribute bindings, so a per-instance attribute buffer can
+ *  be bound next to the shared vertices.
+ ***********************************************************/
+class MeshBuffer
+{
+public:
+	// constructor
+	MeshBuffer();
+	// destructor
+	~MeshBuffer();
+
+	// vertex buffer binding points of the vertex array object
+	enum BUFFER_BINDING
+	{
+		VERTEX_BINDING = 0,
+		INSTANCE_BINDING = 1,
+		OBJECT_INDEX_BINDING = 2
+	};
+
+	// range of the shared buffers that draws one mesh
+	struct MESH_RANGE
+	{
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+	};
+
+	// add the data of a mesh - meshes are added before the upload
+	MESH_RANGE AddMesh(const ShapeGeometry::MESH_DATA& mesh);
+	// copy the added meshes into the shared buffers
+	void Upload();
+	// bind the shared vertex array object
+	void Bind();
+	// free the shared buffers
+	void Destroy();
+
+	// draw a mesh range from the bound shared buffers
+	static void DrawRange(const MESH_RANGE& range);
+	static void DrawRangeInstanced(const MESH_RANGE& range, int instanceCount);
+
+	GLuint GetVertexArray() const { return(m_vao); }
+	GLuint GetIndexBuffer() const { return(m_vbos[1]); }
+
+private:
+	// vertex and index data added before the upload
+	std::vector<float> m_vertices;
+	std::vector<uint32_t> m_indices;
+	// vertex array object and the shared vertex and index buffers
+	GLuint m_vao;
+	GLuint m_vbos[2];
+};
\ No newline at end of file
@@ -0,0 +1,692 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshexporter.cpp
+// ============
+// stream the scene's triangles into a binary STL or 3MF file for 3D printing
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// the most triangles in one chunk of parts - a part with
+	// more triangles makes a chunk of its own
+	const size_t g_ChunkTriangles = 65536;
+	// distance under which welded vertices are merged
+	const float g_WeldTolerance = 1.0e-5f;
+	// bytes of a binary STL header and of one triangle record
+	const int g_StlHeaderSize = 80;
+	const int g_StlTriangleSize = 50;
+	// the largest offset or size the zip headers can hold
+	const uint64_t g_MaxZipSize = 0xFFFFFFFFull;
+	// file date of the package entries - the 1st of January 1980
+	const uint16_t g_ZipDate = (1 << 5) | 1;
+
+	// parts of a 3MF package besides the streamed model
+	const char* g_ContentTypesName = "[Content_Types].xml";
+	const char* g_ContentTypes =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+		"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+		"<Default Extension=\"model\" ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>"
+		"</Types>\n";
+	const char* g_RelationshipsName = "_rels/.rels";
+	const char* g_Relationships =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+		"<Relationship Target=\"/3D/3dmodel.model\" Id=\"rel0\" Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel\"/>"
+		"</Relationships>\n";
+	const char* g_ModelName = "3D/3dmodel.model";
+	const char* g_ModelHeader =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<model unit=\"millimeter\" xml:lang=\"en-US\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\">\n"
+		"<resources>\n";
+
+	// vertex of a part with its position rounded to the weld
+	// tolerance, sorted so equal positions end up side by side
+	struct WELD_VERTEX
+	{
+		int64_t x;
+		int64_t y;
+		int64_t z;
+		uint32_t index;
+
+		bool operator<(const WELD_VERTEX& other) const
+		{
+			if (x != other.x) return(x < other.x);
+			if (y != other.y) return(y < other.y);
+			if (z != other.z) return(z < other.z);
+			return(index < other.index);
+		}
+	};
+
+	// the turn from the Y up scene onto the Z up printing axes
+	glm::mat4 MakeZUpMatrix()
+	{
+		glm::mat4 matrix = glm::mat4(1.0f);
+		matrix[1][1] = 0.0f;
+		matrix[1][2] = 1.0f;
+		matrix[2][1] = -1.0f;
+		matrix[2][2] = 0.0f;
+		return(matrix);
+	}
+
+	// build the byte table of the CRC-32 used by zip files
+	std::vector<uint32_t> BuildCrcTable()
+	{
+		std::vector<uint32_t> table(256);
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = ((value & 1) != 0) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+			}
+			table[i] = value;
+		}
+		return(table);
+	}
+
+	// add the bytes of a CRC-32 to the running value, which
+	// starts at all ones and is inverted once the last byte is in
+	uint32_t UpdateCrc(uint32_t crc, const unsigned char* pData, size_t size)
+	{
+		static const std::vector<uint32_t> table = BuildCrcTable();
+
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return(crc);
+	}
+
+	// append a little endian value of the passed in byte size
+	void AppendValue(std::string& bytes, uint32_t value, int size)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			bytes.push_back((char)((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	// append a float as its 4 stored bytes
+	void AppendFloat(std::string& bytes, float value)
+	{
+		char stored[4];
+		memcpy(stored, &value, sizeof(stored));
+		bytes.append(stored, sizeof(stored));
+	}
+}
+
+/***********************************************************
+ *  MeshExporter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshExporter::MeshExporter()
+{
+	m_pJobSystem = NULL;
+	m_bExporting = false;
+	m_format = FORMAT_STL;
+	m_bWeld = false;
+	m_pFile = NULL;
+	m_fileOffset = 0;
+	m_bWriteFailed = false;
+}
+
+/***********************************************************
+ *  ~MeshExporter()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshExporter::~MeshExporter()
+{
+	Wait();
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  GetFormat()
+ *
+ *  This method is used for picking the format of a file
+ *  from its extension.
+ ***********************************************************/
+MeshExporter::EXPORT_FORMAT MeshExporter::GetFormat(const std::string& filePath)
+{
+	std::string extension;
+	size_t dot = filePath.find_last_of('.');
+	if (dot != std::string::npos)
+	{
+		extension = filePath.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	}
+
+	return((extension == "3mf") ? FORMAT_3MF : FORMAT_STL);
+}
+
+/***********************************************************
+ *  StartExport()
+ *
+ *  This method is used for handing the parts of the scene
+ *  to the export thread.  The meshes and parts are swapped
+ *  in, so the scene can change while the file is written.
+ ***********************************************************/
+bool MeshExporter::StartExport(
+	const std::string& filePath,
+	std::vector<ShapeGeometry::MESH_DATA>& meshes,
+	std::vector<EXPORT_PART>& parts,
+	bool bWeld)
+{
+	if (m_bExporting.load() == true)
+	{
+		std::cout << "An export is already running" << std::endl;
+		return(false);
+	}
+	Wait();
+
+	m_filePath = filePath;
+	m_format = GetFormat(filePath);
+	m_bWeld = bWeld;
+	m_meshes.clear();
+	m_meshes.swap(meshes);
+	m_parts.clear();
+	m_parts.swap(parts);
+
+	m_bExporting = true;
+	m_thread = std::thread(&MeshExporter::RunExport, this);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for waiting until the export thread
+ *  has finished writing.
+ ***********************************************************/
+void MeshExporter::Wait()
+{
+	if (m_thread.joinable() == true)
+	{
+		m_thread.join();
+	}
+}
+
+/***********************************************************
+ *  RunExport()
+ *
+ *  This method is run by the export thread.  The parts are
+ *  taken in chunks, each chunk is built in parallel and then
+ *  written before the next one is built.  The triangle count
+ *  of an STL file is only known at the end, so it is written
+ *  into the header last.
+ ***********************************************************/
+void MeshExporter::RunExport()
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	const int partCount = (int)m_parts.size();
+	uint64_t triangleCount = 0;
+	std::vector<int> objectIDs;
+
+	m_pFile = fopen(m_filePath.c_str(), "wb");
+	if (NULL == m_pFile)
+	{
+		std::cout << "Could not open export file:" << m_filePath << std::endl;
+		m_bExporting = false;
+		return;
+	}
+	m_fileOffset = 0;
+	m_zipEntries.clear();
+	m_bWriteFailed = false;
+
+	if (m_format == FORMAT_STL)
+	{
+		char header[g_StlHeaderSize];
+		memset(header, 0, sizeof(header));
+		strncpy(header, "binary STL exported from the scene", sizeof(header) - 1);
+		uint32_t placeholderCount = 0;
+		WriteBytes(header, sizeof(header));
+		WriteBytes(&placeholderCount, sizeof(placeholderCount));
+	}
+	else
+	{
+		WriteZipEntry(g_ContentTypesName, g_ContentTypes);
+		WriteZipEntry(g_RelationshipsName, g_Relationships);
+		BeginZipEntry(g_ModelName);
+		WriteZipData(g_ModelHeader);
+	}
+
+	JobSystem::RANGE_FUNCTION buildParts;
+	int first = 0;
+	while ((first < partCount) && (m_bWriteFailed == false))
+	{
+		// gather the parts of the next chunk
+		int last = first;
+		size_t chunkTriangles = 0;
+		while (last < partCount)
+		{
+			size_t partTriangles = m_meshes[m_parts[last].meshIndex].indices.size() / 3;
+			if ((last > first) && (chunkTriangles + partTriangles > g_ChunkTriangles))
+			{
+				break;
+			}
+			chunkTriangles += partTriangles;
+			last++;
+		}
+
+		m_outputs.resize(last - first);
+		buildParts = [this, first](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				BuildPart(first + i, m_outputs[i]);
+			}
+		};
+
+		if (NULL != m_pJobSystem)
+		{
+			m_pJobSystem->ParallelFor(last - first, 1, buildParts);
+		}
+		else
+		{
+			buildParts(0, last - first);
+		}
+
+		// the parts are written in order, so the file is the same
+		// no matter how the chunk was split over the threads
+		for (int i = 0; i < last - first; i++)
+		{
+			if (m_outputs[i].triangleCount == 0)
+			{
+				continue;
+			}
+
+			if (m_format == FORMAT_STL)
+			{
+				WriteBytes(m_outputs[i].data.data(), m_outputs[i].data.size());
+			}
+			else
+			{
+				WriteZipData(m_outputs[i].data);
+				objectIDs.push_back(first + i + 1);
+			}
+			triangleCount += m_outputs[i].triangleCount;
+		}
+
+		first = last;
+	}
+
+	if (m_format == FORMAT_STL)
+	{
+		if (triangleCount > g_MaxZipSize)
+		{
+			m_bWriteFailed = true;
+		}
+		else
+		{
+			uint32_t storedCount = (uint32_t)triangleCount;
+			fseek(m_pFile, g_StlHeaderSize, SEEK_SET);
+			if (fwrite(&storedCount, sizeof(storedCount), 1, m_pFile) != 1)
+			{
+				m_bWriteFailed = true;
+			}
+		}
+	}
+	else
+	{
+		// every object is placed once, where its vertices already are
+		std::string build = "</resources>\n<build>\n";
+		char line[64];
+		for (size_t i = 0; i < objectIDs.size(); i++)
+		{
+			snprintf(line, sizeof(line), "<item objectid=\"%d\"/>\n", objectIDs[i]);
+			build += line;
+		}
+		build += "</build>\n</model>\n";
+		WriteZipData(build);
+		EndZipEntry();
+		WriteZipDirectory();
+	}
+
+	if (fclose(m_pFile) != 0)
+	{
+		m_bWriteFailed = true;
+	}
+	m_pFile = NULL;
+
+	if (m_bWriteFailed == true)
+	{
+		std::cout << "Could not write export file:" << m_filePath << std::endl;
+	}
+	else
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+		std::cout << "INFO: Exported " << triangleCount << " triangles of " << partCount << " parts to "
+			<< m_filePath << " in " << elapsed.count() << " ms" << std::endl;
+	}
+
+	// nothing of the export is kept once the file is written
+	std::vector<PART_OUTPUT>().swap(m_outputs);
+	std::vector<ShapeGeometry::MESH_DATA>().swap(m_meshes);
+	std::vector<EXPORT_PART>().swap(m_parts);
+	m_bExporting = false;
+}
+
+/***********************************************************
+ *  BuildPart()
+ *
+ *  This method is used for turning one part into the data of
+ *  the file format - triangle records with a face normal for
+ *  STL, or a mesh object for 3MF, whose object ID is one past
+ *  the part index.
+ ***********************************************************/
+void MeshExporter::BuildPart(int partIndex, PART_OUTPUT& output) const
+{
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+
+	TransformPart(partIndex, positions, indices);
+
+	output.data.clear();
+	output.triangleCount = (uint32_t)(indices.size() / 3);
+	if (output.triangleCount == 0)
+	{
+		return;
+	}
+
+	if (m_format == FORMAT_STL)
+	{
+		output.data.reserve(indices.size() / 3 * g_StlTriangleSize);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			glm::vec3 a = glm::vec3(positions[indices[i] * 3], positions[(indices[i] * 3) + 1], positions[(indices[i] * 3) + 2]);
+			glm::vec3 b = glm::vec3(positions[indices[i + 1] * 3], positions[(indices[i + 1] * 3) + 1], positions[(indices[i + 1] * 3) + 2]);
+			glm::vec3 c = glm::vec3(positions[indices[i + 2] * 3], positions[(indices[i + 2] * 3) + 1], positions[(indices[i + 2] * 3) + 2]);
+			glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+
+			AppendFloat(output.data, normal.x);
+			AppendFloat(output.data, normal.y);
+			AppendFloat(output.data, normal.z);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const float* pPosition = &positions[indices[i + corner] * 3];
+				AppendFloat(output.data, pPosition[0]);
+				AppendFloat(output.data, pPosition[1]);
+				AppendFloat(output.data, pPosition[2]);
+			}
+			AppendValue(output.data, 0, 2);
+		}
+		return;
+	}
+
+	char line[128];
+	snprintf(line, sizeof(line), "<object id=\"%d\" type=\"model\"><mesh><vertices>\n", partIndex + 1);
+	output.data += line;
+	for (size_t i = 0; i < positions.size(); i += 3)
+	{
+		snprintf(line, sizeof(line), "<vertex x=\"%.6g\" y=\"%.6g\" z=\"%.6g\"/>\n", positions[i], positions[i + 1], positions[i + 2]);
+		output.data += line;
+	}
+	output.data += "</vertices><triangles>\n";
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		snprintf(line, sizeof(line), "<triangle v1=\"%u\" v2=\"%u\" v3=\"%u\"/>\n", indices[i], indices[i + 1], indices[i + 2]);
+		output.data += line;
+	}
+	output.data += "</triangles></mesh></object>\n";
+}
+
+/***********************************************************
+ *  TransformPart()
+ *
+ *  This method is used for moving the vertices of a part
+ *  into Z up world space.  When welding, the vertices that
+ *  round to the same position are merged into the first of
+ *  them.  Triangles without area are dropped either way,
+ *  since the printing tools reject them.
+ ***********************************************************/
+void MeshExporter::TransformPart(
+	int partIndex,
+	std::vector<float>& positions,
+	std::vector<uint32_t>& indices) const
+{
+	const EXPORT_PART& part = m_parts[partIndex];
+	const ShapeGeometry::MESH_DATA& mesh = m_meshes[part.meshIndex];
+	const uint32_t vertexCount = (uint32_t)(mesh.vertices.size() / ShapeGeometry::FLOATS_PER_VERTEX);
+	std::vector<uint32_t> remap(vertexCount);
+
+	ShapeGeometry::TransformPositions(mesh, MakeZUpMatrix() * part.model, positions);
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		remap[i] = i;
+	}
+
+	if (m_bWeld == true)
+	{
+		std::vector<WELD_VERTEX> sorted(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			sorted[i].x = (int64_t)std::llround(positions[i * 3] / g_WeldTolerance);
+			sorted[i].y = (int64_t)std::llround(positions[(i * 3) + 1] / g_WeldTolerance);
+			sorted[i].z = (int64_t)std::llround(positions[(i * 3) + 2] / g_WeldTolerance);
+			sorted[i].index = i;
+		}
+		std::sort(sorted.begin(), sorted.end());
+
+		// compact the kept vertices to the front of the positions
+		std::vector<float> welded;
+		welded.reserve(positions.size());
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			bool bSame = (i > 0) &&
+				(sorted[i].x == sorted[i - 1].x) &&
+				(sorted[i].y == sorted[i - 1].y) &&
+				(sorted[i].z == sorted[i - 1].z);
+			if (bSame == false)
+			{
+				const float* pPosition = &positions[sorted[i].index * 3];
+				welded.push_back(pPosition[0]);
+				welded.push_back(pPosition[1]);
+				welded.push_back(pPosition[2]);
+			}
+			remap[sorted[i].index] = (uint32_t)(welded.size() / 3) - 1;
+		}
+		positions.swap(welded);
+	}
+
+	indices.clear();
+	indices.reserve(mesh.indices.size());
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		uint32_t a = remap[mesh.indices[i]];
+		uint32_t b = remap[mesh.indices[i + 1]];
+		uint32_t c = remap[mesh.indices[i + 2]];
+		if ((a == b) || (b == c) || (a == c))
+		{
+			continue;
+		}
+
+		glm::vec3 pointA = glm::vec3(positions[a * 3], positions[(a * 3) + 1], positions[(a * 3) + 2]);
+		glm::vec3 pointB = glm::vec3(positions[b * 3], positions[(b * 3) + 1], positions[(b * 3) + 2]);
+		glm::vec3 pointC = glm::vec3(positions[c * 3], positions[(c * 3) + 1], positions[(c * 3) + 2]);
+		if (glm::length(glm::cross(pointB - pointA, pointC - pointA)) <= 0.0f)
+		{
+			continue;
+		}
+
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+}
+
+/***********************************************************
+ *  WriteBytes()
+ *
+ *  This method is used for writing bytes at the end of the
+ *  export file.  A failed write is remembered and stops the
+ *  rest of the export.
+ ***********************************************************/
+void MeshExporter::WriteBytes(const void* pData, size_t size)
+{
+	if ((m_bWriteFailed == true) || (size == 0))
+	{
+		return;
+	}
+
+	if (fwrite(pData, 1, size, m_pFile) != size)
+	{
+		m_bWriteFailed = true;
+		return;
+	}
+	m_fileOffset += size;
+}
+
+/***********************************************************
+ *  WriteZipEntry()
+ *
+ *  This method is used for writing a whole entry of the 3MF
+ *  package, such as its content types.
+ ***********************************************************/
+void MeshExporter::WriteZipEntry(const char* name, const std::string& data)
+{
+	BeginZipEntry(name);
+	WriteZipData(data);
+	EndZipEntry();
+}
+
+/***********************************************************
+ *  BeginZipEntry()
+ *
+ *  This method is used for writing the local header of a
+ *  stored package entry.  The sizes and the checksum follow
+ *  the data in a descriptor, so the entry can be streamed.
+ ***********************************************************/
+void MeshExporter::BeginZipEntry(const char* name)
+{
+	ZIP_ENTRY entry;
+	entry.name = name;
+	entry.crc = 0xFFFFFFFFu;
+	entry.size = 0;
+	entry.offset = (uint32_t)m_fileOffset;
+	m_zipEntries.push_back(entry);
+
+	std::string header;
+	AppendValue(header, 0x04034B50, 4);
+	AppendValue(header, 20, 2);
+	// the sizes follow the data
+	AppendValue(header, 0x0008, 2);
+	// stored without compression
+	AppendValue(header, 0, 2);
+	AppendValue(header, 0, 2);
+	AppendValue(header, g_ZipDate, 2);
+	AppendValue(header, 0, 4);
+	AppendValue(header, 0, 4);
+	AppendValue(header, 0, 4);
+	AppendValue(header, (uint32_t)entry.name.size(), 2);
+	AppendValue(header, 0, 2);
+	header += entry.name;
+	WriteBytes(header.data(), header.size());
+}
+
+/***********************************************************
+ *  WriteZipData()
+ *
+ *  This method is used for writing data into the current
+ *  package entry and adding it to the entry's checksum.
+ ***********************************************************/
+void MeshExporter::WriteZipData(const std::string& data)
+{
+	ZIP_ENTRY& entry = m_zipEntries.back();
+
+	if ((uint64_t)entry.size + data.size() > g_MaxZipSize)
+	{
+		std::cout << "The 3MF model is too large for a package without zip64 extensions" << std::endl;
+		m_bWriteFailed = true;
+		return;
+	}
+
+	entry.crc = UpdateCrc(entry.crc, (const unsigned char*)data.data(), data.size());
+	entry.size += (uint32_t)data.size();
+	WriteBytes(data.data(), data.size());
+}
+
+/***********************************************************
+ *  EndZipEntry()
+ *
+ *  This method is used for writing the data descriptor that
+ *  ends the current package entry.
+ ***********************************************************/
+void MeshExporter::EndZipEntry()
+{
+	ZIP_ENTRY& entry = m_zipEntries.back();
+	entry.crc ^= 0xFFFFFFFFu;
+
+	std::string descriptor;
+	AppendValue(descriptor, 0x08074B50, 4);
+	AppendValue(descriptor, entry.crc, 4);
+	AppendValue(descriptor, entry.size, 4);
+	AppendValue(descriptor, entry.size, 4);
+	WriteBytes(descriptor.data(), descriptor.size());
+}
+
+/***********************************************************
+ *  WriteZipDirectory()
+ *
+ *  This method is used for writing the central directory of
+ *  the package and the record that points at it.
+ ***********************************************************/
+void MeshExporter::WriteZipDirectory()
+{
+	if (m_fileOffset > g_MaxZipSize)
+	{
+		std::cout << "The 3MF model is too large for a package without zip64 extensions" << std::endl;
+		m_bWriteFailed = true;
+		return;
+	}
+
+	const uint32_t directoryOffset = (uint32_t)m_fileOffset;
+	std::string directory;
+	for (size_t i = 0; i < m_zipEntries.size(); i++)
+	{
+		const ZIP_ENTRY& entry = m_zipEntries[i];
+		AppendValue(directory, 0x02014B50, 4);
+		AppendValue(directory, 20, 2);
+		AppendValue(directory, 20, 2);
+		AppendValue(directory, 0x0008, 2);
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, g_ZipDate, 2);
+		AppendValue(directory, entry.crc, 4);
+		AppendValue(directory, entry.size, 4);
+		AppendValue(directory, entry.size, 4);
+		AppendValue(directory, (uint32_t)entry.name.size(), 2);
+		// no extra field, comment, disk number or attributes
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, 0, 2);
+		AppendValue(directory, 0, 4);
+		AppendValue(directory, entry.offset, 4);
+		directory += entry.name;
+	}
+
+	std::string end;
+	AppendValue(end, 0x06054B50, 4);
+	AppendValue(end, 0, 2);
+	AppendValue(end, 0, 2);
+	AppendValue(end, (uint32_t)m_zipEntries.size(), 2);
+	AppendValue(end, (uint32_t)m_zipEntries.size(), 2);
+	AppendValue(end, (uint32_t)directory.size(), 4);
+	AppendValue(end, directoryOffset, 4);
+	AppendValue(end, 0, 2);
+
+	WriteBytes(directory.data(), directory.size());
+	WriteBytes(end.data(), end.size());
+}
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshexporter.h
+// ============
+// stream the scene's triangles into a binary STL or 3MF file for 3D printing
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeGeometry.h"
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  MeshExporter
+ *
+ *  This class writes the parts of the scene - a local space
+ *  mesh and the model matrix that places it - into a mesh
+ *  file on a thread of its own, so the scene keeps drawing
+ *  while the file is written.  The parts are handled in
+ *  chunks of a bounded number of triangles: the parts of a
+ *  chunk are moved into world space and turned into file
+ *  data in parallel on the job system, then written in
+ *  order, so the memory taken never grows with the size of
+ *  the scene.  The scene is Y up and the printing formats are
+ *  Z up, so the parts are turned onto the Z axis as they are
+ *  written.  Welding merges the vertices of a part that are
+ *  at the same position, which the 3MF meshes need to be
+ *  closed, and the triangles that collapse are dropped.
+ ***********************************************************/
+class MeshExporter
+{
+public:
+	// constructor
+	MeshExporter();
+	// destructor
+	~MeshExporter();
+
+	// formats the scene can be written in
+	enum EXPORT_FORMAT
+	{
+		FORMAT_STL = 0,
+		FORMAT_3MF
+	};
+
+	// one mesh of the scene placed in world space
+	struct EXPORT_PART
+	{
+		// index into the meshes passed in with the parts
+		int meshIndex;
+		glm::mat4 model;
+	};
+
+	// build the chunks on the passed in job system - only while
+	// no export is running
+	void SetJobSystem(JobSystem* pJobSystem) { m_pJobSystem = pJobSystem; }
+
+	// get the format of a file from its extension - files that
+	// do not end in .3mf are written as STL
+	static EXPORT_FORMAT GetFormat(const std::string& filePath);
+
+	// start writing the parts into the file on the export
+	// thread - the meshes and parts are taken over, and false
+	// is returned while an export is still running
+	bool StartExport(
+		const std::string& filePath,
+		std::vector<ShapeGeometry::MESH_DATA>& meshes,
+		std::vector<EXPORT_PART>& parts,
+		bool bWeld);
+	// true while the export thread is writing
+	bool IsExporting() const { return(m_bExporting.load()); }
+	// wait for the export thread to finish
+	void Wait();
+
+private:
+	// file data of one part of the current chunk
+	struct PART_OUTPUT
+	{
+		std::string data;
+		uint32_t triangleCount;
+	};
+
+	// entry of the 3MF package, kept for the zip directory
+	struct ZIP_ENTRY
+	{
+		std::string name;
+		uint32_t crc;
+		uint32_t size;
+		uint32_t offset;
+	};
+
+	// pointer to the job system the chunks are built on
+	JobSystem* m_pJobSystem;
+	// thread that writes the file
+	std::thread m_thread;
+	std::atomic<bool> m_bExporting;
+	// values of the current export
+	std::string m_filePath;
+	EXPORT_FORMAT m_format;
+	bool m_bWeld;
+	std::vector<ShapeGeometry::MESH_DATA> m_meshes;
+	std::vector<EXPORT_PART> m_parts;
+	// file data of the parts of the current chunk
+	std::vector<PART_OUTPUT> m_outputs;
+	// open file, its write offset and the 3MF package entries
+	FILE* m_pFile;
+	uint64_t m_fileOffset;
+	std::vector<ZIP_ENTRY> m_zipEntries;
+	bool m_bWriteFailed;
+
+	// write the whole file - runs on the export thread
+	void RunExport();
+	// build the file data of one part
+	void BuildPart(int partIndex, PART_OUTPUT& output) const;
+	// move a part into Z up world space and weld it when asked,
+	// returning the positions and the triangles that are kept
+	void TransformPart(
+		int partIndex,
+		std::vector<float>& positions,
+		std::vector<uint32_t>& indices) const;
+
+	// write bytes at the end of the file
+	void WriteBytes(const void* pData, size_t size);
+	// write one entry of the 3MF package, or the start and end
+	// of the entry that the model is streamed into
+	void WriteZipEntry(const char* name, const std::string& data);
+	void BeginZipEntry(const char* name);
+	void WriteZipData(const std::string& data);
+	void EndZipEntry();
+	// write the zip directory after the last entry
+	void WriteZipDirectory();
+};
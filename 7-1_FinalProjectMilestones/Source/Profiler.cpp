@@ -0,0 +1,532 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+// ============
+// time named sections of the frame on the CPU and the GPU, count the calls
+// of the frame and show the results over the scene or dump them as a trace
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// seconds that the section times are averaged over
+	const double g_ReportInterval = 0.5;
+	// most samples kept for the trace file, so a long run cannot
+	// use up the memory
+	const size_t g_MaxTraceEvents = 1000000;
+	// milliseconds of the frame budget marked on the overlay,
+	// which spans twice the budget
+	const float g_FrameBudget = 1000.0f / 60.0f;
+	// size in pixels of the overlay bars
+	const int g_OverlayMargin = 8;
+	const int g_OverlayBarHeight = 5;
+	const int g_OverlayRowHeight = 13;
+	const int g_OverlayIndent = 6;
+
+	// bar colors of the sections, picked in turn
+	const float g_SectionColors[8][3] =
+	{
+		{ 0.90f, 0.30f, 0.25f },
+		{ 0.95f, 0.65f, 0.20f },
+		{ 0.90f, 0.90f, 0.30f },
+		{ 0.40f, 0.85f, 0.35f },
+		{ 0.30f, 0.80f, 0.85f },
+		{ 0.35f, 0.50f, 0.95f },
+		{ 0.70f, 0.45f, 0.95f },
+		{ 0.95f, 0.45f, 0.75f }
+	};
+}
+
+/***********************************************************
+ *  Profiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Profiler::Profiler(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_startTime = std::chrono::steady_clock::now();
+	m_gpuStartTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &m_gpuStartTime);
+	m_frameIndex = 0;
+	m_intervalStart = 0.0;
+	m_intervalFrames = 0;
+	m_drawTotal = 0;
+	m_uniformTotal = 0;
+	m_stateChangeTotal = 0;
+	m_bReportReady = false;
+	m_bTraceEnabled = false;
+}
+
+/***********************************************************
+ *  ~Profiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Profiler::~Profiler()
+{
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		glDeleteQueries(4, &m_sections[i].queries[0][0]);
+	}
+	m_sections.clear();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  ScopedSection()
+ *
+ *  The constructor and destructor of the scope marker, which
+ *  start and stop timing a section.
+ ***********************************************************/
+Profiler::ScopedSection::ScopedSection(Profiler* pProfiler, const char* name)
+{
+	m_pProfiler = pProfiler;
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginSection(name);
+	}
+}
+
+Profiler::ScopedSection::~ScopedSection()
+{
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndSection();
+	}
+}
+
+/***********************************************************
+ *  GetTime()
+ *
+ *  This method is used for getting the microseconds that
+ *  have passed since the profiler was created.
+ ***********************************************************/
+double Profiler::GetTime() const
+{
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - m_startTime;
+
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  FindSection()
+ *
+ *  This method is used for finding the section with the
+ *  passed in name at the passed in nesting depth.  A new
+ *  section gets its timestamp queries when it is added.
+ ***********************************************************/
+int Profiler::FindSection(const char* name, int depth)
+{
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		if ((m_sections[i].depth == depth) &&
+			((m_sections[i].name == name) || (strcmp(m_sections[i].name, name) == 0)))
+		{
+			return((int)i);
+		}
+	}
+
+	PROFILE_SECTION section;
+	section.name = name;
+	section.depth = depth;
+	glGenQueries(4, &section.queries[0][0]);
+	section.bQueryPending[0] = false;
+	section.bQueryPending[1] = false;
+	section.queryFrame = (unsigned long long)-1;
+	section.cpuTotal = 0.0;
+	section.gpuTotal = 0.0;
+	section.cpuSamples = 0;
+	section.gpuSamples = 0;
+	section.cpuAverage = 0.0f;
+	section.gpuAverage = 0.0f;
+	m_sections.push_back(section);
+
+	return((int)m_sections.size() - 1);
+}
+
+/***********************************************************
+ *  BeginSection()
+ *
+ *  This method is used for starting to time a section.  Only
+ *  the first time a section is started in a frame gets GPU
+ *  queries, since each section has one pair per frame.
+ ***********************************************************/
+void Profiler::BeginSection(const char* name)
+{
+	OPEN_SECTION openSection;
+	openSection.section = FindSection(name, (int)m_openSections.size());
+	openSection.bQueried = false;
+
+	PROFILE_SECTION& section = m_sections[openSection.section];
+	if (section.queryFrame != m_frameIndex)
+	{
+		int parity = (int)(m_frameIndex & 1);
+		glQueryCounter(section.queries[parity][0], GL_TIMESTAMP);
+		section.queryFrame = m_frameIndex;
+		openSection.bQueried = true;
+	}
+
+	openSection.beginTime = GetTime();
+	m_openSections.push_back(openSection);
+}
+
+/***********************************************************
+ *  EndSection()
+ *
+ *  This method is used for stopping the timing of the section
+ *  that was started last.
+ ***********************************************************/
+void Profiler::EndSection()
+{
+	if (m_openSections.empty() == true)
+	{
+		return;
+	}
+
+	OPEN_SECTION openSection = m_openSections.back();
+	m_openSections.pop_back();
+
+	double endTime = GetTime();
+	PROFILE_SECTION& section = m_sections[openSection.section];
+	section.cpuTotal += endTime - openSection.beginTime;
+	section.cpuSamples++;
+	AddTraceEvent(section.name, 0, openSection.beginTime, endTime - openSection.beginTime);
+
+	if (openSection.bQueried == true)
+	{
+		int parity = (int)(m_frameIndex & 1);
+		glQueryCounter(section.queries[parity][1], GL_TIMESTAMP);
+		section.bQueryPending[parity] = true;
+	}
+}
+
+/***********************************************************
+ *  ResolveQueries()
+ *
+ *  This method is used for reading back the timestamp pairs
+ *  of the passed in parity.  They were issued two frames ago,
+ *  and a pair that has still not finished is dropped rather
+ *  than waited on.
+ ***********************************************************/
+void Profiler::ResolveQueries(int parity)
+{
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		PROFILE_SECTION& section = m_sections[i];
+		if (section.bQueryPending[parity] == false)
+		{
+			continue;
+		}
+		section.bQueryPending[parity] = false;
+
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(section.queries[parity][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+		{
+			continue;
+		}
+
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+		glGetQueryObjectui64v(section.queries[parity][0], GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(section.queries[parity][1], GL_QUERY_RESULT, &endTime);
+		if (endTime < beginTime)
+		{
+			continue;
+		}
+
+		// the timestamps are in nanoseconds
+		double duration = (double)(endTime - beginTime) / 1000.0;
+		section.gpuTotal += duration;
+		section.gpuSamples++;
+		AddTraceEvent(section.name, 1, (double)((GLint64)beginTime - m_gpuStartTime) / 1000.0, duration);
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new frame.  The query
+ *  pairs of this frame's parity are read back before they are
+ *  issued again.
+ ***********************************************************/
+void Profiler::BeginFrame()
+{
+	m_frameIndex++;
+	ResolveQueries((int)(m_frameIndex & 1));
+
+	double now = GetTime();
+	if (now - m_intervalStart >= g_ReportInterval * 1000000.0)
+	{
+		FinishInterval(now);
+	}
+
+	BeginSection("Frame");
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending the frame section and
+ *  adding the call counts of the frame to the interval.
+ ***********************************************************/
+void Profiler::EndFrame()
+{
+	// close any section that was left open, so a missing end
+	// cannot shift the nesting of the next frame
+	while (m_openSections.size() > 1)
+	{
+		EndSection();
+	}
+	EndSection();
+
+	m_intervalFrames++;
+	if (NULL == m_pStateCache)
+	{
+		return;
+	}
+
+	m_drawTotal += m_pStateCache->GetFrameDrawCount();
+	m_uniformTotal += m_pStateCache->GetFrameUniformCount();
+	m_stateChangeTotal += m_pStateCache->GetFrameStateChangeCount();
+
+	if ((m_bTraceEnabled == true) && (m_traceCounters.size() < g_MaxTraceEvents))
+	{
+		TRACE_COUNTERS counters;
+		counters.timestamp = GetTime();
+		counters.drawCount = m_pStateCache->GetFrameDrawCount();
+		counters.uniformCount = m_pStateCache->GetFrameUniformCount();
+		counters.stateChangeCount = m_pStateCache->GetFrameStateChangeCount();
+		m_traceCounters.push_back(counters);
+	}
+}
+
+/***********************************************************
+ *  FinishInterval()
+ *
+ *  This method is used for turning the totals of an interval
+ *  into the averages that are shown, and building the report
+ *  of the interval.  Each section is averaged over the times
+ *  it ran, and sections that did not run are left out.
+ ***********************************************************/
+void Profiler::FinishInterval(double now)
+{
+	if (m_intervalFrames > 0)
+	{
+		char text[128];
+		double frameTime = ((now - m_intervalStart) / 1000.0) / m_intervalFrames;
+
+		snprintf(text, sizeof(text), "%.2f ms (%.0f fps)", frameTime, 1000.0 / frameTime);
+		m_report = text;
+
+		for (size_t i = 0; i < m_sections.size(); i++)
+		{
+			PROFILE_SECTION& section = m_sections[i];
+			section.cpuAverage = (section.cpuSamples > 0) ? (float)(section.cpuTotal / section.cpuSamples / 1000.0) : 0.0f;
+			section.gpuAverage = (section.gpuSamples > 0) ? (float)(section.gpuTotal / section.gpuSamples / 1000.0) : 0.0f;
+
+			if (section.cpuSamples > 0)
+			{
+				snprintf(text, sizeof(text), " | %s %.2f/%.2f", section.name, section.cpuAverage, section.gpuAverage);
+				m_report += text;
+			}
+		}
+
+		snprintf(text, sizeof(text), " | draws %llu uniforms %llu states %llu",
+			m_drawTotal / m_intervalFrames,
+			m_uniformTotal / m_intervalFrames,
+			m_stateChangeTotal / m_intervalFrames);
+		m_report += text;
+		m_bReportReady = true;
+	}
+	else
+	{
+		// sections that ran before the first frame, such as the
+		// loading of the scene, are only logged
+		for (size_t i = 0; i < m_sections.size(); i++)
+		{
+			if (m_sections[i].cpuSamples > 0)
+			{
+				std::cout << "INFO: " << m_sections[i].name << " took "
+					<< (m_sections[i].cpuTotal / 1000.0) << " ms" << std::endl;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		m_sections[i].cpuTotal = 0.0;
+		m_sections[i].gpuTotal = 0.0;
+		m_sections[i].cpuSamples = 0;
+		m_sections[i].gpuSamples = 0;
+	}
+	m_intervalStart = now;
+	m_intervalFrames = 0;
+	m_drawTotal = 0;
+	m_uniformTotal = 0;
+	m_stateChangeTotal = 0;
+}
+
+/***********************************************************
+ *  TakeReport()
+ *
+ *  This method is used for getting the report of the last
+ *  finished interval, with the CPU and GPU milliseconds of
+ *  each section and the average call counts of a frame.
+ ***********************************************************/
+bool Profiler::TakeReport(std::string& report)
+{
+	if (m_bReportReady == false)
+	{
+		return(false);
+	}
+
+	report = m_report;
+	m_bReportReady = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawOverlay()
+ *
+ *  This method is used for drawing one row per section over
+ *  the window, with the CPU time as the upper bar and the
+ *  GPU time as the lower bar.  The bars are scissored clears,
+ *  so no shader or vertex state is touched, and a marker
+ *  shows the frame budget.
+ ***********************************************************/
+void Profiler::DrawOverlay(int width, int height)
+{
+	if ((NULL == m_pStateCache) || (width <= 0) || (height <= 0) || (m_sections.empty() == true))
+	{
+		return;
+	}
+
+	int panelWidth = width / 2;
+	int panelHeight = ((int)m_sections.size() * g_OverlayRowHeight) + g_OverlayMargin;
+	float pixelsPerMillisecond = (float)(panelWidth - g_OverlayMargin * 2) / (g_FrameBudget * 2.0f);
+	int panelTop = height - g_OverlayMargin;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+	m_pStateCache->Enable(GL_SCISSOR_TEST);
+
+	// darken the panel behind the bars
+	glScissor(g_OverlayMargin, panelTop - panelHeight, panelWidth, panelHeight);
+	glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	for (size_t i = 0; i < m_sections.size(); i++)
+	{
+		const PROFILE_SECTION& section = m_sections[i];
+		const float* color = g_SectionColors[i % 8];
+		int left = g_OverlayMargin * 2 + (section.depth * g_OverlayIndent);
+		int rowTop = panelTop - g_OverlayMargin - ((int)i * g_OverlayRowHeight);
+
+		int cpuWidth = (int)(section.cpuAverage * pixelsPerMillisecond);
+		if (cpuWidth > 0)
+		{
+			glScissor(left, rowTop - g_OverlayBarHeight, cpuWidth, g_OverlayBarHeight);
+			glClearColor(color[0], color[1], color[2], 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+
+		int gpuWidth = (int)(section.gpuAverage * pixelsPerMillisecond);
+		if (gpuWidth > 0)
+		{
+			glScissor(left, rowTop - (g_OverlayBarHeight * 2) - 1, gpuWidth, g_OverlayBarHeight);
+			glClearColor(color[0] * 0.6f, color[1] * 0.6f, color[2] * 0.6f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+	}
+
+	// mark the frame budget
+	glScissor(g_OverlayMargin * 2 + (int)(g_FrameBudget * pixelsPerMillisecond), panelTop - panelHeight, 1, panelHeight);
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	m_pStateCache->Disable(GL_SCISSOR_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+/***********************************************************
+ *  AddTraceEvent()
+ *
+ *  This method is used for keeping a section sample for the
+ *  trace file, while the trace is enabled and not full.
+ ***********************************************************/
+void Profiler::AddTraceEvent(const char* name, int thread, double timestamp, double duration)
+{
+	if ((m_bTraceEnabled == false) || (m_traceEvents.size() >= g_MaxTraceEvents))
+	{
+		return;
+	}
+
+	TRACE_EVENT traceEvent;
+	traceEvent.name = name;
+	traceEvent.thread = thread;
+	traceEvent.timestamp = timestamp;
+	traceEvent.duration = duration;
+	m_traceEvents.push_back(traceEvent);
+}
+
+/***********************************************************
+ *  WriteTrace()
+ *
+ *  This method is used for writing the kept samples in the
+ *  Chrome trace event format, which can be opened in
+ *  chrome://tracing or Perfetto.  The CPU and the GPU samples
+ *  are on separate threads and the call counts are counter
+ *  tracks.
+ ***********************************************************/
+bool Profiler::WriteTrace(const char* filePath) const
+{
+	std::ofstream file(filePath, std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write profiler trace:" << filePath << std::endl;
+		return(false);
+	}
+
+	char text[256];
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+	for (size_t i = 0; i < m_traceEvents.size(); i++)
+	{
+		const TRACE_EVENT& traceEvent = m_traceEvents[i];
+		snprintf(text, sizeof(text),
+			",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			traceEvent.name, traceEvent.thread, traceEvent.timestamp, traceEvent.duration);
+		file << text;
+	}
+
+	for (size_t i = 0; i < m_traceCounters.size(); i++)
+	{
+		const TRACE_COUNTERS& counters = m_traceCounters[i];
+		snprintf(text, sizeof(text),
+			",\n{\"name\":\"Calls\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"draws\":%u,\"uniforms\":%u,\"states\":%u}}",
+			counters.timestamp, counters.drawCount, counters.uniformCount, counters.stateChangeCount);
+		file << text;
+	}
+
+	file << "\n]}\n";
+
+	if (!file)
+	{
+		std::cout << "Could not write profiler trace:" << filePath << std::endl;
+		return(false);
+	}
+
+	std::cout << "Wrote profiler trace:" << filePath << ", events:" << m_traceEvents.size() << std::endl;
+	return(true);
+}
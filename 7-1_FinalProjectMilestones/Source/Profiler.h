@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.h
+// ============
+// time named sections of the frame on the CPU and the GPU, count the calls
+// of the frame and show the results over the scene or dump them as a trace
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StateCache.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  This class times named sections of the frame, such as the
+ *  view setup, the render passes and the buffer swap.  The
+ *  CPU time of a section comes from a steady clock and its
+ *  GPU time from a pair of timestamp queries around it.  The
+ *  queries are double buffered - the results of a frame are
+ *  read back two frames later, when they have finished - so
+ *  the timing never waits on the GPU.  The sections are
+ *  averaged over a short interval, which is shown as bars
+ *  over the scene and as a one line report, and every sample
+ *  can be kept for a Chrome trace file.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// constructor
+	Profiler(StateCache* pStateCache);
+	// destructor
+	~Profiler();
+
+	// marker that times the scope it is declared in - a NULL
+	// profiler is allowed, so callers need no checks
+	class ScopedSection
+	{
+	public:
+		ScopedSection(Profiler* pProfiler, const char* name);
+		~ScopedSection();
+
+	private:
+		Profiler* m_pProfiler;
+	};
+
+	// start timing a section - sections can nest, and the name
+	// has to stay valid while the profiler is used, such as a
+	// string literal
+	void BeginSection(const char* name);
+	// stop timing the section that was started last
+	void EndSection();
+
+	// read back the GPU times that have finished and start the
+	// frame section
+	void BeginFrame();
+	// end the frame section and take the call counts of the
+	// frame from the state cache
+	void EndFrame();
+
+	// draw the averaged section times as bars over the window
+	void DrawOverlay(int width, int height);
+	// get the one line report of the last interval - returns
+	// false when no new interval has finished since the last call
+	bool TakeReport(std::string& report);
+
+	// keep every sample for the trace file
+	void EnableTrace(bool bEnable) { m_bTraceEnabled = bEnable; }
+	// write the kept samples as a Chrome trace JSON file
+	bool WriteTrace(const char* filePath) const;
+
+private:
+	// timing of one named section
+	struct PROFILE_SECTION
+	{
+		const char* name;
+		int depth;
+		// begin and end timestamp queries for the even and the
+		// odd frames
+		GLuint queries[2][2];
+		bool bQueryPending[2];
+		// frame whose queries were last issued
+		unsigned long long queryFrame;
+		// totals of the current interval
+		double cpuTotal;
+		double gpuTotal;
+		int cpuSamples;
+		int gpuSamples;
+		// averages of the last interval in milliseconds
+		float cpuAverage;
+		float gpuAverage;
+	};
+
+	// section that has been started and not yet ended
+	struct OPEN_SECTION
+	{
+		int section;
+		double beginTime;
+		bool bQueried;
+	};
+
+	// sample kept for the trace file - a thread of 0 is the
+	// CPU and a thread of 1 the GPU
+	struct TRACE_EVENT
+	{
+		const char* name;
+		int thread;
+		double timestamp;
+		double duration;
+	};
+
+	// call counts of a frame kept for the trace file
+	struct TRACE_COUNTERS
+	{
+		double timestamp;
+		unsigned int drawCount;
+		unsigned int uniformCount;
+		unsigned int stateChangeCount;
+	};
+
+	// pointer to the state cache that counts the calls
+	StateCache* m_pStateCache;
+	// CPU and GPU times that the samples are measured from
+	std::chrono::steady_clock::time_point m_startTime;
+	GLint64 m_gpuStartTime;
+	unsigned long long m_frameIndex;
+	// sections in the order they were first started
+	std::vector<PROFILE_SECTION> m_sections;
+	std::vector<OPEN_SECTION> m_openSections;
+	// interval totals of the call counts
+	double m_intervalStart;
+	int m_intervalFrames;
+	unsigned long long m_drawTotal;
+	unsigned long long m_uniformTotal;
+	unsigned long long m_stateChangeTotal;
+	std::string m_report;
+	bool m_bReportReady;
+	// samples kept for the trace file
+	bool m_bTraceEnabled;
+	std::vector<TRACE_EVENT> m_traceEvents;
+	std::vector<TRACE_COUNTERS> m_traceCounters;
+
+	// microseconds since the profiler was created
+	double GetTime() const;
+	// find a section by its name and depth, adding it when it
+	// is new
+	int FindSection(const char* name, int depth);
+	// read back the finished queries of the passed in parity
+	void ResolveQueries(int parity);
+	// average the totals and build the report of an interval
+	void FinishInterval(double now);
+	// keep a sample for the trace file
+	void AddTraceEvent(const char* name, int thread, double timestamp, double duration);
+};
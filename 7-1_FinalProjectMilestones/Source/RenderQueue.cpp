@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// collect draw items under 64-bit sort keys and sort them before submission
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+// declaration of the global variables and defines
+namespace
+{
+	// widths of the sort key fields
+	const int g_DepthBits = 24;
+	const int g_MeshBits = 8;
+	const int g_MaterialBits = 8;
+	const int g_TextureBits = 8;
+	const int g_ShaderBits = 4;
+
+	const uint64_t g_DepthMask = (1ull << g_DepthBits) - 1;
+	const uint64_t g_MeshMask = (1ull << g_MeshBits) - 1;
+	const uint64_t g_MaterialMask = (1ull << g_MaterialBits) - 1;
+	const uint64_t g_TextureMask = (1ull << g_TextureBits) - 1;
+	const uint64_t g_ShaderMask = (1ull << g_ShaderBits) - 1;
+
+	// the bucket bit puts every transparent item last
+	const uint64_t g_TransparentBit = 1ull << 63;
+
+	// compare two queue items by their sort keys
+	bool CompareItems(const RenderQueue::QUEUE_ITEM& a, const RenderQueue::QUEUE_ITEM& b)
+	{
+		return(a.key < b.key);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_maxDepth = 100.0f;
+	m_opaqueCount = 0;
+}
+
+/***********************************************************
+ *  ~RenderQueue()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderQueue::~RenderQueue()
+{
+	m_items.clear();
+	m_opaqueCount = 0;
+}
+
+/***********************************************************
+ *  SetDepthRange()
+ *
+ *  This method is used for setting the view depth that maps
+ *  to the largest depth value in the sort keys, which is
+ *  normally the far plane of the projection.
+ ***********************************************************/
+void RenderQueue::SetDepthRange(float maxDepth)
+{
+	if (maxDepth > 0.0f)
+	{
+		m_maxDepth = maxDepth;
+	}
+}
+
+/***********************************************************
+ *  QuantizeDepth()
+ *
+ *  This method is used for converting a view depth into the
+ *  24-bit depth field of the sort keys.
+ ***********************************************************/
+uint64_t RenderQueue::QuantizeDepth(float viewDepth) const
+{
+	float normalizedDepth = viewDepth / m_maxDepth;
+
+	if (normalizedDepth < 0.0f)
+		normalizedDepth = 0.0f;
+	else if (normalizedDepth > 1.0f)
+		normalizedDepth = 1.0f;
+
+	return((uint64_t)(normalizedDepth * (float)g_DepthMask) & g_DepthMask);
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for building the sort key of a draw
+ *  item from its state and its depth in view space.  Texture
+ *  and material indices of -1 sort before all valid indices.
+ ***********************************************************/
+uint64_t RenderQueue::MakeKey(
+	bool bTransparent,
+	unsigned int shaderID,
+	int textureSlot,
+	int materialIndex,
+	unsigned int meshKey,
+	float viewDepth) const
+{
+	uint64_t depth = QuantizeDepth(viewDepth);
+	uint64_t state = 0;
+	uint64_t key = 0;
+
+	state = ((uint64_t)shaderID & g_ShaderMask);
+	state = (state << g_TextureBits) | ((uint64_t)(textureSlot + 1) & g_TextureMask);
+	state = (state << g_MaterialBits) | ((uint64_t)(materialIndex + 1) & g_MaterialMask);
+	state = (state << g_MeshBits) | ((uint64_t)meshKey & g_MeshMask);
+
+	if (bTransparent == true)
+	{
+		// farthest items first, then by state
+		key = g_TransparentBit;
+		key |= (g_DepthMask - depth) << (g_ShaderBits + g_TextureBits + g_MaterialBits + g_MeshBits);
+		key |= state;
+	}
+	else
+	{
+		// by state first, then nearest items first
+		key = (state << g_DepthBits) | depth;
+	}
+
+	return(key);
+}
+
+/***********************************************************
+ *  AddItem()
+ *
+ *  This method is used for adding a draw item to the queue.
+ ***********************************************************/
+void RenderQueue::AddItem(uint64_t key, uint32_t index, ITEM_TYPE type)
+{
+	QUEUE_ITEM item;
+
+	item.key = key;
+	item.index = index;
+	item.type = (uint32_t)type;
+	m_items.push_back(item);
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the queued items by their
+ *  keys.  Items with equal keys keep the order they were
+ *  added in.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	std::stable_sort(m_items.begin(), m_items.end(), CompareItems);
+
+	// the transparent items start at the first key with the
+	// bucket bit set
+	m_opaqueCount = 0;
+	while ((m_opaqueCount < (int)m_items.size()) && ((m_items[m_opaqueCount].key & g_TransparentBit) == 0))
+	{
+		m_opaqueCount++;
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all the queued items.
+ *  The storage is kept for the next frame.
+ ***********************************************************/
+void RenderQueue::Clear()
+{
+	m_items.clear();
+}
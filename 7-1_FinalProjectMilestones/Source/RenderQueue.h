@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// collect draw items under 64-bit sort keys and sort them before submission
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draw items of a frame together
+ *  with a 64-bit sort key.  Sorting the keys groups the items
+ *  by shader, texture, material and mesh so state changes
+ *  are kept to a minimum.  Opaque items are ordered front to
+ *  back within equal state, and transparent items are drawn
+ *  after all opaque items in back to front order.
+ *
+ *  The bucket is the top bit of the key.  The other fields
+ *  are packed into the low bits, most significant first:
+ *    opaque:      4 shader | 8 texture | 8 material | 8 mesh | 24 depth
+ *    transparent: 24 inverted depth | 4 shader | 8 texture | 8 material | 8 mesh
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+	// destructor
+	~RenderQueue();
+
+	// kinds of draw items that can be queued
+	enum ITEM_TYPE
+	{
+		ITEM_RECORD = 0,
+		ITEM_INSTANCE_BATCH,
+		ITEM_STATIC_BATCH
+	};
+
+	struct QUEUE_ITEM
+	{
+		uint64_t key;
+		uint32_t index;
+		uint32_t type;
+	};
+
+	// set the view depth that maps to the largest key depth
+	void SetDepthRange(float maxDepth);
+
+	// build the sort key for a draw item
+	uint64_t MakeKey(
+		bool bTransparent,
+		unsigned int shaderID,
+		int textureSlot,
+		int materialIndex,
+		unsigned int meshKey,
+		float viewDepth) const;
+
+	// add a draw item to the queue
+	void AddItem(uint64_t key, uint32_t index, ITEM_TYPE type);
+	// sort the queued items by their keys
+	void Sort();
+	// remove all queued items
+	void Clear();
+
+	int GetItemCount() const { return((int)m_items.size()); }
+	// number of opaque items at the front of the sorted queue
+	int GetOpaqueCount() const { return(m_opaqueCount); }
+	const QUEUE_ITEM& GetItem(int index) const { return(m_items[index]); }
+
+private:
+	// queued draw items
+	std::vector<QUEUE_ITEM> m_items;
+	// view depth that maps to the largest key depth
+	float m_maxDepth;
+	// opaque items found by the last sort
+	int m_opaqueCount;
+
+	// quantize a view depth into the 24-bit key range
+	uint64_t QuantizeDepth(float viewDepth) const;
+};
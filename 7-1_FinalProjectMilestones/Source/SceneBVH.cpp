@@ -0,0 +1,586 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// bounding volume hierarchy over the draw records of a 3D scene - answers
+// frustum, ray and nearest object queries without walking every record
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// deepest traversal - median splits keep the tree depth
+	// well below this for any record count
+	const int g_MaxTraversalDepth = 64;
+	// all six frustum planes still need to be tested
+	const int g_AllPlanesMask = 0x3F;
+
+	/***********************************************************
+	 *  ClassifyBox()
+	 *
+	 *  This function is used for testing a box against the
+	 *  frustum planes in the passed in mask.  It returns -1 when
+	 *  the box is outside of a plane, otherwise the mask of the
+	 *  planes that the box still crosses.
+	 ***********************************************************/
+	int ClassifyBox(
+		const glm::vec3& minimum,
+		const glm::vec3& maximum,
+		const glm::vec4 planes[6],
+		int planeMask)
+	{
+		int remainingMask = planeMask;
+
+		for (int plane = 0; plane < 6; plane++)
+		{
+			if ((planeMask & (1 << plane)) == 0)
+			{
+				continue;
+			}
+
+			const glm::vec4& p = planes[plane];
+
+			// the corners furthest along and against the normal
+			glm::vec3 farCorner(
+				(p.x >= 0.0f) ? maximum.x : minimum.x,
+				(p.y >= 0.0f) ? maximum.y : minimum.y,
+				(p.z >= 0.0f) ? maximum.z : minimum.z);
+			glm::vec3 nearCorner(
+				(p.x >= 0.0f) ? minimum.x : maximum.x,
+				(p.y >= 0.0f) ? minimum.y : maximum.y,
+				(p.z >= 0.0f) ? minimum.z : maximum.z);
+
+			if (glm::dot(glm::vec3(p), farCorner) + p.w < 0.0f)
+			{
+				return(-1);
+			}
+			if (glm::dot(glm::vec3(p), nearCorner) + p.w >= 0.0f)
+			{
+				remainingMask &= ~(1 << plane);
+			}
+		}
+
+		return(remainingMask);
+	}
+
+	/***********************************************************
+	 *  IntersectRayBox()
+	 *
+	 *  This function is used for getting the distance along a
+	 *  ray to where it enters a box.  It returns false when the
+	 *  ray misses the box or enters it beyond the max distance.
+	 ***********************************************************/
+	bool IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& minimum,
+		const glm::vec3& maximum,
+		float maxDistance,
+		float& entryDistance)
+	{
+		glm::vec3 t0 = (minimum - origin) * inverseDirection;
+		glm::vec3 t1 = (maximum - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+		float exit = glm::min(glm::min(tFar.x, tFar.y), tFar.z);
+
+		if ((enter > exit) || (enter >= maxDistance))
+		{
+			return(false);
+		}
+
+		entryDistance = enter;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  BoxDistanceSquared()
+	 *
+	 *  This function is used for getting the squared distance
+	 *  from a point to the nearest point of a box.
+	 ***********************************************************/
+	float BoxDistanceSquared(
+		const glm::vec3& point,
+		const glm::vec3& minimum,
+		const glm::vec3& maximum)
+	{
+		glm::vec3 offset = glm::max(glm::max(minimum - point, point - maximum), glm::vec3(0.0f));
+		return(glm::dot(offset, offset));
+	}
+}
+
+/***********************************************************
+ *  SceneBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneBVH::SceneBVH()
+{
+}
+
+/***********************************************************
+ *  ~SceneBVH()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneBVH::~SceneBVH()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over all of the
+ *  records in the passed in draw list.  The records are split
+ *  at the median of their bounds centers along the longest
+ *  axis, then the item bounds are stored in leaf order and
+ *  every box is fitted from the leaves up.
+ ***********************************************************/
+void SceneBVH::Build(const DrawList& drawList)
+{
+	const int recordCount = drawList.GetRecordCount();
+
+	Clear();
+	if (recordCount == 0)
+	{
+		return;
+	}
+
+	m_itemRecords.resize(recordCount);
+	m_buildCenters.resize(recordCount);
+	for (int i = 0; i < recordCount; i++)
+	{
+		const DrawList::DRAW_RECORD& record = drawList.GetRecord(i);
+		m_itemRecords[i] = i;
+		m_buildCenters[i] = (record.boundsMinimum + record.boundsMaximum) * 0.5f;
+	}
+
+	// the tree has at most two nodes per leaf
+	m_nodes.reserve(((recordCount / MAX_LEAF_RECORDS) + 1) * 2);
+	m_nodes.push_back(BVH_NODE());
+	m_nodes[0].parent = -1;
+	BuildNode(0, 0, recordCount);
+	m_buildCenters.clear();
+
+	// store the item bounds in leaf order
+	m_itemMinimum.resize(recordCount);
+	m_itemMaximum.resize(recordCount);
+	m_recordItems.resize(recordCount);
+	m_itemLeaves.resize(recordCount);
+	for (int i = 0; i < recordCount; i++)
+	{
+		const DrawList::DRAW_RECORD& record = drawList.GetRecord(m_itemRecords[i]);
+		m_itemMinimum[i] = record.boundsMinimum;
+		m_itemMaximum[i] = record.boundsMaximum;
+		m_recordItems[m_itemRecords[i]] = i;
+	}
+
+	// children always come after their parent, so walking the
+	// nodes backwards fits every child before its parent
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		const BVH_NODE& node = m_nodes[i];
+		if (node.count > 0)
+		{
+			for (int j = node.first; j < node.first + node.count; j++)
+			{
+				m_itemLeaves[j] = i;
+			}
+		}
+		FitNode(i);
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for splitting the passed in range of
+ *  items into two child nodes, until a range is small enough
+ *  to be kept in a leaf.
+ ***********************************************************/
+void SceneBVH::BuildNode(int nodeIndex, int first, int count)
+{
+	m_nodes[nodeIndex].first = first;
+	m_nodes[nodeIndex].count = count;
+	if (count <= MAX_LEAF_RECORDS)
+	{
+		return;
+	}
+
+	// split along the axis where the centers spread the most
+	glm::vec3 centerMinimum = m_buildCenters[m_itemRecords[first]];
+	glm::vec3 centerMaximum = centerMinimum;
+	for (int i = first + 1; i < first + count; i++)
+	{
+		centerMinimum = glm::min(centerMinimum, m_buildCenters[m_itemRecords[i]]);
+		centerMaximum = glm::max(centerMaximum, m_buildCenters[m_itemRecords[i]]);
+	}
+
+	glm::vec3 spread = centerMaximum - centerMinimum;
+	int axis = 0;
+	if (spread.y > spread[axis])
+	{
+		axis = 1;
+	}
+	if (spread.z > spread[axis])
+	{
+		axis = 2;
+	}
+
+	// the records all share one center, so keep them together
+	if (spread[axis] <= 0.0f)
+	{
+		return;
+	}
+
+	int* pItems = m_itemRecords.data();
+	const glm::vec3* pCenters = m_buildCenters.data();
+	std::nth_element(
+		pItems + first,
+		pItems + first + (count / 2),
+		pItems + first + count,
+		[pCenters, axis](int a, int b) { return(pCenters[a][axis] < pCenters[b][axis]); });
+
+	// the two children are stored next to each other
+	int childIndex = (int)m_nodes.size();
+	m_nodes.push_back(BVH_NODE());
+	m_nodes.push_back(BVH_NODE());
+	m_nodes[childIndex].parent = nodeIndex;
+	m_nodes[childIndex + 1].parent = nodeIndex;
+	m_nodes[nodeIndex].first = childIndex;
+	m_nodes[nodeIndex].count = 0;
+
+	BuildNode(childIndex, first, count / 2);
+	BuildNode(childIndex + 1, first + (count / 2), count - (count / 2));
+}
+
+/***********************************************************
+ *  FitNode()
+ *
+ *  This method is used for fitting the box of a node around
+ *  its items, or around its two children for inner nodes.
+ ***********************************************************/
+bool SceneBVH::FitNode(int nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+
+	if (node.count > 0)
+	{
+		minimum = m_itemMinimum[node.first];
+		maximum = m_itemMaximum[node.first];
+		for (int i = node.first + 1; i < node.first + node.count; i++)
+		{
+			minimum = glm::min(minimum, m_itemMinimum[i]);
+			maximum = glm::max(maximum, m_itemMaximum[i]);
+		}
+	}
+	else
+	{
+		const BVH_NODE& left = m_nodes[node.first];
+		const BVH_NODE& right = m_nodes[node.first + 1];
+		minimum = glm::min(left.minimum, right.minimum);
+		maximum = glm::max(left.maximum, right.maximum);
+	}
+
+	bool bChanged = (minimum != node.minimum) || (maximum != node.maximum);
+	node.minimum = minimum;
+	node.maximum = maximum;
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for copying the new bounds of the
+ *  changed records into their leaves, then refitting the
+ *  boxes up toward the root.  The walk up stops as soon as a
+ *  box no longer changes, so moving one object only touches
+ *  the nodes above it.
+ ***********************************************************/
+void SceneBVH::Refit(const DrawList& drawList, const std::vector<int>& changedRecords)
+{
+	for (size_t i = 0; i < changedRecords.size(); i++)
+	{
+		int item = m_recordItems[changedRecords[i]];
+		const DrawList::DRAW_RECORD& record = drawList.GetRecord(changedRecords[i]);
+		m_itemMinimum[item] = record.boundsMinimum;
+		m_itemMaximum[item] = record.boundsMaximum;
+	}
+
+	for (size_t i = 0; i < changedRecords.size(); i++)
+	{
+		int nodeIndex = m_itemLeaves[m_recordItems[changedRecords[i]]];
+		while ((nodeIndex >= 0) && (FitNode(nodeIndex) == true))
+		{
+			nodeIndex = m_nodes[nodeIndex].parent;
+		}
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the nodes.
+ ***********************************************************/
+void SceneBVH::Clear()
+{
+	m_nodes.clear();
+	m_itemRecords.clear();
+	m_itemMinimum.clear();
+	m_itemMaximum.clear();
+	m_recordItems.clear();
+	m_itemLeaves.clear();
+	m_buildCenters.clear();
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for getting the records whose bounds
+ *  are inside of or cross the passed in frustum planes.  The
+ *  planes that a node is fully inside of are not tested again
+ *  for its children, so whole subtrees in the middle of the
+ *  view are added without any plane tests.
+ ***********************************************************/
+void SceneBVH::QueryFrustum(const glm::vec4 planes[6], std::vector<int>& results) const
+{
+	int nodeStack[g_MaxTraversalDepth];
+	int maskStack[g_MaxTraversalDepth];
+	int stackSize = 0;
+
+	results.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	nodeStack[stackSize] = 0;
+	maskStack[stackSize] = g_AllPlanesMask;
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const BVH_NODE& node = m_nodes[nodeStack[stackSize]];
+		int planeMask = maskStack[stackSize];
+
+		if (planeMask != 0)
+		{
+			planeMask = ClassifyBox(node.minimum, node.maximum, planes, planeMask);
+			if (planeMask < 0)
+			{
+				continue;
+			}
+		}
+
+		if (node.count == 0)
+		{
+			nodeStack[stackSize] = node.first + 1;
+			maskStack[stackSize] = planeMask;
+			nodeStack[stackSize + 1] = node.first;
+			maskStack[stackSize + 1] = planeMask;
+			stackSize += 2;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			if ((planeMask == 0) ||
+				(ClassifyBox(m_itemMinimum[i], m_itemMaximum[i], planes, planeMask) >= 0))
+			{
+				results.push_back(m_itemRecords[i]);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for getting the nearest record whose
+ *  bounds are hit by the passed in ray.  The nearer child of
+ *  each node is visited first, and nodes that the ray enters
+ *  beyond the current nearest hit are skipped.
+ ***********************************************************/
+int SceneBVH::QueryRay(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float& hitDistance) const
+{
+	int nodeStack[g_MaxTraversalDepth];
+	float distanceStack[g_MaxTraversalDepth];
+	int stackSize = 0;
+	int hitRecord = -1;
+	float nearest = FLT_MAX;
+	float entry = 0.0f;
+
+	if (m_nodes.empty())
+	{
+		return(-1);
+	}
+
+	glm::vec3 unitDirection = glm::normalize(direction);
+	glm::vec3 inverseDirection(
+		1.0f / unitDirection.x,
+		1.0f / unitDirection.y,
+		1.0f / unitDirection.z);
+
+	if (IntersectRayBox(origin, inverseDirection, m_nodes[0].minimum, m_nodes[0].maximum, nearest, entry) == false)
+	{
+		return(-1);
+	}
+
+	nodeStack[stackSize] = 0;
+	distanceStack[stackSize] = entry;
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (distanceStack[stackSize] >= nearest)
+		{
+			continue;
+		}
+
+		const BVH_NODE& node = m_nodes[nodeStack[stackSize]];
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				if (IntersectRayBox(origin, inverseDirection, m_itemMinimum[i], m_itemMaximum[i], nearest, entry) == true)
+				{
+					nearest = entry;
+					hitRecord = m_itemRecords[i];
+				}
+			}
+			continue;
+		}
+
+		float leftEntry = 0.0f;
+		float rightEntry = 0.0f;
+		const BVH_NODE& left = m_nodes[node.first];
+		const BVH_NODE& right = m_nodes[node.first + 1];
+		bool bHitLeft = IntersectRayBox(origin, inverseDirection, left.minimum, left.maximum, nearest, leftEntry);
+		bool bHitRight = IntersectRayBox(origin, inverseDirection, right.minimum, right.maximum, nearest, rightEntry);
+
+		// push the farther child first so the nearer one is popped next
+		if (bHitLeft && bHitRight && (leftEntry < rightEntry))
+		{
+			nodeStack[stackSize] = node.first + 1;
+			distanceStack[stackSize++] = rightEntry;
+			nodeStack[stackSize] = node.first;
+			distanceStack[stackSize++] = leftEntry;
+		}
+		else
+		{
+			if (bHitLeft)
+			{
+				nodeStack[stackSize] = node.first;
+				distanceStack[stackSize++] = leftEntry;
+			}
+			if (bHitRight)
+			{
+				nodeStack[stackSize] = node.first + 1;
+				distanceStack[stackSize++] = rightEntry;
+			}
+		}
+	}
+
+	if (hitRecord >= 0)
+	{
+		hitDistance = nearest;
+	}
+
+	return(hitRecord);
+}
+
+/***********************************************************
+ *  QueryNearest()
+ *
+ *  This method is used for getting the record whose bounds
+ *  are nearest to the passed in point, within the max
+ *  distance.  Records containing the point are at distance 0.
+ ***********************************************************/
+int SceneBVH::QueryNearest(
+	const glm::vec3& point,
+	float maxDistance,
+	float& nearestDistance) const
+{
+	int nodeStack[g_MaxTraversalDepth];
+	float distanceStack[g_MaxTraversalDepth];
+	int stackSize = 0;
+	int nearestRecord = -1;
+	float nearest = maxDistance * maxDistance;
+
+	if (m_nodes.empty())
+	{
+		return(-1);
+	}
+
+	nodeStack[stackSize] = 0;
+	distanceStack[stackSize] = BoxDistanceSquared(point, m_nodes[0].minimum, m_nodes[0].maximum);
+	stackSize++;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (distanceStack[stackSize] > nearest)
+		{
+			continue;
+		}
+
+		const BVH_NODE& node = m_nodes[nodeStack[stackSize]];
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				float distance = BoxDistanceSquared(point, m_itemMinimum[i], m_itemMaximum[i]);
+				if (distance <= nearest)
+				{
+					nearest = distance;
+					nearestRecord = m_itemRecords[i];
+				}
+			}
+			continue;
+		}
+
+		const BVH_NODE& left = m_nodes[node.first];
+		const BVH_NODE& right = m_nodes[node.first + 1];
+		float leftDistance = BoxDistanceSquared(point, left.minimum, left.maximum);
+		float rightDistance = BoxDistanceSquared(point, right.minimum, right.maximum);
+
+		// push the farther child first so the nearer one is popped next
+		if (leftDistance < rightDistance)
+		{
+			nodeStack[stackSize] = node.first + 1;
+			distanceStack[stackSize++] = rightDistance;
+			nodeStack[stackSize] = node.first;
+			distanceStack[stackSize++] = leftDistance;
+		}
+		else
+		{
+			nodeStack[stackSize] = node.first;
+			distanceStack[stackSize++] = leftDistance;
+			nodeStack[stackSize] = node.first + 1;
+			distanceStack[stackSize++] = rightDistance;
+		}
+	}
+
+	if (nearestRecord >= 0)
+	{
+		nearestDistance = std::sqrt(nearest);
+	}
+
+	return(nearestRecord);
+}
\ No newline at end of file
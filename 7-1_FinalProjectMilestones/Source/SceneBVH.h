@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ============
+// bounding volume hierarchy over the draw records of a 3D scene - answers
+// frustum, ray and nearest object queries without walking every record
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "DrawList.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class builds a binary tree of axis aligned boxes over
+ *  the world bounds of the draw records.  The tree is built
+ *  once from the records, and afterwards only the boxes on the
+ *  path from a changed record up to the root are refitted.
+ *  The nodes and the record bounds are kept in flat arrays,
+ *  with the two children of a node stored next to each other.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// constructor
+	SceneBVH();
+	// destructor
+	~SceneBVH();
+
+	// most records that are kept in one leaf node
+	static const int MAX_LEAF_RECORDS = 4;
+
+	struct BVH_NODE
+	{
+		glm::vec3 minimum;
+		// first child for inner nodes, first item for leaf nodes
+		int first;
+		glm::vec3 maximum;
+		// number of items in a leaf node, or 0 for inner nodes
+		int count;
+		// parent node, or -1 for the root node
+		int parent;
+	};
+
+	// build the tree over all of the records in the draw list
+	void Build(const DrawList& drawList);
+	// refit the boxes of the passed in records and their parents
+	void Refit(const DrawList& drawList, const std::vector<int>& changedRecords);
+	// remove all of the nodes from the tree
+	void Clear();
+
+	// get the records whose bounds are inside of the frustum planes
+	void QueryFrustum(const glm::vec4 planes[6], std::vector<int>& results) const;
+	// get the nearest record whose bounds are hit by the ray, or -1
+	int QueryRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float& hitDistance) const;
+	// get the record whose bounds are nearest to the point, or -1
+	int QueryNearest(
+		const glm::vec3& point,
+		float maxDistance,
+		float& nearestDistance) const;
+
+	int GetRecordCount() const { return((int)m_itemRecords.size()); }
+	int GetNodeCount() const { return((int)m_nodes.size()); }
+
+private:
+	// flat array of tree nodes - the root is node 0
+	std::vector<BVH_NODE> m_nodes;
+	// record index of every leaf item, grouped by leaf
+	std::vector<int> m_itemRecords;
+	// world bounds of every leaf item
+	std::vector<glm::vec3> m_itemMinimum;
+	std::vector<glm::vec3> m_itemMaximum;
+	// leaf item of every record, indexed by record
+	std::vector<int> m_recordItems;
+	// leaf node of every item
+	std::vector<int> m_itemLeaves;
+	// bounds centers of the records - only used while building
+	std::vector<glm::vec3> m_buildCenters;
+
+	// split a node's items in two and build its children
+	void BuildNode(int nodeIndex, int first, int count);
+	// fit a node's box around its items or children - returns
+	// true when the box has changed
+	bool FitNode(int nodeIndex);
+};
\ No newline at end of file
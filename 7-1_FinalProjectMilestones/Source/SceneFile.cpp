@@ -0,0 +1,697 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// memory mapped binary scene file, and the compiler that builds one from the
+// text authoring format
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "DrawList.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// the records are read in place, so their sizes are part of
+// the file format and changing one needs a new file version
+static_assert(sizeof(SceneFile::SCENE_HEADER) == 72, "SCENE_HEADER does not match the file layout");
+static_assert(sizeof(SceneFile::SCENE_TEXTURE) == 256, "SCENE_TEXTURE does not match the file layout");
+static_assert(sizeof(SceneFile::SCENE_MATERIAL) == 80, "SCENE_MATERIAL does not match the file layout");
+static_assert(sizeof(SceneFile::SCENE_OBJECT) == 80, "SCENE_OBJECT does not match the file layout");
+
+// declaration of the global variables and defines
+namespace
+{
+	// bytes of one record of each section
+	const size_t g_RecordSizes[SceneFile::SECTION_COUNT] =
+	{
+		sizeof(SceneFile::SCENE_TEXTURE),
+		sizeof(SceneFile::SCENE_MATERIAL),
+		sizeof(UniformBlocks::LIGHT_DATA),
+		sizeof(ClusteredLights::POINT_LIGHT),
+		sizeof(SceneFile::SCENE_OBJECT)
+	};
+	// every table starts on this boundary
+	const size_t g_SectionAlignment = 16;
+
+	// mesh names of the text format, indexed by mesh type
+	const char* const g_MeshNames[DrawList::MESH_TYPE_COUNT] =
+	{
+		"plane",
+		"box",
+		"cone",
+		"cylinder",
+		"sphere"
+	};
+
+	/***********************************************************
+	 *  AlignOffset()
+	 *
+	 *  This function is used for rounding an offset up to the
+	 *  start of the next table.
+	 ***********************************************************/
+	size_t AlignOffset(size_t offset)
+	{
+		return(((offset + g_SectionAlignment - 1) / g_SectionAlignment) * g_SectionAlignment);
+	}
+
+	/***********************************************************
+	 *  CopyName()
+	 *
+	 *  This function is used for copying a tag or a path into a
+	 *  fixed size field of a record - returns false when it is
+	 *  too long to fit with its terminating zero.
+	 ***********************************************************/
+	bool CopyName(char* pField, size_t fieldSize, const std::string& name)
+	{
+		if ((name.empty() == true) || (name.size() >= fieldSize))
+		{
+			return(false);
+		}
+
+		memset(pField, 0, fieldSize);
+		memcpy(pField, name.c_str(), name.size());
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseParts()
+	 *
+	 *  This function is used for reading a comma separated list
+	 *  of mesh parts, such as "top,sides" - returns 0 when a
+	 *  part name is unknown.
+	 ***********************************************************/
+	unsigned int ParseParts(const std::string& text)
+	{
+		unsigned int parts = 0;
+		std::istringstream names(text);
+		std::string name;
+
+		while (std::getline(names, name, ','))
+		{
+			if (name == "all")
+				parts |= DrawList::PART_ALL;
+			else if (name == "top")
+				parts |= DrawList::PART_TOP;
+			else if (name == "bottom")
+				parts |= DrawList::PART_BOTTOM;
+			else if (name == "sides")
+				parts |= DrawList::PART_SIDES;
+			else
+				return(0);
+		}
+
+		return(parts);
+	}
+
+	/***********************************************************
+	 *  FindName()
+	 *
+	 *  This function is used for finding the table index of a
+	 *  texture or material tag, or -1 when it is not defined.
+	 ***********************************************************/
+	template <typename RECORD>
+	int FindName(const std::vector<RECORD>& records, const std::string& tag)
+	{
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (tag == records[i].tag)
+			{
+				return((int)i);
+			}
+		}
+
+		return(-1);
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a binary scene file into
+ *  memory.  Only the header and the few named records are
+ *  checked - the objects are used as they lie in the file.
+ ***********************************************************/
+bool SceneFile::Open(const char* filePath)
+{
+	Close();
+
+	size_t fileSize = 0;
+	const void* pView = NULL;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if ((GetFileSizeEx(file, &size) != 0) && (size.QuadPart >= (LONGLONG)sizeof(SCENE_HEADER)))
+		{
+			fileSize = (size_t)size.QuadPart;
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (NULL != mapping)
+			{
+				// the view keeps the mapping and the file open
+				pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	int file = open(filePath, O_RDONLY);
+	if (file >= 0)
+	{
+		struct stat status;
+		if ((fstat(file, &status) == 0) && (status.st_size >= (off_t)sizeof(SCENE_HEADER)))
+		{
+			fileSize = (size_t)status.st_size;
+			// the mapping keeps the file open
+			void* pMapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+			if (pMapping != MAP_FAILED)
+			{
+				pView = pMapping;
+			}
+		}
+		close(file);
+	}
+#endif
+
+	if (NULL == pView)
+	{
+		std::cout << "Could not map scene file:" << filePath << std::endl;
+		return(false);
+	}
+
+	m_pData = (const unsigned char*)pView;
+	m_size = fileSize;
+
+	const SCENE_HEADER* pHeader = GetHeader();
+	if ((pHeader->magic != FILE_MAGIC) || (pHeader->version != FILE_VERSION) ||
+		(pHeader->fileSize != m_size) || (ValidateSections() == false))
+	{
+		std::cout << "Scene file is damaged or from another version:" << filePath << std::endl;
+		Close();
+		return(false);
+	}
+
+	std::cout << "INFO: Mapped scene file " << filePath << " with "
+		<< pHeader->sections[SECTION_OBJECTS].count << " objects" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the file.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	if (NULL != m_pData)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+#else
+		munmap((void*)m_pData, m_size);
+#endif
+	}
+	m_pData = NULL;
+	m_size = 0;
+}
+
+/***********************************************************
+ *  GetTextures()
+ *
+ *  This method is used for getting the texture table.
+ ***********************************************************/
+const SceneFile::SCENE_TEXTURE* SceneFile::GetTextures(int& count) const
+{
+	return((const SCENE_TEXTURE*)GetSection(SECTION_TEXTURES, count));
+}
+
+/***********************************************************
+ *  GetMaterials()
+ *
+ *  This method is used for getting the material table.
+ ***********************************************************/
+const SceneFile::SCENE_MATERIAL* SceneFile::GetMaterials(int& count) const
+{
+	return((const SCENE_MATERIAL*)GetSection(SECTION_MATERIALS, count));
+}
+
+/***********************************************************
+ *  GetLights()
+ *
+ *  This method is used for getting the light sources of the
+ *  light block.
+ ***********************************************************/
+const UniformBlocks::LIGHT_DATA* SceneFile::GetLights(int& count) const
+{
+	return((const UniformBlocks::LIGHT_DATA*)GetSection(SECTION_LIGHTS, count));
+}
+
+/***********************************************************
+ *  GetPointLights()
+ *
+ *  This method is used for getting the clustered point lights.
+ ***********************************************************/
+const ClusteredLights::POINT_LIGHT* SceneFile::GetPointLights(int& count) const
+{
+	return((const ClusteredLights::POINT_LIGHT*)GetSection(SECTION_POINT_LIGHTS, count));
+}
+
+/***********************************************************
+ *  GetObjects()
+ *
+ *  This method is used for getting the object table.
+ ***********************************************************/
+const SceneFile::SCENE_OBJECT* SceneFile::GetObjects(int& count) const
+{
+	return((const SCENE_OBJECT*)GetSection(SECTION_OBJECTS, count));
+}
+
+/***********************************************************
+ *  GetSection()
+ *
+ *  This method is used for getting the start of a table in
+ *  the mapping and its record count.
+ ***********************************************************/
+const void* SceneFile::GetSection(SECTION_TYPE section, int& count) const
+{
+	if (NULL == m_pData)
+	{
+		count = 0;
+		return(NULL);
+	}
+
+	const SCENE_SECTION& entry = GetHeader()->sections[section];
+	count = (int)entry.count;
+
+	return(m_pData + entry.offset);
+}
+
+/***********************************************************
+ *  ValidateSections()
+ *
+ *  This method is used for checking that every table starts
+ *  on its boundary and ends inside the mapping, and that the
+ *  tags and paths are terminated.
+ ***********************************************************/
+bool SceneFile::ValidateSections() const
+{
+	const SCENE_HEADER* pHeader = GetHeader();
+
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		const SCENE_SECTION& entry = pHeader->sections[i];
+		uint64_t end = (uint64_t)entry.offset + ((uint64_t)entry.count * g_RecordSizes[i]);
+
+		if (((entry.offset % g_SectionAlignment) != 0) || (entry.offset < sizeof(SCENE_HEADER)) || (end > m_size))
+		{
+			return(false);
+		}
+	}
+
+	int textureCount = 0;
+	const SCENE_TEXTURE* pTextures = GetTextures(textureCount);
+	for (int i = 0; i < textureCount; i++)
+	{
+		if ((pTextures[i].tag[TAG_LENGTH - 1] != 0) || (pTextures[i].path[PATH_LENGTH - 1] != 0))
+		{
+			return(false);
+		}
+	}
+
+	int materialCount = 0;
+	const SCENE_MATERIAL* pMaterials = GetMaterials(materialCount);
+	for (int i = 0; i < materialCount; i++)
+	{
+		if (pMaterials[i].tag[TAG_LENGTH - 1] != 0)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for compiling a text scene into a
+ *  binary scene file.  Each line starts with the kind of
+ *  entry - ambient, texture, material, light, pointlight or
+ *  object - followed by named values, and lines starting
+ *  with # are skipped.  Textures and materials are referenced
+ *  by tag and must be defined before the objects using them.
+ ***********************************************************/
+bool SceneFile::Compile(const char* textPath, const char* binaryPath)
+{
+	std::ifstream text(textPath);
+	if (!text)
+	{
+		std::cout << "Could not open scene text:" << textPath << std::endl;
+		return(false);
+	}
+
+	SCENE_HEADER header;
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.fileSize = 0;
+	header.padding = 0;
+	header.globalAmbientColor = glm::vec3(0.0f);
+	header.ambientPadding = 0.0f;
+
+	std::vector<SCENE_TEXTURE> textures;
+	std::vector<SCENE_MATERIAL> materials;
+	std::vector<UniformBlocks::LIGHT_DATA> lights;
+	std::vector<ClusteredLights::POINT_LIGHT> pointLights;
+	std::vector<SCENE_OBJECT> objects;
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(text, line))
+	{
+		lineNumber++;
+
+		std::istringstream values(line);
+		std::string kind;
+		if (!(values >> kind) || (kind[0] == '#'))
+		{
+			continue;
+		}
+
+		std::string error;
+		std::string key;
+
+		if (kind == "ambient")
+		{
+			glm::vec3& color = header.globalAmbientColor;
+			if (!(values >> color.r >> color.g >> color.b))
+			{
+				error = "ambient needs a color";
+			}
+		}
+		else if (kind == "texture")
+		{
+			SCENE_TEXTURE texture;
+			std::string tag;
+			std::string path;
+			values >> tag >> path;
+
+			if ((CopyName(texture.tag, TAG_LENGTH, tag) == false) || (CopyName(texture.path, PATH_LENGTH, path) == false))
+			{
+				error = "texture needs a tag and a path that fit their fields";
+			}
+			else if (FindName(textures, tag) >= 0)
+			{
+				error = "texture " + tag + " is already defined";
+			}
+			else
+			{
+				textures.push_back(texture);
+			}
+		}
+		else if (kind == "material")
+		{
+			SCENE_MATERIAL material;
+			std::string tag;
+			values >> tag;
+
+			UniformBlocks::MATERIAL_DATA& data = material.values;
+			data.ambientColor = glm::vec3(0.0f);
+			data.ambientStrength = 0.0f;
+			data.diffuseColor = glm::vec3(1.0f);
+			data.shininess = 32.0f;
+			data.specularColor = glm::vec3(0.0f);
+			data.padding = 0.0f;
+
+			while ((error.empty() == true) && (values >> key))
+			{
+				bool bRead = false;
+				if (key == "diffuse")
+					bRead = !!(values >> data.diffuseColor.r >> data.diffuseColor.g >> data.diffuseColor.b);
+				else if (key == "specular")
+					bRead = !!(values >> data.specularColor.r >> data.specularColor.g >> data.specularColor.b);
+				else if (key == "ambient")
+					bRead = !!(values >> data.ambientColor.r >> data.ambientColor.g >> data.ambientColor.b >> data.ambientStrength);
+				else if (key == "shininess")
+					bRead = !!(values >> data.shininess);
+
+				if (bRead == false)
+				{
+					error = "bad material value " + key;
+				}
+			}
+
+			if ((error.empty() == true) && (CopyName(material.tag, TAG_LENGTH, tag) == false))
+			{
+				error = "material needs a tag that fits its field";
+			}
+			if (error.empty() == true)
+			{
+				materials.push_back(material);
+			}
+		}
+		else if (kind == "light")
+		{
+			UniformBlocks::LIGHT_DATA light;
+			light.position = glm::vec3(0.0f);
+			light.focalStrength = 16.0f;
+			light.diffuseColor = glm::vec3(0.0f);
+			light.specularIntensity = 0.0f;
+			light.specularColor = glm::vec3(0.0f);
+			light.padding = 0.0f;
+
+			while ((error.empty() == true) && (values >> key))
+			{
+				bool bRead = false;
+				if (key == "position")
+					bRead = !!(values >> light.position.x >> light.position.y >> light.position.z);
+				else if (key == "diffuse")
+					bRead = !!(values >> light.diffuseColor.r >> light.diffuseColor.g >> light.diffuseColor.b);
+				else if (key == "specular")
+					bRead = !!(values >> light.specularColor.r >> light.specularColor.g >> light.specularColor.b);
+				else if (key == "focal")
+					bRead = !!(values >> light.focalStrength);
+				else if (key == "intensity")
+					bRead = !!(values >> light.specularIntensity);
+
+				if (bRead == false)
+				{
+					error = "bad light value " + key;
+				}
+			}
+
+			if ((error.empty() == true) && ((int)lights.size() >= UniformBlocks::MAX_LIGHTS))
+			{
+				error = "the light block holds " + std::to_string(UniformBlocks::MAX_LIGHTS) + " lights, use point lights";
+			}
+			if (error.empty() == true)
+			{
+				lights.push_back(light);
+			}
+		}
+		else if (kind == "pointlight")
+		{
+			ClusteredLights::POINT_LIGHT light;
+			light.position = glm::vec3(0.0f);
+			light.radius = 1.0f;
+			light.color = glm::vec3(1.0f);
+			light.intensity = 1.0f;
+
+			while ((error.empty() == true) && (values >> key))
+			{
+				bool bRead = false;
+				if (key == "position")
+					bRead = !!(values >> light.position.x >> light.position.y >> light.position.z);
+				else if (key == "color")
+					bRead = !!(values >> light.color.r >> light.color.g >> light.color.b);
+				else if (key == "radius")
+					bRead = !!(values >> light.radius);
+				else if (key == "intensity")
+					bRead = !!(values >> light.intensity);
+
+				if (bRead == false)
+				{
+					error = "bad point light value " + key;
+				}
+			}
+
+			if (error.empty() == true)
+			{
+				pointLights.push_back(light);
+			}
+		}
+		else if (kind == "object")
+		{
+			SCENE_OBJECT object;
+			object.color = glm::vec4(1.0f);
+			object.scaleXYZ = glm::vec3(1.0f);
+			object.rotationDegrees = glm::vec3(0.0f);
+			object.positionXYZ = glm::vec3(0.0f);
+			object.uvScale = glm::vec2(1.0f);
+			object.textureIndex = -1;
+			object.materialIndex = -1;
+			object.meshParts = DrawList::PART_ALL;
+			object.flags = 0;
+			object.padding = 0;
+
+			std::string mesh;
+			values >> mesh;
+			int meshID = -1;
+			for (int i = 0; i < DrawList::MESH_TYPE_COUNT; i++)
+			{
+				if (mesh == g_MeshNames[i])
+				{
+					meshID = i;
+				}
+			}
+			if (meshID < 0)
+			{
+				error = "unknown mesh " + mesh;
+			}
+			object.meshID = (uint16_t)meshID;
+
+			while ((error.empty() == true) && (values >> key))
+			{
+				bool bRead = false;
+				std::string name;
+				if (key == "scale")
+					bRead = !!(values >> object.scaleXYZ.x >> object.scaleXYZ.y >> object.scaleXYZ.z);
+				else if (key == "rotation")
+					bRead = !!(values >> object.rotationDegrees.x >> object.rotationDegrees.y >> object.rotationDegrees.z);
+				else if (key == "position")
+					bRead = !!(values >> object.positionXYZ.x >> object.positionXYZ.y >> object.positionXYZ.z);
+				else if (key == "color")
+					bRead = !!(values >> object.color.r >> object.color.g >> object.color.b >> object.color.a);
+				else if (key == "uv")
+					bRead = !!(values >> object.uvScale.x >> object.uvScale.y);
+				else if (key == "dynamic")
+				{
+					object.flags |= OBJECT_DYNAMIC;
+					bRead = true;
+				}
+				else if ((key == "parts") && (values >> name))
+				{
+					object.meshParts = (uint16_t)ParseParts(name);
+					bRead = (object.meshParts != 0);
+				}
+				else if ((key == "texture") && (values >> name))
+				{
+					object.textureIndex = FindName(textures, name);
+					bRead = (object.textureIndex >= 0);
+				}
+				else if ((key == "material") && (values >> name))
+				{
+					object.materialIndex = FindName(materials, name);
+					bRead = (object.materialIndex >= 0);
+				}
+
+				if (bRead == false)
+				{
+					error = "bad or undefined object value " + key;
+				}
+			}
+
+			if (error.empty() == true)
+			{
+				objects.push_back(object);
+			}
+		}
+		else
+		{
+			error = "unknown entry " + kind;
+		}
+
+		if (error.empty() == false)
+		{
+			std::cout << "Scene text " << textPath << " line " << lineNumber << ": " << error << std::endl;
+			return(false);
+		}
+	}
+
+	// lay the tables out one after another, each on its boundary
+	const void* pTables[SECTION_COUNT] =
+	{
+		textures.data(),
+		materials.data(),
+		lights.data(),
+		pointLights.data(),
+		objects.data()
+	};
+	const size_t tableCounts[SECTION_COUNT] =
+	{
+		textures.size(),
+		materials.size(),
+		lights.size(),
+		pointLights.size(),
+		objects.size()
+	};
+
+	size_t offset = AlignOffset(sizeof(SCENE_HEADER));
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		header.sections[i].offset = (uint32_t)offset;
+		header.sections[i].count = (uint32_t)tableCounts[i];
+		offset = AlignOffset(offset + (tableCounts[i] * g_RecordSizes[i]));
+	}
+	header.fileSize = (uint32_t)offset;
+
+	std::vector<unsigned char> image(offset, 0);
+	memcpy(image.data(), &header, sizeof(header));
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		if (tableCounts[i] > 0)
+		{
+			memcpy(image.data() + header.sections[i].offset, pTables[i], tableCounts[i] * g_RecordSizes[i]);
+		}
+	}
+
+	std::ofstream binary(binaryPath, std::ios::binary | std::ios::trunc);
+	binary.write((const char*)image.data(), (std::streamsize)image.size());
+	if (!binary)
+	{
+		std::cout << "Could not write scene file:" << binaryPath << std::endl;
+		return(false);
+	}
+
+	std::cout << "Compiled scene " << textPath << " into " << binaryPath
+		<< ", objects:" << objects.size() << ", bytes:" << image.size() << std::endl;
+	return(true);
+}
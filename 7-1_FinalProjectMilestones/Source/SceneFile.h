@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// memory mapped binary scene file, and the compiler that builds one from the
+// text authoring format
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformBlocks.h"
+#include "ClusteredLights.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class maps a binary scene file into memory and hands
+ *  out its tables in place.  The file is a header followed by
+ *  flat arrays of fixed size records - textures, materials,
+ *  light sources, point lights and objects - so nothing is
+ *  parsed and nothing is allocated per object when it loads.
+ *  The light records match the layouts of the light blocks
+ *  and the object records hold the authored values of a draw
+ *  record in the same order, so they are copied straight
+ *  into the retained draw list.  Texture and material
+ *  references are indices into the file's own tables.  The
+ *  values are stored little endian, as every target of the
+ *  project is.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// "SCNB" read as a little endian number
+	static const uint32_t FILE_MAGIC = 0x424E4353;
+	// raised whenever the layout of a record changes
+	static const uint32_t FILE_VERSION = 1;
+	// longest texture tag, material tag and texture path, with
+	// the terminating zero
+	static const int TAG_LENGTH = 32;
+	static const int PATH_LENGTH = 224;
+
+	// tables of the file, in the order of the header sections
+	enum SECTION_TYPE
+	{
+		SECTION_TEXTURES = 0,
+		SECTION_MATERIALS,
+		SECTION_LIGHTS,
+		SECTION_POINT_LIGHTS,
+		SECTION_OBJECTS,
+		SECTION_COUNT
+	};
+
+	// flags of an object record
+	enum OBJECT_FLAG
+	{
+		// the object moves after the scene is prepared, so it
+		// is never baked into a static batch
+		OBJECT_DYNAMIC = 0x01
+	};
+
+	// byte offset from the start of the file and number of
+	// records of one table
+	struct SCENE_SECTION
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct SCENE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t fileSize;
+		uint32_t padding;
+		SCENE_SECTION sections[SECTION_COUNT];
+		glm::vec3 globalAmbientColor;
+		float ambientPadding;
+	};
+
+	// texture image that is loaded under its tag
+	struct SCENE_TEXTURE
+	{
+		char tag[TAG_LENGTH];
+		char path[PATH_LENGTH];
+	};
+
+	// material that is defined under its tag
+	struct SCENE_MATERIAL
+	{
+		char tag[TAG_LENGTH];
+		UniformBlocks::MATERIAL_DATA values;
+	};
+
+	// authored values of one draw record
+	struct SCENE_OBJECT
+	{
+		glm::vec4 color;
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec2 uvScale;
+		// index into the texture table, or -1 for the solid color
+		int32_t textureIndex;
+		// index into the material table, or -1 for none
+		int32_t materialIndex;
+		uint16_t meshID;
+		uint16_t meshParts;
+		uint32_t flags;
+		uint32_t padding;
+	};
+
+	// map a binary scene file and check its header and tables
+	bool Open(const char* filePath);
+	// unmap the file - the tables are invalid afterwards
+	void Close();
+	bool IsOpen() const { return(NULL != m_pData); }
+
+	// tables of the mapped file - each points into the mapping
+	// and holds the count of its section
+	const SCENE_TEXTURE* GetTextures(int& count) const;
+	const SCENE_MATERIAL* GetMaterials(int& count) const;
+	const UniformBlocks::LIGHT_DATA* GetLights(int& count) const;
+	const ClusteredLights::POINT_LIGHT* GetPointLights(int& count) const;
+	const SCENE_OBJECT* GetObjects(int& count) const;
+	glm::vec3 GetGlobalAmbientColor() const { return(GetHeader()->globalAmbientColor); }
+
+	// compile a text scene into a binary scene file
+	static bool Compile(const char* textPath, const char* binaryPath);
+
+private:
+	// start of the mapping, or NULL when no file is open
+	const unsigned char* m_pData;
+	// bytes in the mapping
+	size_t m_size;
+
+	const SCENE_HEADER* GetHeader() const { return((const SCENE_HEADER*)m_pData); }
+	// get the start of a table and its record count
+	const void* GetSection(SECTION_TYPE section, int& count) const;
+	// check that every table lies inside the mapping
+	bool ValidateSections() const;
+};
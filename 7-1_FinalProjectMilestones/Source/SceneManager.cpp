@@ -1,623 +1,2718 @@
-///////////////////////////////////////////////////////////////////////////////
-// scenemanager.cpp
-// ============
-// manage the preparing and rendering of 3D scenes - textures, materials, lighting
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
-
-#include <glm/gtx/transform.hpp>
-
-// declaration of global variables
-namespace
-{
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
-}
-
-/***********************************************************
- *  SceneManager()
- *
- *  The constructor for the class
- ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
-{
-	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
-}
-
-/***********************************************************
- *  ~SceneManager()
- *
- *  The destructor for the class
- ***********************************************************/
-SceneManager::~SceneManager()
-{
-	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
-}
-
-/***********************************************************
- *  CreateGLTexture()
- *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
-	}
-
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
-}
-
-/***********************************************************
- *  BindGLTextures()
- *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
- ***********************************************************/
-void SceneManager::BindGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  DestroyGLTextures()
- *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
- ***********************************************************/
-void SceneManager::DestroyGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  FindTextureID()
- *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
-{
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureID);
-}
-
-/***********************************************************
- *  FindTextureSlot()
- *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
-{
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
-}
-
-/***********************************************************
- *  FindMaterial()
- *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
- ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
-{
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return(true);
-}
-
-/***********************************************************
- *  SetTransformations()
- *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
- ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
-}
-
-/***********************************************************
- *  SetShaderColor()
- *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
-}
-
-/***********************************************************
- *  SetShaderTexture()
- *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
- ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
-}
-
-/***********************************************************
- *  SetTextureUVScale()
- *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
-}
-
-/***********************************************************
- *  SetShaderMaterial()
- *
- *  This method is used for passing the material values
- *  into the shader.
- ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		// find the defined material that matches the tag
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			// pass the material properties into the shader
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-void SceneManager::LoadSceneTextures()
-{
-	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture(
-		"textures/drywall.jpg",
-		"drywall");
-
-	bReturn = CreateGLTexture(
-		"textures/backdrop.jpg",
-		"backdrop");
-
-	bReturn = CreateGLTexture(
-		"textures/abstract.jpg",
-		"abstract");
-
-	bReturn = CreateGLTexture(
-		"textures/stainedglass.jpg",
-		"stainedglass");
-
-	bReturn = CreateGLTexture(
-		"textures/pyramid.jpg",
-		"pyramid");
-
-	bReturn = CreateGLTexture(
-		"textures/pyramid2.jpg",
-		"pyramid2");
-
-	bReturn = CreateGLTexture(
-		"textures/sand.jpg",
-		"sand");
-
-
-
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
-}
-
-void SceneManager::DefineObjectMaterials()
-{
-	/*setting steel material to use as material for different shapes*/
-	OBJECT_MATERIAL steelMaterial;
-
-	steelMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	steelMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	steelMaterial.shininess = 64.0;
-	steelMaterial.tag = "steel";
-
-	m_objectMaterials.push_back(steelMaterial);
-}
-
-/***********************************************************
- *  SetupSceneLights()
- *
- *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
- ***********************************************************/
-void SceneManager::SetupSceneLights()
-
-{
-
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	m_pShaderManager->setVec3Value("globalAmbientColor", 0.05f, 0.04f, 0.07f);
-
-
-
-	/*light source 1*/
-
-	m_pShaderManager->setVec3Value("lightSources[0].position", -5.0f, 5.0f, 10.0f);
-
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.7f, 0.1f, 0.05f);
-
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", .5f, 0.01f, 0.005f);
-
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 16.0f);
-
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.15f);
-
-
-	/*light source 2*/
-
-	m_pShaderManager->setVec3Value("lightSources[1].position", 5.0f, 15.0f, 6.0f);
-
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.4f, 0.4f, 0.4f);
-
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.25f, 0.25f, 0.25f);
-
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 8.0f);
-
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.1f);
-
-}
-
-/***********************************************************
- *  PrepareScene()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
- ***********************************************************/
-void SceneManager::PrepareScene()
-{
-
-	LoadSceneTextures();
-
-	DefineObjectMaterials();
-	// add and define the light sources for the scene
-	SetupSceneLights();
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadCylinderMesh();
-
-
-}
-
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-
-
-void SceneManager::RenderScene()
-{
-	// Set scale and position for the ground mesh
-	glm::vec3 scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("sand");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawPlaneMesh();
-
-	// Draw descending cubes with varying heights and colors
-	int numCubes = 9;
-	float maxHeight = 3.0f;
-	float cubeHeight = maxHeight / numCubes;
-	float cubeSize = 0.5f;
-
-	for (int i = 0; i < numCubes; ++i)
-	{
-		float scaleFactor = static_cast<float>(numCubes - i) / numCubes;
-		float yPos = cubeHeight * i;
-		float r = 0.8f + (0.2f * scaleFactor);
-		float g = 0.6f + (0.4f * scaleFactor);
-		float b = 0.4f + (0.6f * scaleFactor);
-
-		scaleXYZ = glm::vec3(scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize);
-		positionXYZ = glm::vec3(3.0f, yPos, 3.8f);
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		SetShaderColor(r, g, b, 1.0f);
-		SetShaderTexture("pyramid2");
-		SetTextureUVScale(1.0, 1.0);
-		m_basicMeshes->DrawBoxMesh();
-	}
-
-	// Draw ascending cubes and cones with decreasing sizes and varying textures
-	int numCubess = 5;
-	for (int i = 0; i < numCubess; ++i)
-	{
-		float scaleFactor = static_cast<float>(numCubess - i) / numCubess;
-		float yPos = cubeHeight * i;
-		float r = 0.8f + (0.2f * scaleFactor);
-		float g = 0.6f + (0.4f * scaleFactor);
-		float b = 0.4f + (0.6f * scaleFactor);
-
-		scaleXYZ = glm::vec3(scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize);
-		positionXYZ = glm::vec3(2.0f, yPos, 5.6f);
-		SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-		SetShaderColor(r, g, b, 1.0f);
-
-		if (i == numCubes - 1) {
-			// Skip drawing for the top cube
-		}
-		else if (i == numCubes - 2) {
-			SetShaderTexture("pyramid2");
-			SetTextureUVScale(1.0, 1.0);
-			m_basicMeshes->DrawConeMesh();
-		}
-		else {
-			SetShaderTexture("pyramid2");
-			SetTextureUVScale(1.0, 1.0);
-			m_basicMeshes->DrawBoxMesh();
-		}
-	}
-
-	// Draw large pyramid #2
-	scaleXYZ = glm::vec3(2.0f, 2.0f, 2.0f);
-	positionXYZ = glm::vec3(10.0f, 0.0f, 1.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("pyramid");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawConeMesh();
-
-	// Draw medium pyramid #3
-	scaleXYZ = glm::vec3(2.0f, 2.0f, 2.0f);
-	positionXYZ = glm::vec3(6.0f, 0.0f, 2.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("pyramid");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawConeMesh(true); // Use different texture on sides
-
-	// Draw small pyramid #3
-	scaleXYZ = glm::vec3(0.5f, 0.5f, 0.5f);
-	positionXYZ = glm::vec3(6.0f, 1.6f, 2.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("pyramid2");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawConeMesh(true);
-
-	// Draw complex texture shape with top and sides using different textures
-	scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);
-	positionXYZ = glm::vec3(-1.2f, 0.0f, 4.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("pyramid2");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawCylinderMesh(false, true, true); // Top and sides with different textures
-
-	SetShaderMaterial("steel"); // Set material for subsequent drawing
-
-	SetShaderTexture("sand");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawCylinderMesh(true, false, false); // Draw cylinder with sand texture
-
-	// Draw a small cone on top of the complex shape
-	scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
-	positionXYZ = glm::vec3(0.3f, 0.0f, 3.0f);
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.82f, 0.71f, 0.55f, 1.0f);
-	m_basicMeshes->DrawConeMesh();
-}
-
+///////////////////////////////////////////////////////////////////////////////
+// scenemanager.cpp
+// ============
+// manage the preparing and rendering of 3D scenes - textures, materials, lighting
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneManager.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <glm/gtx/transform.hpp>
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const char* g_ModelName = "model";
+	const char* g_NormalMatrixName = "normalMatrix";
+	const char* g_ColorValueName = "objectColor";
+	const char* g_TextureValueName = "objectTexture";
+	const char* g_TextureLayerName = "textureLayer";
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UseInstancingName = "bUseInstancing";
+	const char* g_UseObjectBufferName = "bUseObjectBuffer";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_LodFadeName = "lodFade";
+	const char* g_DepthOnlyName = "bDepthOnly";
+	const char* g_WriteGBufferName = "bWriteGBuffer";
+	const char* g_DeferredLightingName = "bDeferredLighting";
+
+	// shader variants used in the render queue sort keys - the
+	// permutation is stored above the variant bit
+	const unsigned int g_StandardShaderID = 0;
+	const unsigned int g_InstancedShaderID = 1;
+	// scene shader sources that the permutations are built from
+	const char* g_VertexShaderPath = "shaders/vertexShader.glsl";
+	const char* g_FragmentShaderPath = "shaders/fragmentShader.glsl";
+	// permutation index that selects the base program
+	const int g_BasePermutation = -1;
+	// view depth that maps to the largest sort key depth
+	const float g_MaxSortDepth = 100.0f;
+	// the most decoded texture data uploaded in one frame
+	const size_t g_MaxTextureUploadBytes = 32 * 1024 * 1024;
+	// largest mip level the texture arrays store when they are
+	// created - the streamer adds the finer levels in view
+	const int g_TextureStartSize = 256;
+	// fewest records that are culled through the bvh - smaller
+	// scenes are tested faster by the flat sphere loop
+	const int g_MinIndexedCullRecords = 64;
+	// compute shader that culls the GPU driven scene
+	const char* g_CullShaderPath = "shaders/cullShader.glsl";
+	// compute shader that builds the occluder depth pyramid
+	const char* g_HiZShaderPath = "shaders/hiZShader.glsl";
+	// fewest records in one range of a parallel loop over the
+	// records - smaller scenes are handled on the render thread
+	const int g_RecordGrainSize = 256;
+	// records whose world bounds are at least this wide along
+	// one axis are drawn into the occluder depth
+	const float g_MinOccluderExtent = 1.0f;
+	// mesh value of the static batches in the render queue sort
+	// keys, past the mesh values of the records
+	const unsigned int g_StaticBatchMeshKey = (unsigned int)DrawList::MESH_TYPE_COUNT << 3;
+	// fewest records that are baked into a static batch - a
+	// record on its own keeps its detail levels
+	const size_t g_MinStaticBatchRecords = 2;
+	// width of the grid cells that split the static batches, so
+	// each batch is culled with the part of the scene around it
+	const float g_StaticBatchCellSize = 16.0f;
+	// the most vertices baked into one static batch
+	const size_t g_MaxStaticBatchVertices = 65536;
+	// fewest mesh parts in one range of the parallel bake
+	const int g_StaticBakeGrainSize = 64;
+
+	// meshes of the GPU driven scene and the static batches -
+	// records made of several parts add one mesh for each part
+	enum GPU_MESH
+	{
+		GPU_MESH_PLANE = 0,
+		GPU_MESH_BOX,
+		GPU_MESH_CONE_SIDES,
+		GPU_MESH_CONE_BOTTOM,
+		GPU_MESH_CYLINDER_SIDES,
+		GPU_MESH_CYLINDER_TOP,
+		GPU_MESH_CYLINDER_BOTTOM,
+		GPU_MESH_SPHERE,
+		GPU_MESH_COUNT
+	};
+
+	// tags used by the scene, hashed at compile time
+	constexpr TagRegistry::TAG_HASH g_SandTag = TagRegistry::HashTag("sand");
+	constexpr TagRegistry::TAG_HASH g_PyramidTag = TagRegistry::HashTag("pyramid");
+	constexpr TagRegistry::TAG_HASH g_Pyramid2Tag = TagRegistry::HashTag("pyramid2");
+	constexpr TagRegistry::TAG_HASH g_SteelTag = TagRegistry::HashTag("steel");
+}
+
+/***********************************************************
+ *  SceneManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneManager::SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache, StateCache* pStateCache, UniformBlocks* pUniformBlocks)
+{
+	m_pShaderManager = pShaderManager;
+	m_pUniformCache = pUniformCache;
+	m_pBaseUniformCache = pUniformCache;
+	m_baseProgramID = 0;
+	m_currentPermutation = g_BasePermutation;
+	m_bUseLighting = false;
+	m_bDepthOnlyPass = false;
+	m_bGBufferPass = false;
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		m_permutations[i].programID = 0;
+		m_permutations[i].pUniformCache = NULL;
+	}
+	m_pStateCache = pStateCache;
+	m_pUniformBlocks = pUniformBlocks;
+	m_pProfiler = NULL;
+	m_pJobSystem = NULL;
+	m_pMeshBuffer = new MeshBuffer();
+	m_planeMesh = MeshBuffer::MESH_RANGE();
+	m_boxMesh = MeshBuffer::MESH_RANGE();
+	m_pShaderLibrary = new ShaderLibrary();
+	m_pGPUScene = new GPUScene(pStateCache);
+	m_pHiZBuffer = new HiZBuffer(pStateCache);
+	m_renderMode = RENDER_FORWARD;
+	m_pGBuffer = new GBuffer(pStateCache);
+	m_bGPUDriven = false;
+	m_bGPUSceneDirty = true;
+	m_sceneScale = 1;
+	m_bInstancing = true;
+	m_bCulling = true;
+	m_bStaticBaking = false;
+	m_instancedMeshes = new InstancedMeshes();
+	m_lodMeshes = new LODMeshes();
+	m_pTextureLoader = new TextureLoader(pStateCache);
+	m_pTextureArrays = new TextureArrays(pStateCache);
+	m_pTextureArrays->SetStartSize(g_TextureStartSize);
+	m_pTextureStreamer = new TextureStreamer(m_pTextureLoader, m_pTextureArrays);
+	m_viewportHeight = 0.0f;
+	m_pMeshExporter = new MeshExporter();
+	m_pClusteredLights = new ClusteredLights();
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_renderQueue.SetDepthRange(g_MaxSortDepth);
+}
+
+/***********************************************************
+ *  ~SceneManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneManager::~SceneManager()
+{
+	DestroyShaderPermutations();
+	m_pShaderManager = NULL;
+	m_pUniformCache = NULL;
+	m_pBaseUniformCache = NULL;
+	m_pStateCache = NULL;
+	m_pUniformBlocks = NULL;
+	delete m_pGBuffer;
+	m_pGBuffer = NULL;
+	delete m_pHiZBuffer;
+	m_pHiZBuffer = NULL;
+	delete m_pGPUScene;
+	m_pGPUScene = NULL;
+	delete m_pShaderLibrary;
+	m_pShaderLibrary = NULL;
+	delete m_pMeshBuffer;
+	m_pMeshBuffer = NULL;
+	delete m_instancedMeshes;
+	m_instancedMeshes = NULL;
+	delete m_lodMeshes;
+	m_lodMeshes = NULL;
+	delete m_pMeshExporter;
+	m_pMeshExporter = NULL;
+	delete m_pTextureStreamer;
+	m_pTextureStreamer = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	delete m_pTextureArrays;
+	m_pTextureArrays = NULL;
+	delete m_pClusteredLights;
+	m_pClusteredLights = NULL;
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for loading textures from image files
+ *  into the next texture slot.  The image is decoded on a
+ *  worker thread - the slot shows a placeholder until the
+ *  decoded image has been uploaded and packed into a texture
+ *  array, which happens at the start of a later frame in
+ *  RenderScene().
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, const char* tag)
+{
+	// register the special tag string - its id is the texture slot
+	// and the index of the texture in the texture arrays
+	int textureSlot = m_textureTags.Register(tag);
+	if (textureSlot != (int)m_textureIDs.size())
+	{
+		std::cout << "Could not load image:" << filename << ", the tag " << tag << " cannot be used" << std::endl;
+		return false;
+	}
+
+	GLuint textureID = m_pTextureLoader->RequestTexture(filename);
+
+	// associate the texture with the special tag string
+	TEXTURE_INFO textureInfo;
+	textureInfo.ID = textureID;
+	textureInfo.tag = tag;
+	m_textureIDs.push_back(textureInfo);
+	int textureIndex = m_pTextureArrays->AddTexture(textureID);
+	m_pTextureStreamer->AddTexture(textureIndex, filename);
+
+	return true;
+}
+
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for binding the texture arrays to
+ *  OpenGL texture memory slots.  Each array is bound on the
+ *  slot that matches its index.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	m_pTextureArrays->BindArrays();
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture memory slots.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	m_pTextureArrays->Destroy();
+	m_pTextureStreamer->Clear();
+	m_textureIDs.clear();
+	m_textureTags.Clear();
+}
+
+/***********************************************************
+ *  FindTextureID()
+ *
+ *  This method is used for getting an ID for the previously
+ *  loaded texture bitmap associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindTextureID(TagRegistry::TAG_HASH tagHash)
+{
+	int textureSlot = FindTextureSlot(tagHash);
+
+	if (textureSlot < 0)
+	{
+		return(-1);
+	}
+
+	return(m_textureIDs[textureSlot].ID);
+}
+
+/***********************************************************
+ *  FindTextureSlot()
+ *
+ *  This method is used for getting a slot index for the previously
+ *  loaded texture bitmap associated with the passed in tag.  The
+ *  slot is the id the tag was registered under.
+ ***********************************************************/
+int SceneManager::FindTextureSlot(TagRegistry::TAG_HASH tagHash)
+{
+	return(m_textureTags.Find(tagHash));
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting a material from the previously
+ *  defined materials list that is associated with the passed in tag.
+ *  NULL is returned when no material has the tag.
+ ***********************************************************/
+const SceneManager::OBJECT_MATERIAL* SceneManager::FindMaterial(TagRegistry::TAG_HASH tagHash)
+{
+	int materialIndex = FindMaterialIndex(tagHash);
+
+	if (materialIndex < 0)
+	{
+		return(NULL);
+	}
+
+	return(&m_objectMaterials[materialIndex]);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a previously
+ *  defined material that is associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(TagRegistry::TAG_HASH tagHash)
+{
+	return(m_materialTags.Find(tagHash));
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for registering the tag of a material
+ *  and storing the material under the tag id, both in the
+ *  materials list and in the material table uniform block.
+ *  A material with a tag that is already registered replaces
+ *  the old one.
+ ***********************************************************/
+void SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	int materialIndex = m_materialTags.Find(material.tag.c_str());
+
+	// the material table in the shader has a fixed size
+	if ((materialIndex < 0) && (m_materialTags.GetCount() >= UniformBlocks::MAX_MATERIALS))
+	{
+		std::cout << "Could not define material:" << material.tag << ", the material table is full" << std::endl;
+		return;
+	}
+
+	materialIndex = m_materialTags.Register(material.tag);
+	if (materialIndex < 0)
+	{
+		return;
+	}
+
+	if (NULL != m_pUniformBlocks)
+	{
+		UniformBlocks::MATERIAL_DATA materialData;
+		materialData.ambientColor = material.ambientColor;
+		materialData.ambientStrength = material.ambientStrength;
+		materialData.diffuseColor = material.diffuseColor;
+		materialData.shininess = material.shininess;
+		materialData.specularColor = material.specularColor;
+		materialData.padding = 0.0f;
+		m_pUniformBlocks->SetMaterial(materialIndex, materialData);
+	}
+
+	if (materialIndex < (int)m_objectMaterials.size())
+	{
+		m_objectMaterials[materialIndex] = material;
+	}
+	else
+	{
+		m_objectMaterials.push_back(material);
+	}
+}
+
+/***********************************************************
+ *  GetTextureArray()
+ *
+ *  This method is used for getting the index of the texture
+ *  array that currently holds a texture slot.  Textures that
+ *  are still loading are held by the placeholder array.
+ ***********************************************************/
+int SceneManager::GetTextureArray(int textureSlot)
+{
+	if ((textureSlot < 0) || (textureSlot >= m_pTextureArrays->GetTextureCount()))
+	{
+		return(-1);
+	}
+
+	return(m_pTextureArrays->GetTextureLayer(textureSlot).arrayIndex);
+}
+
+/***********************************************************
+ *  ResolveShaderUniforms()
+ *
+ *  This method is used for getting the typed handles for all
+ *  of the shader uniforms used by the scene.  The handles are
+ *  stored so no uniform names are looked up while rendering.
+ ***********************************************************/
+void SceneManager::ResolveShaderUniforms(
+	UniformCache* pUniformCache,
+	SHADER_UNIFORMS& uniforms)
+{
+	if (NULL == pUniformCache)
+	{
+		return;
+	}
+
+	uniforms.model = pUniformCache->GetHandle<glm::mat4>(g_ModelName);
+	uniforms.normalMatrix = pUniformCache->GetHandle<glm::mat3>(g_NormalMatrixName);
+	uniforms.objectColor = pUniformCache->GetHandle<glm::vec4>(g_ColorValueName);
+	uniforms.objectTexture = pUniformCache->GetHandle<int>(g_TextureValueName);
+	uniforms.textureLayer = pUniformCache->GetHandle<float>(g_TextureLayerName);
+	uniforms.bUseTexture = pUniformCache->GetHandle<bool>(g_UseTextureName);
+	uniforms.bUseLighting = pUniformCache->GetHandle<bool>(g_UseLightingName);
+	uniforms.bUseInstancing = pUniformCache->GetHandle<bool>(g_UseInstancingName);
+	uniforms.bUseObjectBuffer = pUniformCache->GetHandle<bool>(g_UseObjectBufferName);
+	uniforms.UVscale = pUniformCache->GetHandle<glm::vec2>("UVscale");
+	uniforms.materialIndex = pUniformCache->GetHandle<int>(g_MaterialIndexName);
+	uniforms.lodFade = pUniformCache->GetHandle<float>(g_LodFadeName);
+	uniforms.bDepthOnly = pUniformCache->GetHandle<bool>(g_DepthOnlyName);
+	uniforms.bWriteGBuffer = pUniformCache->GetHandle<bool>(g_WriteGBufferName);
+	uniforms.bDeferredLighting = pUniformCache->GetHandle<bool>(g_DeferredLightingName);
+	uniforms.gBufferAlbedo = pUniformCache->GetHandle<int>("gBufferAlbedo");
+	uniforms.gBufferNormal = pUniformCache->GetHandle<int>("gBufferNormal");
+	uniforms.gBufferMaterial = pUniformCache->GetHandle<int>("gBufferMaterial");
+	uniforms.gBufferDepth = pUniformCache->GetHandle<int>("gBufferDepth");
+	uniforms.inverseViewProjection = pUniformCache->GetHandle<glm::mat4>("inverseViewProjection");
+}
+
+/***********************************************************
+ *  BuildShaderPermutations()
+ *
+ *  This method is used for compiling a program for each mix
+ *  of lighting and texturing, with the number of lights that
+ *  the scene uses.  Each program gets its own uniform cache,
+ *  since the uniform locations differ between programs.  A
+ *  permutation that fails to build leaves its draws on the
+ *  base program, which picks the same features at runtime.
+ ***********************************************************/
+void SceneManager::BuildShaderPermutations()
+{
+	DestroyShaderPermutations();
+
+	std::string lightCountDefine = "LIGHT_COUNT " + std::to_string(m_pUniformBlocks->GetLightCount());
+
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		std::vector<std::string> defines;
+		defines.push_back(((i & PERMUTATION_LIT) != 0) ? "USE_LIGHTING 1" : "USE_LIGHTING 0");
+		defines.push_back(((i & PERMUTATION_TEXTURED) != 0) ? "USE_TEXTURE 1" : "USE_TEXTURE 0");
+		defines.push_back(lightCountDefine);
+
+		GLuint programID = m_pShaderLibrary->LoadProgram(g_VertexShaderPath, g_FragmentShaderPath, defines);
+		if (programID == 0)
+		{
+			std::cout << "Shader permutation " << i << " is drawn by the base program" << std::endl;
+			continue;
+		}
+
+		m_permutations[i].programID = programID;
+		m_permutations[i].pUniformCache = new UniformCache();
+		m_permutations[i].pUniformCache->SetStateCache(m_pStateCache);
+		m_permutations[i].pUniformCache->LoadProgram(programID);
+		ResolveShaderUniforms(m_permutations[i].pUniformCache, m_permutations[i].uniforms);
+	}
+}
+
+/***********************************************************
+ *  LoadBaseProgram()
+ *
+ *  This method is used for building the base program, which
+ *  picks its features from the uniforms at runtime, through
+ *  the shader library.  No defines are put in front of its
+ *  sources, so it matches the program the shader manager
+ *  would build, but later launches load it from its cached
+ *  program binary.  The program is put in use and its
+ *  uniform locations are resolved into the base cache.
+ ***********************************************************/
+bool SceneManager::LoadBaseProgram()
+{
+	m_baseProgramID = m_pShaderLibrary->LoadProgram(g_VertexShaderPath, g_FragmentShaderPath, std::vector<std::string>());
+	if (m_baseProgramID == 0)
+	{
+		std::cout << "Could not build the base shader program" << std::endl;
+		return(false);
+	}
+
+	m_pStateCache->UseProgram(m_baseProgramID);
+	m_currentPermutation = g_BasePermutation;
+	if (NULL != m_pBaseUniformCache)
+	{
+		m_pBaseUniformCache->LoadProgram(m_baseProgramID);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyShaderPermutations()
+ *
+ *  This method is used for freeing the uniform caches of the
+ *  permutations.  The programs belong to the shader library.
+ ***********************************************************/
+void SceneManager::DestroyShaderPermutations()
+{
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		delete m_permutations[i].pUniformCache;
+		m_permutations[i].pUniformCache = NULL;
+		m_permutations[i].programID = 0;
+	}
+}
+
+/***********************************************************
+ *  GetShaderPermutation()
+ *
+ *  This method is used for getting the permutation that
+ *  draws with the passed in texture array, where -1 draws
+ *  with the solid color.
+ ***********************************************************/
+int SceneManager::GetShaderPermutation(int textureArray) const
+{
+	int permutation = 0;
+
+	if (m_bUseLighting == true)
+	{
+		permutation |= PERMUTATION_LIT;
+	}
+	if (textureArray >= 0)
+	{
+		permutation |= PERMUTATION_TEXTURED;
+	}
+
+	return(permutation);
+}
+
+/***********************************************************
+ *  AssignShaderPermutations()
+ *
+ *  This method is used for setting the permutation of every
+ *  draw record.  It runs again when textures are packed,
+ *  since a record is only textured once its array is known.
+ ***********************************************************/
+void SceneManager::AssignShaderPermutations()
+{
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+		record.shaderPermutation = (uint16_t)GetShaderPermutation(GetTextureArray(record.textureSlot));
+	}
+
+	for (size_t i = 0; i < m_staticBatches.size(); i++)
+	{
+		STATIC_BATCH& batch = m_staticBatches[i];
+		batch.shaderPermutation = GetShaderPermutation(GetTextureArray(batch.textureSlot));
+	}
+}
+
+/***********************************************************
+ *  UsePermutation()
+ *
+ *  This method is used for putting a permutation in use and
+ *  pointing the uniform setters at its locations.  The pass
+ *  uniforms are passed on, so a pass can switch programs
+ *  between its draws.
+ ***********************************************************/
+void SceneManager::UsePermutation(int permutation)
+{
+	if ((permutation < 0) || (permutation >= PERMUTATION_COUNT) || (m_permutations[permutation].programID == 0))
+	{
+		permutation = g_BasePermutation;
+	}
+
+	if (permutation == g_BasePermutation)
+	{
+		m_pStateCache->UseProgram(m_baseProgramID);
+	}
+	else
+	{
+		m_pStateCache->UseProgram(m_permutations[permutation].programID);
+	}
+
+	if (permutation == m_currentPermutation)
+	{
+		return;
+	}
+
+	m_currentPermutation = permutation;
+	if (permutation == g_BasePermutation)
+	{
+		m_pUniformCache = m_pBaseUniformCache;
+		m_uniforms = m_baseUniforms;
+	}
+	else
+	{
+		m_pUniformCache = m_permutations[permutation].pUniformCache;
+		m_uniforms = m_permutations[permutation].uniforms;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.bDepthOnly, m_bDepthOnlyPass);
+	m_pUniformCache->SetValue(m_uniforms.bWriteGBuffer, m_bGBufferPass);
+}
+
+/***********************************************************
+ *  SetPassUniforms()
+ *
+ *  This method is used for setting the uniforms that select
+ *  the depth only and geometry passes.  Programs put in use
+ *  later in the pass are given the same values.
+ ***********************************************************/
+void SceneManager::SetPassUniforms(bool bDepthOnly, bool bGBuffer)
+{
+	m_bDepthOnlyPass = bDepthOnly;
+	m_bGBufferPass = bGBuffer;
+	m_pUniformCache->SetValue(m_uniforms.bDepthOnly, bDepthOnly);
+	m_pUniformCache->SetValue(m_uniforms.bWriteGBuffer, bGBuffer);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	glm::mat4 modelView;
+	glm::mat4 scale;
+	glm::mat4 rotationX;
+	glm::mat4 rotationY;
+	glm::mat4 rotationZ;
+	glm::mat4 translation;
+
+	// set the scale value in the transform buffer
+	scale = glm::scale(scaleXYZ);
+	// set the rotation values in the transform buffer
+	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+	// set the translation value in the transform buffer
+	translation = glm::translate(positionXYZ);
+
+	modelView = translation * rotationZ * rotationY * rotationX * scale;
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetValue(m_uniforms.model, modelView);
+		m_pUniformCache->SetValue(m_uniforms.normalMatrix, DrawList::BuildNormalMatrix(modelView));
+	}
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for setting the passed in color
+ *  into the shader for the next draw command
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetValue(m_uniforms.bUseTexture, false);
+		m_pUniformCache->SetValue(m_uniforms.objectColor, currentColor);
+	}
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data
+ *  associated with the passed in tag into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	TagRegistry::TAG_HASH textureTag)
+{
+	SetShaderTextureSlot(FindTextureSlot(textureTag));
+}
+
+/***********************************************************
+ *  SetShaderTextureSlot()
+ *
+ *  This method is used for passing the texture array and the
+ *  layer that hold a texture slot into the shader.  Texturing
+ *  is turned off when the slot is -1.
+ ***********************************************************/
+void SceneManager::SetShaderTextureSlot(
+	int textureSlot)
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	if ((textureSlot < 0) || (textureSlot >= m_pTextureArrays->GetTextureCount()))
+	{
+		m_pUniformCache->SetValue(m_uniforms.bUseTexture, false);
+		return;
+	}
+
+	const TextureArrays::TEXTURE_LAYER& textureLayer = m_pTextureArrays->GetTextureLayer(textureSlot);
+
+	m_pUniformCache->SetValue(m_uniforms.bUseTexture, true);
+	m_pUniformCache->SetValue(m_uniforms.objectTexture, textureLayer.arrayIndex);
+	m_pUniformCache->SetValue(m_uniforms.textureLayer, (float)textureLayer.layer);
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values into the shader.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetValue(m_uniforms.UVscale, glm::vec2(u, v));
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the material values
+ *  into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	TagRegistry::TAG_HASH materialTag)
+{
+	if (m_objectMaterials.size() > 0)
+	{
+		// find the defined material that matches the tag
+		SetShaderMaterial(FindMaterialIndex(materialTag));
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting the material at the
+ *  passed in index for the next draw.  The material values
+ *  are already in the material table uniform block, so only
+ *  the index is passed into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	int materialIndex)
+{
+	if ((materialIndex < 0) || (materialIndex >= (int)m_objectMaterials.size()))
+	{
+		return;
+	}
+
+	if (NULL != m_pUniformCache)
+	{
+		m_pUniformCache->SetValue(m_uniforms.materialIndex, materialIndex);
+	}
+}
+
+/***********************************************************
+ *  BuildInstanceBatches()
+ *
+ *  This method is used for grouping the box draw records that
+ *  share the same texture array, material and UV scale into
+ *  batches so each group is drawn with one instanced draw
+ *  call.  The batches are rebuilt when textures are packed,
+ *  since a packed texture moves to a different array.
+ ***********************************************************/
+void SceneManager::BuildInstanceBatches()
+{
+	m_instanceBatches.clear();
+
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+		record.batchIndex = -1;
+
+		if ((m_bInstancing == false) || (record.meshID != DrawList::MESH_BOX) || (record.staticBatchIndex >= 0))
+		{
+			continue;
+		}
+
+		// look for a batch with matching shader state
+		int textureArray = GetTextureArray(record.textureSlot);
+		int batchIndex = -1;
+		int index = 0;
+		while ((index < (int)m_instanceBatches.size()) && (batchIndex < 0))
+		{
+			const INSTANCE_BATCH& batch = m_instanceBatches[index];
+			if ((batch.textureArray == textureArray) &&
+				(batch.materialIndex == record.materialIndex) &&
+				(batch.uvScale == record.uvScale))
+			{
+				batchIndex = index;
+			}
+			else
+				index++;
+		}
+
+		if (batchIndex < 0)
+		{
+			INSTANCE_BATCH batch;
+			batch.textureArray = textureArray;
+			batch.materialIndex = record.materialIndex;
+			batch.uvScale = record.uvScale;
+			batch.shaderPermutation = GetShaderPermutation(textureArray);
+			m_instanceBatches.push_back(batch);
+			batchIndex = (int)m_instanceBatches.size() - 1;
+		}
+
+		m_instanceBatches[batchIndex].recordIndices.push_back(i);
+		record.batchIndex = batchIndex;
+	}
+}
+
+/***********************************************************
+ *  DrawInstanceBatch()
+ *
+ *  This method is used for drawing the records of an instance
+ *  batch with one draw call.  The model matrices and colors
+ *  are read from the vertex attributes instead of the shader
+ *  uniforms.
+ ***********************************************************/
+void SceneManager::DrawInstanceBatch(
+	int batchIndex)
+{
+	if ((NULL == m_pUniformCache) || (batchIndex < 0) || (batchIndex >= (int)m_instanceBatches.size()))
+	{
+		return;
+	}
+
+	const INSTANCE_BATCH& batch = m_instanceBatches[batchIndex];
+
+	// gather the cached transforms and colors of the instances
+	// that passed the frustum test
+	m_instanceData.clear();
+	for (size_t j = 0; j < batch.recordIndices.size(); j++)
+	{
+		if (m_drawList.IsVisible(batch.recordIndices[j]) == false)
+		{
+			continue;
+		}
+
+		const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(batch.recordIndices[j]);
+		InstancedMeshes::INSTANCE_DATA instance;
+		instance.model = record.model;
+		instance.normalMatrix = record.normalMatrix;
+		instance.color = record.color;
+		instance.textureLayer = 0.0f;
+		if (batch.textureArray >= 0)
+		{
+			instance.textureLayer = (float)m_pTextureArrays->GetTextureLayer(record.textureSlot).layer;
+		}
+		m_instanceData.push_back(instance);
+	}
+
+	if (m_instanceData.size() == 0)
+	{
+		return;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.bUseInstancing, true);
+	if (batch.textureArray >= 0)
+	{
+		m_pUniformCache->SetValue(m_uniforms.bUseTexture, true);
+		m_pUniformCache->SetValue(m_uniforms.objectTexture, batch.textureArray);
+	}
+	else
+	{
+		m_pUniformCache->SetValue(m_uniforms.bUseTexture, false);
+	}
+	m_pUniformCache->SetValue(m_uniforms.UVscale, batch.uvScale);
+	SetShaderMaterial(batch.materialIndex);
+
+	m_instancedMeshes->DrawBoxMeshInstanced(
+		m_instanceData.data(),
+		(int)m_instanceData.size());
+	m_pStateCache->CountDrawCalls(1);
+}
+
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for baking the static draw records
+ *  into world space meshes.  The opaque static records that
+ *  share a texture, a material and a color and sit in the
+ *  same cell of a grid are grouped, up to a vertex limit, so
+ *  a batch stays small enough to be culled with the view.
+ *  Baking takes the static boxes ahead of the instance
+ *  batches, and the curved shapes are baked at their finest
+ *  detail level, so they no longer change level or fade.
+ *  The vertices of every record in a group are moved into
+ *  world space in parallel and added to the shared buffer as
+ *  one mesh, so the group is drawn with one draw call.
+ *  Groups of a single record gain nothing and are left to
+ *  the normal path.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	std::vector<STATIC_BATCH> groups;
+	std::vector<glm::ivec3> groupCells;
+	std::vector<size_t> groupVertices;
+	std::vector<ShapeGeometry::MESH_DATA> shapeMeshes;
+
+	m_staticBatches.clear();
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		m_drawList.GetRecord(i).staticBatchIndex = -1;
+	}
+
+	if (m_bStaticBaking == false)
+	{
+		return;
+	}
+
+	// the copied records are added without their model matrix
+	m_drawList.UpdateTransforms(m_pJobSystem);
+	// the local space meshes of every part
+	GenerateShapeMeshes(shapeMeshes);
+
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+
+		// blended records must be sorted by depth every frame
+		bool bTransparent = (record.textureSlot < 0) && (record.color.a < 1.0f);
+		if ((record.bStatic == false) || (bTransparent == true))
+		{
+			continue;
+		}
+
+		int meshes[3];
+		int meshCount = GetRecordMeshes(record, meshes);
+		size_t vertexCount = 0;
+		for (int k = 0; k < meshCount; k++)
+		{
+			vertexCount += shapeMeshes[meshes[k]].vertices.size() / ShapeGeometry::FLOATS_PER_VERTEX;
+		}
+
+		// look for a group with matching shader state in the same
+		// cell that still has room for the record
+		glm::ivec3 cell = glm::ivec3(glm::floor(glm::vec3(record.model[3]) / g_StaticBatchCellSize));
+		int groupIndex = -1;
+		int index = 0;
+		while ((index < (int)groups.size()) && (groupIndex < 0))
+		{
+			const STATIC_BATCH& group = groups[index];
+			if ((groupCells[index] == cell) &&
+				(groupVertices[index] + vertexCount <= g_MaxStaticBatchVertices) &&
+				(group.textureSlot == record.textureSlot) &&
+				(group.materialIndex == record.materialIndex) &&
+				((record.textureSlot >= 0) || (group.color == record.color)))
+			{
+				groupIndex = index;
+			}
+			else
+				index++;
+		}
+
+		if (groupIndex < 0)
+		{
+			STATIC_BATCH group;
+			group.textureSlot = record.textureSlot;
+			group.materialIndex = record.materialIndex;
+			group.color = record.color;
+			group.shaderPermutation = 0;
+			group.mesh = MeshBuffer::MESH_RANGE();
+			groups.push_back(group);
+			groupCells.push_back(cell);
+			groupVertices.push_back(0);
+			groupIndex = (int)groups.size() - 1;
+		}
+
+		groups[groupIndex].recordIndices.push_back(i);
+		groupVertices[groupIndex] += vertexCount;
+	}
+
+	// lay out where each part of the baked groups is written,
+	// so the parts can be moved into world space in parallel
+	std::vector<STATIC_BATCH_PART> parts;
+	std::vector<ShapeGeometry::MESH_DATA> batchMeshes;
+	int bakedCount = 0;
+	int replacedDraws = 0;
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		STATIC_BATCH& group = groups[i];
+
+		if (group.recordIndices.size() < g_MinStaticBatchRecords)
+		{
+			continue;
+		}
+
+		const int batchIndex = (int)m_staticBatches.size();
+		size_t vertexFloats = 0;
+		size_t indexCount = 0;
+		for (size_t j = 0; j < group.recordIndices.size(); j++)
+		{
+			DrawList::DRAW_RECORD& record = m_drawList.GetRecord(group.recordIndices[j]);
+			int meshes[3];
+			int meshCount = GetRecordMeshes(record, meshes);
+			for (int k = 0; k < meshCount; k++)
+			{
+				STATIC_BATCH_PART part;
+				part.batchIndex = batchIndex;
+				part.recordIndex = group.recordIndices[j];
+				part.shapeMesh = meshes[k];
+				part.firstFloat = vertexFloats;
+				part.firstIndex = indexCount;
+				parts.push_back(part);
+
+				vertexFloats += shapeMeshes[meshes[k]].vertices.size();
+				indexCount += shapeMeshes[meshes[k]].indices.size();
+			}
+			// each part of a record is a draw call of its own
+			replacedDraws += meshCount;
+			record.staticBatchIndex = batchIndex;
+		}
+
+		batchMeshes.push_back(ShapeGeometry::MESH_DATA());
+		batchMeshes.back().vertices.resize(vertexFloats);
+		batchMeshes.back().indices.resize(indexCount);
+		bakedCount += (int)group.recordIndices.size();
+		m_staticBatches.push_back(group);
+	}
+
+	JobSystem::RANGE_FUNCTION bakeParts = [this, &parts, &shapeMeshes, &batchMeshes](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			const STATIC_BATCH_PART& part = parts[i];
+			const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(part.recordIndex);
+			ShapeGeometry::MESH_DATA& meshData = batchMeshes[part.batchIndex];
+
+			ShapeGeometry::WriteTransformedMesh(
+				shapeMeshes[part.shapeMesh],
+				record.model,
+				record.uvScale,
+				meshData.vertices.data() + part.firstFloat,
+				meshData.indices.data() + part.firstIndex,
+				(uint32_t)(part.firstFloat / ShapeGeometry::FLOATS_PER_VERTEX));
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor((int)parts.size(), g_StaticBakeGrainSize, bakeParts);
+	}
+	else
+	{
+		bakeParts(0, (int)parts.size());
+	}
+
+	// the shared buffer is only added to on this thread
+	for (size_t i = 0; i < m_staticBatches.size(); i++)
+	{
+		m_staticBatches[i].mesh = m_pMeshBuffer->AddMesh(batchMeshes[i]);
+	}
+
+	std::cout << "INFO: Baked " << bakedCount << " static records into "
+		<< m_staticBatches.size() << " static batches, which replace "
+		<< replacedDraws << " draw calls with " << m_staticBatches.size() << std::endl;
+}
+
+/***********************************************************
+ *  GenerateShapeMeshes()
+ *
+ *  This method is used for generating the local space mesh
+ *  of each GPU scene mesh, with the curved shapes at their
+ *  finest detail level.
+ ***********************************************************/
+void SceneManager::GenerateShapeMeshes(
+	std::vector<ShapeGeometry::MESH_DATA>& shapeMeshes)
+{
+	shapeMeshes.clear();
+	shapeMeshes.resize(GPU_MESH_COUNT);
+
+	ShapeGeometry::GeneratePlaneMesh(shapeMeshes[GPU_MESH_PLANE]);
+	ShapeGeometry::GenerateBoxMesh(shapeMeshes[GPU_MESH_BOX]);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_CONE_SIDES], LODMeshes::SHAPE_CONE, 0, LODMeshes::PART_SIDES);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_CONE_BOTTOM], LODMeshes::SHAPE_CONE, 0, LODMeshes::PART_BOTTOM);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_CYLINDER_SIDES], LODMeshes::SHAPE_CYLINDER, 0, LODMeshes::PART_SIDES);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_CYLINDER_TOP], LODMeshes::SHAPE_CYLINDER, 0, LODMeshes::PART_TOP);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_CYLINDER_BOTTOM], LODMeshes::SHAPE_CYLINDER, 0, LODMeshes::PART_BOTTOM);
+	LODMeshes::AppendPart(shapeMeshes[GPU_MESH_SPHERE], LODMeshes::SHAPE_SPHERE, 0, LODMeshes::PART_SIDES);
+}
+
+/***********************************************************
+ *  DrawStaticBatch()
+ *
+ *  This method is used for drawing the baked mesh of a static
+ *  batch.  The vertices are already in world space and their
+ *  texture coordinates already scaled, so the model matrix
+ *  is the identity and the UV scale is 1.
+ ***********************************************************/
+void SceneManager::DrawStaticBatch(
+	int batchIndex)
+{
+	if ((NULL == m_pUniformCache) || (batchIndex < 0) || (batchIndex >= (int)m_staticBatches.size()))
+	{
+		return;
+	}
+
+	const STATIC_BATCH& batch = m_staticBatches[batchIndex];
+
+	// the baked normals are already in world space
+	m_pUniformCache->SetValue(m_uniforms.model, glm::mat4(1.0f));
+	m_pUniformCache->SetValue(m_uniforms.normalMatrix, glm::mat3(1.0f));
+	SetShaderTextureSlot(batch.textureSlot);
+	m_pUniformCache->SetValue(m_uniforms.objectColor, batch.color);
+	m_pUniformCache->SetValue(m_uniforms.UVscale, glm::vec2(1.0f, 1.0f));
+	SetShaderMaterial(batch.materialIndex);
+
+	MeshBuffer::DrawRange(batch.mesh);
+	m_pStateCache->CountDrawCalls(1);
+}
+
+/***********************************************************
+ *  GetRecordMeshes()
+ *
+ *  This method is used for getting the mesh parts that draw
+ *  a record, such as the sides and the bottom of a cone.
+ *  The number of parts is returned.
+ ***********************************************************/
+int SceneManager::GetRecordMeshes(
+	const DrawList::DRAW_RECORD& record,
+	int meshes[3])
+{
+	int meshCount = 0;
+
+	switch (record.meshID)
+	{
+	case DrawList::MESH_PLANE:
+		meshes[meshCount++] = GPU_MESH_PLANE;
+		break;
+	case DrawList::MESH_BOX:
+		meshes[meshCount++] = GPU_MESH_BOX;
+		break;
+	case DrawList::MESH_CONE:
+		meshes[meshCount++] = GPU_MESH_CONE_SIDES;
+		if ((record.meshParts & DrawList::PART_BOTTOM) != 0)
+		{
+			meshes[meshCount++] = GPU_MESH_CONE_BOTTOM;
+		}
+		break;
+	case DrawList::MESH_CYLINDER:
+		if ((record.meshParts & DrawList::PART_SIDES) != 0)
+		{
+			meshes[meshCount++] = GPU_MESH_CYLINDER_SIDES;
+		}
+		if ((record.meshParts & DrawList::PART_TOP) != 0)
+		{
+			meshes[meshCount++] = GPU_MESH_CYLINDER_TOP;
+		}
+		if ((record.meshParts & DrawList::PART_BOTTOM) != 0)
+		{
+			meshes[meshCount++] = GPU_MESH_CYLINDER_BOTTOM;
+		}
+		break;
+	default:
+		meshes[meshCount++] = GPU_MESH_SPHERE;
+		break;
+	}
+
+	return(meshCount);
+}
+
+/***********************************************************
+ *  CullSceneRecords()
+ *
+ *  This method is used for testing the records against the
+ *  frustum of this frame's view.  The GPU driven path culls
+ *  its own records, and the few records left in the queue
+ *  are drawn without a test.
+ ***********************************************************/
+void SceneManager::CullSceneRecords()
+{
+	glm::mat4 viewProjection = m_projectionMatrix * m_viewMatrix;
+
+	if (m_bGPUDriven == true)
+	{
+		return;
+	}
+
+	if (m_bCulling == false)
+	{
+		m_drawList.SetAllVisible();
+	}
+	else if (m_drawList.GetRecordCount() < g_MinIndexedCullRecords)
+	{
+		m_drawList.CullRecords(viewProjection, m_pJobSystem);
+	}
+	else
+	{
+		glm::vec4 planes[6];
+		DrawList::ExtractFrustumPlanes(viewProjection, planes);
+		m_sceneBVH.QueryFrustum(planes, m_visibleRecords);
+		m_drawList.SetVisibleRecords(m_visibleRecords);
+	}
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for queueing the draw records and the
+ *  instance batches under sort keys built from their shader
+ *  state and their depth from the camera.  Records outside
+ *  of the view frustum are left out of the queue.  The keys
+ *  and the detail levels of the records are built in parallel
+ *  ranges, then queued in record order.  The same ranges
+ *  measure how large the textures of the visible records are
+ *  on the screen for the texture streamer.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	// the view depth is the negated view space z value
+	glm::vec3 viewDepthRow = glm::vec3(-m_viewMatrix[0][2], -m_viewMatrix[1][2], -m_viewMatrix[2][2]);
+	float viewDepthOffset = -m_viewMatrix[3][2];
+	const int recordCount = m_drawList.GetRecordCount();
+
+	m_renderQueue.Clear();
+	m_recordKeys.resize(recordCount);
+	m_recordQueued.resize(recordCount);
+	m_recordLODs.resize(recordCount);
+	m_recordCoverage.resize(recordCount);
+
+	JobSystem::RANGE_FUNCTION buildKeys = [this, viewDepthRow, viewDepthOffset](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+			m_recordQueued[i] = 0;
+			m_recordCoverage[i] = 0.0f;
+
+			// the GPU driven path culls on the GPU, so all of its
+			// textured records count as seen
+			if ((record.textureSlot >= 0) && ((m_bGPUDriven == true) || (m_drawList.IsVisible(i) == true)))
+			{
+				// the texture repeats across the record uvScale times
+				float repeats = glm::max(glm::max(record.uvScale.x, record.uvScale.y), 1.0f);
+				m_recordCoverage[i] = (GetScreenRadius(record) * m_viewportHeight) / repeats;
+			}
+
+			if (m_bGPUDriven == true)
+			{
+				// records in the GPU scene are drawn from its buffers
+				if (m_gpuObjects[i] >= 0)
+				{
+					continue;
+				}
+			}
+			// records in an instance or static batch are drawn with
+			// the batch
+			else if ((record.batchIndex >= 0) || (record.staticBatchIndex >= 0) || (m_drawList.IsVisible(i) == false))
+			{
+				continue;
+			}
+
+			// solid colors with alpha need blending over the opaque items
+			bool bTransparent = (record.textureSlot < 0) && (record.color.a < 1.0f);
+			float viewDepth = glm::dot(viewDepthRow, glm::vec3(record.model[3])) + viewDepthOffset;
+			m_recordKeys[i] = m_renderQueue.MakeKey(
+				bTransparent,
+				((unsigned int)record.shaderPermutation << 1) | g_StandardShaderID,
+				GetTextureArray(record.textureSlot),
+				record.materialIndex,
+				((unsigned int)record.meshID << 3) | record.meshParts,
+				viewDepth);
+			m_recordQueued[i] = 1;
+
+			if (record.meshID >= DrawList::MESH_CONE)
+			{
+				m_recordLODs[i] = SelectRecordLOD(record);
+			}
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(recordCount, g_RecordGrainSize, buildKeys);
+	}
+	else
+	{
+		buildKeys(0, recordCount);
+	}
+
+	for (int i = 0; i < recordCount; i++)
+	{
+		if (m_recordQueued[i] != 0)
+		{
+			m_renderQueue.AddItem(m_recordKeys[i], (uint32_t)i, RenderQueue::ITEM_RECORD);
+		}
+		if (m_recordCoverage[i] > 0.0f)
+		{
+			m_pTextureStreamer->AddCoverage(m_drawList.GetRecord(i).textureSlot, m_recordCoverage[i]);
+		}
+	}
+
+	for (int i = 0; (m_bGPUDriven == false) && (i < (int)m_instanceBatches.size()); i++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[i];
+		float nearestDepth = g_MaxSortDepth;
+		bool bAnyVisible = false;
+
+		// a batch is ordered by its nearest visible instance
+		for (size_t j = 0; j < batch.recordIndices.size(); j++)
+		{
+			if (m_drawList.IsVisible(batch.recordIndices[j]) == false)
+			{
+				continue;
+			}
+
+			bAnyVisible = true;
+			const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(batch.recordIndices[j]);
+			float viewDepth = glm::dot(viewDepthRow, glm::vec3(record.model[3])) + viewDepthOffset;
+			if (viewDepth < nearestDepth)
+			{
+				nearestDepth = viewDepth;
+			}
+		}
+
+		// the whole batch is outside of the view
+		if (bAnyVisible == false)
+		{
+			continue;
+		}
+
+		uint64_t key = m_renderQueue.MakeKey(
+			false,
+			((unsigned int)batch.shaderPermutation << 1) | g_InstancedShaderID,
+			batch.textureArray,
+			batch.materialIndex,
+			((unsigned int)DrawList::MESH_BOX << 3) | DrawList::PART_ALL,
+			nearestDepth);
+
+		m_renderQueue.AddItem(key, (uint32_t)i, RenderQueue::ITEM_INSTANCE_BATCH);
+	}
+
+	for (int i = 0; (m_bGPUDriven == false) && (i < (int)m_staticBatches.size()); i++)
+	{
+		const STATIC_BATCH& batch = m_staticBatches[i];
+		float nearestDepth = g_MaxSortDepth;
+		bool bAnyVisible = false;
+
+		// a static batch is drawn whole when any of its records is
+		// in the view, and is ordered by the nearest of them
+		for (size_t j = 0; j < batch.recordIndices.size(); j++)
+		{
+			if (m_drawList.IsVisible(batch.recordIndices[j]) == false)
+			{
+				continue;
+			}
+
+			bAnyVisible = true;
+			const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(batch.recordIndices[j]);
+			float viewDepth = glm::dot(viewDepthRow, glm::vec3(record.model[3])) + viewDepthOffset;
+			if (viewDepth < nearestDepth)
+			{
+				nearestDepth = viewDepth;
+			}
+		}
+
+		if (bAnyVisible == false)
+		{
+			continue;
+		}
+
+		uint64_t key = m_renderQueue.MakeKey(
+			false,
+			((unsigned int)batch.shaderPermutation << 1) | g_StandardShaderID,
+			GetTextureArray(batch.textureSlot),
+			batch.materialIndex,
+			g_StaticBatchMeshKey,
+			nearestDepth);
+
+		m_renderQueue.AddItem(key, (uint32_t)i, RenderQueue::ITEM_STATIC_BATCH);
+	}
+
+	m_renderQueue.Sort();
+}
+
+/***********************************************************
+ *  SubmitRenderQueue()
+ *
+ *  This method is used for drawing the queued items in their
+ *  sorted order.  The opaque items are shaded by the current
+ *  render mode, and the transparent items are always blended
+ *  over them afterwards.
+ ***********************************************************/
+void SceneManager::SubmitRenderQueue()
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	// every queued item draws from the shared mesh buffer
+	m_pMeshBuffer->Bind();
+
+	// the GPU driven records are culled once and drawn by
+	// every pass of the opaque items
+	if (m_bGPUDriven == true)
+	{
+		Profiler::ScopedSection section(m_pProfiler, "Cull");
+		CullGPUScene();
+	}
+
+	// the deferred mode falls back to forward shading when its
+	// targets cannot be created
+	if ((m_renderMode == RENDER_DEFERRED) && (m_pGBuffer->BeginGeometryPass() == false))
+	{
+		m_renderMode = RENDER_FORWARD;
+	}
+
+	switch (m_renderMode)
+	{
+	case RENDER_DEPTH_PREPASS:
+		{
+			// the first pass only lays down the depth, so the second
+			// pass shades just the nearest fragment of each pixel
+			Profiler::ScopedSection section(m_pProfiler, "Depth pre-pass");
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			SetPassUniforms(true, false);
+			DrawOpaqueItems();
+			SetPassUniforms(false, false);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		}
+		{
+			Profiler::ScopedSection section(m_pProfiler, "Opaque");
+			glDepthFunc(GL_EQUAL);
+			glDepthMask(GL_FALSE);
+			DrawOpaqueItems();
+			glDepthMask(GL_TRUE);
+			glDepthFunc(GL_LESS);
+		}
+		break;
+	case RENDER_DEFERRED:
+		{
+			// the geometry targets are written without blending
+			Profiler::ScopedSection section(m_pProfiler, "Geometry");
+			m_pStateCache->Disable(GL_BLEND);
+			SetPassUniforms(false, true);
+			DrawOpaqueItems();
+			SetPassUniforms(false, false);
+			m_pStateCache->Enable(GL_BLEND);
+		}
+		{
+			Profiler::ScopedSection section(m_pProfiler, "Lighting");
+			m_pGBuffer->BeginLightingPass();
+			DrawDeferredLighting();
+			// the transparent items are tested against the depth of
+			// the geometry pass
+			m_pGBuffer->BeginForwardPass();
+		}
+		break;
+	default:
+		{
+			Profiler::ScopedSection section(m_pProfiler, "Opaque");
+			DrawOpaqueItems();
+		}
+		break;
+	}
+
+	{
+		Profiler::ScopedSection section(m_pProfiler, "Transparent");
+		DrawQueueItems(m_renderQueue.GetOpaqueCount(), m_renderQueue.GetItemCount());
+	}
+
+	// the lit color of the deferred mode goes to the window
+	if (m_renderMode == RENDER_DEFERRED)
+	{
+		m_pGBuffer->EndLightingPass();
+	}
+
+	// leave the base program set for drawing single objects
+	UsePermutation(g_BasePermutation);
+	m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawQueueItems()
+ *
+ *  This method is used for drawing the queued items from the
+ *  first item up to, but not including, the last item.
+ ***********************************************************/
+void SceneManager::DrawQueueItems(int firstItem, int lastItem)
+{
+	for (int i = firstItem; i < lastItem; i++)
+	{
+		const RenderQueue::QUEUE_ITEM& item = m_renderQueue.GetItem(i);
+
+		if (item.type == RenderQueue::ITEM_INSTANCE_BATCH)
+		{
+			UsePermutation(m_instanceBatches[item.index].shaderPermutation);
+			DrawInstanceBatch((int)item.index);
+		}
+		else if (item.type == RenderQueue::ITEM_STATIC_BATCH)
+		{
+			UsePermutation(m_staticBatches[item.index].shaderPermutation);
+			m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+			DrawStaticBatch((int)item.index);
+		}
+		else
+		{
+			const DrawList::DRAW_RECORD& record = m_drawList.GetRecord((int)item.index);
+			UsePermutation(record.shaderPermutation);
+			m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+			DrawSceneObject(record, m_recordLODs[item.index]);
+		}
+	}
+}
+
+/***********************************************************
+ *  DrawOpaqueItems()
+ *
+ *  This method is used for drawing the opaque GPU scene
+ *  draws and the opaque queued items.
+ ***********************************************************/
+void SceneManager::DrawOpaqueItems()
+{
+	if (m_bGPUDriven == true)
+	{
+		DrawGPUScene();
+	}
+
+	DrawQueueItems(0, m_renderQueue.GetOpaqueCount());
+}
+
+/***********************************************************
+ *  DrawDeferredLighting()
+ *
+ *  This method is used for shading the geometry targets with
+ *  one fullscreen triangle.  The lighting target has no depth
+ *  attached, so the triangle covers every pixel.
+ ***********************************************************/
+void SceneManager::DrawDeferredLighting()
+{
+	// only the base program reads the geometry targets
+	UsePermutation(g_BasePermutation);
+	m_pUniformCache->SetValue(m_uniforms.gBufferAlbedo, (int)GBuffer::ALBEDO_TEXTURE_UNIT);
+	m_pUniformCache->SetValue(m_uniforms.gBufferNormal, (int)GBuffer::NORMAL_TEXTURE_UNIT);
+	m_pUniformCache->SetValue(m_uniforms.gBufferMaterial, (int)GBuffer::MATERIAL_TEXTURE_UNIT);
+	m_pUniformCache->SetValue(m_uniforms.gBufferDepth, (int)GBuffer::DEPTH_TEXTURE_UNIT);
+	m_pUniformCache->SetValue(m_uniforms.inverseViewProjection, glm::inverse(m_projectionMatrix * m_viewMatrix));
+	m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+	m_pUniformCache->SetValue(m_uniforms.bDeferredLighting, true);
+
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	m_pStateCache->CountDrawCalls(1);
+
+	m_pUniformCache->SetValue(m_uniforms.bDeferredLighting, false);
+}
+
+/***********************************************************
+ *  DrawSceneObject()
+ *
+ *  This method is used for passing the cached values of a
+ *  draw record into the shader and drawing its mesh.  The
+ *  curved shapes are drawn at the passed in detail level.
+ ***********************************************************/
+void SceneManager::DrawSceneObject(
+	const DrawList::DRAW_RECORD& record,
+	const LODMeshes::LOD_SELECTION& lodSelection)
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.model, record.model);
+	m_pUniformCache->SetValue(m_uniforms.normalMatrix, record.normalMatrix);
+
+	SetShaderTextureSlot(record.textureSlot);
+	if (record.textureSlot < 0)
+	{
+		m_pUniformCache->SetValue(m_uniforms.objectColor, record.color);
+	}
+	m_pUniformCache->SetValue(m_uniforms.UVscale, record.uvScale);
+
+	SetShaderMaterial(record.materialIndex);
+
+	switch (record.meshID)
+	{
+	case DrawList::MESH_PLANE:
+		MeshBuffer::DrawRange(m_planeMesh);
+		m_pStateCache->CountDrawCalls(1);
+		break;
+	case DrawList::MESH_BOX:
+		MeshBuffer::DrawRange(m_boxMesh);
+		m_pStateCache->CountDrawCalls(1);
+		break;
+	case DrawList::MESH_CONE:
+	case DrawList::MESH_CYLINDER:
+	case DrawList::MESH_SPHERE:
+		DrawLODObject(record, lodSelection);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  SelectRecordLOD()
+ *
+ *  This method is used for picking the detail level of a
+ *  curved shape record from its size on the screen.
+ ***********************************************************/
+LODMeshes::LOD_SELECTION SceneManager::SelectRecordLOD(
+	const DrawList::DRAW_RECORD& record) const
+{
+	return(LODMeshes::SelectLevel(GetScreenRadius(record)));
+}
+
+/***********************************************************
+ *  GetScreenRadius()
+ *
+ *  This method is used for projecting the bounding sphere of
+ *  the world bounds of a record by the clip space w - which
+ *  is 1 for the orthographic projection.
+ ***********************************************************/
+float SceneManager::GetScreenRadius(const DrawList::DRAW_RECORD& record) const
+{
+	glm::vec3 center = (record.boundsMinimum + record.boundsMaximum) * 0.5f;
+	float radius = glm::length(record.boundsMaximum - record.boundsMinimum) * 0.5f;
+	glm::vec4 clipCenter = m_projectionMatrix * (m_viewMatrix * glm::vec4(center, 1.0f));
+
+	return((radius * m_projectionMatrix[1][1]) / glm::max(clipCenter.w, 0.0001f));
+}
+
+/***********************************************************
+ *  DrawLODObject()
+ *
+ *  This method is used for drawing a curved shape at the
+ *  passed in detail level.  While a record is fading between
+ *  two levels, both levels are drawn over opposite dithered
+ *  pixels.
+ ***********************************************************/
+void SceneManager::DrawLODObject(
+	const DrawList::DRAW_RECORD& record,
+	const LODMeshes::LOD_SELECTION& selection)
+{
+	if (selection.blend <= 0.0f)
+	{
+		DrawLODLevel(record, selection.level);
+		return;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.lodFade, 1.0f - selection.blend);
+	DrawLODLevel(record, selection.level);
+	m_pUniformCache->SetValue(m_uniforms.lodFade, -(1.0f - selection.blend));
+	DrawLODLevel(record, selection.level + 1);
+	m_pUniformCache->SetValue(m_uniforms.lodFade, 0.0f);
+}
+
+/***********************************************************
+ *  DrawLODLevel()
+ *
+ *  This method is used for drawing the mesh of a curved
+ *  shape record at the passed in detail level.
+ ***********************************************************/
+void SceneManager::DrawLODLevel(
+	const DrawList::DRAW_RECORD& record,
+	int level)
+{
+	switch (record.meshID)
+	{
+	case DrawList::MESH_CONE:
+		m_lodMeshes->DrawConeMesh(
+			level,
+			(record.meshParts & DrawList::PART_BOTTOM) != 0);
+		break;
+	case DrawList::MESH_CYLINDER:
+		m_lodMeshes->DrawCylinderMesh(
+			level,
+			(record.meshParts & DrawList::PART_TOP) != 0,
+			(record.meshParts & DrawList::PART_BOTTOM) != 0,
+			(record.meshParts & DrawList::PART_SIDES) != 0);
+		break;
+	case DrawList::MESH_SPHERE:
+		m_lodMeshes->DrawSphereMesh(level);
+		break;
+	default:
+		return;
+	}
+
+	m_pStateCache->CountDrawCalls(1);
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+void SceneManager::LoadSceneTextures()
+{
+	/*** STUDENTS - add the code BELOW for loading the textures that ***/
+	/*** will be used for mapping to objects in the 3D scene. The    ***/
+	/*** textures are packed into texture arrays, so there is no     ***/
+	/*** fixed limit. Refer to the code in the OpenGL Sample for help.***/
+	bool bReturn = false;
+
+	bReturn = CreateGLTexture(
+		"textures/drywall.jpg",
+		"drywall");
+
+	bReturn = CreateGLTexture(
+		"textures/backdrop.jpg",
+		"backdrop");
+
+	bReturn = CreateGLTexture(
+		"textures/abstract.jpg",
+		"abstract");
+
+	bReturn = CreateGLTexture(
+		"textures/stainedglass.jpg",
+		"stainedglass");
+
+	bReturn = CreateGLTexture(
+		"textures/pyramid.jpg",
+		"pyramid");
+
+	bReturn = CreateGLTexture(
+		"textures/pyramid2.jpg",
+		"pyramid2");
+
+	bReturn = CreateGLTexture(
+		"textures/sand.jpg",
+		"sand");
+
+
+
+	// after the texture image data is loaded into memory, the
+	// texture arrays need to be bound to texture slots - each
+	// array holds many textures of the same size
+	BindGLTextures();
+}
+
+void SceneManager::DefineObjectMaterials()
+{
+	/*setting steel material to use as material for different shapes*/
+	OBJECT_MATERIAL steelMaterial;
+
+	steelMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	steelMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	steelMaterial.shininess = 64.0;
+	steelMaterial.tag = "steel";
+
+	AddObjectMaterial(steelMaterial);
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is called to add and configure the light
+ *  sources for the 3D scene.  The light values are kept in
+ *  the light uniform block - there are up to TOTAL_LIGHTS
+ *  light sources.  Any number of point lights can be added
+ *  to the clustered lights on top of them.
+ ***********************************************************/
+void SceneManager::SetupSceneLights()
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.bUseLighting, true);
+	m_bUseLighting = true;
+
+	if (NULL == m_pUniformBlocks)
+	{
+		return;
+	}
+
+	m_pUniformBlocks->SetGlobalAmbientColor(glm::vec3(0.05f, 0.04f, 0.07f));
+
+	UniformBlocks::LIGHT_DATA light;
+	light.padding = 0.0f;
+
+	/*light source 1*/
+
+	light.position = glm::vec3(-5.0f, 5.0f, 10.0f);
+
+	light.diffuseColor = glm::vec3(0.7f, 0.1f, 0.05f);
+
+	light.specularColor = glm::vec3(.5f, 0.01f, 0.005f);
+
+	light.focalStrength = 16.0f;
+
+	light.specularIntensity = 0.15f;
+
+	m_pUniformBlocks->SetLight(0, light);
+
+
+	/*light source 2*/
+
+	light.position = glm::vec3(5.0f, 15.0f, 6.0f);
+
+	light.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
+
+	light.specularColor = glm::vec3(0.25f, 0.25f, 0.25f);
+
+	light.focalStrength = 8.0f;
+
+	light.specularIntensity = 0.1f;
+
+	m_pUniformBlocks->SetLight(1, light);
+
+
+	/*point lights - binned into view clusters each frame, so
+	  each fragment only shades the lights that reach it*/
+
+	ClusteredLights::POINT_LIGHT pointLight;
+
+	pointLight.radius = 3.0f;
+
+	pointLight.color = glm::vec3(1.0f, 0.6f, 0.25f);
+
+	pointLight.intensity = 0.8f;
+
+	const glm::vec3 torchPositions[] =
+	{
+		glm::vec3(8.5f, 0.5f, 3.0f),
+		glm::vec3(4.5f, 0.5f, 3.5f),
+		glm::vec3(1.0f, 0.5f, 6.5f),
+		glm::vec3(-1.2f, 1.0f, 5.0f)
+	};
+
+	m_pClusteredLights->ClearPointLights();
+	for (int i = 0; i < (int)(sizeof(torchPositions) / sizeof(torchPositions[0])); i++)
+	{
+		pointLight.position = torchPositions[i];
+		m_pClusteredLights->AddPointLight(pointLight);
+	}
+
+}
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// get the cached shader uniform handles before
+	// any values are passed into the shader
+	ResolveShaderUniforms(m_pBaseUniformCache, m_baseUniforms);
+	m_uniforms = m_baseUniforms;
+
+	// a scene file replaces the built in scene, which is kept
+	// when the file cannot be mapped
+	SceneFile sceneFile;
+	bool bSceneFile = (m_sceneFilePath.empty() == false) && (sceneFile.Open(m_sceneFilePath.c_str()) == true);
+
+	{
+		Profiler::ScopedSection section(m_pProfiler, "Load textures");
+		if (bSceneFile == true)
+		{
+			LoadFileTextures(sceneFile);
+		}
+		else
+		{
+			LoadSceneTextures();
+		}
+	}
+
+	// add and define the materials and light sources for the scene
+	m_pClusteredLights->CreateBuffers();
+	if (bSceneFile == true)
+	{
+		DefineFileMaterials(sceneFile);
+		SetupFileLights(sceneFile);
+	}
+	else
+	{
+		DefineObjectMaterials();
+		SetupSceneLights();
+	}
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	// every mesh is packed into one shared buffer, so drawing a
+	// different shape never rebinds a vertex array object
+	ShapeGeometry::MESH_DATA meshData;
+	ShapeGeometry::GeneratePlaneMesh(meshData);
+	m_planeMesh = m_pMeshBuffer->AddMesh(meshData);
+	ShapeGeometry::GenerateBoxMesh(meshData);
+	m_boxMesh = m_pMeshBuffer->AddMesh(meshData);
+	// the curved shapes are drawn at a level of detail
+	m_lodMeshes->LoadMeshes(m_pMeshBuffer);
+
+	// build the retained draw records once - every frame
+	// just walks the records in RenderScene()
+	if (bSceneFile == true)
+	{
+		BuildFileDrawList(sceneFile);
+	}
+	else
+	{
+		BuildSceneDrawList();
+	}
+	sceneFile.Close();
+	// the static records are baked into the shared buffer, so
+	// the buffer is uploaded after them
+	BuildStaticBatches();
+	m_pMeshBuffer->Upload();
+	m_instancedMeshes->LoadBoxMesh(m_pMeshBuffer, m_boxMesh);
+	// repeated boxes are drawn with hardware instancing
+	BuildInstanceBatches();
+
+	// the lights are set, so the specialized programs can be
+	// built with the number of lights the scene uses
+	BuildShaderPermutations();
+	AssignShaderPermutations();
+}
+
+/***********************************************************
+ *  BuildSceneDrawList()
+ *
+ *  This method is used for building the retained draw records
+ *  for the basic 3D shapes that make up the scene.  It runs
+ *  once from PrepareScene() after the textures and materials
+ *  have been defined.
+ ***********************************************************/
+void SceneManager::BuildSceneDrawList()
+{
+	DrawList::DRAW_RECORD record;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+
+	// the steel material stays set in the shader for every
+	// object once it has been passed in
+	int steelMaterial = FindMaterialIndex(g_SteelTag);
+
+	m_drawList.Clear();
+
+	// Set scale and position for the ground mesh
+	record = DrawList::MakeRecord(
+		DrawList::MESH_PLANE, DrawList::PART_ALL,
+		glm::vec3(20.0f, 1.0f, 10.0f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(0.0f, 0.0f, 0.0f));
+	record.textureSlot = FindTextureSlot(g_SandTag);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// Draw descending cubes with varying heights and colors
+	int numCubes = 9;
+	float maxHeight = 3.0f;
+	float cubeHeight = maxHeight / numCubes;
+	float cubeSize = 0.5f;
+
+	for (int i = 0; i < numCubes; ++i)
+	{
+		float scaleFactor = static_cast<float>(numCubes - i) / numCubes;
+		float yPos = cubeHeight * i;
+		float r = 0.8f + (0.2f * scaleFactor);
+		float g = 0.6f + (0.4f * scaleFactor);
+		float b = 0.4f + (0.6f * scaleFactor);
+
+		record = DrawList::MakeRecord(
+			DrawList::MESH_BOX, DrawList::PART_ALL,
+			glm::vec3(scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize),
+			XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+			glm::vec3(3.0f, yPos, 3.8f));
+		record.color = glm::vec4(r, g, b, 1.0f);
+		record.textureSlot = FindTextureSlot(g_Pyramid2Tag);
+		record.materialIndex = steelMaterial;
+		m_drawList.AddRecord(record);
+	}
+
+	// Draw ascending cubes with decreasing sizes
+	int numCubess = 5;
+	for (int i = 0; i < numCubess; ++i)
+	{
+		float scaleFactor = static_cast<float>(numCubess - i) / numCubess;
+		float yPos = cubeHeight * i;
+		float r = 0.8f + (0.2f * scaleFactor);
+		float g = 0.6f + (0.4f * scaleFactor);
+		float b = 0.4f + (0.6f * scaleFactor);
+
+		record = DrawList::MakeRecord(
+			DrawList::MESH_BOX, DrawList::PART_ALL,
+			glm::vec3(scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize, scaleFactor * 3.0f * cubeSize),
+			XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+			glm::vec3(2.0f, yPos, 5.6f));
+		record.color = glm::vec4(r, g, b, 1.0f);
+		record.textureSlot = FindTextureSlot(g_Pyramid2Tag);
+		record.materialIndex = steelMaterial;
+		m_drawList.AddRecord(record);
+	}
+
+	// Draw large pyramid #2
+	record = DrawList::MakeRecord(
+		DrawList::MESH_CONE, DrawList::PART_ALL,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(10.0f, 0.0f, 1.0f));
+	record.textureSlot = FindTextureSlot(g_PyramidTag);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// Draw medium pyramid #3
+	record = DrawList::MakeRecord(
+		DrawList::MESH_CONE, DrawList::PART_ALL,
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(6.0f, 0.0f, 2.0f));
+	record.textureSlot = FindTextureSlot(g_PyramidTag);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// Draw small pyramid #3
+	record = DrawList::MakeRecord(
+		DrawList::MESH_CONE, DrawList::PART_ALL,
+		glm::vec3(0.5f, 0.5f, 0.5f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(6.0f, 1.6f, 2.0f));
+	record.textureSlot = FindTextureSlot(g_Pyramid2Tag);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// Draw complex texture shape with bottom and sides using
+	// different textures than the top
+	record = DrawList::MakeRecord(
+		DrawList::MESH_CYLINDER, DrawList::PART_BOTTOM | DrawList::PART_SIDES,
+		glm::vec3(0.3f, 0.3f, 0.3f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(-1.2f, 0.0f, 4.0f));
+	record.textureSlot = FindTextureSlot(g_Pyramid2Tag);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// Draw the top of the cylinder with sand texture
+	record.meshParts = DrawList::PART_TOP;
+	record.textureSlot = FindTextureSlot(g_SandTag);
+	m_drawList.AddRecord(record);
+
+	// Draw a small cone on top of the complex shape
+	record = DrawList::MakeRecord(
+		DrawList::MESH_CONE, DrawList::PART_ALL,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		XrotationDegrees, YrotationDegrees, ZrotationDegrees,
+		glm::vec3(0.3f, 0.0f, 3.0f));
+	record.color = glm::vec4(0.82f, 0.71f, 0.55f, 1.0f);
+	record.materialIndex = steelMaterial;
+	m_drawList.AddRecord(record);
+
+	// nothing in the scene moves once it is placed, so every
+	// record can be baked
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		m_drawList.GetRecord(i).bStatic = true;
+	}
+
+	ReplicateSceneDrawList();
+}
+
+/***********************************************************
+ *  LoadFileTextures()
+ *
+ *  This method is used for loading the textures of a scene
+ *  file under their tags, the same way as the built in scene
+ *  loads its textures.
+ ***********************************************************/
+void SceneManager::LoadFileTextures(const SceneFile& sceneFile)
+{
+	int textureCount = 0;
+	const SceneFile::SCENE_TEXTURE* pTextures = sceneFile.GetTextures(textureCount);
+
+	for (int i = 0; i < textureCount; i++)
+	{
+		CreateGLTexture(pTextures[i].path, pTextures[i].tag);
+	}
+
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  DefineFileMaterials()
+ *
+ *  This method is used for defining the materials of a scene
+ *  file under their tags.
+ ***********************************************************/
+void SceneManager::DefineFileMaterials(const SceneFile& sceneFile)
+{
+	int materialCount = 0;
+	const SceneFile::SCENE_MATERIAL* pMaterials = sceneFile.GetMaterials(materialCount);
+
+	for (int i = 0; i < materialCount; i++)
+	{
+		const UniformBlocks::MATERIAL_DATA& values = pMaterials[i].values;
+
+		OBJECT_MATERIAL material;
+		material.ambientColor = values.ambientColor;
+		material.ambientStrength = values.ambientStrength;
+		material.diffuseColor = values.diffuseColor;
+		material.specularColor = values.specularColor;
+		material.shininess = values.shininess;
+		material.tag = pMaterials[i].tag;
+
+		AddObjectMaterial(material);
+	}
+}
+
+/***********************************************************
+ *  SetupFileLights()
+ *
+ *  This method is used for passing the light sources and the
+ *  point lights of a scene file into the light blocks.  The
+ *  file records already have the layouts of the blocks.
+ ***********************************************************/
+void SceneManager::SetupFileLights(const SceneFile& sceneFile)
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	m_pUniformCache->SetValue(m_uniforms.bUseLighting, true);
+	m_bUseLighting = true;
+
+	if (NULL == m_pUniformBlocks)
+	{
+		return;
+	}
+
+	m_pUniformBlocks->SetGlobalAmbientColor(sceneFile.GetGlobalAmbientColor());
+
+	int lightCount = 0;
+	const UniformBlocks::LIGHT_DATA* pLights = sceneFile.GetLights(lightCount);
+	for (int i = 0; (i < lightCount) && (i < TOTAL_LIGHTS); i++)
+	{
+		m_pUniformBlocks->SetLight(i, pLights[i]);
+	}
+
+	int pointLightCount = 0;
+	const ClusteredLights::POINT_LIGHT* pPointLights = sceneFile.GetPointLights(pointLightCount);
+	m_pClusteredLights->ClearPointLights();
+	for (int i = 0; i < pointLightCount; i++)
+	{
+		m_pClusteredLights->AddPointLight(pPointLights[i]);
+	}
+}
+
+/***********************************************************
+ *  BuildFileDrawList()
+ *
+ *  This method is used for building the retained draw records
+ *  from the object table of a scene file.  The file indices
+ *  of the textures and materials are turned into slots once,
+ *  and the objects are copied into the reserved draw list in
+ *  one pass.  The records are added dirty, so their matrices
+ *  and bounds are built by the parallel transform update.
+ ***********************************************************/
+void SceneManager::BuildFileDrawList(const SceneFile& sceneFile)
+{
+	int textureCount = 0;
+	int materialCount = 0;
+	int objectCount = 0;
+	const SceneFile::SCENE_TEXTURE* pTextures = sceneFile.GetTextures(textureCount);
+	const SceneFile::SCENE_MATERIAL* pMaterials = sceneFile.GetMaterials(materialCount);
+	const SceneFile::SCENE_OBJECT* pObjects = sceneFile.GetObjects(objectCount);
+
+	std::vector<int> textureSlots(textureCount);
+	for (int i = 0; i < textureCount; i++)
+	{
+		textureSlots[i] = FindTextureSlot(TagRegistry::HashTag(pTextures[i].tag));
+	}
+	std::vector<int> materialIndices(materialCount);
+	for (int i = 0; i < materialCount; i++)
+	{
+		materialIndices[i] = FindMaterialIndex(TagRegistry::HashTag(pMaterials[i].tag));
+	}
+
+	m_drawList.Clear();
+	m_drawList.Reserve(objectCount * m_sceneScale);
+
+	DrawList::DRAW_RECORD record = DrawList::MakeRecord(
+		DrawList::MESH_PLANE, DrawList::PART_ALL,
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		0.0f, 0.0f, 0.0f,
+		glm::vec3(0.0f, 0.0f, 0.0f));
+	record.bDirty = true;
+
+	int skippedCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		const SceneFile::SCENE_OBJECT& object = pObjects[i];
+		if ((object.meshID >= DrawList::MESH_TYPE_COUNT) ||
+			(object.textureIndex >= textureCount) || (object.materialIndex >= materialCount))
+		{
+			skippedCount++;
+			continue;
+		}
+
+		record.color = object.color;
+		record.scaleXYZ = object.scaleXYZ;
+		record.rotationDegrees = object.rotationDegrees;
+		record.positionXYZ = object.positionXYZ;
+		record.uvScale = object.uvScale;
+		record.textureSlot = (object.textureIndex >= 0) ? textureSlots[object.textureIndex] : -1;
+		record.materialIndex = (object.materialIndex >= 0) ? materialIndices[object.materialIndex] : -1;
+		record.meshID = object.meshID;
+		record.meshParts = object.meshParts;
+		record.bStatic = ((object.flags & SceneFile::OBJECT_DYNAMIC) == 0);
+		m_drawList.AddRecord(record);
+	}
+
+	if (skippedCount > 0)
+	{
+		std::cout << "Skipped " << skippedCount << " scene file objects with unknown meshes or references" << std::endl;
+	}
+
+	ReplicateSceneDrawList();
+}
+
+/***********************************************************
+ *  ReplicateSceneDrawList()
+ *
+ *  This method is used for repeating the scene records in a
+ *  square grid, one ground plane apart, until the draw list
+ *  holds the requested number of scene copies.  The copies
+ *  are always laid out the same way, so a benchmark of a
+ *  scale draws the same scene on every run.
+ ***********************************************************/
+void SceneManager::ReplicateSceneDrawList()
+{
+	int recordCount = m_drawList.GetRecordCount();
+	int columns = (int)std::ceil(std::sqrt((float)m_sceneScale));
+
+	// the ground plane spans 40 by 20 units
+	const glm::vec3 spacing = glm::vec3(42.0f, 0.0f, 22.0f);
+
+	for (int copy = 1; copy < m_sceneScale; copy++)
+	{
+		glm::vec3 offset = glm::vec3((float)(copy % columns), 0.0f, -(float)(copy / columns)) * spacing;
+
+		for (int i = 0; i < recordCount; i++)
+		{
+			DrawList::DRAW_RECORD record = m_drawList.GetRecord(i);
+			record.positionXYZ += offset;
+			record.bDirty = true;
+			m_drawList.AddRecord(record);
+		}
+	}
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by walking
+ *  the retained draw records - only the records that have
+ *  been marked dirty get their transforms rebuilt.  The CPU
+ *  side of the frame runs as a graph of jobs, and the OpenGL
+ *  calls stay on the render thread once the graph is done.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// upload the uniform blocks that changed, such as the camera
+	if (NULL != m_pUniformBlocks)
+	{
+		m_pUniformBlocks->Update();
+	}
+
+	// upload any textures that have finished decoding and move
+	// them into the texture arrays
+	{
+		Profiler::ScopedSection section(m_pProfiler, "Texture uploads");
+		m_pTextureLoader->ProcessCompletedLoads(g_MaxTextureUploadBytes);
+		m_pTextureLoader->TakeUploadedTextures(m_uploadedTextures, m_failedTextures);
+		// reloads that failed leave their layers at the levels
+		// they already have
+		m_pTextureArrays->CancelRestreams(m_failedTextures);
+		if (m_pTextureArrays->PackTextures(m_uploadedTextures) > 0)
+		{
+			// packed textures can join batches with other textures
+			// that are in the same array
+			BindGLTextures();
+			BuildInstanceBatches();
+			AssignShaderPermutations();
+			// the GPU scene draws are bucketed by texture array
+			m_bGPUSceneDirty = true;
+		}
+	}
+
+	// the light binning does not touch the records, so it runs
+	// beside the transforms, the spatial index and the culling,
+	// which each need the one before them
+	m_frameJobs.Clear();
+	m_frameJobs.AddJob([this]()
+	{
+		// bin the point lights into the clusters of this frame's view
+		m_pClusteredLights->BinLights(m_viewMatrix, m_projectionMatrix);
+	});
+	int transformJob = m_frameJobs.AddJob([this]()
+	{
+		// rebuild the model matrix of any record that has changed
+		m_drawList.UpdateTransforms(m_pJobSystem);
+	});
+	int indexJob = m_frameJobs.AddJob([this]()
+	{
+		// keep the spatial index in step with the records - it is
+		// only rebuilt when records have been added or removed
+		if (m_sceneBVH.GetRecordCount() != m_drawList.GetRecordCount())
+		{
+			m_sceneBVH.Build(m_drawList);
+		}
+		else
+		{
+			m_sceneBVH.Refit(m_drawList, m_drawList.GetChangedRecords());
+		}
+	});
+	int cullJob = m_frameJobs.AddJob([this]()
+	{
+		CullSceneRecords();
+	});
+	m_frameJobs.AddDependency(indexJob, transformJob);
+	m_frameJobs.AddDependency(cullJob, indexJob);
+	{
+		Profiler::ScopedSection section(m_pProfiler, "Frame jobs");
+		m_frameJobs.Run(m_pJobSystem);
+	}
+
+	// keep the GPU scene objects in step with the records
+	if (m_bGPUDriven == true)
+	{
+		if ((m_bGPUSceneDirty == true) || ((int)m_gpuObjects.size() != m_drawList.GetRecordCount()))
+		{
+			BuildGPUScene();
+		}
+		else
+		{
+			const std::vector<int>& changedRecords = m_drawList.GetChangedRecords();
+			for (size_t i = 0; i < changedRecords.size(); i++)
+			{
+				int objectIndex = m_gpuObjects[changedRecords[i]];
+				if (objectIndex >= 0)
+				{
+					m_pGPUScene->UpdateObject(objectIndex, MakeObjectData(m_drawList.GetRecord(changedRecords[i])));
+				}
+			}
+		}
+	}
+
+	m_pClusteredLights->UploadBuffers();
+
+	// the texture coverage of the records is measured in pixels
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	m_viewportHeight = (float)viewport[3];
+
+	// sort the draw items by shader state and depth, then draw them
+	BuildRenderQueue();
+	{
+		// store the texture levels the visible records need
+		Profiler::ScopedSection section(m_pProfiler, "Texture streaming");
+		m_pTextureStreamer->Update();
+	}
+	SubmitRenderQueue();
+}
+
+/***********************************************************
+ *  SetSceneView()
+ *
+ *  This method is used for setting the view values of the
+ *  current frame, which are used for ordering the draw items.
+ ***********************************************************/
+void SceneManager::SetSceneView(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  ExportScene()
+ *
+ *  This method is used for writing the scene into a mesh
+ *  file for 3D printing.  Each mesh part of each draw record
+ *  becomes one export part - the shared local space mesh and
+ *  the record's model matrix - so only the matrices are
+ *  copied here, and the export thread moves the vertices
+ *  into world space as it writes.  The curved shapes are
+ *  written at full detail whatever level they are drawn at.
+ ***********************************************************/
+bool SceneManager::ExportScene(
+	const std::string& filePath,
+	bool bWeld)
+{
+	std::vector<ShapeGeometry::MESH_DATA> shapeMeshes;
+	std::vector<MeshExporter::EXPORT_PART> parts;
+
+	if (m_pMeshExporter->IsExporting() == true)
+	{
+		std::cout << "An export is already running" << std::endl;
+		return(false);
+	}
+
+	GenerateShapeMeshes(shapeMeshes);
+
+	parts.reserve(m_drawList.GetRecordCount());
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+		int meshes[3];
+		int meshCount = GetRecordMeshes(record, meshes);
+		for (int j = 0; j < meshCount; j++)
+		{
+			MeshExporter::EXPORT_PART part;
+			part.meshIndex = meshes[j];
+			part.model = record.model;
+			parts.push_back(part);
+		}
+	}
+
+	std::cout << "INFO: Exporting " << parts.size() << " parts to " << filePath << std::endl;
+
+	return(m_pMeshExporter->StartExport(filePath, shapeMeshes, parts, bWeld));
+}
+
+/***********************************************************
+ *  PickSceneObject()
+ *
+ *  This method is used for finding the draw record that the
+ *  passed in world space ray hits first.  It returns the
+ *  record index, or -1 when the ray hits nothing.
+ ***********************************************************/
+int SceneManager::PickSceneObject(
+	const glm::vec3& origin,
+	const glm::vec3& direction)
+{
+	float hitDistance = 0.0f;
+	int recordIndex = m_sceneBVH.QueryRay(origin, direction, hitDistance);
+
+	if (recordIndex >= 0)
+	{
+		std::cout << "INFO: Picked draw record " << recordIndex
+			<< " at distance " << hitDistance << std::endl;
+	}
+
+	return(recordIndex);
+}
+
+/***********************************************************
+ *  SetGPUDriven()
+ *
+ *  This method is used for switching the opaque records
+ *  between the render queue and the GPU driven path.  The
+ *  first switch builds the cull program and uploads the mesh
+ *  ranges, so it must come after PrepareScene().  It returns
+ *  false, and keeps drawing from the render queue, when the
+ *  context cannot run the GPU driven path.
+ ***********************************************************/
+bool SceneManager::SetGPUDriven(bool bGPUDriven)
+{
+	if (bGPUDriven == false)
+	{
+		m_bGPUDriven = false;
+		return(true);
+	}
+
+	if (m_pGPUScene->IsCreated() == false)
+	{
+		if (m_pGPUScene->Create(m_pShaderLibrary, m_pMeshBuffer, g_CullShaderPath) == false)
+		{
+			std::cout << "GPU driven rendering is not available - drawing from the render queue" << std::endl;
+			return(false);
+		}
+
+		// every mesh has a range for each detail level - the
+		// plane and box use the same range at every level
+		std::vector<MeshBuffer::MESH_RANGE> ranges(GPU_MESH_COUNT * LODMeshes::LOD_COUNT);
+		for (int level = 0; level < LODMeshes::LOD_COUNT; level++)
+		{
+			ranges[(GPU_MESH_PLANE * LODMeshes::LOD_COUNT) + level] = m_planeMesh;
+			ranges[(GPU_MESH_BOX * LODMeshes::LOD_COUNT) + level] = m_boxMesh;
+			ranges[(GPU_MESH_CONE_SIDES * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_CONE, level, LODMeshes::PART_SIDES);
+			ranges[(GPU_MESH_CONE_BOTTOM * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_CONE, level, LODMeshes::PART_BOTTOM);
+			ranges[(GPU_MESH_CYLINDER_SIDES * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_CYLINDER, level, LODMeshes::PART_SIDES);
+			ranges[(GPU_MESH_CYLINDER_TOP * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_CYLINDER, level, LODMeshes::PART_TOP);
+			ranges[(GPU_MESH_CYLINDER_BOTTOM * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_CYLINDER, level, LODMeshes::PART_BOTTOM);
+			ranges[(GPU_MESH_SPHERE * LODMeshes::LOD_COUNT) + level] =
+				m_lodMeshes->GetRange(LODMeshes::SHAPE_SPHERE, level, LODMeshes::PART_SIDES);
+		}
+		m_pGPUScene->SetMeshRanges(ranges, LODMeshes::LOD_COUNT);
+
+		// the draws are only frustum culled without the pyramid
+		if (m_pHiZBuffer->Create(m_pShaderLibrary, g_HiZShaderPath) == false)
+		{
+			std::cout << "Occlusion culling is not available - culling against the view frustum only" << std::endl;
+		}
+	}
+
+	m_bGPUDriven = true;
+	m_bGPUSceneDirty = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  MakeObjectData()
+ *
+ *  This method is used for getting the GPU scene values of a
+ *  draw record.
+ ***********************************************************/
+GPUScene::OBJECT_DATA SceneManager::MakeObjectData(
+	const DrawList::DRAW_RECORD& record)
+{
+	GPUScene::OBJECT_DATA object;
+
+	object.model = record.model;
+	object.color = record.color;
+	object.boundsMinimum = glm::vec4(record.boundsMinimum, record.uvScale.x);
+	object.boundsMaximum = glm::vec4(record.boundsMaximum, record.uvScale.y);
+	object.materialIndex = (record.materialIndex >= 0) ? record.materialIndex : 0;
+	object.textureLayer = 0;
+	if (GetTextureArray(record.textureSlot) >= 0)
+	{
+		object.textureLayer = m_pTextureArrays->GetTextureLayer(record.textureSlot).layer;
+	}
+	object.padding[0] = 0;
+	object.padding[1] = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		object.normalColumns[i] = glm::vec4(record.normalMatrix[i], 0.0f);
+	}
+
+	return(object);
+}
+
+/***********************************************************
+ *  BuildGPUScene()
+ *
+ *  This method is used for adding every opaque record to the
+ *  GPU scene, with one draw for each of its mesh parts.
+ *  Transparent records stay in the render queue, since they
+ *  must be blended in depth order after the opaque ones.
+ ***********************************************************/
+void SceneManager::BuildGPUScene()
+{
+	m_pGPUScene->Clear();
+	m_gpuObjects.assign(m_drawList.GetRecordCount(), -1);
+	m_occluderRecords.clear();
+
+	for (int i = 0; i < m_drawList.GetRecordCount(); i++)
+	{
+		const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(i);
+
+		if ((record.textureSlot < 0) && (record.color.a < 1.0f))
+		{
+			continue;
+		}
+
+		int objectIndex = m_pGPUScene->AddObject(MakeObjectData(record));
+		int textureArray = GetTextureArray(record.textureSlot);
+		m_gpuObjects[i] = objectIndex;
+
+		// the ground, the large cones and the bottom of the box
+		// towers hide most of the smaller objects behind them
+		glm::vec3 extent = record.boundsMaximum - record.boundsMinimum;
+		if (glm::max(extent.x, glm::max(extent.y, extent.z)) >= g_MinOccluderExtent)
+		{
+			m_occluderRecords.push_back(i);
+		}
+
+		int meshes[3];
+		int meshCount = GetRecordMeshes(record, meshes);
+		for (int j = 0; j < meshCount; j++)
+		{
+			m_pGPUScene->AddDraw(objectIndex, meshes[j], textureArray);
+		}
+	}
+
+	m_pGPUScene->Upload();
+	m_bGPUSceneDirty = false;
+}
+
+/***********************************************************
+ *  CullGPUScene()
+ *
+ *  This method is used for culling the GPU scene against the
+ *  view and the occluders into its indirect commands.
+ ***********************************************************/
+void SceneManager::CullGPUScene()
+{
+	DrawOccluders();
+	m_pGPUScene->Cull(
+		m_projectionMatrix * m_viewMatrix,
+		m_projectionMatrix,
+		m_pHiZBuffer->IsCreated() ? m_pHiZBuffer : NULL);
+	// the cull shader leaves its program bound
+	UsePermutation(g_BasePermutation);
+}
+
+/***********************************************************
+ *  DrawGPUScene()
+ *
+ *  This method is used for drawing every texture array
+ *  bucket of the culled GPU scene with one multi-draw call.
+ ***********************************************************/
+void SceneManager::DrawGPUScene()
+{
+	for (int i = 0; i < m_pGPUScene->GetBucketCount(); i++)
+	{
+		int textureArray = m_pGPUScene->GetBucketTextureArray(i);
+
+		// the vertex shader already applied the texture scale of
+		// each object
+		UsePermutation(GetShaderPermutation(textureArray));
+		m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+		m_pUniformCache->SetValue(m_uniforms.bUseObjectBuffer, true);
+		m_pUniformCache->SetValue(m_uniforms.UVscale, glm::vec2(1.0f, 1.0f));
+		if (textureArray >= 0)
+		{
+			m_pUniformCache->SetValue(m_uniforms.bUseTexture, true);
+			m_pUniformCache->SetValue(m_uniforms.objectTexture, textureArray);
+		}
+		else
+		{
+			m_pUniformCache->SetValue(m_uniforms.bUseTexture, false);
+		}
+
+		m_pGPUScene->DrawBucket(i);
+		m_pStateCache->CountDrawCalls(1);
+		m_pUniformCache->SetValue(m_uniforms.bUseObjectBuffer, false);
+	}
+}
+
+/***********************************************************
+ *  DrawOccluders()
+ *
+ *  This method is used for drawing the depth of the occluder
+ *  records and building the pyramid that the GPU scene is
+ *  culled against.  The curved shapes are drawn at their
+ *  coarsest level, whose facets lie inside the full surface,
+ *  so they never hide more than the real shape would.
+ ***********************************************************/
+void SceneManager::DrawOccluders()
+{
+	if (m_pHiZBuffer->IsCreated() == false)
+	{
+		return;
+	}
+
+	m_pHiZBuffer->BeginOccluderPass();
+
+	m_pUniformCache->SetValue(m_uniforms.bUseInstancing, false);
+	for (size_t i = 0; i < m_occluderRecords.size(); i++)
+	{
+		const DrawList::DRAW_RECORD& record = m_drawList.GetRecord(m_occluderRecords[i]);
+
+		m_pUniformCache->SetValue(m_uniforms.model, record.model);
+		switch (record.meshID)
+		{
+		case DrawList::MESH_PLANE:
+			MeshBuffer::DrawRange(m_planeMesh);
+			m_pStateCache->CountDrawCalls(1);
+			break;
+		case DrawList::MESH_BOX:
+			MeshBuffer::DrawRange(m_boxMesh);
+			m_pStateCache->CountDrawCalls(1);
+			break;
+		default:
+			DrawLODLevel(record, LODMeshes::LOD_COUNT - 1);
+			break;
+		}
+	}
+
+	m_pHiZBuffer->EndOccluderPass();
+	m_pHiZBuffer->BuildPyramid();
+}
+
+/***********************************************************
+ *  SetRenderMode()
+ *
+ *  This method is used for choosing how the opaque items are
+ *  shaded.  The transparent items are drawn forward in every
+ *  mode, since they are blended in depth order.
+ ***********************************************************/
+void SceneManager::SetRenderMode(RENDER_MODE renderMode)
+{
+	m_renderMode = renderMode;
+}
+/***********************************************************
+ *  SetStreamBuffer()
+ *
+ *  This method is used for passing the per-frame stream
+ *  buffer to the objects that upload dynamic data every
+ *  frame - the light lists, the instances and the changed
+ *  objects of the GPU scene.
+ ***********************************************************/
+void SceneManager::SetStreamBuffer(StreamBuffer* pStreamBuffer)
+{
+	m_pClusteredLights->SetStreamBuffer(pStreamBuffer);
+	m_instancedMeshes->SetStreamBuffer(pStreamBuffer);
+	m_pGPUScene->SetStreamBuffer(pStreamBuffer);
+}
@@ -1,113 +1,501 @@
-///////////////////////////////////////////////////////////////////////////////
-// scenemanager.h
-// ============
-// manage the preparing and rendering of 3D scenes - textures, materials, lighting
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
-
-#include <string>
-#include <vector>
-
-/***********************************************************
- *  SceneManager
- *
- *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
- ***********************************************************/
-class SceneManager
-{
-public:
-	// constructor
-	SceneManager(ShaderManager *pShaderManager);
-	// destructor
-	~SceneManager();
-
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
-	struct OBJECT_MATERIAL
-	{
-		float ambientStrength;
-		glm::vec3 ambientColor;
-		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
-	};
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
-
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
-	// free the loaded OpenGL textures
-	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
-
-public:
-
-	// The following methods are for the students to 
-	// customize for their own 3D scene
-	void PrepareScene();
-	void RenderScene();
-
-	void LoadSceneTextures();
-
-	void DefineObjectMaterials();
-
-	void SetupSceneLights();
-
+///////////////////////////////////////////////////////////////////////////////
+// scenemanager.h
+// ============
+// manage the preparing and rendering of 3D scenes - textures, materials, lighting
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformCache.h"
+#include "StateCache.h"
+#include "DrawList.h"
+#include "MeshBuffer.h"
+#include "InstancedMeshes.h"
+#include "LODMeshes.h"
+#include "RenderQueue.h"
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+#include "TextureStreamer.h"
+#include "TagRegistry.h"
+#include "UniformBlocks.h"
+#include "ClusteredLights.h"
+#include "SceneBVH.h"
+#include "ShaderLibrary.h"
+#include "GPUScene.h"
+#include "HiZBuffer.h"
+#include "GBuffer.h"
+#include "Profiler.h"
+#include "StreamBuffer.h"
+#include "JobSystem.h"
+#include "JobGraph.h"
+#include "SceneFile.h"
+#include "MeshExporter.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache, StateCache* pStateCache, UniformBlocks* pUniformBlocks);
+	// destructor
+	~SceneManager();
+
+	struct TEXTURE_INFO
+	{
+		std::string tag;
+		uint32_t ID;
+	};
+
+	struct OBJECT_MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// draw records that share the same mesh and shader state
+	// and are drawn together with one instanced draw call
+	struct INSTANCE_BATCH
+	{
+		// texture array sampled by the batch, or -1 for none -
+		// each instance picks its own layer
+		int textureArray;
+		int materialIndex;
+		glm::vec2 uvScale;
+		// shader permutation that draws the batch
+		int shaderPermutation;
+		std::vector<int> recordIndices;
+	};
+
+	// static draw records that share the same texture, material
+	// and color in one cell of the scene, baked into one world
+	// space mesh at load time and drawn with one draw call and
+	// an identity model matrix
+	struct STATIC_BATCH
+	{
+		int textureSlot;
+		int materialIndex;
+		// solid color of untextured batches
+		glm::vec4 color;
+		// shader permutation that draws the batch
+		int shaderPermutation;
+		// range of the baked mesh in the shared buffer
+		MeshBuffer::MESH_RANGE mesh;
+		std::vector<int> recordIndices;
+	};
+
+	// mesh part of a record in a static batch, and where its
+	// baked vertices and indices are written
+	struct STATIC_BATCH_PART
+	{
+		int batchIndex;
+		int recordIndex;
+		// GPU scene mesh that the part is baked from
+		int shapeMesh;
+		size_t firstFloat;
+		size_t firstIndex;
+	};
+
+	// number of light sources declared in the fragment shader
+	static const int TOTAL_LIGHTS = UniformBlocks::MAX_LIGHTS;
+
+	// ways of shading the opaque items
+	enum RENDER_MODE
+	{
+		// shade every fragment as it is drawn
+		RENDER_FORWARD = 0,
+		// draw the opaque depth first, then shade only the
+		// fragments that match it
+		RENDER_DEPTH_PREPASS,
+		// write the opaque surfaces into the geometry targets
+		// and shade each pixel once in a fullscreen pass
+		RENDER_DEFERRED
+	};
+
+private:
+	// cached handles for the per-object shader uniforms
+	struct SHADER_UNIFORMS
+	{
+		UniformCache::UniformHandle<glm::mat4> model;
+		UniformCache::UniformHandle<glm::mat3> normalMatrix;
+		UniformCache::UniformHandle<glm::vec4> objectColor;
+		UniformCache::UniformHandle<int> objectTexture;
+		UniformCache::UniformHandle<float> textureLayer;
+		UniformCache::UniformHandle<bool> bUseTexture;
+		UniformCache::UniformHandle<bool> bUseLighting;
+		UniformCache::UniformHandle<bool> bUseInstancing;
+		UniformCache::UniformHandle<bool> bUseObjectBuffer;
+		UniformCache::UniformHandle<glm::vec2> UVscale;
+		UniformCache::UniformHandle<int> materialIndex;
+		UniformCache::UniformHandle<float> lodFade;
+		UniformCache::UniformHandle<bool> bDepthOnly;
+		UniformCache::UniformHandle<bool> bWriteGBuffer;
+		UniformCache::UniformHandle<bool> bDeferredLighting;
+		UniformCache::UniformHandle<int> gBufferAlbedo;
+		UniformCache::UniformHandle<int> gBufferNormal;
+		UniformCache::UniformHandle<int> gBufferMaterial;
+		UniformCache::UniformHandle<int> gBufferDepth;
+		UniformCache::UniformHandle<glm::mat4> inverseViewProjection;
+	};
+
+	// feature bits of the specialized scene shader programs
+	enum PERMUTATION_FLAG
+	{
+		PERMUTATION_LIT = 0x01,
+		PERMUTATION_TEXTURED = 0x02,
+		PERMUTATION_COUNT = 4
+	};
+
+	// a specialized scene program with its own uniform locations
+	struct SHADER_PERMUTATION
+	{
+		GLuint programID;
+		UniformCache* pUniformCache;
+		SHADER_UNIFORMS uniforms;
+	};
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// pointer to the camera, light and material uniform blocks
+	UniformBlocks* m_pUniformBlocks;
+	// pointer to the frame profiler, or NULL when not profiling
+	Profiler* m_pProfiler;
+	// pointer to the worker threads that the frame update is
+	// spread over, or NULL to run it on the render thread
+	JobSystem* m_pJobSystem;
+	// jobs of the frame update, built again every frame
+	JobGraph m_frameJobs;
+	// pointer to the point lights binned into view clusters
+	ClusteredLights* m_pClusteredLights;
+	// handles for the shader uniforms of the program in use
+	SHADER_UNIFORMS m_uniforms;
+	// uniform locations and handles of the base program, which
+	// picks its features from the uniforms at runtime
+	UniformCache* m_pBaseUniformCache;
+	SHADER_UNIFORMS m_baseUniforms;
+	GLuint m_baseProgramID;
+	// specialized programs indexed by their feature bits
+	SHADER_PERMUTATION m_permutations[PERMUTATION_COUNT];
+	// permutation in use, or -1 for the base program
+	int m_currentPermutation;
+	// true when the scene is lit
+	bool m_bUseLighting;
+	// uniforms of the current pass that every program is given
+	// when it is put in use
+	bool m_bDepthOnlyPass;
+	bool m_bGBufferPass;
+	// pointer to the shared buffer that holds every mesh
+	MeshBuffer* m_pMeshBuffer;
+	// pointer to the extra shader programs, such as the cull shader
+	ShaderLibrary* m_pShaderLibrary;
+	// pointer to the object buffers of the GPU driven path
+	GPUScene* m_pGPUScene;
+	// true when the opaque records are culled and drawn on the GPU
+	bool m_bGPUDriven;
+	// copies of the scene in the draw list
+	int m_sceneScale;
+	// true when repeated boxes are drawn in instance batches and
+	// when the render queue only takes records in the view
+	bool m_bInstancing;
+	bool m_bCulling;
+	// true when the static records are baked into static batches
+	bool m_bStaticBaking;
+	// binary scene file to load, or empty for the built in scene
+	std::string m_sceneFilePath;
+	// true when the GPU scene must be built again
+	bool m_bGPUSceneDirty;
+	// GPU scene object of every record, or -1 for records that
+	// are drawn from the render queue
+	std::vector<int> m_gpuObjects;
+	// occluder depth pyramid that the GPU scene is culled against
+	HiZBuffer* m_pHiZBuffer;
+	// large opaque records drawn into the occluder depth
+	std::vector<int> m_occluderRecords;
+	// how the opaque items are shaded
+	RENDER_MODE m_renderMode;
+	// pointer to the geometry targets of the deferred mode
+	GBuffer* m_pGBuffer;
+	// ranges of the plane and box in the shared buffer
+	MeshBuffer::MESH_RANGE m_planeMesh;
+	MeshBuffer::MESH_RANGE m_boxMesh;
+	// pointer to instanced shapes object
+	InstancedMeshes* m_instancedMeshes;
+	// pointer to the detail levels of the curved shapes
+	LODMeshes* m_lodMeshes;
+	// pointer to the asynchronous texture loading object
+	TextureLoader* m_pTextureLoader;
+	// pointer to the texture arrays that hold the loaded textures
+	TextureArrays* m_pTextureArrays;
+	// pointer to the streamer that picks the stored mip levels
+	TextureStreamer* m_pTextureStreamer;
+	// pointer to the exporter that writes the scene mesh files
+	MeshExporter* m_pMeshExporter;
+	// height in pixels of this frame's viewport
+	float m_viewportHeight;
+	// loaded textures info - indexed by texture slot
+	std::vector<TEXTURE_INFO> m_textureIDs;
+	// texture tags - the id of a tag is its texture slot
+	TagRegistry m_textureTags;
+	// material tags - the id of a tag is its material index
+	TagRegistry m_materialTags;
+	// textures uploaded in the current frame, and the ones whose
+	// image could not be loaded
+	std::vector<GLuint> m_uploadedTextures;
+	std::vector<GLuint> m_failedTextures;
+	// defined object materials
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// retained draw records for the 3D scene
+	DrawList m_drawList;
+	// spatial index over the draw record bounds
+	SceneBVH m_sceneBVH;
+	// records returned by the last frustum query
+	std::vector<int> m_visibleRecords;
+	// sort key, queued flag and detail level of every record,
+	// filled in parallel before the records are queued
+	std::vector<uint64_t> m_recordKeys;
+	std::vector<uint8_t> m_recordQueued;
+	std::vector<LODMeshes::LOD_SELECTION> m_recordLODs;
+	// screen pixels one texture repeat of every visible textured
+	// record covers, or 0 for the others
+	std::vector<float> m_recordCoverage;
+	// instance batches built from the draw records
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// static batches baked from the static draw records
+	std::vector<STATIC_BATCH> m_staticBatches;
+	// sorted draw items for the current frame
+	RenderQueue m_renderQueue;
+	// view values for the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// per-frame instance data gathered for an instanced draw
+	std::vector<InstancedMeshes::INSTANCE_DATA> m_instanceData;
+
+	// load texture images and convert to OpenGL texture data
+	bool CreateGLTexture(const char* filename, const char* tag);
+	// bind the texture arrays to slots in memory
+	void BindGLTextures();
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// find a loaded texture by tag hash
+	int FindTextureID(TagRegistry::TAG_HASH tagHash);
+	int FindTextureSlot(TagRegistry::TAG_HASH tagHash);
+	// get the texture array holding a texture slot, or -1
+	int GetTextureArray(int textureSlot);
+	// pass the texture array and layer of a texture slot into
+	// the shader, or turn off texturing for slot -1
+	void SetShaderTextureSlot(int textureSlot);
+	// find a defined material by tag hash
+	const OBJECT_MATERIAL* FindMaterial(TagRegistry::TAG_HASH tagHash);
+	int FindMaterialIndex(TagRegistry::TAG_HASH tagHash);
+	// define a material under its tag
+	void AddObjectMaterial(const OBJECT_MATERIAL& material);
+
+	// get the typed handles for the shader uniforms of a program
+	void ResolveShaderUniforms(
+		UniformCache* pUniformCache,
+		SHADER_UNIFORMS& uniforms);
+	// compile the specialized programs of the scene shaders
+	void BuildShaderPermutations();
+	// free the specialized programs' uniform caches
+	void DestroyShaderPermutations();
+	// get the permutation that draws with a texture array
+	int GetShaderPermutation(int textureArray) const;
+	// set the permutation of every draw record
+	void AssignShaderPermutations();
+	// put a permutation, or the base program for -1, in use
+	void UsePermutation(int permutation);
+	// set the pass uniforms of the current program
+	void SetPassUniforms(bool bDepthOnly, bool bGBuffer);
+
+	// set the transformation values 
+	// into the transform buffer
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the shader
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture data into the shader
+	void SetShaderTexture(
+		TagRegistry::TAG_HASH textureTag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
+
+	// set the object material into the shader
+	void SetShaderMaterial(
+		TagRegistry::TAG_HASH materialTag);
+	void SetShaderMaterial(
+		int materialIndex);
+
+	// build the retained draw records for the 3D scene
+	void BuildSceneDrawList();
+	// load the textures, materials, lights and draw records of a
+	// mapped scene file in place of the built in scene
+	void LoadFileTextures(const SceneFile& sceneFile);
+	void DefineFileMaterials(const SceneFile& sceneFile);
+	void SetupFileLights(const SceneFile& sceneFile);
+	void BuildFileDrawList(const SceneFile& sceneFile);
+	// add the grid copies of the scene records
+	void ReplicateSceneDrawList();
+	// pass the draw record values into the shader and draw its mesh
+	void DrawSceneObject(
+		const DrawList::DRAW_RECORD& record,
+		const LODMeshes::LOD_SELECTION& lodSelection);
+	// pick the detail level of a curved shape record from its
+	// size on the screen
+	LODMeshes::LOD_SELECTION SelectRecordLOD(
+		const DrawList::DRAW_RECORD& record) const;
+	// radius of the bounds of a record on the screen, where 1
+	// is half of the viewport height
+	float GetScreenRadius(const DrawList::DRAW_RECORD& record) const;
+	// draw a curved shape record at the passed in detail level
+	void DrawLODObject(
+		const DrawList::DRAW_RECORD& record,
+		const LODMeshes::LOD_SELECTION& selection);
+	void DrawLODLevel(
+		const DrawList::DRAW_RECORD& record,
+		int level);
+	// group the box draw records that share state into instance batches
+	void BuildInstanceBatches();
+	// draw the records of an instance batch with one instanced draw call
+	void DrawInstanceBatch(
+		int batchIndex);
+	// bake the static draw records into world space meshes in the
+	// shared buffer - only before the buffer is uploaded
+	void BuildStaticBatches();
+	// generate the local space mesh of every GPU scene mesh at
+	// full detail, indexed like the record mesh parts
+	static void GenerateShapeMeshes(
+		std::vector<ShapeGeometry::MESH_DATA>& shapeMeshes);
+	// draw the baked mesh of a static batch with one draw call
+	void DrawStaticBatch(
+		int batchIndex);
+	// get the mesh parts that draw a record, as GPU scene meshes -
+	// returns the number of parts
+	static int GetRecordMeshes(
+		const DrawList::DRAW_RECORD& record,
+		int meshes[3]);
+	// mark the records in this frame's view as visible
+	void CullSceneRecords();
+	// queue the draw records and instance batches under sort keys
+	void BuildRenderQueue();
+	// draw the queued items in sorted order
+	void SubmitRenderQueue();
+	// build the GPU scene objects and draws from the records
+	void BuildGPUScene();
+	// get the GPU scene values of a record
+	GPUScene::OBJECT_DATA MakeObjectData(
+		const DrawList::DRAW_RECORD& record);
+	// draw the queued items in the passed in range
+	void DrawQueueItems(int firstItem, int lastItem);
+	// draw the opaque GPU scene draws and queued items
+	void DrawOpaqueItems();
+	// shade the geometry targets with a fullscreen triangle
+	void DrawDeferredLighting();
+	// cull the GPU scene into its indirect commands
+	void CullGPUScene();
+	// draw the culled GPU scene
+	void DrawGPUScene();
+	// draw the occluder records and build the depth pyramid
+	void DrawOccluders();
+
+public:
+
+	// The following methods are for the students to 
+	// customize for their own 3D scene
+	void PrepareScene();
+	void RenderScene();
+
+	// set the view values used for ordering the draw items
+	void SetSceneView(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+
+	// build the base program through the shader library, so it
+	// is loaded from its program binary when one is cached, and
+	// resolve its uniforms - returns false when it cannot be built
+	bool LoadBaseProgram();
+	// switch the opaque records to the GPU driven path - only
+	// after the scene is prepared, returns false when the
+	// context cannot run it
+	bool SetGPUDriven(bool bGPUDriven);
+	// choose how the opaque items are shaded
+	void SetRenderMode(RENDER_MODE renderMode);
+	// time the texture loading and the render passes
+	void SetProfiler(Profiler* pProfiler) { m_pProfiler = pProfiler; }
+	// spread the transforms, culling, light binning and render
+	// queue building over the passed in job system
+	void SetJobSystem(JobSystem* pJobSystem) { m_pJobSystem = pJobSystem; m_pMeshExporter->SetJobSystem(pJobSystem); }
+	// bytes of video memory the stored texture levels may take,
+	// or 0 to store every level the view needs
+	void SetTextureBudget(size_t budgetBytes) { m_pTextureStreamer->SetBudget(budgetBytes); }
+	// copy the per-frame dynamic data into the passed in
+	// persistently mapped stream buffer
+	void SetStreamBuffer(StreamBuffer* pStreamBuffer);
+	// repeat the scene in a grid of the passed in number of
+	// copies - only before the scene is prepared
+	void SetSceneScale(int copyCount) { m_sceneScale = (copyCount > 1) ? copyCount : 1; }
+	// turn the instance batches and the view culling of the
+	// render queue on or off, such as for comparing them
+	void SetInstancing(bool bInstancing) { m_bInstancing = bInstancing; }
+	void SetCulling(bool bCulling) { m_bCulling = bCulling; }
+	// turn the baking of the static records on or off, which is
+	// off unless asked for - only before the scene is prepared
+	void SetStaticBaking(bool bStaticBaking) { m_bStaticBaking = bStaticBaking; }
+	// load the scene from a binary scene file instead of the
+	// built in scene - only before the scene is prepared
+	void SetSceneFile(const std::string& filePath) { m_sceneFilePath = filePath; }
+	// number of draw records in the scene
+	int GetObjectCount() const { return(m_drawList.GetRecordCount()); }
+
+	// find the draw record hit first by a world space ray
+	int PickSceneObject(
+		const glm::vec3& origin,
+		const glm::vec3& direction);
+	// write the triangles of every draw record into a binary STL
+	// or 3MF file on a background thread, welding the vertices
+	// when asked - returns false while an export is running
+	bool ExportScene(
+		const std::string& filePath,
+		bool bWeld);
+	// true while an export is writing its file
+	bool IsExporting() const { return(m_pMeshExporter->IsExporting()); }
+
+	void LoadSceneTextures();
+
+	void DefineObjectMaterials();
+
+	void SetupSceneLights();
+
 };
\ No newline at end of file
@@ -0,0 +1,470 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderlibrary.cpp
+// ============
+// compile and keep the extra shader programs used by the renderer, such as
+// the compute programs and the specialized permutations of the scene shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderLibrary.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// "GLPB" file identifier of the program binary cache files
+	const uint32_t g_BinaryCacheMagic = 0x42504C47;
+	// 64-bit FNV-1a constants
+	const uint64_t g_FNVOffsetBasis = 14695981039346656037ULL;
+	const uint64_t g_FNVPrime = 1099511628211ULL;
+
+	// header at the start of a program binary cache file
+	struct PROGRAM_BINARY_HEADER
+	{
+		uint32_t magic;
+		uint32_t binaryFormat;
+		uint64_t cacheKey;
+		uint32_t binaryLength;
+		uint32_t padding;
+	};
+
+	// fold the bytes of a string into an FNV-1a hash
+	uint64_t HashText(uint64_t hash, const std::string& text)
+	{
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			hash ^= (uint64_t)(unsigned char)text[i];
+			hash *= g_FNVPrime;
+		}
+
+		// separate the strings, so moving text from one to the
+		// next changes the hash
+		hash ^= 0xFF;
+		hash *= g_FNVPrime;
+
+		return(hash);
+	}
+
+	// concatenate the strings that identify the driver - a
+	// program binary is only valid for the driver that made it
+	std::string GetDriverString()
+	{
+		const GLenum names[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		std::string driver;
+
+		for (int i = 0; i < 3; i++)
+		{
+			const GLubyte* pText = glGetString(names[i]);
+			if (pText != NULL)
+			{
+				driver += (const char*)pText;
+			}
+			driver += "\n";
+		}
+
+		return(driver);
+	}
+}
+
+/***********************************************************
+ *  ShaderLibrary()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderLibrary::ShaderLibrary()
+{
+}
+
+/***********************************************************
+ *  ~ShaderLibrary()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderLibrary::~ShaderLibrary()
+{
+	DeletePrograms();
+}
+
+/***********************************************************
+ *  LoadComputeProgram()
+ *
+ *  This method is used for building a compute program from
+ *  the passed in GLSL file.  It returns 0 when the file is
+ *  missing or does not compile.
+ ***********************************************************/
+GLuint ShaderLibrary::LoadComputeProgram(const char* filePath)
+{
+	std::string source;
+
+	if (ReadShaderFile(filePath, source) == false)
+	{
+		return(0);
+	}
+
+	std::string cacheFilename = std::string(filePath) + ".bin";
+	uint64_t cacheKey = HashText(HashText(g_FNVOffsetBasis, source), GetDriverString());
+
+	GLuint programID = ReadProgramBinary(cacheFilename, cacheKey);
+	if (programID != 0)
+	{
+		m_programs.push_back(programID);
+		return(programID);
+	}
+
+	GLuint shaderID = CompileShader(GL_COMPUTE_SHADER, source, filePath);
+	if (shaderID == 0)
+	{
+		return(0);
+	}
+
+	programID = glCreateProgram();
+	glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(programID, shaderID);
+	bool bLinked = LinkProgram(programID, filePath);
+	glDetachShader(programID, shaderID);
+	glDeleteShader(shaderID);
+
+	if (bLinked == false)
+	{
+		glDeleteProgram(programID);
+		return(0);
+	}
+
+	WriteProgramBinary(programID, cacheFilename, cacheKey);
+	m_programs.push_back(programID);
+
+	return(programID);
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for building a program from a vertex
+ *  and a fragment GLSL file, with the passed in defines added
+ *  to both stages.  Each define is a name, optionally followed
+ *  by its value.  It returns 0 when a file is missing or does
+ *  not compile.
+ ***********************************************************/
+GLuint ShaderLibrary::LoadProgram(
+	const char* vertexPath,
+	const char* fragmentPath,
+	const std::vector<std::string>& defines)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	if ((ReadShaderFile(vertexPath, vertexSource) == false) ||
+		(ReadShaderFile(fragmentPath, fragmentSource) == false))
+	{
+		return(0);
+	}
+
+	InjectDefines(vertexSource, defines);
+	InjectDefines(fragmentSource, defines);
+
+	// the file name tells the programs built from the fragment
+	// file apart, and the key tells whether a file is still
+	// valid for the sources and the driver
+	uint64_t nameHash = HashText(g_FNVOffsetBasis, vertexPath);
+	for (size_t i = 0; i < defines.size(); i++)
+	{
+		nameHash = HashText(nameHash, defines[i]);
+	}
+	std::ostringstream cacheFilename;
+	cacheFilename << fragmentPath << "." << std::hex << std::setw(16) << std::setfill('0') << nameHash << ".bin";
+
+	uint64_t cacheKey = HashText(g_FNVOffsetBasis, vertexSource);
+	cacheKey = HashText(cacheKey, fragmentSource);
+	cacheKey = HashText(cacheKey, GetDriverString());
+
+	GLuint programID = ReadProgramBinary(cacheFilename.str(), cacheKey);
+	if (programID != 0)
+	{
+		m_programs.push_back(programID);
+		return(programID);
+	}
+
+	GLuint vertexID = CompileShader(GL_VERTEX_SHADER, vertexSource, vertexPath);
+	if (vertexID == 0)
+	{
+		return(0);
+	}
+
+	GLuint fragmentID = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, fragmentPath);
+	if (fragmentID == 0)
+	{
+		glDeleteShader(vertexID);
+		return(0);
+	}
+
+	programID = glCreateProgram();
+	glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(programID, vertexID);
+	glAttachShader(programID, fragmentID);
+	bool bLinked = LinkProgram(programID, fragmentPath);
+	glDetachShader(programID, vertexID);
+	glDetachShader(programID, fragmentID);
+	glDeleteShader(vertexID);
+	glDeleteShader(fragmentID);
+
+	if (bLinked == false)
+	{
+		glDeleteProgram(programID);
+		return(0);
+	}
+
+	WriteProgramBinary(programID, cacheFilename.str(), cacheKey);
+	m_programs.push_back(programID);
+
+	return(programID);
+}
+
+/***********************************************************
+ *  DeletePrograms()
+ *
+ *  This method is used for deleting every program that was
+ *  created by the library.
+ ***********************************************************/
+void ShaderLibrary::DeletePrograms()
+{
+	for (size_t i = 0; i < m_programs.size(); i++)
+	{
+		glDeleteProgram(m_programs[i]);
+	}
+	m_programs.clear();
+}
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used for reading the whole text of a
+ *  shader source file.
+ ***********************************************************/
+bool ShaderLibrary::ReadShaderFile(const char* filePath, std::string& source)
+{
+	std::ifstream file(filePath);
+
+	if (file.is_open() == false)
+	{
+		std::cout << "Could not open shader file: " << filePath << std::endl;
+		return(false);
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	source = stream.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  InjectDefines()
+ *
+ *  This method is used for adding a define line for each of
+ *  the passed in defines.  The lines go after the version
+ *  line, which has to stay first in a GLSL source.
+ ***********************************************************/
+void ShaderLibrary::InjectDefines(std::string& source, const std::vector<std::string>& defines)
+{
+	std::string defineLines;
+
+	for (size_t i = 0; i < defines.size(); i++)
+	{
+		defineLines += "#define " + defines[i] + "\n";
+	}
+
+	size_t insertAt = 0;
+	if (source.compare(0, 8, "#version") == 0)
+	{
+		size_t lineEnd = source.find('\n');
+		insertAt = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+	}
+
+	source.insert(insertAt, defineLines);
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one shader stage and
+ *  logging the compile errors.
+ ***********************************************************/
+GLuint ShaderLibrary::CompileShader(GLenum shaderType, const std::string& source, const char* filePath)
+{
+	GLuint shaderID = glCreateShader(shaderType);
+	const GLchar* pSource = source.c_str();
+	GLint compiled = GL_FALSE;
+
+	glShaderSource(shaderID, 1, &pSource, NULL);
+	glCompileShader(shaderID);
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compiled);
+
+	if (compiled == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log((size_t)logLength + 1, '\0');
+		glGetShaderInfoLog(shaderID, logLength, NULL, log.data());
+		std::cout << "Failed to compile shader " << filePath << ":\n" << log.data() << std::endl;
+
+		glDeleteShader(shaderID);
+		return(0);
+	}
+
+	return(shaderID);
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used for linking a program and logging the
+ *  link errors.
+ ***********************************************************/
+bool ShaderLibrary::LinkProgram(GLuint programID, const char* filePath)
+{
+	GLint linked = GL_FALSE;
+
+	glLinkProgram(programID);
+	glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+
+	if (linked == GL_FALSE)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log((size_t)logLength + 1, '\0');
+		glGetProgramInfoLog(programID, logLength, NULL, log.data());
+		std::cout << "Failed to link shader program " << filePath << ":\n" << log.data() << std::endl;
+
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsBinaryCacheSupported()
+ *
+ *  This method is used for checking whether the driver can
+ *  save and load linked programs in at least one format.
+ ***********************************************************/
+bool ShaderLibrary::IsBinaryCacheSupported()
+{
+	GLint formatCount = 0;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	return(formatCount > 0);
+}
+
+/***********************************************************
+ *  ReadProgramBinary()
+ *
+ *  This method is used for creating a program from a saved
+ *  program binary.  It returns 0 when the cache file is
+ *  missing, was saved for other sources or another driver, or
+ *  is refused by the driver, so the program is compiled from
+ *  its sources instead.
+ ***********************************************************/
+GLuint ShaderLibrary::ReadProgramBinary(const std::string& cacheFilename, uint64_t cacheKey)
+{
+	PROGRAM_BINARY_HEADER header;
+
+	if (IsBinaryCacheSupported() == false)
+	{
+		return(0);
+	}
+
+	std::ifstream file(cacheFilename.c_str(), std::ios::binary);
+	if (!file)
+	{
+		return(0);
+	}
+
+	file.read((char*)&header, sizeof(header));
+	if ((!file) ||
+		(header.magic != g_BinaryCacheMagic) ||
+		(header.cacheKey != cacheKey) ||
+		(header.binaryLength == 0))
+	{
+		std::cout << "Program binary cache is out of date:" << cacheFilename << std::endl;
+		return(0);
+	}
+
+	std::vector<char> binary(header.binaryLength);
+	file.read(binary.data(), header.binaryLength);
+	if (!file)
+	{
+		return(0);
+	}
+
+	GLuint programID = glCreateProgram();
+	GLint linked = GL_FALSE;
+	glProgramBinary(programID, (GLenum)header.binaryFormat, binary.data(), (GLsizei)header.binaryLength);
+	glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+
+	if (linked == GL_FALSE)
+	{
+		std::cout << "Program binary cache was refused by the driver:" << cacheFilename << std::endl;
+		glDeleteProgram(programID);
+		return(0);
+	}
+
+	std::cout << "Loaded program binary cache:" << cacheFilename << std::endl;
+	return(programID);
+}
+
+/***********************************************************
+ *  WriteProgramBinary()
+ *
+ *  This method is used for saving the binary of a linked
+ *  program, so the next launch can skip compiling it.
+ ***********************************************************/
+bool ShaderLibrary::WriteProgramBinary(GLuint programID, const std::string& cacheFilename, uint64_t cacheKey)
+{
+	GLint binaryLength = 0;
+	GLenum binaryFormat = 0;
+
+	if (IsBinaryCacheSupported() == false)
+	{
+		return(false);
+	}
+
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0)
+	{
+		return(false);
+	}
+
+	std::vector<char> binary((size_t)binaryLength);
+	glGetProgramBinary(programID, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+	PROGRAM_BINARY_HEADER header;
+	header.magic = g_BinaryCacheMagic;
+	header.binaryFormat = (uint32_t)binaryFormat;
+	header.cacheKey = cacheKey;
+	header.binaryLength = (uint32_t)binaryLength;
+	header.padding = 0;
+
+	std::ofstream file(cacheFilename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write program binary cache:" << cacheFilename << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), binaryLength);
+
+	if (!file)
+	{
+		std::cout << "Could not write program binary cache:" << cacheFilename << std::endl;
+		return(false);
+	}
+
+	std::cout << "Wrote program binary cache:" << cacheFilename << std::endl;
+	return(true);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderlibrary.h
+// ============
+// compile and keep the extra shader programs used by the renderer, such as
+// the compute programs and the specialized permutations of the scene shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ShaderLibrary
+ *
+ *  This class loads GLSL source files, compiles and links
+ *  them into programs and deletes every program it created
+ *  when it is destroyed.  Compile and link errors are logged
+ *  with the name of the file and a program handle of 0 is
+ *  returned, so callers can fall back to another path.
+ *  Linked programs are saved as program binaries next to
+ *  their sources, keyed by a hash of the sources with their
+ *  defines and the driver strings, and are loaded from there
+ *  on later launches instead of being compiled again.
+ ***********************************************************/
+class ShaderLibrary
+{
+public:
+	// constructor
+	ShaderLibrary();
+	// destructor
+	~ShaderLibrary();
+
+	// compile and link a compute program from a GLSL file
+	GLuint LoadComputeProgram(const char* filePath);
+	// compile and link a vertex and fragment program with the
+	// passed in "NAME VALUE" defines put in front of both sources
+	GLuint LoadProgram(
+		const char* vertexPath,
+		const char* fragmentPath,
+		const std::vector<std::string>& defines);
+	// delete every program created by the library
+	void DeletePrograms();
+
+private:
+	// programs created by the library
+	std::vector<GLuint> m_programs;
+
+	// read the whole text of a shader file
+	static bool ReadShaderFile(const char* filePath, std::string& source);
+	// put define lines after the version line of a source
+	static void InjectDefines(std::string& source, const std::vector<std::string>& defines);
+	// compile one shader stage - returns 0 on failure
+	static GLuint CompileShader(GLenum shaderType, const std::string& source, const char* filePath);
+	// link the attached stages of a program - returns false on failure
+	static bool LinkProgram(GLuint programID, const char* filePath);
+	// check whether the driver has any program binary formats
+	static bool IsBinaryCacheSupported();
+	// create a program from a cache file whose key matches -
+	// returns 0 when the program has to be compiled
+	static GLuint ReadProgramBinary(const std::string& cacheFilename, uint64_t cacheKey);
+	// save the binary of a linked program with its key
+	static bool WriteProgramBinary(GLuint programID, const std::string& cacheFilename, uint64_t cacheKey);
+};
\ No newline at end of file
@@ -0,0 +1,448 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.cpp
+// ============
+// generate the CPU side vertex and index data for the basic 3D shapes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeGeometry.h"
+
+#include <cmath>
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for appending one interleaved vertex
+ *  to the passed in mesh data.
+ ***********************************************************/
+void ShapeGeometry::AddVertex(
+	MESH_DATA& mesh,
+	float x, float y, float z,
+	float nx, float ny, float nz,
+	float u, float v)
+{
+	mesh.vertices.push_back(x);
+	mesh.vertices.push_back(y);
+	mesh.vertices.push_back(z);
+	mesh.vertices.push_back(nx);
+	mesh.vertices.push_back(ny);
+	mesh.vertices.push_back(nz);
+	mesh.vertices.push_back(u);
+	mesh.vertices.push_back(v);
+}
+
+/***********************************************************
+ *  GeneratePlaneMesh()
+ *
+ *  This method is used for generating a flat plane facing up
+ *  that spans -1 to 1 on the X and Z axes at a height of 0.
+ ***********************************************************/
+void ShapeGeometry::GeneratePlaneMesh(MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddVertex(mesh, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+	AddVertex(mesh, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f);
+	AddVertex(mesh, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f);
+	AddVertex(mesh, -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f);
+
+	// two counter-clockwise triangles seen from above
+	mesh.indices.push_back(0);
+	mesh.indices.push_back(1);
+	mesh.indices.push_back(2);
+	mesh.indices.push_back(0);
+	mesh.indices.push_back(2);
+	mesh.indices.push_back(3);
+}
+
+/***********************************************************
+ *  GenerateBoxMesh()
+ *
+ *  This method is used for generating a box that is one unit
+ *  on each side and centered on the origin.  Each face has
+ *  its own four vertices so the normals and texture
+ *  coordinates are not shared between faces.
+ ***********************************************************/
+void ShapeGeometry::GenerateBoxMesh(MESH_DATA& mesh)
+{
+	// face normal followed by the two axes spanning the face
+	const float faces[6][9] =
+	{
+		// back
+		{ 0.0f, 0.0f, -1.0f,   -1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f },
+		// front
+		{ 0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 0.0f,    0.0f, 1.0f, 0.0f },
+		// left
+		{ -1.0f, 0.0f, 0.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.0f },
+		// right
+		{ 1.0f, 0.0f, 0.0f,    0.0f, 0.0f, -1.0f,   0.0f, 1.0f, 0.0f },
+		// bottom
+		{ 0.0f, -1.0f, 0.0f,   1.0f, 0.0f, 0.0f,    0.0f, 0.0f, 1.0f },
+		// top
+		{ 0.0f, 1.0f, 0.0f,    1.0f, 0.0f, 0.0f,    0.0f, 0.0f, -1.0f }
+	};
+	const float corners[4][2] =
+	{
+		{ -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f }
+	};
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	for (int face = 0; face < 6; face++)
+	{
+		const float* n = faces[face];
+		const float* s = faces[face] + 3;
+		const float* t = faces[face] + 6;
+		uint32_t baseIndex = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+		for (int corner = 0; corner < 4; corner++)
+		{
+			float a = corners[corner][0];
+			float b = corners[corner][1];
+
+			AddVertex(
+				mesh,
+				(n[0] * 0.5f) + (s[0] * a) + (t[0] * b),
+				(n[1] * 0.5f) + (s[1] * a) + (t[1] * b),
+				(n[2] * 0.5f) + (s[2] * a) + (t[2] * b),
+				n[0], n[1], n[2],
+				a + 0.5f, b + 0.5f);
+		}
+
+		// two counter-clockwise triangles per face
+		mesh.indices.push_back(baseIndex + 0);
+		mesh.indices.push_back(baseIndex + 1);
+		mesh.indices.push_back(baseIndex + 2);
+		mesh.indices.push_back(baseIndex + 0);
+		mesh.indices.push_back(baseIndex + 2);
+		mesh.indices.push_back(baseIndex + 3);
+	}
+}
+
+/***********************************************************
+ *  AppendSphere()
+ *
+ *  This method is used for appending a sphere made of rings
+ *  of vertices from the top pole down to the bottom pole.
+ *  The first and last vertex of a ring meet at the texture
+ *  seam, so each ring has one more vertex than slices.
+ ***********************************************************/
+void ShapeGeometry::AppendSphere(MESH_DATA& mesh, int slices, int stacks)
+{
+	const float pi = 3.14159265f;
+	const uint32_t ringSize = (uint32_t)slices + 1;
+	uint32_t baseIndex = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float phi = pi * stack / stacks;
+		float ringRadius = std::sin(phi);
+		float y = std::cos(phi);
+
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			float theta = 2.0f * pi * slice / slices;
+			float x = ringRadius * std::cos(theta);
+			float z = ringRadius * std::sin(theta);
+
+			AddVertex(
+				mesh,
+				x, y, z,
+				x, y, z,
+				(float)slice / slices, 1.0f - ((float)stack / stacks));
+		}
+	}
+
+	// two counter-clockwise triangles between each pair of rings
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int slice = 0; slice < slices; slice++)
+		{
+			uint32_t upper = baseIndex + ((uint32_t)stack * ringSize) + slice;
+			uint32_t lower = upper + ringSize;
+
+			mesh.indices.push_back(upper);
+			mesh.indices.push_back(upper + 1);
+			mesh.indices.push_back(lower);
+			mesh.indices.push_back(upper + 1);
+			mesh.indices.push_back(lower + 1);
+			mesh.indices.push_back(lower);
+		}
+	}
+}
+
+/***********************************************************
+ *  AppendCylinderSides()
+ *
+ *  This method is used for appending the sides of a cylinder
+ *  as one strip of quads around the Y axis.
+ ***********************************************************/
+void ShapeGeometry::AppendCylinderSides(MESH_DATA& mesh, int slices)
+{
+	const float pi = 3.14159265f;
+	uint32_t baseIndex = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float theta = 2.0f * pi * slice / slices;
+		float x = std::cos(theta);
+		float z = std::sin(theta);
+		float u = (float)slice / slices;
+
+		AddVertex(mesh, x, 0.0f, z, x, 0.0f, z, u, 0.0f);
+		AddVertex(mesh, x, 1.0f, z, x, 0.0f, z, u, 1.0f);
+	}
+
+	for (int slice = 0; slice < slices; slice++)
+	{
+		uint32_t bottom = baseIndex + ((uint32_t)slice * 2);
+
+		mesh.indices.push_back(bottom);
+		mesh.indices.push_back(bottom + 1);
+		mesh.indices.push_back(bottom + 2);
+		mesh.indices.push_back(bottom + 2);
+		mesh.indices.push_back(bottom + 1);
+		mesh.indices.push_back(bottom + 3);
+	}
+}
+
+/***********************************************************
+ *  AppendConeSides()
+ *
+ *  This method is used for appending the sides of a cone.
+ *  Each slice has its own tip vertex, so the normal at the
+ *  tip follows the middle of the slice instead of pointing
+ *  straight up.
+ ***********************************************************/
+void ShapeGeometry::AppendConeSides(MESH_DATA& mesh, int slices)
+{
+	const float pi = 3.14159265f;
+	// the slope is 45 degrees, since the radius and height are 1
+	const float normalScale = 1.0f / std::sqrt(2.0f);
+	uint32_t baseIndex = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float theta = 2.0f * pi * slice / slices;
+		float tipTheta = 2.0f * pi * (slice + 0.5f) / slices;
+		float x = std::cos(theta);
+		float z = std::sin(theta);
+
+		AddVertex(
+			mesh,
+			x, 0.0f, z,
+			x * normalScale, normalScale, z * normalScale,
+			(float)slice / slices, 0.0f);
+		AddVertex(
+			mesh,
+			0.0f, 1.0f, 0.0f,
+			std::cos(tipTheta) * normalScale, normalScale, std::sin(tipTheta) * normalScale,
+			(slice + 0.5f) / slices, 1.0f);
+	}
+
+	for (int slice = 0; slice < slices; slice++)
+	{
+		uint32_t bottom = baseIndex + ((uint32_t)slice * 2);
+
+		mesh.indices.push_back(bottom);
+		mesh.indices.push_back(bottom + 1);
+		mesh.indices.push_back(bottom + 2);
+	}
+}
+
+/***********************************************************
+ *  AppendDisc()
+ *
+ *  This method is used for appending a flat disc as a fan of
+ *  triangles around a center vertex.  The winding follows the
+ *  facing, so the disc is counter-clockwise from the side it
+ *  faces.
+ ***********************************************************/
+void ShapeGeometry::AppendDisc(MESH_DATA& mesh, int slices, float height, bool bFacingUp)
+{
+	const float pi = 3.14159265f;
+	float normalY = bFacingUp ? 1.0f : -1.0f;
+	uint32_t baseIndex = (uint32_t)(mesh.vertices.size() / FLOATS_PER_VERTEX);
+
+	AddVertex(mesh, 0.0f, height, 0.0f, 0.0f, normalY, 0.0f, 0.5f, 0.5f);
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float theta = 2.0f * pi * slice / slices;
+		float x = std::cos(theta);
+		float z = std::sin(theta);
+
+		AddVertex(
+			mesh,
+			x, height, z,
+			0.0f, normalY, 0.0f,
+			0.5f + (x * 0.5f), 0.5f + (z * 0.5f));
+	}
+
+	for (int slice = 0; slice < slices; slice++)
+	{
+		uint32_t ring = baseIndex + 1 + (uint32_t)slice;
+
+		mesh.indices.push_back(baseIndex);
+		mesh.indices.push_back(bFacingUp ? ring + 1 : ring);
+		mesh.indices.push_back(bFacingUp ? ring : ring + 1);
+	}
+}
+
+/***********************************************************
+ *  WriteTransformedMesh()
+ *
+ *  This method is used for writing a copy of the source mesh
+ *  in world space.  The positions are moved by the model
+ *  matrix and the normals by its inverse transpose, so they
+ *  stay at right angles to scaled surfaces.  The indices are
+ *  moved past the passed in first vertex.  The loop only
+ *  reads and writes plain floats, so the compiler can
+ *  vectorize it.
+ ***********************************************************/
+void ShapeGeometry::WriteTransformedMesh(
+	const MESH_DATA& source,
+	const glm::mat4& model,
+	glm::vec2 uvScale,
+	float* pVertices,
+	uint32_t* pIndices,
+	uint32_t firstVertex)
+{
+	const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+	const float* pSource = source.vertices.data();
+
+	for (size_t i = 0; i < source.vertices.size(); i += FLOATS_PER_VERTEX)
+	{
+		glm::vec3 position = glm::vec3(model * glm::vec4(pSource[i], pSource[i + 1], pSource[i + 2], 1.0f));
+		glm::vec3 normal = normalMatrix * glm::vec3(pSource[i + 3], pSource[i + 4], pSource[i + 5]);
+		float normalLength = glm::length(normal);
+		if (normalLength > 0.0f)
+		{
+			normal /= normalLength;
+		}
+
+		pVertices[i] = position.x;
+		pVertices[i + 1] = position.y;
+		pVertices[i + 2] = position.z;
+		pVertices[i + 3] = normal.x;
+		pVertices[i + 4] = normal.y;
+		pVertices[i + 5] = normal.z;
+		pVertices[i + 6] = pSource[i + 6] * uvScale.x;
+		pVertices[i + 7] = pSource[i + 7] * uvScale.y;
+	}
+
+	for (size_t i = 0; i < source.indices.size(); i++)
+	{
+		pIndices[i] = source.indices[i] + firstVertex;
+	}
+}
+
+/***********************************************************
+ *  TransformPositions()
+ *
+ *  This method is used for moving the positions of the source
+ *  mesh by a model matrix into a packed array.  The matrix is
+ *  read into plain floats first and the bottom row is left
+ *  out, since the model matrices have no projection, so the
+ *  loop has nothing in it that keeps the compiler from
+ *  vectorizing it.
+ ***********************************************************/
+void ShapeGeometry::TransformPositions(
+	const MESH_DATA& source,
+	const glm::mat4& model,
+	std::vector<float>& positions)
+{
+	const size_t vertexCount = source.vertices.size() / FLOATS_PER_VERTEX;
+	const float m00 = model[0][0], m01 = model[0][1], m02 = model[0][2];
+	const float m10 = model[1][0], m11 = model[1][1], m12 = model[1][2];
+	const float m20 = model[2][0], m21 = model[2][1], m22 = model[2][2];
+	const float m30 = model[3][0], m31 = model[3][1], m32 = model[3][2];
+
+	positions.resize(vertexCount * 3);
+	const float* pSource = source.vertices.data();
+	float* pTarget = positions.data();
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const float x = pSource[i * FLOATS_PER_VERTEX];
+		const float y = pSource[(i * FLOATS_PER_VERTEX) + 1];
+		const float z = pSource[(i * FLOATS_PER_VERTEX) + 2];
+
+		pTarget[i * 3] = (m00 * x) + (m10 * y) + (m20 * z) + m30;
+		pTarget[(i * 3) + 1] = (m01 * x) + (m11 * y) + (m21 * z) + m31;
+		pTarget[(i * 3) + 2] = (m02 * x) + (m12 * y) + (m22 * z) + m32;
+	}
+}
+
+/***********************************************************
+ *  MakeBounds()
+ *
+ *  This function is used for building a bounds value from
+ *  its minimum and maximum corners.
+ ***********************************************************/
+static ShapeGeometry::BOUNDS MakeBounds(glm::vec3 minimum, glm::vec3 maximum)
+{
+	ShapeGeometry::BOUNDS bounds;
+
+	bounds.minimum = minimum;
+	bounds.maximum = maximum;
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  GetPlaneBounds()
+ *
+ *  This method is used for getting the bounds of the plane,
+ *  which spans -1 to 1 on the X and Z axes at a height of 0.
+ ***********************************************************/
+ShapeGeometry::BOUNDS ShapeGeometry::GetPlaneBounds()
+{
+	return(MakeBounds(glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 1.0f)));
+}
+
+/***********************************************************
+ *  GetBoxBounds()
+ *
+ *  This method is used for getting the bounds of the box,
+ *  which is one unit on each side centered on the origin.
+ ***********************************************************/
+ShapeGeometry::BOUNDS ShapeGeometry::GetBoxBounds()
+{
+	return(MakeBounds(glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, 0.5f, 0.5f)));
+}
+
+/***********************************************************
+ *  GetConeBounds()
+ *
+ *  This method is used for getting the bounds of the cone,
+ *  which has a base of radius 1 at a height of 0 and its tip
+ *  at a height of 1.
+ ***********************************************************/
+ShapeGeometry::BOUNDS ShapeGeometry::GetConeBounds()
+{
+	return(MakeBounds(glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+}
+
+/***********************************************************
+ *  GetCylinderBounds()
+ *
+ *  This method is used for getting the bounds of the
+ *  cylinder, which has a radius of 1 and runs from a height
+ *  of 0 up to a height of 1.
+ ***********************************************************/
+ShapeGeometry::BOUNDS ShapeGeometry::GetCylinderBounds()
+{
+	return(MakeBounds(glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+}
+
+/***********************************************************
+ *  GetSphereBounds()
+ *
+ *  This method is used for getting the bounds of the sphere,
+ *  which has a radius of 1 centered on the origin.
+ ***********************************************************/
+ShapeGeometry::BOUNDS ShapeGeometry::GetSphereBounds()
+{
+	return(MakeBounds(glm::vec3(-1.0f, -1.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+}
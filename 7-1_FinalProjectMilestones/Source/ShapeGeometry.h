@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapegeometry.h
+// ============
+// generate the CPU side vertex and index data for the basic 3D shapes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  ShapeGeometry
+ *
+ *  This class generates interleaved vertex data (position,
+ *  normal, texture coordinate) and triangle indices for the
+ *  basic 3D shapes.  The shapes use the same dimensions as
+ *  the meshes drawn by ShapeMeshes.
+ ***********************************************************/
+class ShapeGeometry
+{
+public:
+	// number of floats per interleaved vertex
+	static const int FLOATS_PER_VERTEX = 8;
+
+	struct MESH_DATA
+	{
+		// position (3), normal (3), texture coordinate (2)
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// local space axis aligned bounding box of a shape
+	struct BOUNDS
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// generate a plane from -1 to 1 on the X and Z axes
+	static void GeneratePlaneMesh(MESH_DATA& mesh);
+	// generate a unit box centered on the origin
+	static void GenerateBoxMesh(MESH_DATA& mesh);
+
+	// the curved shape parts below are appended to the mesh
+	// data, so several shapes can share one set of buffers
+
+	// append a sphere with a radius of 1 centered on the origin
+	static void AppendSphere(MESH_DATA& mesh, int slices, int stacks);
+	// append the sides of a cylinder with a radius of 1, from
+	// a height of 0 up to 1
+	static void AppendCylinderSides(MESH_DATA& mesh, int slices);
+	// append the sides of a cone with a radius of 1 at a height
+	// of 0 and its tip at a height of 1
+	static void AppendConeSides(MESH_DATA& mesh, int slices);
+	// append a disc with a radius of 1 at the passed in height
+	static void AppendDisc(MESH_DATA& mesh, int slices, float height, bool bFacingUp);
+
+	// write a copy of the source mesh moved into world space by
+	// the passed in model matrix, with its texture coordinates
+	// scaled, into room already made for it - the indices are
+	// moved past the passed in first vertex, so several copies
+	// can be written into one mesh in parallel, such as for
+	// baking static objects
+	static void WriteTransformedMesh(
+		const MESH_DATA& source,
+		const glm::mat4& model,
+		glm::vec2 uvScale,
+		float* pVertices,
+		uint32_t* pIndices,
+		uint32_t firstVertex);
+	// move only the positions of the source mesh by the passed
+	// in model matrix, three floats per vertex, such as for
+	// exporting the scene
+	static void TransformPositions(
+		const MESH_DATA& source,
+		const glm::mat4& model,
+		std::vector<float>& positions);
+
+	// get the local space bounds of the basic shapes
+	static BOUNDS GetPlaneBounds();
+	static BOUNDS GetBoxBounds();
+	static BOUNDS GetConeBounds();
+	static BOUNDS GetCylinderBounds();
+	static BOUNDS GetSphereBounds();
+
+private:
+	// append one interleaved vertex to the mesh data
+	static void AddVertex(
+		MESH_DATA& mesh,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v);
+};
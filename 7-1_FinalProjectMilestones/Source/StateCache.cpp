@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+// statecache.cpp
+// ============
+// filter out redundant OpenGL state changes and uniform uploads
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StateCache.h"
+
+#include <cstring>
+
+/***********************************************************
+ *  StateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StateCache::StateCache()
+{
+	m_issuedCount = 0;
+	m_filteredCount = 0;
+	m_frameIssuedCount = 0;
+	m_frameFilteredCount = 0;
+	m_frameUniformCount = 0;
+	m_frameDrawCount = 0;
+
+	Invalidate();
+}
+
+/***********************************************************
+ *  ~StateCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StateCache::~StateCache()
+{
+	m_capabilities.clear();
+	m_uniformShadows.clear();
+}
+
+/***********************************************************
+ *  CountIssued() / CountFiltered()
+ *
+ *  These methods are used for counting the calls that were
+ *  passed on to OpenGL and the calls that were filtered out.
+ ***********************************************************/
+void StateCache::CountIssued()
+{
+	m_issuedCount++;
+	m_frameIssuedCount++;
+}
+
+void StateCache::CountFiltered()
+{
+	m_filteredCount++;
+	m_frameFilteredCount++;
+}
+
+/***********************************************************
+ *  CountDrawCalls()
+ *
+ *  This method is used for counting the draw calls of the
+ *  frame, which are made without going through this object.
+ ***********************************************************/
+void StateCache::CountDrawCalls(unsigned int drawCount)
+{
+	m_frameDrawCount += drawCount;
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making the passed in shader
+ *  program current, unless it is already in use.
+ ***********************************************************/
+void StateCache::UseProgram(GLuint programID)
+{
+	if ((m_bProgramValid == true) && (m_currentProgram == programID))
+	{
+		CountFiltered();
+		return;
+	}
+
+	glUseProgram(programID);
+	m_currentProgram = programID;
+	m_bProgramValid = true;
+	CountIssued();
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding the passed in texture to
+ *  a texture unit.  The active texture unit is only changed
+ *  when the binding itself has to change.
+ ***********************************************************/
+void StateCache::BindTexture(GLuint unit, GLenum target, GLuint textureID)
+{
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		const TEXTURE_BINDING& binding = m_textureBindings[unit];
+		if ((binding.bValid == true) && (binding.target == target) && (binding.textureID == textureID))
+		{
+			CountFiltered();
+			return;
+		}
+	}
+
+	if ((m_bActiveTextureValid == false) || (m_activeTextureUnit != unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeTextureUnit = unit;
+		m_bActiveTextureValid = true;
+		CountIssued();
+	}
+
+	glBindTexture(target, textureID);
+	CountIssued();
+
+	if (unit < MAX_TEXTURE_UNITS)
+	{
+		m_textureBindings[unit].target = target;
+		m_textureBindings[unit].textureID = textureID;
+		m_textureBindings[unit].bValid = true;
+	}
+}
+
+/***********************************************************
+ *  SetCapability()
+ *
+ *  This method is used for enabling or disabling an OpenGL
+ *  capability when it differs from the shadowed enable bit.
+ ***********************************************************/
+void StateCache::SetCapability(GLenum capability, bool bEnabled)
+{
+	std::unordered_map<GLenum, bool>::iterator found = m_capabilities.find(capability);
+	if ((found != m_capabilities.end()) && (found->second == bEnabled))
+	{
+		CountFiltered();
+		return;
+	}
+
+	if (bEnabled == true)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	m_capabilities[capability] = bEnabled;
+	CountIssued();
+}
+
+void StateCache::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+void StateCache::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+/***********************************************************
+ *  FilterUniform()
+ *
+ *  This method is used for checking a uniform value against
+ *  its shadow copy.  Uploads to a location of -1 are always
+ *  filtered since OpenGL ignores them.
+ ***********************************************************/
+bool StateCache::FilterUniform(
+	GLuint programID,
+	GLint location,
+	const void* pValue,
+	size_t valueSize)
+{
+	if (location < 0)
+	{
+		CountFiltered();
+		return(true);
+	}
+
+	// values that are too large are never shadowed
+	if (valueSize > MAX_UNIFORM_SIZE)
+	{
+		CountIssued();
+		m_frameUniformCount++;
+		return(false);
+	}
+
+	std::vector<UNIFORM_SHADOW>& shadows = m_uniformShadows[programID];
+	if (location >= (GLint)shadows.size())
+	{
+		UNIFORM_SHADOW emptyShadow;
+		emptyShadow.valueSize = 0;
+		emptyShadow.bValid = false;
+		shadows.resize(location + 1, emptyShadow);
+	}
+
+	UNIFORM_SHADOW& shadow = shadows[location];
+	if ((shadow.bValid == true) &&
+		(shadow.valueSize == valueSize) &&
+		(memcmp(shadow.value, pValue, valueSize) == 0))
+	{
+		CountFiltered();
+		return(true);
+	}
+
+	memcpy(shadow.value, pValue, valueSize);
+	shadow.valueSize = valueSize;
+	shadow.bValid = true;
+	CountIssued();
+	m_frameUniformCount++;
+
+	return(false);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all of the shadowed
+ *  state so the next change of each kind reaches OpenGL.
+ ***********************************************************/
+void StateCache::Invalidate()
+{
+	m_currentProgram = 0;
+	m_bProgramValid = false;
+	m_activeTextureUnit = 0;
+	m_bActiveTextureValid = false;
+	for (GLuint i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_textureBindings[i].target = 0;
+		m_textureBindings[i].textureID = 0;
+		m_textureBindings[i].bValid = false;
+	}
+	m_capabilities.clear();
+	m_uniformShadows.clear();
+}
+
+/***********************************************************
+ *  ForgetTexture()
+ *
+ *  This method is used for dropping the shadowed bindings of
+ *  a texture, so a new texture that reuses its name is bound.
+ ***********************************************************/
+void StateCache::ForgetTexture(GLuint textureID)
+{
+	for (GLuint i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (m_textureBindings[i].textureID == textureID)
+		{
+			m_textureBindings[i].bValid = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  ResetFrameCounters()
+ *
+ *  This method is used for starting the per-frame call
+ *  counters over at the beginning of a frame.
+ ***********************************************************/
+void StateCache::ResetFrameCounters()
+{
+	m_frameIssuedCount = 0;
+	m_frameFilteredCount = 0;
+	m_frameUniformCount = 0;
+	m_frameDrawCount = 0;
+}
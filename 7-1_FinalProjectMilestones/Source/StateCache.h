@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// statecache.h
+// ============
+// filter out redundant OpenGL state changes and uniform uploads
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  StateCache
+ *
+ *  This class shadows the OpenGL state that the scene changes
+ *  most often - the program in use, the bound textures, the
+ *  enable bits and the uniform values.  A change is only
+ *  passed on to OpenGL when it differs from the shadow copy.
+ ***********************************************************/
+class StateCache
+{
+public:
+	// constructor
+	StateCache();
+	// destructor
+	~StateCache();
+
+	// use the passed in shader program
+	void UseProgram(GLuint programID);
+	// bind the passed in texture to a texture unit
+	void BindTexture(GLuint unit, GLenum target, GLuint textureID);
+	// enable or disable an OpenGL capability
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+
+	// check a uniform value against its shadow copy - returns
+	// true when the upload can be skipped, otherwise the shadow
+	// copy is updated and false is returned
+	bool FilterUniform(
+		GLuint programID,
+		GLint location,
+		const void* pValue,
+		size_t valueSize);
+
+	// forget all shadowed state, such as after OpenGL calls
+	// were made without going through this object
+	void Invalidate();
+	// forget the shadowed texture binding of a deleted texture
+	void ForgetTexture(GLuint textureID);
+
+	// start counting the calls for a new frame
+	void ResetFrameCounters();
+	// number of calls passed on to OpenGL
+	unsigned long long GetIssuedCount() const { return(m_issuedCount); }
+	// number of redundant calls that were filtered out
+	unsigned long long GetFilteredCount() const { return(m_filteredCount); }
+	unsigned int GetFrameIssuedCount() const { return(m_frameIssuedCount); }
+	unsigned int GetFrameFilteredCount() const { return(m_frameFilteredCount); }
+	// the calls of the frame that were passed on, split into
+	// uniform uploads and state changes
+	unsigned int GetFrameUniformCount() const { return(m_frameUniformCount); }
+	unsigned int GetFrameStateChangeCount() const { return(m_frameIssuedCount - m_frameUniformCount); }
+
+	// count draw calls that were made for the frame
+	void CountDrawCalls(unsigned int drawCount);
+	unsigned int GetFrameDrawCount() const { return(m_frameDrawCount); }
+
+private:
+	// the most texture units that are shadowed
+	static const GLuint MAX_TEXTURE_UNITS = 32;
+	// the largest uniform value that is shadowed (a mat4)
+	static const size_t MAX_UNIFORM_SIZE = 64;
+
+	struct TEXTURE_BINDING
+	{
+		GLenum target;
+		GLuint textureID;
+		bool bValid;
+	};
+
+	struct UNIFORM_SHADOW
+	{
+		unsigned char value[MAX_UNIFORM_SIZE];
+		size_t valueSize;
+		bool bValid;
+	};
+
+	// shadowed program in use
+	GLuint m_currentProgram;
+	bool m_bProgramValid;
+	// shadowed active texture unit
+	GLuint m_activeTextureUnit;
+	bool m_bActiveTextureValid;
+	// shadowed texture bindings per texture unit
+	TEXTURE_BINDING m_textureBindings[MAX_TEXTURE_UNITS];
+	// shadowed enable bits keyed by capability
+	std::unordered_map<GLenum, bool> m_capabilities;
+	// shadowed uniform values per program, indexed by location
+	std::unordered_map<GLuint, std::vector<UNIFORM_SHADOW> > m_uniformShadows;
+
+	// call counters
+	unsigned long long m_issuedCount;
+	unsigned long long m_filteredCount;
+	unsigned int m_frameIssuedCount;
+	unsigned int m_frameFilteredCount;
+	unsigned int m_frameUniformCount;
+	unsigned int m_frameDrawCount;
+
+	// count a call that was passed on or filtered out
+	void CountIssued();
+	void CountFiltered();
+	// set an enable bit when it differs from the shadow copy
+	void SetCapability(GLenum capability, bool bEnabled);
+};
@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.cpp
+// ============
+// persistently mapped ring buffer that the per-frame dynamic data is copied
+// into, with a fence guarding each frame's region
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StreamBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000;
+}
+
+/***********************************************************
+ *  StreamBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StreamBuffer::StreamBuffer()
+{
+	m_buffer = 0;
+	m_pMapped = NULL;
+	m_regionSize = 0;
+	m_region = 0;
+	m_regionOffset = 0;
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	m_uniformAlignment = 256;
+	m_storageAlignment = 256;
+	m_stallCount = 0;
+	m_bFullReported = false;
+}
+
+/***********************************************************
+ *  ~StreamBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StreamBuffer::~StreamBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer with room for
+ *  every region and mapping it once.  The coherent mapping
+ *  makes the writes visible to the GPU without any flushes.
+ ***********************************************************/
+bool StreamBuffer::Create(size_t regionSize)
+{
+	Destroy();
+
+	if ((GLEW_VERSION_4_4 == false) && (GLEW_ARB_buffer_storage == false))
+	{
+		std::cout << "Persistent buffer mapping is not supported, the stream buffer is off" << std::endl;
+		return(false);
+	}
+
+	const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_storageAlignment);
+
+	// every region starts on a boundary that suits any binding
+	size_t regionAlignment = 256;
+	m_regionSize = ((regionSize + regionAlignment - 1) / regionAlignment) * regionAlignment;
+
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferStorage(m_buffer, (GLsizeiptr)(m_regionSize * REGION_COUNT), NULL, mapFlags);
+	m_pMapped = (unsigned char*)glMapNamedBufferRange(m_buffer, 0, (GLsizeiptr)(m_regionSize * REGION_COUNT), mapFlags);
+	if (NULL == m_pMapped)
+	{
+		std::cout << "Could not map the stream buffer" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_region = 0;
+	m_regionOffset = 0;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for unmapping and freeing the buffer
+ *  and the fences.
+ ***********************************************************/
+void StreamBuffer::Destroy()
+{
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+
+	if (m_buffer != 0)
+	{
+		if (NULL != m_pMapped)
+		{
+			glUnmapNamedBuffer(m_buffer);
+		}
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_pMapped = NULL;
+	m_regionSize = 0;
+	m_regionOffset = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the next region.  When
+ *  the GPU has not yet passed the fence of the frame that
+ *  last used the region, which only happens when it is more
+ *  frames behind than there are regions, the method waits.
+ ***********************************************************/
+void StreamBuffer::BeginFrame()
+{
+	if (NULL == m_pMapped)
+	{
+		return;
+	}
+
+	m_region = (m_region + 1) % REGION_COUNT;
+	m_regionOffset = 0;
+	m_bFullReported = false;
+
+	GLsync fence = m_fences[m_region];
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	GLenum waitResult = glClientWaitSync(fence, 0, 0);
+	if (waitResult == GL_TIMEOUT_EXPIRED)
+	{
+		m_stallCount++;
+		do
+		{
+			waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+		} while (waitResult == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	m_fences[m_region] = NULL;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence that guards the
+ *  region of the frame after the frame's draws.
+ ***********************************************************/
+void StreamBuffer::EndFrame()
+{
+	if (NULL == m_pMapped)
+	{
+		return;
+	}
+
+	if (NULL != m_fences[m_region])
+	{
+		glDeleteSync(m_fences[m_region]);
+	}
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for taking the next aligned part of
+ *  the current region.  Nothing is freed during the frame -
+ *  the whole region is reused when its fence has passed.
+ ***********************************************************/
+StreamBuffer::STREAM_ALLOCATION StreamBuffer::Allocate(size_t size, size_t alignment)
+{
+	STREAM_ALLOCATION allocation;
+	allocation.pData = NULL;
+	allocation.offset = 0;
+	allocation.size = 0;
+
+	if ((NULL == m_pMapped) || (size == 0))
+	{
+		return(allocation);
+	}
+
+	if (alignment < 4)
+	{
+		alignment = 4;
+	}
+
+	size_t start = ((m_regionOffset + alignment - 1) / alignment) * alignment;
+	if (start + size > m_regionSize)
+	{
+		if (m_bFullReported == false)
+		{
+			std::cout << "The stream buffer region is full, " << size << " bytes go through the fallback" << std::endl;
+			m_bFullReported = true;
+		}
+		return(allocation);
+	}
+
+	m_regionOffset = start + size;
+
+	size_t bufferOffset = ((size_t)m_region * m_regionSize) + start;
+	allocation.pData = m_pMapped + bufferOffset;
+	allocation.offset = (GLintptr)bufferOffset;
+	allocation.size = (GLsizeiptr)size;
+
+	return(allocation);
+}
+
+/***********************************************************
+ *  UploadAndBind()
+ *
+ *  This method is used for copying data into the current
+ *  region at the offset alignment of the passed in binding
+ *  target and binding the copy to an indexed binding point.
+ ***********************************************************/
+bool StreamBuffer::UploadAndBind(GLenum target, GLuint binding, const void* pData, size_t size)
+{
+	STREAM_ALLOCATION allocation = Allocate(size, GetOffsetAlignment(target));
+	if (NULL == allocation.pData)
+	{
+		return(false);
+	}
+
+	memcpy(allocation.pData, pData, size);
+	glBindBufferRange(target, binding, m_buffer, allocation.offset, allocation.size);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetOffsetAlignment()
+ *
+ *  This method is used for getting the offset alignment that
+ *  the passed in indexed binding target needs.
+ ***********************************************************/
+size_t StreamBuffer::GetOffsetAlignment(GLenum target) const
+{
+	if (target == GL_UNIFORM_BUFFER)
+	{
+		return((size_t)m_uniformAlignment);
+	}
+
+	return((size_t)m_storageAlignment);
+}
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.h
+// ============
+// persistently mapped ring buffer that the per-frame dynamic data is copied
+// into, with a fence guarding each frame's region
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  StreamBuffer
+ *
+ *  This class owns one buffer that stays mapped for its whole
+ *  life and is split into a region for each of the frames in
+ *  flight.  The data of a frame is bump allocated from its
+ *  region and written with a plain memcpy, and a fence is
+ *  placed after the frame's draws.  A region is only reused
+ *  after the fence of the frame that last used it has been
+ *  passed, so writes never touch data the GPU still reads
+ *  and no upload makes the driver wait on the GPU.
+ ***********************************************************/
+class StreamBuffer
+{
+public:
+	// constructor
+	StreamBuffer();
+	// destructor
+	~StreamBuffer();
+
+	// number of frames whose regions can be in flight
+	static const int REGION_COUNT = 3;
+
+	// part of the current region handed out by Allocate()
+	struct STREAM_ALLOCATION
+	{
+		// mapped memory to write the data into
+		void* pData;
+		// offset from the start of the buffer, for binding
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	// create and map the buffer with the passed in size of
+	// each region - returns false when the context has no
+	// persistent mapping, so callers keep their own buffers
+	bool Create(size_t regionSize);
+	// unmap and free the buffer
+	void Destroy();
+	bool IsCreated() const { return(NULL != m_pMapped); }
+
+	// move to the region of a new frame, waiting for its fence
+	// when the GPU is still reading it
+	void BeginFrame();
+	// fence the region of the frame after its last draw
+	void EndFrame();
+
+	// take an aligned part of the current region - the pData
+	// member is NULL when the region is full
+	STREAM_ALLOCATION Allocate(size_t size, size_t alignment);
+	// copy data into the current region and bind it to an
+	// indexed uniform or shader storage binding - returns false
+	// when the region is full
+	bool UploadAndBind(GLenum target, GLuint binding, const void* pData, size_t size);
+
+	// get the offset alignment of an indexed binding target
+	size_t GetOffsetAlignment(GLenum target) const;
+
+	GLuint GetBuffer() const { return(m_buffer); }
+	// bytes used from the current region
+	size_t GetUsedSize() const { return(m_regionOffset); }
+	// number of frames that had to wait for their region
+	unsigned int GetStallCount() const { return(m_stallCount); }
+
+private:
+	GLuint m_buffer;
+	unsigned char* m_pMapped;
+	size_t m_regionSize;
+	// region of the current frame and the next free byte in it
+	int m_region;
+	size_t m_regionOffset;
+	// fence of the frame that last used each region
+	GLsync m_fences[REGION_COUNT];
+	// offset alignments of the indexed buffer bindings
+	GLint m_uniformAlignment;
+	GLint m_storageAlignment;
+	unsigned int m_stallCount;
+	// true when the region that was full has been reported
+	bool m_bFullReported;
+};
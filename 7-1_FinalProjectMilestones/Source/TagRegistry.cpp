@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.cpp
+// ============
+// intern tag strings into integer ids for constant time lookups
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TagRegistry.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for interning a tag.  A new tag gets
+ *  the next consecutive id.  Two different tags with the same
+ *  hash cannot both be registered.
+ ***********************************************************/
+int TagRegistry::Register(const std::string& tag)
+{
+	TAG_HASH hash = HashTag(tag.c_str());
+
+	std::unordered_map<TAG_HASH, int>::const_iterator found = m_ids.find(hash);
+	if (found != m_ids.end())
+	{
+		if (m_tags[found->second].compare(tag) != 0)
+		{
+			std::cout << "Tag " << tag << " has the same hash as " << m_tags[found->second] << std::endl;
+			return(-1);
+		}
+		return(found->second);
+	}
+
+	int id = (int)m_tags.size();
+	m_tags.push_back(tag);
+	m_ids[hash] = id;
+
+	return(id);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the id of a registered
+ *  tag from its hash.
+ ***********************************************************/
+int TagRegistry::Find(TAG_HASH hash) const
+{
+	std::unordered_map<TAG_HASH, int>::const_iterator found = m_ids.find(hash);
+	if (found == m_ids.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all registered tags.
+ ***********************************************************/
+void TagRegistry::Clear()
+{
+	m_tags.clear();
+	m_ids.clear();
+}
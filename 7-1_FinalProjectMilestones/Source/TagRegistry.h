@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// tagregistry.h
+// ============
+// intern tag strings into integer ids for constant time lookups
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TagRegistry
+ *
+ *  This class interns tag strings into consecutive integer
+ *  ids, so the objects a tag names can be stored in a flat
+ *  array indexed by the id.  Tags are found by their FNV-1a
+ *  hash, which is computed at compile time for string
+ *  literals through HashTag().
+ ***********************************************************/
+class TagRegistry
+{
+public:
+	typedef uint32_t TAG_HASH;
+
+	// FNV-1a hash of a tag - usable in constant expressions
+	static constexpr TAG_HASH HashTag(const char* tag)
+	{
+		TAG_HASH hash = 2166136261u;
+		while (*tag != '\0')
+		{
+			hash = (hash ^ (TAG_HASH)(unsigned char)*tag) * 16777619u;
+			tag++;
+		}
+		return(hash);
+	}
+
+	// intern a tag - returns its id, the existing id when the
+	// tag is already registered, or -1 on a hash collision
+	int Register(const std::string& tag);
+	// get the id of a registered tag, or -1 when not found
+	int Find(TAG_HASH hash) const;
+	int Find(const char* tag) const { return(Find(HashTag(tag))); }
+
+	// get the tag string of an id
+	const std::string& GetTag(int id) const { return(m_tags[id]); }
+	int GetCount() const { return((int)m_tags.size()); }
+	// remove all registered tags
+	void Clear();
+
+private:
+	// registered tags indexed by id
+	std::vector<std::string> m_tags;
+	// ids keyed by tag hash
+	std::unordered_map<TAG_HASH, int> m_ids;
+};
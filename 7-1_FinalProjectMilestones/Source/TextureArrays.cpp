@@ -0,0 +1,638 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// pack the scene textures into layers of 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// texture unit reserved for uploads and packing - the
+	// arrays use the units below it
+	const GLuint g_PackTextureUnit = 31;
+	// the most texture arrays, one per texture unit
+	const int g_MaxArrays = 16;
+	// number of layers allocated for each texture array
+	const int g_LayersPerArray = 16;
+	// color of the placeholder shown until a texture is packed
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+
+	// get the size of one mip level, which stops at one texel
+	int GetLevelSize(int size, int level)
+	{
+		size >>= level;
+		return((size > 1) ? size : 1);
+	}
+
+	// get the bytes one layer of a mip level takes - the block
+	// compressed formats store 4x4 texel blocks, and drivers pad
+	// the 24 bit format out to 32 bits
+	size_t GetLevelBytes(GLenum internalFormat, int width, int height)
+	{
+		size_t blocks = (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4);
+
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			return(blocks * 8);
+		case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return(blocks * 16);
+		default:
+			return((size_t)width * (size_t)height * 4);
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_startSize = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the placeholder array.
+ *  It holds a single gray layer that every texture is drawn
+ *  with until it has been loaded and packed.
+ ***********************************************************/
+void TextureArrays::Initialize()
+{
+	if (m_arrays.size() > 0)
+	{
+		return;
+	}
+
+	ARRAY_INFO placeholder;
+	placeholder.internalFormat = GL_RGBA8;
+	placeholder.width = 1;
+	placeholder.height = 1;
+	placeholder.levels = 1;
+	placeholder.layerCount = 1;
+	placeholder.layerCapacity = 1;
+	placeholder.storageLevel = 0;
+	placeholder.residentLevel = 0;
+	placeholder.pendingLayers = 0;
+
+	glGenTextures(1, &placeholder.textureID);
+	BindForPacking(GL_TEXTURE_2D_ARRAY, placeholder.textureID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, 1, 1, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+
+	m_arrays.push_back(placeholder);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for registering a texture that is
+ *  still being loaded.  It samples the placeholder array
+ *  until PackTextures() is passed its texture ID.
+ ***********************************************************/
+int TextureArrays::AddTexture(GLuint textureID)
+{
+	TEXTURE_ENTRY entry;
+
+	Initialize();
+
+	entry.sourceID = textureID;
+	entry.location.arrayIndex = 0;
+	entry.location.layer = 0;
+	entry.bRestream = false;
+	m_textures.push_back(entry);
+
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  PackTextures()
+ *
+ *  This method is used for copying the passed in loaded
+ *  textures into array layers.  Textures that were not
+ *  registered are ignored.  Reloaded images only fill in the
+ *  levels of their layer and are not counted, since the
+ *  texture keeps its layer.
+ ***********************************************************/
+int TextureArrays::PackTextures(const std::vector<GLuint>& textureIDs)
+{
+	int packedCount = 0;
+
+	for (size_t i = 0; i < textureIDs.size(); i++)
+	{
+		for (size_t j = 0; j < m_textures.size(); j++)
+		{
+			if (m_textures[j].sourceID != textureIDs[i])
+			{
+				continue;
+			}
+
+			if (m_textures[j].bRestream == true)
+			{
+				RestreamTexture(m_textures[j]);
+			}
+			else if (PackTexture(m_textures[j]) == true)
+			{
+				packedCount++;
+			}
+		}
+	}
+
+	return(packedCount);
+}
+
+/***********************************************************
+ *  PackTexture()
+ *
+ *  This method is used for copying the stored mip levels of
+ *  a loaded texture into a free layer of the array that
+ *  matches its size and format.  The copy stays on the GPU,
+ *  so compressed textures are copied without decoding.
+ ***********************************************************/
+bool TextureArrays::PackTexture(TEXTURE_ENTRY& entry)
+{
+	GLint width = 0;
+	GLint height = 0;
+	GLint internalFormat = 0;
+	int levels = 1;
+
+	BindForPacking(GL_TEXTURE_2D, entry.sourceID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	// the loaded textures have a complete mip chain
+	int largest = (width > height) ? width : height;
+	while (largest > 1)
+	{
+		largest /= 2;
+		levels++;
+	}
+
+	int arrayIndex = FindArray((GLenum)internalFormat, width, height, levels);
+	if (arrayIndex < 0)
+	{
+		std::cout << "Could not pack texture, all texture array units are in use" << std::endl;
+		return(false);
+	}
+
+	ARRAY_INFO& array = m_arrays[arrayIndex];
+	int layer = array.layerCount;
+	for (int level = array.storageLevel; level < levels; level++)
+	{
+		glCopyImageSubData(
+			entry.sourceID, GL_TEXTURE_2D, level, 0, 0, 0,
+			array.textureID, GL_TEXTURE_2D_ARRAY, level - array.storageLevel, 0, 0, layer,
+			GetLevelSize(width, level), GetLevelSize(height, level), 1);
+	}
+	array.layerCount++;
+
+	// the source texture is no longer needed
+	DeleteSource(entry);
+	entry.location.arrayIndex = arrayIndex;
+	entry.location.layer = layer;
+
+	return(true);
+}
+
+/***********************************************************
+ *  RestreamTexture()
+ *
+ *  This method is used for copying the levels that the layer
+ *  of a packed texture is missing out of its reloaded image.
+ *  Once the last layer of the array has them, the base level
+ *  moves back to the storage level.
+ ***********************************************************/
+void TextureArrays::RestreamTexture(TEXTURE_ENTRY& entry)
+{
+	ARRAY_INFO& array = m_arrays[entry.location.arrayIndex];
+	GLint width = 0;
+	GLint height = 0;
+
+	BindForPacking(GL_TEXTURE_2D, entry.sourceID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+	// an image that no longer matches its array keeps sampling
+	// the levels the layer already has
+	if ((width == array.width) && (height == array.height))
+	{
+		for (int level = array.storageLevel; level < array.residentLevel; level++)
+		{
+			glCopyImageSubData(
+				entry.sourceID, GL_TEXTURE_2D, level, 0, 0, 0,
+				array.textureID, GL_TEXTURE_2D_ARRAY, level - array.storageLevel, 0, 0, entry.location.layer,
+				GetLevelSize(width, level), GetLevelSize(height, level), 1);
+		}
+	}
+	else
+	{
+		std::cout << "Reloaded texture does not match its texture array, width:" << width << ", height:" << height << std::endl;
+	}
+
+	DeleteSource(entry);
+	entry.bRestream = false;
+	FinishPendingLayer(array);
+}
+
+/***********************************************************
+ *  FinishPendingLayer()
+ *
+ *  This method is used for counting off a layer that was
+ *  waiting for its reloaded image.  After the last one the
+ *  base level moves back to the storage level.
+ ***********************************************************/
+void TextureArrays::FinishPendingLayer(ARRAY_INFO& array)
+{
+	array.pendingLayers--;
+	if (array.pendingLayers <= 0)
+	{
+		array.pendingLayers = 0;
+		array.residentLevel = array.storageLevel;
+		ApplyBaseLevel(array);
+	}
+}
+
+/***********************************************************
+ *  SetStorageLevel()
+ *
+ *  This method is used for moving the finest stored mip level
+ *  of an array.  New storage is created at the size of the
+ *  new level and the levels that every layer holds are copied
+ *  into it on the GPU.  When levels were added, the textures
+ *  of the array are listed for reloading and the base level
+ *  holds the layers at the levels they already have until
+ *  every reloaded image has been passed in.
+ ***********************************************************/
+bool TextureArrays::SetStorageLevel(int arrayIndex, int storageLevel, std::vector<int>& reloadTextures)
+{
+	reloadTextures.clear();
+
+	if ((arrayIndex <= 0) || (arrayIndex >= (int)m_arrays.size()))
+	{
+		return(false);
+	}
+
+	ARRAY_INFO& array = m_arrays[arrayIndex];
+	if (storageLevel < 0)
+	{
+		storageLevel = 0;
+	}
+	if (storageLevel > array.levels - 1)
+	{
+		storageLevel = array.levels - 1;
+	}
+	if ((storageLevel == array.storageLevel) || (array.pendingLayers > 0))
+	{
+		return(false);
+	}
+
+	ARRAY_INFO resized = array;
+	resized.storageLevel = storageLevel;
+	resized.residentLevel = (storageLevel > array.residentLevel) ? storageLevel : array.residentLevel;
+	resized.textureID = CreateStorage(resized);
+
+	if (array.layerCount > 0)
+	{
+		for (int level = resized.residentLevel; level < array.levels; level++)
+		{
+			glCopyImageSubData(
+				array.textureID, GL_TEXTURE_2D_ARRAY, level - array.storageLevel, 0, 0, 0,
+				resized.textureID, GL_TEXTURE_2D_ARRAY, level - resized.storageLevel, 0, 0, 0,
+				GetLevelSize(array.width, level), GetLevelSize(array.height, level), array.layerCount);
+		}
+	}
+
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->ForgetTexture(array.textureID);
+	}
+	glDeleteTextures(1, &array.textureID);
+
+	if (resized.residentLevel > resized.storageLevel)
+	{
+		for (int i = 0; i < (int)m_textures.size(); i++)
+		{
+			if ((m_textures[i].location.arrayIndex == arrayIndex) && (m_textures[i].sourceID == 0))
+			{
+				reloadTextures.push_back(i);
+			}
+		}
+		resized.pendingLayers = (int)reloadTextures.size();
+		if (resized.pendingLayers == 0)
+		{
+			resized.residentLevel = resized.storageLevel;
+		}
+	}
+
+	array = resized;
+	BindForPacking(GL_TEXTURE_2D_ARRAY, array.textureID);
+	ApplyBaseLevel(array);
+
+	// rebind the new storage on the unit of the array
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->BindTexture(arrayIndex, GL_TEXTURE_2D_ARRAY, array.textureID);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE0 + arrayIndex);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, array.textureID);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetRestreamSource()
+ *
+ *  This method is used for passing in a texture that is
+ *  loading the image of a packed texture again.  A texture
+ *  ID of 0 marks an image that cannot be reloaded, and its
+ *  layer is no longer waited for.
+ ***********************************************************/
+void TextureArrays::SetRestreamSource(int textureIndex, GLuint textureID)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	TEXTURE_ENTRY& entry = m_textures[textureIndex];
+	if (entry.sourceID != 0)
+	{
+		return;
+	}
+
+	if (textureID == 0)
+	{
+		if (entry.location.arrayIndex > 0)
+		{
+			FinishPendingLayer(m_arrays[entry.location.arrayIndex]);
+		}
+		return;
+	}
+
+	entry.sourceID = textureID;
+	entry.bRestream = true;
+}
+
+/***********************************************************
+ *  CancelRestreams()
+ *
+ *  This method is used for giving up on the reloaded images
+ *  that failed to load.  The placeholder texture of each one
+ *  is deleted and its layer is no longer waited for, so the
+ *  array can change its levels again once the other layers
+ *  are in.  Textures that were never packed are ignored.
+ ***********************************************************/
+void TextureArrays::CancelRestreams(const std::vector<GLuint>& textureIDs)
+{
+	for (size_t i = 0; i < textureIDs.size(); i++)
+	{
+		for (size_t j = 0; j < m_textures.size(); j++)
+		{
+			TEXTURE_ENTRY& entry = m_textures[j];
+			if ((entry.sourceID != textureIDs[i]) || (entry.bRestream == false))
+			{
+				continue;
+			}
+
+			DeleteSource(entry);
+			entry.bRestream = false;
+			FinishPendingLayer(m_arrays[entry.location.arrayIndex]);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetArrayBytes()
+ *
+ *  This method is used for getting the bytes of storage an
+ *  array takes when it stores the passed in level and every
+ *  smaller one.
+ ***********************************************************/
+size_t TextureArrays::GetArrayBytes(int arrayIndex, int storageLevel) const
+{
+	const ARRAY_INFO& array = m_arrays[arrayIndex];
+	size_t bytes = 0;
+
+	for (int level = storageLevel; level < array.levels; level++)
+	{
+		bytes += GetLevelBytes(array.internalFormat, GetLevelSize(array.width, level), GetLevelSize(array.height, level));
+	}
+
+	return(bytes * (size_t)array.layerCapacity);
+}
+
+/***********************************************************
+ *  FindArray()
+ *
+ *  This method is used for finding an array with a free layer
+ *  for a texture of the passed in size and format.  A new
+ *  array is created when none of the existing ones fit.
+ ***********************************************************/
+int TextureArrays::FindArray(GLenum internalFormat, int width, int height, int levels)
+{
+	for (int i = 1; i < (int)m_arrays.size(); i++)
+	{
+		const ARRAY_INFO& array = m_arrays[i];
+		if ((array.internalFormat == internalFormat) &&
+			(array.width == width) &&
+			(array.height == height) &&
+			(array.levels == levels) &&
+			(array.layerCount < array.layerCapacity))
+		{
+			return(i);
+		}
+	}
+
+	if ((int)m_arrays.size() >= g_MaxArrays)
+	{
+		return(-1);
+	}
+
+	ARRAY_INFO array;
+	array.internalFormat = internalFormat;
+	array.width = width;
+	array.height = height;
+	array.levels = levels;
+	array.layerCount = 0;
+	array.layerCapacity = g_LayersPerArray;
+	array.storageLevel = 0;
+	array.pendingLayers = 0;
+
+	// new arrays start out with only the small levels stored,
+	// and the streamer adds the rest where they are seen
+	if (m_startSize > 0)
+	{
+		int largest = (width > height) ? width : height;
+		while (((largest >> array.storageLevel) > m_startSize) && (array.storageLevel < levels - 1))
+		{
+			array.storageLevel++;
+		}
+	}
+	array.residentLevel = array.storageLevel;
+	array.textureID = CreateStorage(array);
+
+	m_arrays.push_back(array);
+
+	std::cout << "Created texture array " << (m_arrays.size() - 1) << ", width:" << width << ", height:" << height << ", layers:" << array.layerCapacity << ", first stored level:" << array.storageLevel << std::endl;
+
+	return((int)m_arrays.size() - 1);
+}
+
+/***********************************************************
+ *  CreateStorage()
+ *
+ *  This method is used for creating the storage of an array
+ *  from its storage level down and setting its sampling
+ *  parameters, which filter across the stored mip chain.
+ *  The new texture is left bound for packing.
+ ***********************************************************/
+GLuint TextureArrays::CreateStorage(const ARRAY_INFO& array)
+{
+	GLuint textureID = 0;
+
+	glGenTextures(1, &textureID);
+	BindForPacking(GL_TEXTURE_2D_ARRAY, textureID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, array.levels - array.storageLevel, array.internalFormat,
+		GetLevelSize(array.width, array.storageLevel), GetLevelSize(array.height, array.storageLevel), array.layerCapacity);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters - the stored levels are
+	// blended between, so records far away sample the small
+	// levels even while a near record has the finest one in
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array.levels - 1 - array.storageLevel);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  ApplyBaseLevel()
+ *
+ *  This method is used for pointing the base level of an
+ *  array at the finest level that every layer holds.
+ ***********************************************************/
+void TextureArrays::ApplyBaseLevel(const ARRAY_INFO& array)
+{
+	glTextureParameteri(array.textureID, GL_TEXTURE_BASE_LEVEL, array.residentLevel - array.storageLevel);
+}
+
+/***********************************************************
+ *  DeleteSource()
+ *
+ *  This method is used for deleting the loaded texture of an
+ *  entry once its levels have been copied.
+ ***********************************************************/
+void TextureArrays::DeleteSource(TEXTURE_ENTRY& entry)
+{
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->ForgetTexture(entry.sourceID);
+	}
+	glDeleteTextures(1, &entry.sourceID);
+	entry.sourceID = 0;
+}
+
+/***********************************************************
+ *  BindArrays()
+ *
+ *  This method is used for binding each texture array on the
+ *  texture unit that matches its index.
+ ***********************************************************/
+void TextureArrays::BindArrays()
+{
+	for (int i = 0; i < (int)m_arrays.size(); i++)
+	{
+		if (NULL != m_pStateCache)
+		{
+			m_pStateCache->BindTexture(i, GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+		}
+		else
+		{
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].textureID);
+		}
+	}
+}
+
+/***********************************************************
+ *  BindForPacking()
+ *
+ *  This method is used for binding a texture on the texture
+ *  unit that is reserved for packing.
+ ***********************************************************/
+void TextureArrays::BindForPacking(GLenum target, GLuint textureID)
+{
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->BindTexture(g_PackTextureUnit, target, textureID);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE0 + g_PackTextureUnit);
+		glBindTexture(target, textureID);
+	}
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the texture arrays and any
+ *  loaded textures that were never packed.
+ ***********************************************************/
+void TextureArrays::Destroy()
+{
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].sourceID != 0)
+		{
+			if (NULL != m_pStateCache)
+			{
+				m_pStateCache->ForgetTexture(m_textures[i].sourceID);
+			}
+			glDeleteTextures(1, &m_textures[i].sourceID);
+		}
+	}
+	m_textures.clear();
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		if (NULL != m_pStateCache)
+		{
+			m_pStateCache->ForgetTexture(m_arrays[i].textureID);
+		}
+		glDeleteTextures(1, &m_arrays[i].textureID);
+	}
+	m_arrays.clear();
+}
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// pack the scene textures into layers of 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "StateCache.h"
+
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class packs loaded 2D textures into the layers of
+ *  texture arrays, one array for each combination of size
+ *  and format.  Each array stays bound on the texture unit
+ *  that matches its index, so a draw only needs the array
+ *  index and layer of its texture - textures in the same
+ *  array can be drawn together in one batch.
+ *
+ *  The layers of an array share one mip chain, so the mip
+ *  levels are made resident per array.  An array only has
+ *  storage from its storage level down to its smallest level,
+ *  at the size of the storage level, and the layers sample it
+ *  with the same texture coordinates at any storage level.
+ *  While the finer levels are reloaded after the storage has
+ *  grown, the base level keeps sampling the levels that every
+ *  layer already holds.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays(StateCache* pStateCache);
+	// destructor
+	~TextureArrays();
+
+	// where a texture can be sampled from
+	struct TEXTURE_LAYER
+	{
+		// array holding the texture - also its texture unit
+		int arrayIndex;
+		int layer;
+	};
+
+	// create the placeholder array that textures use until
+	// they have been packed
+	void Initialize();
+	// register a texture that is still loading - returns the
+	// texture index used for finding its layer
+	int AddTexture(GLuint textureID);
+	// copy loaded textures into array layers and delete the
+	// source textures - returns the number of textures packed
+	int PackTextures(const std::vector<GLuint>& textureIDs);
+	// bind each array on the texture unit matching its index
+	void BindArrays();
+	// give new arrays storage only for the mip levels that are
+	// at most the passed in size - 0 stores every level
+	void SetStartSize(int maxSize) { m_startSize = maxSize; }
+	// move the finest stored mip level of an array - dropping
+	// levels copies the rest into smaller storage, and adding
+	// levels lists the textures whose images must be loaded
+	// again before the new levels are sampled
+	bool SetStorageLevel(int arrayIndex, int storageLevel, std::vector<int>& reloadTextures);
+	// pass in a reloaded image of a packed texture - the levels
+	// its layer is missing are copied out of it when it is packed
+	void SetRestreamSource(int textureIndex, GLuint textureID);
+	// pass in the loaded textures whose images could not be read
+	// - the layers that waited for them as reloads keep the levels
+	// they already have
+	void CancelRestreams(const std::vector<GLuint>& textureIDs);
+	// bytes of storage an array would take from the passed in
+	// storage level down
+	size_t GetArrayBytes(int arrayIndex, int storageLevel) const;
+	// free all of the arrays
+	void Destroy();
+
+	// get the array index and layer of a registered texture
+	const TEXTURE_LAYER& GetTextureLayer(int textureIndex) const { return(m_textures[textureIndex].location); }
+	int GetTextureCount() const { return((int)m_textures.size()); }
+	int GetArrayCount() const { return((int)m_arrays.size()); }
+	// full size and mip levels of the textures in an array, and
+	// the finest level that has storage
+	int GetArraySize(int arrayIndex) const { return((m_arrays[arrayIndex].width > m_arrays[arrayIndex].height) ? m_arrays[arrayIndex].width : m_arrays[arrayIndex].height); }
+	int GetLevelCount(int arrayIndex) const { return(m_arrays[arrayIndex].levels); }
+	int GetStorageLevel(int arrayIndex) const { return(m_arrays[arrayIndex].storageLevel); }
+	// true while layers of an array wait for reloaded images
+	bool IsArrayStreaming(int arrayIndex) const { return(m_arrays[arrayIndex].pendingLayers > 0); }
+
+private:
+	struct ARRAY_INFO
+	{
+		GLuint textureID;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levels;
+		int layerCount;
+		int layerCapacity;
+		// finest mip level with storage - the storage holds the
+		// levels from here down at the size of this level
+		int storageLevel;
+		// finest mip level that every layer holds
+		int residentLevel;
+		// layers waiting for a reloaded image
+		int pendingLayers;
+	};
+
+	struct TEXTURE_ENTRY
+	{
+		// loaded texture waiting to be packed, or 0 once packed
+		GLuint sourceID;
+		TEXTURE_LAYER location;
+		// true when the source is a reloaded image for the
+		// missing levels of a texture that is already packed
+		bool bRestream;
+	};
+
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// texture arrays - the first one is the placeholder
+	std::vector<ARRAY_INFO> m_arrays;
+	// registered textures indexed by texture index
+	std::vector<TEXTURE_ENTRY> m_textures;
+	// largest storage level size of new arrays, or 0 for all
+	int m_startSize;
+
+	// copy one loaded texture into a free array layer
+	bool PackTexture(TEXTURE_ENTRY& entry);
+	// copy the missing levels of a packed texture out of its
+	// reloaded image
+	void RestreamTexture(TEXTURE_ENTRY& entry);
+	// create the storage of an array from its storage level down
+	GLuint CreateStorage(const ARRAY_INFO& array);
+	// count off a layer that waited for its reloaded image
+	void FinishPendingLayer(ARRAY_INFO& array);
+	// point the base level of an array at its resident level
+	void ApplyBaseLevel(const ARRAY_INFO& array);
+	// delete a loaded source texture
+	void DeleteSource(TEXTURE_ENTRY& entry);
+	// find an array with a free layer for the passed in size
+	// and format, creating one if needed - returns -1 when the
+	// texture units for arrays have run out
+	int FindArray(GLenum internalFormat, int width, int height, int levels);
+	// bind a texture on the texture unit reserved for packing
+	void BindForPacking(GLenum target, GLuint textureID);
+};
@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// read and write block-compressed texture mip chains in KTX cache files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// KTX 1.1 file identifier
+	const unsigned char g_KTXIdentifier[12] =
+	{
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+	};
+	const uint32_t g_KTXEndianness = 0x04030201;
+	// key of the value that holds the source image stamp
+	const char* g_SourceStampKey = "SourceStamp";
+	// largest width or height a cache file may hold
+	const uint32_t g_MaxCacheImageSize = 16384;
+
+	// KTX 1.1 header that follows the file identifier
+	struct KTX_HEADER
+	{
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+
+	// round a byte count up to the next multiple of four
+	uint32_t PadToFour(uint32_t size)
+	{
+		return((size + 3) & ~((uint32_t)3));
+	}
+
+	// bytes of one 4x4 block of the formats the cache writes, or
+	// 0 for any other format
+	uint32_t GetBlockBytes(uint32_t internalFormat)
+	{
+		if (internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+			return(8);
+		else if (internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+			return(16);
+
+		return(0);
+	}
+
+	// bytes left in a file from its read position to its end
+	uint64_t GetBytesLeft(std::ifstream& file, std::streamoff fileSize)
+	{
+		std::streamoff position = file.tellg();
+		if ((position < 0) || (position > fileSize))
+		{
+			return(0);
+		}
+		return((uint64_t)(fileSize - position));
+	}
+}
+
+/***********************************************************
+ *  GetCacheFilename()
+ *
+ *  This method is used for getting the name of the cache
+ *  file that belongs to a source image.
+ ***********************************************************/
+std::string TextureCache::GetCacheFilename(const std::string& sourceFilename)
+{
+	return(sourceFilename + ".ktx");
+}
+
+/***********************************************************
+ *  GetSourceStamp()
+ *
+ *  This method is used for building a stamp from the size and
+ *  the modification time of a source image.  An empty stamp
+ *  is returned if the source image cannot be found.
+ ***********************************************************/
+std::string TextureCache::GetSourceStamp(const std::string& sourceFilename)
+{
+	struct stat fileInfo;
+
+	if (stat(sourceFilename.c_str(), &fileInfo) != 0)
+	{
+		return(std::string());
+	}
+
+	return(std::to_string((long long)fileInfo.st_size) + ":" + std::to_string((long long)fileInfo.st_mtime));
+}
+
+/***********************************************************
+ *  GetCompressedFormat()
+ *
+ *  This method is used for picking the block-compressed format
+ *  for an image - BC1 for RGB images and BC3 for RGBA images.
+ ***********************************************************/
+GLenum TextureCache::GetCompressedFormat(int colorChannels)
+{
+	if (!GLEW_EXT_texture_compression_s3tc)
+	{
+		return(0);
+	}
+
+	if (colorChannels == 3)
+		return(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+	else if (colorChannels == 4)
+		return(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+
+	return(0);
+}
+
+/***********************************************************
+ *  ReadCacheFile()
+ *
+ *  This method is used for reading the compressed mip chain
+ *  of a source image from its cache file.  It fails when the
+ *  cache file is missing, damaged or older than the source.
+ *  Only the formats the cache writes are read, the chain must
+ *  go down to 1x1 and every level must have the size of its
+ *  blocks, with no sizes larger than what is left in the
+ *  file, so a damaged file is decoded and written again.
+ ***********************************************************/
+bool TextureCache::ReadCacheFile(
+	const std::string& sourceFilename,
+	COMPRESSED_IMAGE& image)
+{
+	unsigned char identifier[12];
+	KTX_HEADER header;
+	std::string sourceStamp = GetSourceStamp(sourceFilename);
+	bool bStampMatches = false;
+
+	std::ifstream file(GetCacheFilename(sourceFilename).c_str(), std::ios::binary | std::ios::ate);
+	if ((sourceStamp.empty() == true) || (!file))
+	{
+		return(false);
+	}
+	const std::streamoff fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	file.read((char*)identifier, sizeof(identifier));
+	file.read((char*)&header, sizeof(header));
+	if ((!file) ||
+		(memcmp(identifier, g_KTXIdentifier, sizeof(identifier)) != 0) ||
+		(header.endianness != g_KTXEndianness) ||
+		(header.glType != 0) ||
+		(header.numberOfFaces != 1) ||
+		(header.numberOfArrayElements != 0) ||
+		(header.pixelDepth != 0))
+	{
+		return(false);
+	}
+
+	// the cache only holds the formats it writes, with a full
+	// mip chain, since the arrays copy every level
+	const uint32_t blockBytes = GetBlockBytes(header.glInternalFormat);
+	if ((blockBytes == 0) ||
+		(header.pixelWidth == 0) || (header.pixelWidth > g_MaxCacheImageSize) ||
+		(header.pixelHeight == 0) || (header.pixelHeight > g_MaxCacheImageSize))
+	{
+		return(false);
+	}
+
+	uint32_t chainLevels = 1;
+	uint32_t largest = (header.pixelWidth > header.pixelHeight) ? header.pixelWidth : header.pixelHeight;
+	while (largest > 1)
+	{
+		largest /= 2;
+		chainLevels++;
+	}
+	if ((header.numberOfMipmapLevels != chainLevels) ||
+		(header.bytesOfKeyValueData > GetBytesLeft(file, fileSize)))
+	{
+		return(false);
+	}
+
+	// look for the source stamp in the key and value data
+	std::vector<char> keyValueData(header.bytesOfKeyValueData);
+	if (header.bytesOfKeyValueData > 0)
+	{
+		file.read(keyValueData.data(), keyValueData.size());
+	}
+	size_t position = 0;
+	while (position + sizeof(uint32_t) <= keyValueData.size())
+	{
+		uint32_t keyAndValueSize = 0;
+		memcpy(&keyAndValueSize, &keyValueData[position], sizeof(uint32_t));
+		position += sizeof(uint32_t);
+		if (position + keyAndValueSize > keyValueData.size())
+		{
+			break;
+		}
+
+		std::string keyAndValue(&keyValueData[position], keyAndValueSize);
+		size_t separator = keyAndValue.find('\0');
+		if ((separator != std::string::npos) && (keyAndValue.compare(0, separator, g_SourceStampKey) == 0))
+		{
+			std::string stamp = keyAndValue.substr(separator + 1);
+			stamp = stamp.substr(0, stamp.find('\0'));
+			bStampMatches = (stamp.compare(sourceStamp) == 0);
+		}
+		position += PadToFour(keyAndValueSize);
+	}
+
+	// the source image changed since the cache was written
+	if (bStampMatches == false)
+	{
+		return(false);
+	}
+
+	image.internalFormat = header.glInternalFormat;
+	image.baseFormat = header.glBaseInternalFormat;
+	image.width = (int)header.pixelWidth;
+	image.height = (int)header.pixelHeight;
+	image.levels.clear();
+	image.data.clear();
+
+	int levelWidth = image.width;
+	int levelHeight = image.height;
+	for (uint32_t level = 0; level < header.numberOfMipmapLevels; level++)
+	{
+		uint32_t imageSize = 0;
+		file.read((char*)&imageSize, sizeof(imageSize));
+		if (!file)
+		{
+			return(false);
+		}
+
+		// the level must be exactly its blocks and fit in the file
+		uint64_t expectedSize = (uint64_t)((levelWidth + 3) / 4) * (uint64_t)((levelHeight + 3) / 4) * blockBytes;
+		if ((imageSize != expectedSize) || (PadToFour(imageSize) > GetBytesLeft(file, fileSize)))
+		{
+			return(false);
+		}
+
+		MIP_LEVEL mipLevel;
+		mipLevel.offset = image.data.size();
+		mipLevel.size = imageSize;
+		mipLevel.width = levelWidth;
+		mipLevel.height = levelHeight;
+		image.data.resize(mipLevel.offset + imageSize);
+		file.read((char*)&image.data[mipLevel.offset], imageSize);
+		file.seekg(PadToFour(imageSize) - imageSize, std::ios::cur);
+		if (!file)
+		{
+			return(false);
+		}
+		image.levels.push_back(mipLevel);
+
+		levelWidth = (levelWidth > 1) ? (levelWidth / 2) : 1;
+		levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteCacheFile()
+ *
+ *  This method is used for writing the compressed mip chain
+ *  of a source image into its cache file, stamped with the
+ *  current size and modification time of the source image.
+ ***********************************************************/
+bool TextureCache::WriteCacheFile(
+	const std::string& sourceFilename,
+	const COMPRESSED_IMAGE& image)
+{
+	std::string sourceStamp = GetSourceStamp(sourceFilename);
+	std::string cacheFilename = GetCacheFilename(sourceFilename);
+	const unsigned char padding[4] = { 0, 0, 0, 0 };
+
+	if ((sourceStamp.empty() == true) || (image.levels.size() == 0))
+	{
+		return(false);
+	}
+
+	// one key and value pair holding the source stamp
+	std::string keyAndValue = std::string(g_SourceStampKey) + '\0' + sourceStamp + '\0';
+	uint32_t keyAndValueSize = (uint32_t)keyAndValue.size();
+
+	KTX_HEADER header;
+	header.endianness = g_KTXEndianness;
+	header.glType = 0;
+	header.glTypeSize = 1;
+	header.glFormat = 0;
+	header.glInternalFormat = image.internalFormat;
+	header.glBaseInternalFormat = image.baseFormat;
+	header.pixelWidth = (uint32_t)image.width;
+	header.pixelHeight = (uint32_t)image.height;
+	header.pixelDepth = 0;
+	header.numberOfArrayElements = 0;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = (uint32_t)image.levels.size();
+	header.bytesOfKeyValueData = (uint32_t)sizeof(uint32_t) + PadToFour(keyAndValueSize);
+
+	std::ofstream file(cacheFilename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "Could not write texture cache:" << cacheFilename << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)g_KTXIdentifier, sizeof(g_KTXIdentifier));
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&keyAndValueSize, sizeof(keyAndValueSize));
+	file.write(keyAndValue.data(), keyAndValueSize);
+	file.write((const char*)padding, PadToFour(keyAndValueSize) - keyAndValueSize);
+
+	for (size_t level = 0; level < image.levels.size(); level++)
+	{
+		const MIP_LEVEL& mipLevel = image.levels[level];
+		uint32_t imageSize = (uint32_t)mipLevel.size;
+
+		file.write((const char*)&imageSize, sizeof(imageSize));
+		file.write((const char*)&image.data[mipLevel.offset], imageSize);
+		file.write((const char*)padding, PadToFour(imageSize) - imageSize);
+	}
+
+	if (!file)
+	{
+		std::cout << "Could not write texture cache:" << cacheFilename << std::endl;
+		return(false);
+	}
+
+	std::cout << "Wrote texture cache:" << cacheFilename << ", mip levels:" << image.levels.size() << std::endl;
+	return(true);
+}
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// read and write block-compressed texture mip chains in KTX cache files
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class stores block-compressed (BCn) textures with
+ *  their complete mip chains in KTX files next to the source
+ *  images.  A cache file records the size and modification
+ *  time of its source image, so it is only used while the
+ *  source image is unchanged.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	struct MIP_LEVEL
+	{
+		size_t offset;
+		size_t size;
+		int width;
+		int height;
+	};
+
+	// a compressed texture with all of its mip levels packed
+	// one after another into a single block of data
+	struct COMPRESSED_IMAGE
+	{
+		GLenum internalFormat;
+		GLenum baseFormat;
+		int width;
+		int height;
+		std::vector<MIP_LEVEL> levels;
+		std::vector<unsigned char> data;
+	};
+
+	// get the cache file name for a source image
+	static std::string GetCacheFilename(const std::string& sourceFilename);
+	// read a cache file - fails if it is missing or stale
+	static bool ReadCacheFile(
+		const std::string& sourceFilename,
+		COMPRESSED_IMAGE& image);
+	// write a cache file for a source image
+	static bool WriteCacheFile(
+		const std::string& sourceFilename,
+		const COMPRESSED_IMAGE& image);
+
+	// pick the compressed format to use for a color channel count,
+	// or 0 when compressed textures are not supported
+	static GLenum GetCompressedFormat(int colorChannels);
+
+private:
+	// build the stamp that identifies the state of a source image
+	static std::string GetSourceStamp(const std::string& sourceFilename);
+};
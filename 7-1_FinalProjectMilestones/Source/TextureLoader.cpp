@@ -0,0 +1,547 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and upload them without blocking
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// texture unit reserved for uploads so the scene bindings
+	// on the other units are never disturbed
+	const GLuint g_UploadTextureUnit = 31;
+	// the most worker threads used for decoding
+	const unsigned int g_MaxWorkers = 4;
+	// color of the placeholder shown until a texture is ready
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(StateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_bStopping = false;
+	m_pendingCount = 0;
+	m_pixelBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	// tell the workers to exit and wait for them
+	{
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_bStopping = true;
+
+		// drop the loads that have not started, but keep the cache
+		// writes so the compressed images are not lost
+		std::deque<LOAD_REQUEST> cacheWrites;
+		for (size_t i = 0; i < m_requests.size(); i++)
+		{
+			if (m_requests[i].bWriteCache == true)
+			{
+				cacheWrites.push_back(std::move(m_requests[i]));
+			}
+		}
+		m_requests.swap(cacheWrites);
+	}
+	m_requestReady.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	// free any decoded images that were never uploaded
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		stbi_image_free(m_results[i].pixels);
+	}
+	m_results.clear();
+
+	if (m_pixelBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_pixelBuffer);
+		m_pixelBuffer = 0;
+	}
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used for starting the decoding threads.
+ *  One core is left for the render thread.
+ ***********************************************************/
+void TextureLoader::StartWorkers()
+{
+	unsigned int workerCount = std::thread::hardware_concurrency();
+
+	if (m_workers.size() > 0)
+	{
+		return;
+	}
+
+	if (workerCount > 1)
+		workerCount--;
+	if (workerCount < 1)
+		workerCount = 1;
+	if (workerCount > g_MaxWorkers)
+		workerCount = g_MaxWorkers;
+
+	// the flip setting is global in stb_image, so it is set once
+	// before any worker can start decoding
+	stbi_set_flip_vertically_on_load(true);
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by each worker thread.  It reads the
+ *  cache file or decodes the image file for each request and
+ *  passes the results back to the render thread.  Queued
+ *  cache writes are finished before the worker exits.
+ ***********************************************************/
+void TextureLoader::WorkerLoop()
+{
+	while (true)
+	{
+		LOAD_REQUEST request;
+
+		// wait for the next request
+		{
+			std::unique_lock<std::mutex> lock(m_requestMutex);
+			while ((m_bStopping == false) && (m_requests.size() == 0))
+			{
+				m_requestReady.wait(lock);
+			}
+			if (m_requests.size() == 0)
+			{
+				return;
+			}
+			request = std::move(m_requests.front());
+			m_requests.pop_front();
+		}
+
+		if (request.bWriteCache == true)
+		{
+			TextureCache::WriteCacheFile(request.filename, request.cacheImage);
+			continue;
+		}
+
+		LOAD_RESULT result;
+		result.filename = request.filename;
+		result.textureID = request.textureID;
+		result.width = 0;
+		result.height = 0;
+		result.colorChannels = 0;
+		result.pixels = NULL;
+
+		// use the compressed cache file while it is up to date
+		result.bCompressed = TextureCache::ReadCacheFile(request.filename, result.compressed);
+		if (result.bCompressed == false)
+		{
+			// try to parse the image data from the specified image file
+			result.pixels = stbi_load(
+				request.filename.c_str(),
+				&result.width,
+				&result.height,
+				&result.colorChannels,
+				0);
+		}
+
+		std::lock_guard<std::mutex> lock(m_resultMutex);
+		m_results.push_back(std::move(result));
+	}
+}
+
+/***********************************************************
+ *  RequestTexture()
+ *
+ *  This method is used for creating a texture that shows a
+ *  placeholder image and queueing the image file to be
+ *  decoded on a worker thread.
+ ***********************************************************/
+GLuint TextureLoader::RequestTexture(const char* filename)
+{
+	GLuint textureID = 0;
+
+	StartWorkers();
+
+	glGenTextures(1, &textureID);
+	BindForUpload(textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// show the placeholder until the real image is uploaded
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+
+	LOAD_REQUEST request;
+	request.filename = filename;
+	request.textureID = textureID;
+	request.bWriteCache = false;
+	{
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_requests.push_back(request);
+		m_pendingCount++;
+	}
+	m_requestReady.notify_one();
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  BindForUpload()
+ *
+ *  This method is used for binding a texture on the texture
+ *  unit that is reserved for uploads.
+ ***********************************************************/
+void TextureLoader::BindForUpload(GLuint textureID)
+{
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->BindTexture(g_UploadTextureUnit, GL_TEXTURE_2D, textureID);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE0 + g_UploadTextureUnit);
+		glBindTexture(GL_TEXTURE_2D, textureID);
+	}
+}
+
+/***********************************************************
+ *  UploadResult()
+ *
+ *  This method is used for copying a decoded image into the
+ *  pixel buffer object and specifying the texture image from
+ *  it, so the driver can transfer the data asynchronously.
+ ***********************************************************/
+void TextureLoader::UploadResult(const LOAD_RESULT& result)
+{
+	GLenum internalFormat = 0;
+	GLenum pixelFormat = 0;
+
+	if (result.bCompressed == true)
+	{
+		UploadCompressed(result);
+		return;
+	}
+
+	if (NULL == result.pixels)
+	{
+		std::cout << "Could not load image:" << result.filename << std::endl;
+		m_failedTextures.push_back(result.textureID);
+		return;
+	}
+
+	// if the loaded image is in RGB format
+	if (result.colorChannels == 3)
+	{
+		internalFormat = GL_RGB8;
+		pixelFormat = GL_RGB;
+	}
+	// if the loaded image is in RGBA format - it supports transparency
+	else if (result.colorChannels == 4)
+	{
+		internalFormat = GL_RGBA8;
+		pixelFormat = GL_RGBA;
+	}
+	else
+	{
+		std::cout << "Not implemented to handle image with " << result.colorChannels << " channels" << std::endl;
+		m_failedTextures.push_back(result.textureID);
+		return;
+	}
+
+	std::cout << "Successfully loaded image:" << result.filename << ", width:" << result.width << ", height:" << result.height << ", channels:" << result.colorChannels << std::endl;
+
+	// let the driver compress the image when it is supported
+	GLenum compressedFormat = TextureCache::GetCompressedFormat(result.colorChannels);
+	if (compressedFormat != 0)
+	{
+		internalFormat = compressedFormat;
+	}
+
+	size_t imageSize = (size_t)result.width * result.height * result.colorChannels;
+	bool bMapped = FillPixelBuffer(result.pixels, imageSize);
+
+	BindForUpload(result.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (bMapped == true)
+	{
+		// the image data is read from the bound pixel buffer
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, result.width, result.height, 0, pixelFormat, GL_UNSIGNED_BYTE, (void*)0);
+	}
+	else
+	{
+		// fall back to a direct upload if mapping failed
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, result.width, result.height, 0, pixelFormat, GL_UNSIGNED_BYTE, result.pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	// keep the compressed result so the next run can skip this work
+	if (compressedFormat != 0)
+	{
+		SaveCompressedImage(result.filename, pixelFormat, result.width, result.height);
+	}
+
+	m_uploadedTextures.push_back(result.textureID);
+}
+
+/***********************************************************
+ *  FillPixelBuffer()
+ *
+ *  This method is used for copying data into the pixel buffer
+ *  object that the uploads are read from.  The buffer is left
+ *  bound to GL_PIXEL_UNPACK_BUFFER.
+ ***********************************************************/
+bool TextureLoader::FillPixelBuffer(const void* pData, size_t size)
+{
+	if (m_pixelBuffer == 0)
+	{
+		glGenBuffers(1, &m_pixelBuffer);
+	}
+
+	// orphan the previous storage so the copy never waits on
+	// an upload that is still in flight
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+	void* pMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (NULL == pMapped)
+	{
+		return(false);
+	}
+
+	memcpy(pMapped, pData, size);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	return(true);
+}
+
+/***********************************************************
+ *  UploadCompressed()
+ *
+ *  This method is used for uploading a compressed mip chain
+ *  that was read from a cache file.  No decoding or mipmap
+ *  generation is needed.
+ ***********************************************************/
+void TextureLoader::UploadCompressed(const LOAD_RESULT& result)
+{
+	const TextureCache::COMPRESSED_IMAGE& image = result.compressed;
+
+	std::cout << "Successfully loaded cached image:" << result.filename << ", width:" << image.width << ", height:" << image.height << ", mip levels:" << image.levels.size() << std::endl;
+
+	bool bMapped = FillPixelBuffer(image.data.data(), image.data.size());
+	if (bMapped == false)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	BindForUpload(result.textureID);
+	for (size_t level = 0; level < image.levels.size(); level++)
+	{
+		const TextureCache::MIP_LEVEL& mipLevel = image.levels[level];
+		// the level data is read from its offset in the bound
+		// pixel buffer, or directly if mapping failed
+		const void* pLevelData = (bMapped == true) ?
+			(const void*)mipLevel.offset :
+			(const void*)&image.data[mipLevel.offset];
+
+		glCompressedTexImage2D(
+			GL_TEXTURE_2D,
+			(GLint)level,
+			image.internalFormat,
+			mipLevel.width,
+			mipLevel.height,
+			0,
+			(GLsizei)mipLevel.size,
+			pLevelData);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	m_uploadedTextures.push_back(result.textureID);
+}
+
+/***********************************************************
+ *  SaveCompressedImage()
+ *
+ *  This method is used for reading back the mip chain that
+ *  the driver compressed for the bound texture and queueing
+ *  it to be written to the cache file on a worker thread.
+ *  This only happens the first time an image is loaded.
+ ***********************************************************/
+void TextureLoader::SaveCompressedImage(const std::string& filename, GLenum baseFormat, int width, int height)
+{
+	GLint bCompressed = 0;
+	GLint internalFormat = 0;
+
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &bCompressed);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	if (bCompressed == GL_FALSE)
+	{
+		return;
+	}
+
+	LOAD_REQUEST request;
+	request.filename = filename;
+	request.textureID = 0;
+	request.bWriteCache = true;
+	request.cacheImage.internalFormat = (GLenum)internalFormat;
+	request.cacheImage.baseFormat = baseFormat;
+	request.cacheImage.width = width;
+	request.cacheImage.height = height;
+
+	int levelWidth = width;
+	int levelHeight = height;
+	for (GLint level = 0; ; level++)
+	{
+		GLint levelSize = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSize);
+		if (levelSize <= 0)
+		{
+			return;
+		}
+
+		TextureCache::MIP_LEVEL mipLevel;
+		mipLevel.offset = request.cacheImage.data.size();
+		mipLevel.size = (size_t)levelSize;
+		mipLevel.width = levelWidth;
+		mipLevel.height = levelHeight;
+		request.cacheImage.data.resize(mipLevel.offset + mipLevel.size);
+		glGetCompressedTexImage(GL_TEXTURE_2D, level, &request.cacheImage.data[mipLevel.offset]);
+		request.cacheImage.levels.push_back(mipLevel);
+
+		if ((levelWidth == 1) && (levelHeight == 1))
+		{
+			break;
+		}
+		levelWidth = (levelWidth > 1) ? (levelWidth / 2) : 1;
+		levelHeight = (levelHeight > 1) ? (levelHeight / 2) : 1;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_requests.push_back(std::move(request));
+	}
+	m_requestReady.notify_one();
+}
+
+/***********************************************************
+ *  ProcessCompletedLoads()
+ *
+ *  This method is used for uploading the images that have
+ *  finished decoding.  Uploads stop once the passed in byte
+ *  budget is used up, but at least one image is uploaded.
+ ***********************************************************/
+int TextureLoader::ProcessCompletedLoads(size_t maxUploadBytes)
+{
+	size_t uploadedBytes = 0;
+	int uploadCount = 0;
+
+	while (uploadedBytes < maxUploadBytes)
+	{
+		LOAD_RESULT result;
+		{
+			std::lock_guard<std::mutex> lock(m_resultMutex);
+			if (m_results.size() == 0)
+			{
+				break;
+			}
+			result = std::move(m_results.front());
+			m_results.pop_front();
+		}
+
+		UploadResult(result);
+		if (result.bCompressed == true)
+			uploadedBytes += result.compressed.data.size();
+		else
+			uploadedBytes += (size_t)result.width * result.height * result.colorChannels;
+		uploadCount++;
+
+		// free the image data from local memory
+		if (NULL != result.pixels)
+		{
+			stbi_image_free(result.pixels);
+		}
+
+		std::lock_guard<std::mutex> lock(m_requestMutex);
+		m_pendingCount--;
+	}
+
+	return(uploadCount);
+}
+
+/***********************************************************
+ *  TakeUploadedTextures()
+ *
+ *  This method is used for collecting the textures whose real
+ *  image has been uploaded since the last call, and the ones
+ *  whose image could not be loaded, which keep showing their
+ *  placeholder.
+ ***********************************************************/
+void TextureLoader::TakeUploadedTextures(std::vector<GLuint>& textureIDs, std::vector<GLuint>& failedIDs)
+{
+	textureIDs.clear();
+	textureIDs.swap(m_uploadedTextures);
+	failedIDs.clear();
+	failedIDs.swap(m_failedTextures);
+}
+
+/***********************************************************
+ *  IsIdle()
+ *
+ *  This method is used for checking whether every requested
+ *  texture has been decoded and uploaded.
+ ***********************************************************/
+bool TextureLoader::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(m_requestMutex);
+	return(m_pendingCount == 0);
+}
+
+/***********************************************************
+ *  WaitForAll()
+ *
+ *  This method is used for blocking until every requested
+ *  texture has been uploaded.
+ ***********************************************************/
+void TextureLoader::WaitForAll()
+{
+	while (IsIdle() == false)
+	{
+		if (ProcessCompletedLoads((size_t)-1) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and upload them without blocking
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "StateCache.h"
+#include "TextureCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class decodes texture image files on a pool of
+ *  worker threads.  Each requested texture is created right
+ *  away with a small placeholder image, so it can be bound
+ *  and drawn immediately.  The decoded images are uploaded
+ *  through a pixel buffer object on the render thread as
+ *  they become ready, a few per frame.
+ *
+ *  Images are stored on the GPU block-compressed.  The first
+ *  time an image is loaded the driver compresses it and the
+ *  compressed mip chain is written to a cache file, so later
+ *  runs upload the cached data directly without decoding.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader(StateCache* pStateCache);
+	// destructor
+	~TextureLoader();
+
+	// create a placeholder texture and queue the image file for
+	// decoding - the returned texture ID is valid immediately
+	GLuint RequestTexture(const char* filename);
+
+	// upload the decoded images that are ready - called once per
+	// frame on the render thread, returns the number uploaded
+	int ProcessCompletedLoads(size_t maxUploadBytes);
+
+	// move the IDs of the textures uploaded since the last call
+	// into the passed in list, and the IDs of the textures whose
+	// image could not be loaded into the failed list
+	void TakeUploadedTextures(std::vector<GLuint>& textureIDs, std::vector<GLuint>& failedIDs);
+
+	// true when every requested texture has been uploaded
+	bool IsIdle();
+	// block until every requested texture has been uploaded
+	void WaitForAll();
+
+private:
+	struct LOAD_REQUEST
+	{
+		std::string filename;
+		GLuint textureID;
+		// true when the worker should write the cache file for
+		// the image instead of loading it
+		bool bWriteCache;
+		TextureCache::COMPRESSED_IMAGE cacheImage;
+	};
+
+	struct LOAD_RESULT
+	{
+		std::string filename;
+		GLuint textureID;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+		// true when the image was read from its cache file
+		bool bCompressed;
+		TextureCache::COMPRESSED_IMAGE compressed;
+	};
+
+	// pointer to the redundant state filtering object
+	StateCache* m_pStateCache;
+	// worker threads that decode the image files
+	std::vector<std::thread> m_workers;
+	// requests waiting for a worker
+	std::deque<LOAD_REQUEST> m_requests;
+	std::mutex m_requestMutex;
+	std::condition_variable m_requestReady;
+	// decoded images waiting for upload
+	std::deque<LOAD_RESULT> m_results;
+	std::mutex m_resultMutex;
+	// true when the workers have been told to exit
+	bool m_bStopping;
+	// number of requests that have not been uploaded yet
+	int m_pendingCount;
+	// pixel buffer object used for streaming the uploads
+	GLuint m_pixelBuffer;
+	// textures uploaded since the last TakeUploadedTextures(),
+	// and the textures that kept their placeholder
+	std::vector<GLuint> m_uploadedTextures;
+	std::vector<GLuint> m_failedTextures;
+
+	// start the worker threads on the first request
+	void StartWorkers();
+	// decode queued image files until told to stop
+	void WorkerLoop();
+	// upload one decoded image into its texture
+	void UploadResult(const LOAD_RESULT& result);
+	// upload a cached compressed mip chain into its texture
+	void UploadCompressed(const LOAD_RESULT& result);
+	// read back the compressed mip chain of the bound texture
+	// and queue it to be written to the cache file
+	void SaveCompressedImage(const std::string& filename, GLenum baseFormat, int width, int height);
+	// copy data into the pixel buffer object, returns false if
+	// the buffer could not be mapped
+	bool FillPixelBuffer(const void* pData, size_t size);
+	// bind a texture for uploading on the reserved texture unit
+	void BindForUpload(GLuint textureID);
+};
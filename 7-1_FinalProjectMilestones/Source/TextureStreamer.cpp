@@ -0,0 +1,302 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// keep the mip levels of the texture arrays that the view needs resident
+// within a video memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// frames an array must go unseen before its levels are
+	// dropped to make room for another array
+	const int g_IdleFrames = 120;
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer(TextureLoader* pTextureLoader, TextureArrays* pTextureArrays)
+{
+	m_pTextureLoader = pTextureLoader;
+	m_pTextureArrays = pTextureArrays;
+	m_budgetBytes = 0;
+	m_frame = 0;
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	m_pTextureLoader = NULL;
+	m_pTextureArrays = NULL;
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for registering the image file that
+ *  a texture was loaded from.
+ ***********************************************************/
+void TextureStreamer::AddTexture(int textureIndex, const std::string& filename)
+{
+	if (textureIndex < 0)
+	{
+		return;
+	}
+
+	if (textureIndex >= (int)m_filenames.size())
+	{
+		m_filenames.resize(textureIndex + 1);
+		m_coverage.resize(textureIndex + 1, 0.0f);
+	}
+	m_filenames[textureIndex] = filename;
+}
+
+/***********************************************************
+ *  AddCoverage()
+ *
+ *  This method is used for passing in the screen pixels that
+ *  one repeat of a texture covers.  The largest coverage of
+ *  the frame is kept.
+ ***********************************************************/
+void TextureStreamer::AddCoverage(int textureIndex, float pixels)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_coverage.size()))
+	{
+		return;
+	}
+
+	if (pixels > m_coverage[textureIndex])
+	{
+		m_coverage[textureIndex] = pixels;
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for turning the coverage of this frame
+ *  into the level each array wants.  Levels are dropped while
+ *  the arrays are over the budget, then the array that is
+ *  furthest from the level it wants grows, if the new levels
+ *  fit once arrays that have gone unseen are dropped.  Only
+ *  one array grows in a frame, so the reloads are spread out.
+ ***********************************************************/
+void TextureStreamer::Update()
+{
+	const int arrayCount = m_pTextureArrays->GetArrayCount();
+	std::vector<int> wantedLevels(arrayCount, -1);
+
+	m_frame++;
+	if ((int)m_lastSeenFrames.size() < arrayCount)
+	{
+		m_lastSeenFrames.resize(arrayCount, m_frame);
+	}
+
+	for (int i = 0; (i < (int)m_coverage.size()) && (i < m_pTextureArrays->GetTextureCount()); i++)
+	{
+		float pixels = m_coverage[i];
+		m_coverage[i] = 0.0f;
+
+		int arrayIndex = m_pTextureArrays->GetTextureLayer(i).arrayIndex;
+		if ((pixels <= 0.0f) || (arrayIndex <= 0))
+		{
+			continue;
+		}
+
+		// the finest level whose size still covers the pixels
+		int level = 0;
+		int size = m_pTextureArrays->GetArraySize(arrayIndex);
+		while (((float)(size >> (level + 1)) >= pixels) && (level < m_pTextureArrays->GetLevelCount(arrayIndex) - 1))
+		{
+			level++;
+		}
+
+		if ((wantedLevels[arrayIndex] < 0) || (level < wantedLevels[arrayIndex]))
+		{
+			wantedLevels[arrayIndex] = level;
+		}
+		m_lastSeenFrames[arrayIndex] = m_frame;
+	}
+
+	size_t storedBytes = GetStoredBytes();
+
+	if (m_budgetBytes > 0)
+	{
+		while ((storedBytes > m_budgetBytes) && (DropLeastRecentLevel(-1, false, storedBytes) == true))
+		{
+		}
+	}
+
+	int growArray = -1;
+	int growLevels = 0;
+	for (int i = 1; i < arrayCount; i++)
+	{
+		if ((wantedLevels[i] < 0) || (m_pTextureArrays->IsArrayStreaming(i) == true))
+		{
+			continue;
+		}
+
+		int missingLevels = m_pTextureArrays->GetStorageLevel(i) - wantedLevels[i];
+		if (missingLevels > growLevels)
+		{
+			growArray = i;
+			growLevels = missingLevels;
+		}
+	}
+
+	if (growArray < 0)
+	{
+		return;
+	}
+
+	// without a budget the array grows straight to its level,
+	// and within one it takes in as many levels as fit
+	int storageLevel = m_pTextureArrays->GetStorageLevel(growArray);
+	int targetLevel = wantedLevels[growArray];
+	while ((m_budgetBytes > 0) && (targetLevel < storageLevel))
+	{
+		size_t grownBytes = storedBytes - m_pTextureArrays->GetArrayBytes(growArray, storageLevel) +
+			m_pTextureArrays->GetArrayBytes(growArray, targetLevel);
+		if (grownBytes <= m_budgetBytes)
+		{
+			break;
+		}
+
+		if (DropLeastRecentLevel(growArray, true, storedBytes) == false)
+		{
+			targetLevel++;
+		}
+	}
+
+	if (targetLevel < storageLevel)
+	{
+		GrowArray(growArray, targetLevel, storedBytes);
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting the registered
+ *  textures, such as when the texture arrays are destroyed.
+ ***********************************************************/
+void TextureStreamer::Clear()
+{
+	m_filenames.clear();
+	m_coverage.clear();
+	m_lastSeenFrames.clear();
+}
+
+/***********************************************************
+ *  GetStoredBytes()
+ *
+ *  This method is used for adding up the bytes that the
+ *  stored levels of the arrays take.
+ ***********************************************************/
+size_t TextureStreamer::GetStoredBytes() const
+{
+	size_t storedBytes = 0;
+
+	for (int i = 1; i < m_pTextureArrays->GetArrayCount(); i++)
+	{
+		storedBytes += m_pTextureArrays->GetArrayBytes(i, m_pTextureArrays->GetStorageLevel(i));
+	}
+
+	return(storedBytes);
+}
+
+/***********************************************************
+ *  DropLeastRecentLevel()
+ *
+ *  This method is used for dropping the finest stored level
+ *  of the array that was seen longest ago.  Arrays that are
+ *  streaming or already store only their smallest level are
+ *  passed over.  It returns false when no array qualifies.
+ ***********************************************************/
+bool TextureStreamer::DropLeastRecentLevel(int keptArray, bool bIdleOnly, size_t& storedBytes)
+{
+	int dropArray = -1;
+	int oldestFrame = m_frame + 1;
+	std::vector<int> reloadTextures;
+
+	for (int i = 1; i < m_pTextureArrays->GetArrayCount(); i++)
+	{
+		if ((i == keptArray) ||
+			(m_pTextureArrays->IsArrayStreaming(i) == true) ||
+			(m_pTextureArrays->GetStorageLevel(i) >= m_pTextureArrays->GetLevelCount(i) - 1))
+		{
+			continue;
+		}
+
+		int lastSeen = m_lastSeenFrames[i];
+		if ((bIdleOnly == true) && (lastSeen + g_IdleFrames > m_frame))
+		{
+			continue;
+		}
+
+		if (lastSeen < oldestFrame)
+		{
+			dropArray = i;
+			oldestFrame = lastSeen;
+		}
+	}
+
+	if (dropArray < 0)
+	{
+		return(false);
+	}
+
+	int storageLevel = m_pTextureArrays->GetStorageLevel(dropArray);
+	size_t oldBytes = m_pTextureArrays->GetArrayBytes(dropArray, storageLevel);
+	if (m_pTextureArrays->SetStorageLevel(dropArray, storageLevel + 1, reloadTextures) == false)
+	{
+		return(false);
+	}
+	storedBytes = storedBytes - oldBytes + m_pTextureArrays->GetArrayBytes(dropArray, storageLevel + 1);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GrowArray()
+ *
+ *  This method is used for adding the levels down to the
+ *  passed in level to an array and requesting its images
+ *  again.  The array samples its old levels until every
+ *  image has been reloaded.
+ ***********************************************************/
+void TextureStreamer::GrowArray(int arrayIndex, int storageLevel, size_t& storedBytes)
+{
+	std::vector<int> reloadTextures;
+	size_t oldBytes = m_pTextureArrays->GetArrayBytes(arrayIndex, m_pTextureArrays->GetStorageLevel(arrayIndex));
+
+	if (m_pTextureArrays->SetStorageLevel(arrayIndex, storageLevel, reloadTextures) == false)
+	{
+		return;
+	}
+	storedBytes = storedBytes - oldBytes + m_pTextureArrays->GetArrayBytes(arrayIndex, storageLevel);
+
+	for (size_t i = 0; i < reloadTextures.size(); i++)
+	{
+		int textureIndex = reloadTextures[i];
+		GLuint textureID = 0;
+		if ((textureIndex < (int)m_filenames.size()) && (m_filenames[textureIndex].empty() == false))
+		{
+			textureID = m_pTextureLoader->RequestTexture(m_filenames[textureIndex].c_str());
+		}
+		m_pTextureArrays->SetRestreamSource(textureIndex, textureID);
+	}
+
+	std::cout << "INFO: Streaming texture array " << arrayIndex << " from level " << storageLevel << std::endl;
+}
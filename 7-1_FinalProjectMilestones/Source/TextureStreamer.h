@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// keep the mip levels of the texture arrays that the view needs resident
+// within a video memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class decides which mip levels of each texture array
+ *  are stored.  Each frame the draw records pass in how many
+ *  pixels one repeat of their texture covers on the screen,
+ *  and an array wants the finest level that is not larger
+ *  than the most any of its textures covers.  Arrays that
+ *  want finer levels grow one at a time, which reloads their
+ *  images through the texture loader, and while the stored
+ *  levels are over the budget the arrays that were seen
+ *  longest ago drop their finest level.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer(TextureLoader* pTextureLoader, TextureArrays* pTextureArrays);
+	// destructor
+	~TextureStreamer();
+
+	// bytes the stored levels may take, or 0 for no limit
+	void SetBudget(size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	// register the image file of a texture so its levels can
+	// be loaded again
+	void AddTexture(int textureIndex, const std::string& filename);
+	// pass in how many pixels one repeat of a texture covers on
+	// the screen in this frame
+	void AddCoverage(int textureIndex, float pixels);
+	// move the stored levels of the arrays toward what this
+	// frame's coverage wants
+	void Update();
+	// forget the registered textures
+	void Clear();
+
+	// bytes the stored levels of every array take
+	size_t GetStoredBytes() const;
+
+private:
+	// pointer to the loader that reloads the images
+	TextureLoader* m_pTextureLoader;
+	// pointer to the arrays whose levels are streamed
+	TextureArrays* m_pTextureArrays;
+	// bytes the stored levels may take, or 0 for no limit
+	size_t m_budgetBytes;
+	// image file of each texture, indexed by texture index
+	std::vector<std::string> m_filenames;
+	// most pixels each texture covers in the current frame
+	std::vector<float> m_coverage;
+	// last frame each array was seen in, indexed by array
+	std::vector<int> m_lastSeenFrames;
+	// number of the current frame
+	int m_frame;
+
+	// drop the finest stored level of the array that was seen
+	// longest ago - arrays seen in the last idle frames are only
+	// dropped when bIdleOnly is false
+	bool DropLeastRecentLevel(int keptArray, bool bIdleOnly, size_t& storedBytes);
+	// add levels to an array and reload the images of its layers
+	void GrowArray(int arrayIndex, int storageLevel, size_t& storedBytes);
+};
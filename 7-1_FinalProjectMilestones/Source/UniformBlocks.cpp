@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.cpp
+// ============
+// std140 uniform buffer blocks for the camera, the lights and the materials
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBlocks.h"
+
+// the CPU copies are uploaded as they are, so their sizes
+// must match the std140 layout of the blocks
+static_assert(sizeof(UniformBlocks::LIGHT_DATA) == 48, "LIGHT_DATA does not match the std140 layout");
+static_assert(sizeof(UniformBlocks::MATERIAL_DATA) == 48, "MATERIAL_DATA does not match the std140 layout");
+
+/***********************************************************
+ *  UniformBlocks()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBlocks::UniformBlocks()
+{
+	LIGHT_DATA emptyLight;
+	MATERIAL_DATA emptyMaterial;
+
+	emptyLight.position = glm::vec3(0.0f);
+	emptyLight.focalStrength = 0.0f;
+	emptyLight.diffuseColor = glm::vec3(0.0f);
+	emptyLight.specularIntensity = 0.0f;
+	emptyLight.specularColor = glm::vec3(0.0f);
+	emptyLight.padding = 0.0f;
+	emptyMaterial.ambientColor = glm::vec3(0.0f);
+	emptyMaterial.ambientStrength = 0.0f;
+	emptyMaterial.diffuseColor = glm::vec3(0.0f);
+	emptyMaterial.shininess = 0.0f;
+	emptyMaterial.specularColor = glm::vec3(0.0f);
+	emptyMaterial.padding = 0.0f;
+
+	m_cameraBlock.view = glm::mat4(1.0f);
+	m_cameraBlock.projection = glm::mat4(1.0f);
+	m_cameraBlock.viewPosition = glm::vec3(0.0f);
+	m_cameraBlock.padding = 0.0f;
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		m_lightBlock.lightSources[i] = emptyLight;
+	}
+	m_lightBlock.globalAmbientColor = glm::vec3(0.0f);
+	m_lightBlock.padding = 0.0f;
+	m_lightCount = 0;
+	for (int i = 0; i < MAX_MATERIALS; i++)
+	{
+		m_materialBlock.materials[i] = emptyMaterial;
+	}
+	m_buffers[CAMERA_BINDING] = 0;
+	m_buffers[LIGHT_BINDING] = 0;
+	m_buffers[MATERIAL_BINDING] = 0;
+	m_pStreamBuffer = NULL;
+	m_bCameraStreamed = false;
+	m_bCameraDirty = true;
+	m_bLightsDirty = true;
+	m_firstDirtyMaterial = 0;
+	m_lastDirtyMaterial = MAX_MATERIALS - 1;
+}
+
+/***********************************************************
+ *  ~UniformBlocks()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBlocks::~UniformBlocks()
+{
+	if (m_buffers[CAMERA_BINDING] != 0)
+	{
+		glDeleteBuffers(3, m_buffers);
+	}
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the uniform buffers with
+ *  the size of their blocks and attaching each one to its
+ *  binding point.  The shaders pick the blocks up through the
+ *  binding layout qualifiers.
+ ***********************************************************/
+void UniformBlocks::CreateBuffers()
+{
+	const GLsizeiptr blockSizes[3] =
+	{
+		sizeof(CAMERA_BLOCK),
+		sizeof(LIGHT_BLOCK),
+		sizeof(MATERIAL_BLOCK)
+	};
+
+	if (m_buffers[CAMERA_BINDING] != 0)
+	{
+		return;
+	}
+
+	glGenBuffers(3, m_buffers);
+	for (GLuint binding = 0; binding < 3; binding++)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffers[binding]);
+		glBufferData(GL_UNIFORM_BUFFER, blockSizes[binding], NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_buffers[binding]);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// every block is uploaded on the first update
+	m_bCameraDirty = true;
+	m_bLightsDirty = true;
+	m_firstDirtyMaterial = 0;
+	m_lastDirtyMaterial = MAX_MATERIALS - 1;
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for setting the view values of the
+ *  camera block.
+ ***********************************************************/
+void UniformBlocks::SetCamera(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition)
+{
+	if ((m_cameraBlock.view == view) &&
+		(m_cameraBlock.projection == projection) &&
+		(m_cameraBlock.viewPosition == viewPosition))
+	{
+		return;
+	}
+
+	m_cameraBlock.view = view;
+	m_cameraBlock.projection = projection;
+	m_cameraBlock.viewProjection = projection * view;
+	m_cameraBlock.viewPosition = viewPosition;
+	m_bCameraDirty = true;
+}
+
+/***********************************************************
+ *  SetLight()
+ *
+ *  This method is used for setting one light source of the
+ *  light block.
+ ***********************************************************/
+void UniformBlocks::SetLight(int lightIndex, const LIGHT_DATA& light)
+{
+	if ((lightIndex < 0) || (lightIndex >= MAX_LIGHTS))
+	{
+		return;
+	}
+
+	m_lightBlock.lightSources[lightIndex] = light;
+	m_lightBlock.lightSources[lightIndex].padding = 0.0f;
+	m_bLightsDirty = true;
+	if (lightIndex >= m_lightCount)
+	{
+		m_lightCount = lightIndex + 1;
+	}
+}
+
+/***********************************************************
+ *  SetGlobalAmbientColor()
+ *
+ *  This method is used for setting the ambient color that is
+ *  added by every light source.
+ ***********************************************************/
+void UniformBlocks::SetGlobalAmbientColor(const glm::vec3& color)
+{
+	m_lightBlock.globalAmbientColor = color;
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  SetMaterial()
+ *
+ *  This method is used for setting an entry of the material
+ *  table.  Only the changed range of entries is uploaded.
+ ***********************************************************/
+void UniformBlocks::SetMaterial(int materialIndex, const MATERIAL_DATA& material)
+{
+	if ((materialIndex < 0) || (materialIndex >= MAX_MATERIALS))
+	{
+		return;
+	}
+
+	m_materialBlock.materials[materialIndex] = material;
+	m_materialBlock.materials[materialIndex].padding = 0.0f;
+
+	if ((m_firstDirtyMaterial < 0) || (materialIndex < m_firstDirtyMaterial))
+		m_firstDirtyMaterial = materialIndex;
+	if (materialIndex > m_lastDirtyMaterial)
+		m_lastDirtyMaterial = materialIndex;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the blocks that changed
+ *  since the last update.  It is called once per frame before
+ *  anything is drawn.  A streamed camera block is copied every
+ *  frame, since the region of an earlier frame is reused.
+ ***********************************************************/
+void UniformBlocks::Update()
+{
+	if ((NULL != m_pStreamBuffer) && (m_buffers[CAMERA_BINDING] != 0) &&
+		(m_pStreamBuffer->UploadAndBind(GL_UNIFORM_BUFFER, CAMERA_BINDING, &m_cameraBlock, sizeof(m_cameraBlock)) == true))
+	{
+		m_bCameraStreamed = true;
+		m_bCameraDirty = false;
+	}
+	else if ((m_bCameraDirty == true) || (m_bCameraStreamed == true))
+	{
+		// go back to the camera buffer when the stream is full
+		if (m_bCameraStreamed == true)
+		{
+			glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, m_buffers[CAMERA_BINDING]);
+			m_bCameraStreamed = false;
+		}
+		UploadBlock(CAMERA_BINDING, 0, sizeof(m_cameraBlock), &m_cameraBlock);
+		m_bCameraDirty = false;
+	}
+
+	if (m_bLightsDirty == true)
+	{
+		UploadBlock(LIGHT_BINDING, 0, sizeof(m_lightBlock), &m_lightBlock);
+		m_bLightsDirty = false;
+	}
+
+	if (m_firstDirtyMaterial >= 0)
+	{
+		UploadBlock(
+			MATERIAL_BINDING,
+			sizeof(MATERIAL_DATA) * m_firstDirtyMaterial,
+			sizeof(MATERIAL_DATA) * (m_lastDirtyMaterial - m_firstDirtyMaterial + 1),
+			&m_materialBlock.materials[m_firstDirtyMaterial]);
+		m_firstDirtyMaterial = -1;
+		m_lastDirtyMaterial = -1;
+	}
+}
+
+/***********************************************************
+ *  UploadBlock()
+ *
+ *  This method is used for copying part of a block into its
+ *  uniform buffer.
+ ***********************************************************/
+void UniformBlocks::UploadBlock(BLOCK_BINDING binding, size_t offset, size_t size, const void* pData)
+{
+	if (m_buffers[binding] == 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffers[binding]);
+	glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)offset, (GLsizeiptr)size, pData);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
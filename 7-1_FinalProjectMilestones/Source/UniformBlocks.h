@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ============
+// std140 uniform buffer blocks for the camera, the lights and the materials
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StreamBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  UniformBlocks
+ *
+ *  This class owns the uniform buffer objects that back the
+ *  std140 uniform blocks declared in the shaders.  The block
+ *  values are kept in CPU copies that match the std140
+ *  layout, and each block that changed is uploaded with one
+ *  glBufferSubData call in Update().  The camera block, which
+ *  changes nearly every frame, is copied into the stream
+ *  buffer instead when one is set.
+ ***********************************************************/
+class UniformBlocks
+{
+public:
+	// constructor
+	UniformBlocks();
+	// destructor
+	~UniformBlocks();
+
+	// number of light sources in the light block
+	static const int MAX_LIGHTS = 2;
+	// number of materials in the material table
+	static const int MAX_MATERIALS = 64;
+
+	// binding points - must match the binding layout
+	// qualifiers of the blocks in the shaders
+	enum BLOCK_BINDING
+	{
+		CAMERA_BINDING = 0,
+		LIGHT_BINDING = 1,
+		MATERIAL_BINDING = 2
+	};
+
+	// one light source - a float follows each vec3 so the
+	// members line up with the std140 layout
+	struct LIGHT_DATA
+	{
+		glm::vec3 position;
+		float focalStrength;
+		glm::vec3 diffuseColor;
+		float specularIntensity;
+		glm::vec3 specularColor;
+		float padding;
+	};
+
+	// one entry of the material table
+	struct MATERIAL_DATA
+	{
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		float shininess;
+		glm::vec3 specularColor;
+		float padding;
+	};
+
+	// create the uniform buffers and attach them to their
+	// binding points - needs a current OpenGL context
+	void CreateBuffers();
+
+	// set the view values of the camera block
+	void SetCamera(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition);
+	// set a light source of the light block
+	void SetLight(int lightIndex, const LIGHT_DATA& light);
+	// number of light sources up to the last one that was set
+	int GetLightCount() const { return(m_lightCount); }
+	// set the global ambient color of the light block
+	void SetGlobalAmbientColor(const glm::vec3& color);
+	// set an entry of the material table
+	void SetMaterial(int materialIndex, const MATERIAL_DATA& material);
+
+	// upload the blocks that changed since the last update
+	void Update();
+	// copy the per-frame camera block into the passed in
+	// stream buffer instead of its own uniform buffer
+	void SetStreamBuffer(StreamBuffer* pStreamBuffer) { m_pStreamBuffer = pStreamBuffer; }
+
+private:
+	struct CAMERA_BLOCK
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		// projection times view, multiplied once per frame here
+		// instead of once per vertex in the shader
+		glm::mat4 viewProjection;
+		glm::vec3 viewPosition;
+		float padding;
+	};
+
+	struct LIGHT_BLOCK
+	{
+		LIGHT_DATA lightSources[MAX_LIGHTS];
+		glm::vec3 globalAmbientColor;
+		float padding;
+	};
+
+	struct MATERIAL_BLOCK
+	{
+		MATERIAL_DATA materials[MAX_MATERIALS];
+	};
+
+	// CPU copies of the blocks
+	CAMERA_BLOCK m_cameraBlock;
+	LIGHT_BLOCK m_lightBlock;
+	MATERIAL_BLOCK m_materialBlock;
+	// light sources up to the last one that was set
+	int m_lightCount;
+	// uniform buffers indexed by binding point
+	GLuint m_buffers[3];
+	// pointer to the per-frame stream buffer, or NULL
+	StreamBuffer* m_pStreamBuffer;
+	// true when the camera block binding is in the stream buffer
+	bool m_bCameraStreamed;
+	// blocks changed since the last update
+	bool m_bCameraDirty;
+	bool m_bLightsDirty;
+	// range of material entries changed since the last update
+	int m_firstDirtyMaterial;
+	int m_lastDirtyMaterial;
+
+	// upload part of a block into its uniform buffer
+	void UploadBlock(BLOCK_BINDING binding, size_t offset, size_t size, const void* pData);
+};
@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// resolve and cache the shader uniform locations once after linking
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_programID = 0;
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_locations.clear();
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for resolving the location of every
+ *  active uniform in the passed in program.  Array uniforms
+ *  are registered under each element name and also under
+ *  the name without the "[0]" subscript.
+ ***********************************************************/
+void UniformCache::LoadProgram(GLuint programID)
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+
+	m_programID = programID;
+	m_locations.clear();
+
+	// a newly linked program starts with default uniform values
+	if (NULL != m_pStateCache)
+	{
+		m_pStateCache->Invalidate();
+	}
+
+	if (m_programID == 0)
+	{
+		return;
+	}
+
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+
+		glGetActiveUniform(m_programID, (GLuint)i, (GLsizei)nameBuffer.size(), &nameLength, &arraySize, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), nameLength);
+		GLint location = glGetUniformLocation(m_programID, name.c_str());
+
+		// uniforms inside uniform blocks have no location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		m_locations[name] = location;
+
+		// register every element of an array of basic types
+		size_t subscript = name.rfind("[0]");
+		if ((subscript != std::string::npos) && (subscript + 3 == name.size()))
+		{
+			std::string baseName = name.substr(0, subscript);
+			m_locations[baseName] = location;
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				m_locations[elementName] = glGetUniformLocation(m_programID, elementName.c_str());
+			}
+		}
+	}
+
+	std::cout << "Cached " << m_locations.size() << " uniform locations for shader program " << m_programID << std::endl;
+}
+
+/***********************************************************
+ *  LoadCurrentProgram()
+ *
+ *  This method is used for resolving the active uniforms of
+ *  the shader program that is currently in use.
+ ***********************************************************/
+void UniformCache::LoadCurrentProgram()
+{
+	GLint programID = 0;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	LoadProgram((GLuint)programID);
+}
+
+/***********************************************************
+ *  FindLocation()
+ *
+ *  This method is used for getting the cached location of
+ *  the uniform with the passed in name.
+ ***********************************************************/
+GLint UniformCache::FindLocation(const std::string& name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator found = m_locations.find(name);
+	if (found == m_locations.end())
+	{
+		return(-1);
+	}
+
+	return(found->second);
+}
+
+/***********************************************************
+ *  IsRedundant()
+ *
+ *  This method is used for checking whether the value being
+ *  uploaded is already set in the shader program.  Without a
+ *  state cache every upload is passed on to OpenGL.
+ ***********************************************************/
+bool UniformCache::IsRedundant(GLint location, const void* pValue, size_t valueSize)
+{
+	if (NULL == m_pStateCache)
+	{
+		return(false);
+	}
+
+	return(m_pStateCache->FilterUniform(m_programID, location, pValue, valueSize));
+}
+
+/***********************************************************
+ *  SetValue()
+ *
+ *  These methods are used for setting uniform values into
+ *  the shader program through the cached locations.
+ ***********************************************************/
+void UniformCache::SetValue(UniformHandle<bool> handle, bool value)
+{
+	int intValue = (int)value;
+
+	if (IsRedundant(handle.location, &intValue, sizeof(intValue)))
+		return;
+	glUniform1i(handle.location, intValue);
+}
+
+void UniformCache::SetValue(UniformHandle<int> handle, int value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniform1i(handle.location, value);
+}
+
+void UniformCache::SetValue(UniformHandle<float> handle, float value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniform1f(handle.location, value);
+}
+
+void UniformCache::SetValue(UniformHandle<glm::vec2> handle, const glm::vec2& value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniform2fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetValue(UniformHandle<glm::vec3> handle, const glm::vec3& value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniform3fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetValue(UniformHandle<glm::vec4> handle, const glm::vec4& value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniform4fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void UniformCache::SetValue(UniformHandle<glm::mat3> handle, const glm::mat3& value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void UniformCache::SetValue(UniformHandle<glm::mat4> handle, const glm::mat4& value)
+{
+	if (IsRedundant(handle.location, &value, sizeof(value)))
+		return;
+	glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// resolve and cache the shader uniform locations once after linking
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "StateCache.h"
+
+#include <string>
+#include <unordered_map>
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class resolves the location of every active uniform
+ *  of a linked shader program one time.  It hands out typed
+ *  handles that can be stored and used for setting uniform
+ *  values without any per-call name lookups.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+	// destructor
+	~UniformCache();
+
+	// typed handle to a cached uniform location - the type
+	// only selects which setter the handle can be passed to
+	template <typename T>
+	struct UniformHandle
+	{
+		GLint location;
+
+		UniformHandle() : location(-1) {}
+		bool IsValid() const { return(location >= 0); }
+	};
+
+	// resolve the active uniforms of the passed in program
+	void LoadProgram(GLuint programID);
+	// resolve the active uniforms of the program in use
+	void LoadCurrentProgram();
+	// get the program the cached locations belong to
+	GLuint GetProgramID() const { return(m_programID); }
+	// filter redundant uniform uploads through the state cache
+	void SetStateCache(StateCache* pStateCache) { m_pStateCache = pStateCache; }
+
+	// get the cached location of a uniform, or -1 if the
+	// program does not have an active uniform with the name
+	GLint FindLocation(const std::string& name) const;
+
+	// get a typed handle for the uniform with the passed in name
+	template <typename T>
+	UniformHandle<T> GetHandle(const std::string& name) const
+	{
+		UniformHandle<T> handle;
+		handle.location = FindLocation(name);
+		return(handle);
+	}
+
+	// set the uniform values through the typed handles
+	void SetValue(UniformHandle<bool> handle, bool value);
+	void SetValue(UniformHandle<int> handle, int value);
+	void SetValue(UniformHandle<float> handle, float value);
+	void SetValue(UniformHandle<glm::vec2> handle, const glm::vec2& value);
+	void SetValue(UniformHandle<glm::vec3> handle, const glm::vec3& value);
+	void SetValue(UniformHandle<glm::vec4> handle, const glm::vec4& value);
+	void SetValue(UniformHandle<glm::mat3> handle, const glm::mat3& value);
+	void SetValue(UniformHandle<glm::mat4> handle, const glm::mat4& value);
+
+private:
+	// program the cached locations belong to
+	GLuint m_programID;
+	// uniform locations keyed by their full names
+	std::unordered_map<std::string, GLint> m_locations;
+	// pointer to the state cache that filters redundant uploads
+	StateCache* m_pStateCache;
+
+	// check whether an upload can be skipped
+	bool IsRedundant(GLint location, const void* pValue, size_t valueSize);
+};
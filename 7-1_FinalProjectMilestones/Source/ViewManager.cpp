@@ -1,284 +1,454 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.cpp
-// ============
-// manage the viewing of 3D objects within the viewport - camera, projection
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "ViewManager.h"
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>    
-
-// declaration of the global variables and defines
-namespace
-{
-	// Variables for window width and height
-	const int WINDOW_WIDTH = 1000;
-	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
-
-	// camera object used for viewing and interacting with
-	// the 3D scene
-	Camera* g_pCamera = nullptr;
-
-	// these variables are used for mouse movement processing
-	float gLastX = WINDOW_WIDTH / 2.0f;
-	float gLastY = WINDOW_HEIGHT / 2.0f;
-	bool gFirstMouse = true;
-
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f;
-	float gLastFrame = 0.0f;
-
-	// if orthographic projection is on, this value will be true automatically
-	bool bOrthographicProjection = false;
-
-	float gLookSpeed = 1.0f;  //  look speed
-	float gCameraSpeed = 1.0f;  //  camera speed for both movement and look sensitivity
-
-	bool gIsPerspective = true;
-
-	// Orthographic projection parameters for automatic view
-	float gOrthoLeft = -10.0f;
-	float gOrthoRight = 10.0f;
-	float gOrthoBottom = -10.0f;
-	float gOrthoTop = 10.0f;
-	float gOrthoNear = 0.1f;
-	float gOrthoFar = 100.0f;
-
-}
-
-/***********************************************************
- *  ViewManager()
- *
- *  The constructor for the class
- ***********************************************************/
-ViewManager::ViewManager(
-	ShaderManager* pShaderManager)
-{
-	// initialize the member variables
-	m_pShaderManager = pShaderManager;
-	m_pWindow = NULL;
-	g_pCamera = new Camera();
-	// default camera view parameters
-	g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
-	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
-	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-	g_pCamera->Zoom = 80;
-	g_pCamera->MovementSpeed = 10;
-}
-
-/***********************************************************
- *  ~ViewManager()
- *
- *  The destructor for the class
- ***********************************************************/
-ViewManager::~ViewManager()
-{
-	// free up allocated memory
-	m_pShaderManager = NULL;
-	m_pWindow = NULL;
-	if (NULL != g_pCamera)
-	{
-		delete g_pCamera;
-		g_pCamera = NULL;
-	}
-}
-
-/***********************************************************
- *  CreateDisplayWindow()
- *
- *  This method is used to create the main display window.
- ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
-{
-	GLFWwindow* window = nullptr;
-
-	// try to create the displayed OpenGL window
-	window = glfwCreateWindow(
-		WINDOW_WIDTH,
-		WINDOW_HEIGHT,
-		windowTitle,
-		NULL, NULL);
-	if (window == NULL)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return NULL;
-	}
-	glfwMakeContextCurrent(window);
-
-	// this callback is used to receive mouse moving events
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
-
-	//new mouse scroll code added
-	glfwSetScrollCallback(window, &ViewManager::Mouse_Wheel_Callback);
-
-
-	// tell GLFW to capture all mouse events
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	m_pWindow = window;
-
-	return(window);
-}
-
-/***********************************************************
- *  Mouse_Position_Callback()
- *
- *  This method is automatically called from GLFW whenever
- *  the mouse is moved within the active GLFW display window.
- ***********************************************************/
-void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
-{
-	if (gFirstMouse)
-	{
-		gLastX = xMousePos;
-		gLastY = yMousePos;
-		gFirstMouse = false;
-	}
-
-	// Calculate the X offset and Y offset values for moving the 3D camera accordingly
-	float xOffset = (xMousePos - gLastX) * gCameraSpeed;
-	float yOffset = (gLastY - yMousePos) * gCameraSpeed; // Reversed since y-coordinates go from bottom to top
-
-	// Set the current positions into the last position variables
-	gLastX = xMousePos;
-	gLastY = yMousePos;
-
-	// Move the 3D camera according to the calculated offsets
-	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
-}
-
-
-//MouseWheelCallback()
-void ViewManager::Mouse_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance)
-{
-
-	gCameraSpeed += yScrollDistance * 0.1f;
-
-	if (gCameraSpeed < 0.1f)
-	{
-		gCameraSpeed = 0.1f;  // Minimum speed
-	}
-	else if (gCameraSpeed > 10.0f)
-	{
-		gCameraSpeed = 10.0f; // Maximum speed
-	}
-}
-/***********************************************************
- *  ProcessKeyboardEvents()
- *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
- ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
-{
-	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-	{
-		glfwSetWindowShouldClose(m_pWindow, true);
-	}
-
-	// if the camera object is null, then exit this method
-	if (NULL == g_pCamera)
-	{
-		return;
-	}
-
-	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime * gCameraSpeed);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime * gCameraSpeed);
-	}
-
-	// process camera panning left and right
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime * gCameraSpeed);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime * gCameraSpeed);
-	}
-
-	//basically took boiler point from above and added UP and DOWN which were given
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime * gCameraSpeed);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime * gCameraSpeed);
-	}
-
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
-	{
-		gIsPerspective = true;
-		g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
-		g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
-	{
-		gIsPerspective = false;
-		g_pCamera->Position = glm::vec3(0.0f, 0.0f, 10.0f);
-		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
-	}
-
-}
-
-/***********************************************************
- *  PrepareSceneView()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
- ***********************************************************/
-void ViewManager::PrepareSceneView()
-{
-	glm::mat4 view;
-	glm::mat4 projection;
-
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// Process any keyboard events that may be waiting in the event queue
-	ProcessKeyboardEvents();
-
-	// Get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
-
-	// Define the current projection matrix
-	if (gIsPerspective)
-	{
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
-	}
-	else
-	{
-		projection = glm::ortho(gOrthoLeft, gOrthoRight, gOrthoBottom, gOrthoTop, gOrthoNear, gOrthoFar);
-	}
-
-	// If the shader manager object is valid
-	if (NULL != m_pShaderManager)
-	{
-		//setting view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-	}
-}
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.cpp
+// ============
+// manage the viewing of 3D objects within the viewport - camera, projection
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ViewManager.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>    
+
+// declaration of the global variables and defines
+namespace
+{
+	// Variables for window width and height
+	const int WINDOW_WIDTH = 1000;
+	const int WINDOW_HEIGHT = 800;
+
+	// camera object used for viewing and interacting with
+	// the 3D scene
+	Camera* g_pCamera = nullptr;
+
+	// these variables are used for mouse movement processing
+	float gLastX = WINDOW_WIDTH / 2.0f;
+	float gLastY = WINDOW_HEIGHT / 2.0f;
+	bool gFirstMouse = true;
+
+	// if orthographic projection is on, this value will be true automatically
+	bool bOrthographicProjection = false;
+
+	float gLookSpeed = 1.0f;  //  look speed
+	float gCameraSpeed = 1.0f;  //  camera speed for both movement and look sensitivity
+
+	bool gIsPerspective = true;
+
+	// Orthographic projection parameters for automatic view
+	float gOrthoLeft = -10.0f;
+	float gOrthoRight = 10.0f;
+	float gOrthoBottom = -10.0f;
+	float gOrthoTop = 10.0f;
+	float gOrthoNear = 0.1f;
+	float gOrthoFar = 100.0f;
+
+}
+
+/***********************************************************
+ *  ViewManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ViewManager::ViewManager(
+	ShaderManager* pShaderManager,
+	UniformBlocks* pUniformBlocks)
+{
+	// initialize the member variables
+	m_pShaderManager = pShaderManager;
+	m_pUniformBlocks = pUniformBlocks;
+	m_pWindow = NULL;
+	m_viewportWidth = WINDOW_WIDTH;
+	m_viewportHeight = WINDOW_HEIGHT;
+	m_bPickButtonDown = false;
+	m_bPickRequested = false;
+	g_pCamera = new Camera();
+	// default camera view parameters
+	g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
+	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
+	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	g_pCamera->Zoom = 80;
+	g_pCamera->MovementSpeed = 10;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = g_pCamera->Position;
+	m_previousPosition = g_pCamera->Position;
+}
+
+/***********************************************************
+ *  ~ViewManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ViewManager::~ViewManager()
+{
+	// free up allocated memory
+	m_pShaderManager = NULL;
+	m_pUniformBlocks = NULL;
+	m_pWindow = NULL;
+	if (NULL != g_pCamera)
+	{
+		delete g_pCamera;
+		g_pCamera = NULL;
+	}
+}
+
+/***********************************************************
+ *  CreateDisplayWindow()
+ *
+ *  This method is used to create the main display window.
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+{
+	GLFWwindow* window = nullptr;
+
+	// try to create the displayed OpenGL window
+	window = glfwCreateWindow(
+		WINDOW_WIDTH,
+		WINDOW_HEIGHT,
+		windowTitle,
+		NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+
+	// this callback is used to receive mouse moving events
+	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+
+	//new mouse scroll code added
+	glfwSetScrollCallback(window, &ViewManager::Mouse_Wheel_Callback);
+
+
+	// tell GLFW to capture all mouse events
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// enable blending for supporting tranparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = window;
+
+	return(window);
+}
+
+/***********************************************************
+ *  CreateHiddenWindow()
+ *
+ *  This method is used to create a window that is never
+ *  shown, so the scene can be drawn into offscreen targets
+ *  without any input.  Vsync is turned off, so the frames
+ *  are not held to the display refresh.
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateHiddenWindow(const char* windowTitle)
+{
+	GLFWwindow* window = nullptr;
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	window = glfwCreateWindow(
+		WINDOW_WIDTH,
+		WINDOW_HEIGHT,
+		windowTitle,
+		NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+
+	// enable blending for supporting tranparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = window;
+
+	return(window);
+}
+
+/***********************************************************
+ *  SetViewportSize()
+ *
+ *  This method is used for setting the size of the target
+ *  that the scene is drawn into, which sets the aspect of
+ *  the perspective projection.
+ ***********************************************************/
+void ViewManager::SetViewportSize(int width, int height)
+{
+	if ((width > 0) && (height > 0))
+	{
+		m_viewportWidth = width;
+		m_viewportHeight = height;
+	}
+}
+
+/***********************************************************
+ *  GetCameraKey()
+ *
+ *  This method is used for getting the current state of the
+ *  camera as a camera path key.
+ ***********************************************************/
+CameraPath::CAMERA_KEY ViewManager::GetCameraKey() const
+{
+	CameraPath::CAMERA_KEY key;
+
+	key.position = g_pCamera->Position;
+	key.front = g_pCamera->Front;
+	key.up = g_pCamera->Up;
+	key.zoom = g_pCamera->Zoom;
+
+	return(key);
+}
+
+/***********************************************************
+ *  SetCameraKey()
+ *
+ *  This method is used for moving the camera to the state
+ *  of a camera path key.  The camera jumps to the key
+ *  instead of moving there over the next update.
+ ***********************************************************/
+void ViewManager::SetCameraKey(const CameraPath::CAMERA_KEY& key)
+{
+	m_previousPosition = key.position;
+	g_pCamera->Position = key.position;
+	g_pCamera->Front = key.front;
+	g_pCamera->Up = key.up;
+	g_pCamera->Zoom = key.zoom;
+}
+
+/***********************************************************
+ *  Mouse_Position_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the mouse is moved within the active GLFW display window.
+ ***********************************************************/
+void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
+{
+	if (gFirstMouse)
+	{
+		gLastX = xMousePos;
+		gLastY = yMousePos;
+		gFirstMouse = false;
+	}
+
+	// Calculate the X offset and Y offset values for moving the 3D camera accordingly
+	float xOffset = (xMousePos - gLastX) * gCameraSpeed;
+	float yOffset = (gLastY - yMousePos) * gCameraSpeed; // Reversed since y-coordinates go from bottom to top
+
+	// Set the current positions into the last position variables
+	gLastX = xMousePos;
+	gLastY = yMousePos;
+
+	// Move the 3D camera according to the calculated offsets
+	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+}
+
+
+//MouseWheelCallback()
+void ViewManager::Mouse_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance)
+{
+
+	gCameraSpeed += yScrollDistance * 0.1f;
+
+	if (gCameraSpeed < 0.1f)
+	{
+		gCameraSpeed = 0.1f;  // Minimum speed
+	}
+	else if (gCameraSpeed > 10.0f)
+	{
+		gCameraSpeed = 10.0f; // Maximum speed
+	}
+}
+/***********************************************************
+ *  ProcessKeyboardEvents()
+ *
+ *  This method is called to process any keyboard events
+ *  that may be waiting in the event queue.
+ ***********************************************************/
+void ViewManager::ProcessKeyboardEvents(float timeStep)
+{
+	// close the window if the escape key has been pressed
+	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	{
+		glfwSetWindowShouldClose(m_pWindow, true);
+	}
+
+	// if the camera object is null, then exit this method
+	if (NULL == g_pCamera)
+	{
+		return;
+	}
+
+	// process camera zooming in and out
+	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(FORWARD, timeStep * gCameraSpeed);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(BACKWARD, timeStep * gCameraSpeed);
+	}
+
+	// process camera panning left and right
+	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(LEFT, timeStep * gCameraSpeed);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(RIGHT, timeStep * gCameraSpeed);
+	}
+
+	//basically took boiler point from above and added UP and DOWN which were given
+	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(UP, timeStep * gCameraSpeed);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(DOWN, timeStep * gCameraSpeed);
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+	{
+		gIsPerspective = true;
+		g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
+		g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+	{
+		gIsPerspective = false;
+		g_pCamera->Position = glm::vec3(0.0f, 0.0f, 10.0f);
+		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+	}
+
+	// request a pick when the left mouse button goes down
+	bool bPickButtonDown = (glfwGetMouseButton(m_pWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+	if ((bPickButtonDown == true) && (m_bPickButtonDown == false))
+	{
+		m_bPickRequested = true;
+	}
+	m_bPickButtonDown = bPickButtonDown;
+
+}
+
+/***********************************************************
+ *  UpdateView()
+ *
+ *  This method is used for running one fixed update of the
+ *  camera.  The updates run at their own rate, so the camera
+ *  moves the same distance each second at any frame rate.
+ ***********************************************************/
+void ViewManager::UpdateView(float timeStep)
+{
+	if (NULL == g_pCamera)
+	{
+		return;
+	}
+
+	m_previousPosition = g_pCamera->Position;
+
+	// Process any keyboard events that may be waiting in the event queue
+	ProcessKeyboardEvents(timeStep);
+}
+
+/***********************************************************
+ *  PrepareSceneView()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene
+ *  rendering.  The camera position is blended between the
+ *  last two updates, while the look direction follows the
+ *  mouse right away, since any delay there is felt.
+ ***********************************************************/
+void ViewManager::PrepareSceneView(float interpolation)
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	// Get the current view matrix from the blended camera position
+	m_viewPosition = glm::mix(m_previousPosition, g_pCamera->Position, glm::clamp(interpolation, 0.0f, 1.0f));
+	view = glm::lookAt(m_viewPosition, m_viewPosition + g_pCamera->Front, g_pCamera->Up);
+
+	// Define the current projection matrix
+	if (gIsPerspective)
+	{
+		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)m_viewportWidth / (GLfloat)m_viewportHeight, 0.1f, 100.0f);
+	}
+	else
+	{
+		projection = glm::ortho(gOrthoLeft, gOrthoRight, gOrthoBottom, gOrthoTop, gOrthoNear, gOrthoFar);
+	}
+
+	// keep the view values for the rest of the frame
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
+	// If the uniform blocks object is valid
+	if (NULL != m_pUniformBlocks)
+	{
+		// setting the view values into the camera block - the
+		// block is uploaded once before the scene is drawn
+		m_pUniformBlocks->SetCamera(view, projection, m_viewPosition);
+	}
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the world space ray that
+ *  passes through the passed in window position, from the
+ *  near plane toward the far plane of the current view.
+ ***********************************************************/
+void ViewManager::GetPickRay(
+	float windowX,
+	float windowY,
+	glm::vec3& origin,
+	glm::vec3& direction) const
+{
+	glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+
+	// window y goes down while normalized device y goes up
+	float ndcX = ((2.0f * windowX) / m_viewportWidth) - 1.0f;
+	float ndcY = 1.0f - ((2.0f * windowY) / m_viewportHeight);
+
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	origin = glm::vec3(nearPoint);
+	direction = glm::normalize(glm::vec3(farPoint) - glm::vec3(nearPoint));
+}
+
+/***********************************************************
+ *  TakePickRay()
+ *
+ *  This method is used for getting the ray of a pick that
+ *  was requested since the last call.  The cursor is captured
+ *  for the mouse look, so the tracked mouse position keeps
+ *  growing past the window edges - the pick ray goes through
+ *  the middle of the window, where the camera is looking.
+ ***********************************************************/
+bool ViewManager::TakePickRay(
+	glm::vec3& origin,
+	glm::vec3& direction)
+{
+	if (m_bPickRequested == false)
+	{
+		return(false);
+	}
+
+	m_bPickRequested = false;
+	GetPickRay(m_viewportWidth / 2.0f, m_viewportHeight / 2.0f, origin, direction);
+
+	return(true);
+}
\ No newline at end of file
@@ -1,47 +1,98 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.h
-// ============
-// manage the viewing of 3D objects within the viewport - camera, projection
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "camera.h"
-
-// GLFW library
-#include "GLFW/glfw3.h" 
-
-class ViewManager
-{
-public:
-	// constructor
-	ViewManager(
-		ShaderManager* pShaderManager);
-	// destructor
-	~ViewManager();
-
-	// mouse position callback for mouse interaction with the 3D scene
-	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
-
-	static void Mouse_Wheel_Callback(GLFWwindow* window, double xMousePos, double yScrollDistance);
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// active OpenGL display window
-	GLFWwindow* m_pWindow;
-
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
-
-public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.h
+// ============
+// manage the viewing of 3D objects within the viewport - camera, projection
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformBlocks.h"
+#include "CameraPath.h"
+#include "camera.h"
+
+// GLFW library
+#include "GLFW/glfw3.h" 
+
+class ViewManager
+{
+public:
+	// constructor
+	ViewManager(
+		ShaderManager* pShaderManager,
+		UniformBlocks* pUniformBlocks);
+	// destructor
+	~ViewManager();
+
+	// mouse position callback for mouse interaction with the 3D scene
+	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+
+	static void Mouse_Wheel_Callback(GLFWwindow* window, double xMousePos, double yScrollDistance);
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// pointer to the uniform blocks holding the camera values
+	UniformBlocks* m_pUniformBlocks;
+	// view values of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// camera position before the last view update, which the
+	// frames are drawn from toward the current position
+	glm::vec3 m_previousPosition;
+	// active OpenGL display window
+	GLFWwindow* m_pWindow;
+	// size in pixels of the target the scene is drawn into
+	int m_viewportWidth;
+	int m_viewportHeight;
+	// pick button state - a pick is requested when it is pressed
+	bool m_bPickButtonDown;
+	bool m_bPickRequested;
+
+	// process keyboard events for interaction with the 3D scene,
+	// moving the camera for the passed in seconds
+	void ProcessKeyboardEvents(float timeStep);
+
+public:
+	// create the initial OpenGL display window
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// create a hidden window that only provides the OpenGL
+	// context, with vsync off, for drawing into offscreen targets
+	GLFWwindow* CreateHiddenWindow(const char* windowTitle);
+	// set the size of the target the scene is drawn into, which
+	// is the window size unless an offscreen target is used
+	void SetViewportSize(int width, int height);
+
+	// get and set the camera state, such as for recording and
+	// replaying a camera path
+	CameraPath::CAMERA_KEY GetCameraKey() const;
+	void SetCameraKey(const CameraPath::CAMERA_KEY& key);
+	
+	// advance the camera by one fixed update of the passed in
+	// seconds from the input that is waiting
+	void UpdateView(float timeStep);
+	// prepare the conversion from 3D object display to 2D scene
+	// display, with the camera the passed in part of the way
+	// from the last update to the current one
+	void PrepareSceneView(float interpolation);
+
+	// get the view values of the current frame
+	const glm::mat4& GetViewMatrix() const { return(m_viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projectionMatrix); }
+	const glm::vec3& GetViewPosition() const { return(m_viewPosition); }
+
+	// get the world space ray through a window position
+	void GetPickRay(
+		float windowX,
+		float windowY,
+		glm::vec3& origin,
+		glm::vec3& direction) const;
+	// get the ray of a pick requested since the last call
+	bool TakePickRay(
+		glm::vec3& origin,
+		glm::vec3& direction);
 };
\ No newline at end of file
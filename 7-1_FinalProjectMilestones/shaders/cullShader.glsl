@@ -0,0 +1,194 @@
+#version 440 core
+// culls the draws of the GPU driven scene against the view frustum
+// and the hierarchical-Z pyramid of the occluders, picks their level
+// of detail and appends the visible draws to the
+// indirect command buffer
+layout (local_size_x = 64) in;
+
+struct ObjectData
+{
+   mat4 model;
+   vec4 color;
+   // world bounds - the w values hold the texture scale
+   vec4 boundsMinimum;
+   vec4 boundsMaximum;
+   // material index, texture array layer
+   ivec4 params;
+   mat3 normalMatrix;
+};
+
+struct DrawItem
+{
+   uint objectIndex;
+   uint meshIndex;
+   uint bucket;
+   uint commandOffset;
+};
+
+struct MeshRange
+{
+   uint indexCount;
+   uint firstIndex;
+   int baseVertex;
+   uint padding;
+};
+
+struct DrawCommand
+{
+   uint count;
+   uint instanceCount;
+   uint firstIndex;
+   int baseVertex;
+   uint baseInstance;
+};
+
+layout (std430, binding = 3) readonly buffer ObjectBuffer
+{
+   ObjectData objects[];
+};
+
+layout (std430, binding = 4) readonly buffer DrawItemBuffer
+{
+   DrawItem drawItems[];
+};
+
+// ranges of every mesh at every level - mesh * levelCount + level
+layout (std430, binding = 5) readonly buffer MeshRangeBuffer
+{
+   MeshRange meshRanges[];
+};
+
+layout (std430, binding = 6) writeonly buffer CommandBuffer
+{
+   DrawCommand commands[];
+};
+
+// number of commands appended to each bucket
+layout (std430, binding = 7) buffer DrawCountBuffer
+{
+   uint drawCounts[];
+};
+
+uniform vec4 frustumPlanes[6];
+uniform mat4 viewProjection;
+// scale from view space radius to normalized device radius
+uniform float lodScale;
+uniform uint drawItemCount;
+uniform uint levelCount;
+uniform float fullDetailRadius;
+// farthest occluder depth pyramid - only read when bUseOcclusion is true
+uniform bool bUseOcclusion = false;
+uniform sampler2D hiZBuffer;
+uniform int hiZLevelCount;
+
+// true when the box is on the inner side of every plane
+bool IsBoxInFrustum(vec3 boxMinimum, vec3 boxMaximum)
+{
+   for(int i = 0; i < 6; i++)
+   {
+      vec4 plane = frustumPlanes[i];
+      vec3 farCorner = mix(boxMinimum, boxMaximum, greaterThanEqual(plane.xyz, vec3(0.0f)));
+      if(dot(plane.xyz, farCorner) + plane.w < 0.0f)
+      {
+         return(false);
+      }
+   }
+
+   return(true);
+}
+
+// true when the box is behind the occluders in every pyramid texel
+// under its screen rectangle
+bool IsBoxOccluded(vec3 boxMinimum, vec3 boxMaximum)
+{
+   vec2 screenMinimum = vec2(1.0f);
+   vec2 screenMaximum = vec2(0.0f);
+   float nearestDepth = 1.0f;
+
+   for(int i = 0; i < 8; i++)
+   {
+      vec3 corner = vec3(
+         ((i & 1) != 0) ? boxMaximum.x : boxMinimum.x,
+         ((i & 2) != 0) ? boxMaximum.y : boxMinimum.y,
+         ((i & 4) != 0) ? boxMaximum.z : boxMinimum.z);
+      vec4 clip = viewProjection * vec4(corner, 1.0f);
+
+      // a box that reaches the camera plane is never hidden
+      if(clip.w <= 0.0f)
+      {
+         return(false);
+      }
+
+      vec3 window = ((clip.xyz / clip.w) * 0.5f) + 0.5f;
+      screenMinimum = min(screenMinimum, window.xy);
+      screenMaximum = max(screenMaximum, window.xy);
+      nearestDepth = min(nearestDepth, window.z);
+   }
+
+   screenMinimum = clamp(screenMinimum, vec2(0.0f), vec2(1.0f));
+   screenMaximum = clamp(screenMaximum, vec2(0.0f), vec2(1.0f));
+
+   // the level where the rectangle spans about two texels
+   vec2 extent = (screenMaximum - screenMinimum) * vec2(textureSize(hiZBuffer, 0));
+   int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0f)))), 0, hiZLevelCount - 1);
+   ivec2 levelSize = textureSize(hiZBuffer, level);
+   ivec2 first = min(ivec2(screenMinimum * vec2(levelSize)), levelSize - 1);
+   ivec2 last = min(ivec2(screenMaximum * vec2(levelSize)), levelSize - 1);
+
+   float farthestDepth = 0.0f;
+   for(int y = first.y; y <= last.y; y++)
+   {
+      for(int x = first.x; x <= last.x; x++)
+      {
+         farthestDepth = max(farthestDepth, texelFetch(hiZBuffer, ivec2(x, y), level).r);
+      }
+   }
+
+   return(nearestDepth > farthestDepth);
+}
+
+void main()
+{
+   uint drawIndex = gl_GlobalInvocationID.x;
+   if(drawIndex >= drawItemCount)
+   {
+      return;
+   }
+
+   DrawItem item = drawItems[drawIndex];
+   ObjectData object = objects[item.objectIndex];
+   vec3 boxMinimum = object.boundsMinimum.xyz;
+   vec3 boxMaximum = object.boundsMaximum.xyz;
+
+   if(IsBoxInFrustum(boxMinimum, boxMaximum) == false)
+   {
+      return;
+   }
+
+   if((bUseOcclusion == true) && (IsBoxOccluded(boxMinimum, boxMaximum) == true))
+   {
+      return;
+   }
+
+   // drop one level each time the projected radius halves
+   vec3 center = (boxMinimum + boxMaximum) * 0.5f;
+   float radius = length(boxMaximum - boxMinimum) * 0.5f;
+   float clipW = max((viewProjection * vec4(center, 1.0f)).w, 0.0001f);
+   float screenRadius = (radius * lodScale) / clipW;
+   uint level = 0u;
+   if(screenRadius < fullDetailRadius)
+   {
+      level = min(uint(log2(fullDetailRadius / max(screenRadius, 0.000001f))), levelCount - 1u);
+   }
+
+   MeshRange range = meshRanges[(item.meshIndex * levelCount) + level];
+
+   uint slot = atomicAdd(drawCounts[item.bucket], 1u);
+   DrawCommand command;
+   command.count = range.indexCount;
+   command.instanceCount = 1u;
+   command.firstIndex = range.firstIndex;
+   command.baseVertex = range.baseVertex;
+   command.baseInstance = item.objectIndex;
+   commands[item.commandOffset + slot] = command;
+}
\ No newline at end of file
@@ -1,107 +1,321 @@
-#version 440 core
-
-struct Material 
-{
-    vec3 diffuseColor;
-    vec3 specularColor;
-    float shininess;
-}; 
-
-struct LightSource 
-{
-    vec3 position;	
-    vec3 diffuseColor;
-    vec3 specularColor;
-    float focalStrength;
-    float specularIntensity;
-};
-
-#define TOTAL_LIGHTS 2
-
-in vec3 fragmentPosition;
-in vec3 fragmentVertexNormal;
-in vec2 fragmentTextureCoordinate;
-
-out vec4 outFragmentColor;
-
-uniform bool bUseTexture=false;
-uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform sampler2D objectTexture;
-uniform vec3 viewPosition;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
-uniform LightSource lightSources[TOTAL_LIGHTS];
-uniform Material material;
-uniform vec3 globalAmbientColor;
-    
-
-// function prototypes
-vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
-
-void main()
-{
-   if(bUseLighting == true)
-   {
-      // properties
-      vec3 lightNormal = normalize(fragmentVertexNormal);
-      vec3 viewDirection = normalize(viewPosition - fragmentPosition);
-      vec3 phongResult = vec3(0.0f);
-
-      for(int i = 0; i < TOTAL_LIGHTS; i++)
-      {
-         phongResult += CalcLightSource(lightSources[i], lightNormal, fragmentPosition, viewDirection); 
-      }   
-    
-      if(bUseTexture == true)
-      {
-         vec4 textureColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
-         outFragmentColor = vec4(phongResult * textureColor.xyz, 1.0);
-      }
-      else
-      {
-         outFragmentColor = vec4(phongResult * objectColor.xyz, objectColor.w);
-      }
-   }
-   else 
-   {
-      if(bUseTexture == true)
-      {
-         outFragmentColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
-      }
-      else
-      {
-         outFragmentColor = objectColor;
-      }
-   }
-}
-
-// calculates the color when using a directional light.
-vec3 CalcLightSource(LightSource light, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
-{
-   vec3 ambient;
-   vec3 diffuse;
-   vec3 specular;
-
-   //**Calculate Ambient lighting**
-
-   ambient = globalAmbientColor;
-
-   //**Calculate Diffuse lighting**
-
-   // Calculate distance (light direction) between light source and fragments/pixels
-   vec3 lightDirection = normalize(light.position - vertexPosition); 
-   // Calculate diffuse impact by generating dot product of normal and light
-   float impact = max(dot(lightNormal, lightDirection), 0.0);
-   // Generate diffuse material color   
-   diffuse = impact * material.diffuseColor; 
-
-   //**Calculate Specular lighting**
-
-   // Calculate reflection vector
-   vec3 reflectDir = reflect(-lightDirection, lightNormal);
-   // Calculate specular component
-   float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), light.focalStrength);
-   specular = (light.specularIntensity * material.shininess) * specularComponent * material.specularColor;
-  
-   return(ambient + diffuse + specular);
+#version 440 core
+
+// the member order of the structs keeps each vec3 paired with
+// a float so the std140 layout matches the C++ side
+struct Material 
+{
+    vec3 ambientColor;
+    float ambientStrength;
+    vec3 diffuseColor;
+    float shininess;
+    vec3 specularColor;
+}; 
+
+struct LightSource 
+{
+    vec3 position;	
+    float focalStrength;
+    vec3 diffuseColor;
+    float specularIntensity;
+    vec3 specularColor;
+};
+
+#define TOTAL_LIGHTS 2
+#define MAX_MATERIALS 64
+
+// a permutation compiles the light sources that the scene uses in
+// place of the whole light block
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT TOTAL_LIGHTS
+#endif
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 view;
+   mat4 projection;
+   // projection * view, multiplied once per frame on the CPU
+   mat4 viewProjection;
+   vec3 viewPosition;
+};
+
+layout (std140, binding = 1) uniform LightBlock
+{
+   LightSource lightSources[TOTAL_LIGHTS];
+   vec3 globalAmbientColor;
+};
+
+layout (std140, binding = 2) uniform MaterialBlock
+{
+   Material materials[MAX_MATERIALS];
+};
+
+// point lights binned into view space clusters on the CPU
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 colorIntensity;
+};
+
+layout (std140, binding = 3) uniform ClusterBlock
+{
+   // tiles across, tiles down, depth slices, point light count
+   uvec4 clusterGridSize;
+   // near depth, far depth, slice scale, slice bias
+   vec4 clusterDepthParams;
+   // viewport x, y, width, height
+   vec4 clusterViewport;
+};
+
+layout (std430, binding = 0) readonly buffer PointLightBuffer
+{
+   PointLight pointLights[];
+};
+
+// offset into the light indices and light count per cluster
+layout (std430, binding = 1) readonly buffer ClusterRangeBuffer
+{
+   uvec2 clusterRanges[];
+};
+
+layout (std430, binding = 2) readonly buffer ClusterIndexBuffer
+{
+   uint clusterLightIndices[];
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+in vec4 fragmentObjectColor;
+flat in float fragmentTextureLayer;
+flat in int fragmentMaterialIndex;
+
+layout (location = 0) out vec4 outFragmentColor;
+// geometry targets of the deferred mode - only written when
+// bWriteGBuffer is true, and the unlit color goes to location 0
+layout (location = 1) out vec4 outGBufferNormal;
+layout (location = 2) out uint outGBufferMaterial;
+
+// permutations fix the texturing and lighting with USE_TEXTURE and
+// USE_LIGHTING, so their branches compile away - the base program
+// reads them from the uniforms
+#ifdef USE_TEXTURE
+const bool bUseTexture = (USE_TEXTURE != 0);
+#else
+uniform bool bUseTexture=false;
+#endif
+#ifdef USE_LIGHTING
+const bool bUseLighting = (USE_LIGHTING != 0);
+#else
+uniform bool bUseLighting=false;
+#endif
+uniform sampler2DArray objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// cross fade between two detail levels - 0 keeps every fragment,
+// a positive value keeps the fragments whose dither threshold is
+// below it and a negative value keeps the others
+uniform float lodFade = 0.0f;
+// depth pre-pass - only the depth and the dithered discard matter
+uniform bool bDepthOnly = false;
+// deferred mode - the geometry pass writes the surface attributes
+// and the lighting pass shades them once per pixel
+uniform bool bWriteGBuffer = false;
+uniform bool bDeferredLighting = false;
+uniform sampler2D gBufferAlbedo;
+uniform sampler2D gBufferNormal;
+uniform usampler2D gBufferMaterial;
+uniform sampler2D gBufferDepth;
+uniform mat4 inverseViewProjection;
+    
+
+// function prototypes
+vec3 CalcLighting(Material material, vec3 lightNormal, vec3 vertexPosition);
+void ShadeGBuffer();
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+vec3 CalcClusterLights(Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection);
+float CalcDitherThreshold();
+
+void main()
+{
+   if(bDeferredLighting == true)
+   {
+      ShadeGBuffer();
+      return;
+   }
+
+   // the two detail levels of a cross fade cover opposite pixels
+   if(lodFade != 0.0f)
+   {
+      bool bKeep = (lodFade > 0.0f) ? (CalcDitherThreshold() < lodFade) : (CalcDitherThreshold() >= -lodFade);
+      if(bKeep == false)
+      {
+         discard;
+      }
+   }
+
+   if(bDepthOnly == true)
+   {
+      outFragmentColor = vec4(0.0f);
+      return;
+   }
+
+   vec4 surfaceColor = fragmentObjectColor;
+   if(bUseTexture == true)
+   {
+      surfaceColor = texture(objectTexture, vec3(fragmentTextureCoordinate * UVscale, fragmentTextureLayer));
+   }
+
+   // the material is stored plus one so zero marks unlit pixels
+   if(bWriteGBuffer == true)
+   {
+      outFragmentColor = vec4(surfaceColor.rgb, 1.0f);
+      outGBufferNormal = vec4(normalize(fragmentVertexNormal), 0.0f);
+      outGBufferMaterial = (bUseLighting == true) ? uint(fragmentMaterialIndex + 1) : 0u;
+      return;
+   }
+
+   if(bUseLighting == true)
+   {
+      vec3 phongResult = CalcLighting(materials[fragmentMaterialIndex], normalize(fragmentVertexNormal), fragmentPosition);
+
+      if(bUseTexture == true)
+      {
+         outFragmentColor = vec4(phongResult * surfaceColor.xyz, 1.0);
+      }
+      else
+      {
+         outFragmentColor = vec4(phongResult * surfaceColor.xyz, surfaceColor.w);
+      }
+   }
+   else 
+   {
+      outFragmentColor = surfaceColor;
+   }
+}
+
+// calculates the light reaching a surface from the light sources and
+// the point lights of its cluster
+vec3 CalcLighting(Material material, vec3 lightNormal, vec3 vertexPosition)
+{
+   vec3 viewDirection = normalize(viewPosition - vertexPosition);
+   vec3 phongResult = vec3(0.0f);
+
+   for(int i = 0; i < LIGHT_COUNT; i++)
+   {
+      phongResult += CalcLightSource(lightSources[i], material, lightNormal, vertexPosition, viewDirection); 
+   }   
+
+   // add the point lights that reach this fragment's cluster
+   if(clusterGridSize.w > 0u)
+   {
+      phongResult += CalcClusterLights(material, lightNormal, vertexPosition, viewDirection);
+   }
+
+   return(phongResult);
+}
+
+// shades the opaque surface that the geometry pass left in this
+// pixel - the position is rebuilt from the depth
+void ShadeGBuffer()
+{
+   ivec2 pixel = ivec2(gl_FragCoord.xy);
+   vec4 albedo = texelFetch(gBufferAlbedo, pixel, 0);
+   uint materialID = texelFetch(gBufferMaterial, pixel, 0).r;
+
+   if(materialID == 0u)
+   {
+      outFragmentColor = albedo;
+      return;
+   }
+
+   float depth = texelFetch(gBufferDepth, pixel, 0).r;
+   vec2 screenPosition = (gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw;
+   vec4 worldPosition = inverseViewProjection * vec4((vec3(screenPosition, depth) * 2.0f) - 1.0f, 1.0f);
+   vec3 lightNormal = texelFetch(gBufferNormal, pixel, 0).xyz;
+
+   vec3 phongResult = CalcLighting(materials[materialID - 1u], lightNormal, worldPosition.xyz / worldPosition.w);
+   outFragmentColor = vec4(phongResult * albedo.rgb, 1.0f);
+}
+
+// calculates the color when using a directional light.
+vec3 CalcLightSource(LightSource light, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+   vec3 ambient;
+   vec3 diffuse;
+   vec3 specular;
+
+   //**Calculate Ambient lighting**
+
+   ambient = globalAmbientColor;
+
+   //**Calculate Diffuse lighting**
+
+   // Calculate distance (light direction) between light source and fragments/pixels
+   vec3 lightDirection = normalize(light.position - vertexPosition); 
+   // Calculate diffuse impact by generating dot product of normal and light
+   float impact = max(dot(lightNormal, lightDirection), 0.0);
+   // Generate diffuse material color   
+   diffuse = impact * material.diffuseColor; 
+
+   //**Calculate Specular lighting**
+
+   // Calculate reflection vector
+   vec3 reflectDir = reflect(-lightDirection, lightNormal);
+   // Calculate specular component
+   float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), light.focalStrength);
+   specular = (light.specularIntensity * material.shininess) * specularComponent * material.specularColor;
+  
+   return(ambient + diffuse + specular);
+}
+
+// calculates the color added by the point lights of the cluster
+// that holds the fragment
+vec3 CalcClusterLights(Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection)
+{
+   vec3 result = vec3(0.0f);
+
+   // find the cluster from the window position and the view depth
+   float viewDepth = -(view * vec4(vertexPosition, 1.0f)).z;
+   vec2 tileCoordinate = (gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw;
+   uvec3 cluster;
+   cluster.x = min(uint(tileCoordinate.x * float(clusterGridSize.x)), clusterGridSize.x - 1u);
+   cluster.y = min(uint(tileCoordinate.y * float(clusterGridSize.y)), clusterGridSize.y - 1u);
+   cluster.z = uint(clamp(log(max(viewDepth, clusterDepthParams.x)) * clusterDepthParams.z - clusterDepthParams.w, 0.0f, float(clusterGridSize.z - 1u)));
+   uint clusterIndex = cluster.x + (clusterGridSize.x * (cluster.y + (clusterGridSize.y * cluster.z)));
+
+   uvec2 range = clusterRanges[clusterIndex];
+   for(uint i = 0u; i < range.y; i++)
+   {
+      PointLight light = pointLights[clusterLightIndices[range.x + i]];
+
+      vec3 lightVector = light.positionRadius.xyz - vertexPosition;
+      float lightDistance = length(lightVector);
+      vec3 lightDirection = lightVector / max(lightDistance, 0.0001f);
+
+      // smooth falloff that reaches zero at the light radius
+      float falloff = clamp(1.0f - ((lightDistance * lightDistance) / (light.positionRadius.w * light.positionRadius.w)), 0.0f, 1.0f);
+      falloff *= falloff;
+
+      float impact = max(dot(lightNormal, lightDirection), 0.0);
+      vec3 reflectDir = reflect(-lightDirection, lightNormal);
+      float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), material.shininess);
+
+      vec3 lightColor = light.colorIntensity.rgb * (light.colorIntensity.a * falloff);
+      result += lightColor * ((impact * material.diffuseColor) + (specularComponent * material.specularColor));
+   }
+
+   return(result);
+}
+
+// gets the ordered dither threshold of the fragment's pixel from
+// a 4x4 Bayer matrix
+float CalcDitherThreshold()
+{
+   const float bayer[16] = float[16](
+       0.0f,  8.0f,  2.0f, 10.0f,
+      12.0f,  4.0f, 14.0f,  6.0f,
+       3.0f, 11.0f,  1.0f,  9.0f,
+      15.0f,  7.0f, 13.0f,  5.0f);
+   ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+
+   return((bayer[(pixel.y * 4) + pixel.x] + 0.5f) / 16.0f);
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 440 core
+// builds one level of the hierarchical-Z pyramid - every texel takes
+// the farthest depth of the texels that it covers in the source level
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// occluder depth for the first level, the pyramid for the others
+uniform sampler2D sourceDepth;
+uniform int sourceLevel;
+uniform ivec2 sourceSize;
+uniform ivec2 destinationSize;
+
+layout (r32f, binding = 0) writeonly uniform image2D destination;
+
+void main()
+{
+   ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+   if(any(greaterThanEqual(texel, destinationSize)))
+   {
+      return;
+   }
+
+   // the source texels under this texel - three wide along the
+   // side of an odd sized level, so no source texel is skipped
+   ivec2 first = (texel * sourceSize) / destinationSize;
+   ivec2 last = min((((texel + 1) * sourceSize) + destinationSize - 1) / destinationSize, sourceSize) - 1;
+
+   float farthestDepth = 0.0f;
+   for(int y = first.y; y <= last.y; y++)
+   {
+      for(int x = first.x; x <= last.x; x++)
+      {
+         farthestDepth = max(farthestDepth, texelFetch(sourceDepth, ivec2(x, y), sourceLevel).r);
+      }
+   }
+
+   imageStore(destination, texel, vec4(farthestDepth));
+}
\ No newline at end of file
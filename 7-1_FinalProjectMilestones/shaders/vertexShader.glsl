@@ -1,20 +1,119 @@
-#version 330 core
-layout (location = 0) in vec3 inVertexPosition;
-layout (location = 1) in vec3 inVertexNormal;
-layout (location = 2) in vec2 inTextureCoordinate;
-
-out vec3 fragmentPosition;
-out vec3 fragmentVertexNormal;
-out vec2 fragmentTextureCoordinate;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
-   fragmentTextureCoordinate = inTextureCoordinate;
+#version 440 core
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance attributes - only read when bUseInstancing is true
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in float inInstanceTextureLayer;
+layout (location = 10) in mat3 inInstanceNormalMatrix;
+// object of a GPU driven draw - the base instance of the indirect
+// command selects it, only read when bUseObjectBuffer is true
+layout (location = 9) in uint inObjectIndex;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+out vec4 fragmentObjectColor;
+flat out float fragmentTextureLayer;
+flat out int fragmentMaterialIndex;
+// the depth pre-pass and the main pass must produce the same depth
+invariant gl_Position;
+
+uniform bool bUseInstancing = false;
+uniform bool bUseObjectBuffer = false;
+// draws the fullscreen triangle of the deferred lighting pass
+uniform bool bDeferredLighting = false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform float textureLayer = 0.0f;
+uniform mat4 model;
+// inverse transpose of the model matrix, built on the CPU each
+// time the object moves
+uniform mat3 normalMatrix = mat3(1.0f);
+// entry of the material table used by the current draw
+uniform int materialIndex = 0;
+
+// camera values shared by every draw - set once per frame
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 view;
+   mat4 projection;
+   // projection * view, multiplied once per frame on the CPU
+   mat4 viewProjection;
+   vec3 viewPosition;
+};
+
+struct ObjectData
+{
+   mat4 model;
+   vec4 color;
+   // world bounds - the w values hold the texture scale
+   vec4 boundsMinimum;
+   vec4 boundsMaximum;
+   // material index, texture array layer
+   ivec4 params;
+   mat3 normalMatrix;
+};
+
+// per-object data of the GPU driven scene
+layout (std430, binding = 3) readonly buffer ObjectBuffer
+{
+   ObjectData objects[];
+};
+
+void main()
+{
+   // the three vertices of the lighting pass cover the screen
+   if(bDeferredLighting == true)
+   {
+      vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+      gl_Position = vec4((corner * 2.0f) - 1.0f, 0.0f, 1.0f);
+      fragmentPosition = vec3(0.0f);
+      fragmentVertexNormal = vec3(0.0f);
+      fragmentTextureCoordinate = corner;
+      fragmentObjectColor = vec4(1.0f);
+      fragmentTextureLayer = 0.0f;
+      fragmentMaterialIndex = 0;
+      return;
+   }
+
+   mat4 objectModel = model;
+   mat3 objectNormalMatrix = normalMatrix;
+   vec4 objectVertexColor = objectColor;
+   float objectTextureLayer = textureLayer;
+   int objectMaterialIndex = materialIndex;
+   vec2 objectUVScale = vec2(1.0f);
+
+   // instanced draws take the model matrix, color and texture
+   // layer from the instance attributes instead of the uniforms
+   if(bUseInstancing == true)
+   {
+      objectModel = inInstanceModel;
+      objectNormalMatrix = inInstanceNormalMatrix;
+      objectVertexColor = inInstanceColor;
+      objectTextureLayer = inInstanceTextureLayer;
+   }
+
+   // GPU driven draws take every object value from the object buffer
+   if(bUseObjectBuffer == true)
+   {
+      ObjectData object = objects[inObjectIndex];
+      objectModel = object.model;
+      objectNormalMatrix = object.normalMatrix;
+      objectVertexColor = object.color;
+      objectTextureLayer = float(object.params.y);
+      objectMaterialIndex = object.params.x;
+      objectUVScale = vec2(object.boundsMinimum.w, object.boundsMaximum.w);
+   }
+
+   // the world position is needed for the lighting anyway, so
+   // the clip position only costs one more matrix times vector
+   vec4 worldPosition = objectModel * vec4(inVertexPosition, 1.0f);
+   fragmentPosition = vec3(worldPosition);
+   gl_Position = viewProjection * worldPosition;
+   fragmentVertexNormal = objectNormalMatrix * inVertexNormal;
+   fragmentTextureCoordinate = inTextureCoordinate * objectUVScale;
+   fragmentObjectColor = objectVertexColor;
+   fragmentTextureLayer = objectTextureLayer;
+   fragmentMaterialIndex = objectMaterialIndex;
 }
\ No newline at end of file